@@ -12,6 +12,7 @@ CREATE_LOGGER(BodyContainer);
 
 void BodyContainer::clear(){
 	body.clear();
+	revision++;
 }
 
 Body::id_t BodyContainer::insert(shared_ptr<Body> b){
@@ -21,13 +22,32 @@ Body::id_t BodyContainer::insert(shared_ptr<Body> b){
 	b->id=body.size();
 	scene->doSort = true;
 	body.push_back(b);
+	revision++;
 	// Notify ForceContainer about new id
 	scene->forces.addMaxId(b->id);
 	return b->id;
 }
 
+Body::id_t BodyContainer::insertBatch(const vector<shared_ptr<Body> >& bb){
+	const shared_ptr<Scene>& scene=Omega::instance().getScene();
+	const Body::id_t first=body.size();
+	if(bb.empty()) return first;
+	body.reserve(body.size()+bb.size());
+	FOREACH(const shared_ptr<Body>& b, bb){
+		b->iterBorn=scene->iter;
+		b->timeBorn=scene->time;
+		b->id=body.size();
+		body.push_back(b);
+	}
+	scene->doSort = true;
+	revision++;
+	scene->forces.addMaxId(body.size()-1);
+	return first;
+}
+
 bool BodyContainer::erase(Body::id_t id, bool eraseClumpMembers){//default is false (as before)
 	if(!body[id]) return false;
+	revision++;
 	const shared_ptr<Body>& b=Body::byId(id);
 	if ((b) and (b->isClumpMember())) {
 		const shared_ptr<Body> clumpBody=Body::byId(b->clumpId);
@@ -51,9 +51,13 @@ class BodyContainer: public Serializable{
 		using iterator = smart_iterator ;
 		using const_iterator = const smart_iterator ;
 
-		BodyContainer() {};
+		//! incremented whenever bodies are inserted or erased, so that engines can tell when lists of ids they cache are outdated
+		unsigned long revision;
+		BodyContainer(): revision(0) {};
 		virtual ~BodyContainer() {};
 		Body::id_t insert(shared_ptr<Body>);
+		//! insert many bodies at once, reserving storage and notifying the scene (collider, ForceContainer) only once; returns the first new id
+		Body::id_t insertBatch(const vector<shared_ptr<Body> >& bb);
 		void clear();
 		iterator begin() {
 			iterator temp(body.begin());
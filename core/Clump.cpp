@@ -41,6 +41,7 @@ void Clump::add(const shared_ptr<Body>& clumpBody, const shared_ptr<Body>& subBo
 	}
 	clumpBody->clumpId=clumpBody->id; // just to make sure
 	clumpBody->setBounded(false); // disallow collisions with the clump itself
+	clump->updateMemberArrays();
 	if(subBody->isStandalone()){LOG_DEBUG("Added body #"<<subBody->id<<" to clump #"<<clumpBody->id);}
 }
 
@@ -49,19 +50,29 @@ void Clump::del(const shared_ptr<Body>& clumpBody, const shared_ptr<Body>& subBo
 	const shared_ptr<Clump> clump=YADE_PTR_CAST<Clump>(clumpBody->shape);
 	if(clump->members.erase(subBody->id)!=1) throw std::invalid_argument(("Body #"+boost::lexical_cast<string>(subBody->id)+" not part of clump #"+boost::lexical_cast<string>(clumpBody->id)+"; not removing.").c_str());
 	subBody->clumpId=Body::ID_NONE;
+	clump->updateMemberArrays();
 	LOG_DEBUG("Removed body #"<<subBody->id<<" from clump #"<<clumpBody->id);
 }
 
-void Clump::addForceTorqueFromMembers(const State* clumpState, Scene* scene, Vector3r& F, Vector3r& T){
+void Clump::updateMemberArrays(){
+	memberIds.resize(members.size()); memberRelPos.resize(members.size()); memberRelOri.resize(members.size());
+	size_t i=0;
 	FOREACH(const MemberMap::value_type& mm, members){
-		const Body::id_t& memberId=mm.first; 
-		const shared_ptr<Body>& member=Body::byId(memberId,scene); 
-		assert(member->isClumpMember()); 
-		State* memberState=member->state.get();
-		const Vector3r& f=scene->forces.getForce(memberId); 
+		memberIds[i]=mm.first; memberRelPos[i]=mm.second.position; memberRelOri[i]=mm.second.orientation;
+		i++;
+	}
+}
+
+void Clump::addForceTorqueFromMembers(const State* clumpState, Scene* scene, Vector3r& F, Vector3r& T){
+	if(memberIds.size()!=members.size()) updateMemberArrays();
+	for(size_t i=0; i<memberIds.size(); i++){
+		const Body::id_t& memberId=memberIds[i];
+		assert((*scene->bodies)[memberId]->isClumpMember());
+		const Vector3r& f=scene->forces.getForce(memberId);
 		const Vector3r& t=scene->forces.getTorque(memberId);
 		F+=f;
-		T+=t+(memberState->pos-clumpState->pos).cross(f);
+		// member position from the relative one, to avoid touching the member body
+		T+=t+(clumpState->ori*memberRelPos[i]).cross(f);
 	}
 }
 
@@ -107,6 +118,7 @@ void Clump::updateProperties(const shared_ptr<Body>& clumpBody, unsigned int dis
 		state->mass=subState->mass;
 		state->vel=Vector3r::Zero();
 		state->angVel=Vector3r::Zero();
+		clump->updateMemberArrays();
 		return;
 	}
 	//check for intersections:
@@ -235,6 +247,7 @@ void Clump::updateProperties(const shared_ptr<Body>& clumpBody, unsigned int dis
 		I.second.orientation=state->ori.conjugate()*subState->ori;
 		I.second.position=state->ori.conjugate()*(subState->pos-state->pos);
 	}
+	clump->updateMemberArrays();
 }
 
 
@@ -262,6 +275,7 @@ void Clump::updatePropertiesNonSpherical(const shared_ptr<Body>& clumpBody, bool
 		state->mass=subState->mass;
 		state->vel=Vector3r::Zero();
 		state->angVel=Vector3r::Zero();
+		clump->updateMemberArrays();
 		return;
 	}
 
@@ -342,6 +356,7 @@ void Clump::updatePropertiesNonSpherical(const shared_ptr<Body>& clumpBody, bool
 		I.second.position=state->ori.conjugate()*(subState->pos-state->pos);
 	}
 
+	clump->updateMemberArrays();
 }
 
 void Clump::updatePropertiesNonSpherical(const shared_ptr<Body>& clumpBody, bool intersecting){ //FIXME
@@ -366,6 +381,7 @@ void Clump::updatePropertiesNonSpherical(const shared_ptr<Body>& clumpBody, bool
 		state->mass=subState->mass;
 		state->vel=Vector3r::Zero();
 		state->angVel=Vector3r::Zero();
+		clump->updateMemberArrays();
 		return;
 	}
 
@@ -447,6 +463,7 @@ void Clump::updatePropertiesNonSpherical(const shared_ptr<Body>& clumpBody, bool
 	}
 
 
+	clump->updateMemberArrays();
 }
 
 void Clump::addNonSpherical(const shared_ptr<Body>& clumpBody, const shared_ptr<Body>& subBody){ //FIXME
@@ -459,6 +476,7 @@ void Clump::addNonSpherical(const shared_ptr<Body>& clumpBody, const shared_ptr<
 	subBody->clumpId=clumpBody->id;
 	clumpBody->clumpId=clumpBody->id; // just to make sure
 	clumpBody->setBounded(false); // disallow collisions with the clump itself
+	clump->updateMemberArrays();
 	//LOG_DEBUG("Added body #"<<subId<<" to clump #"<<getId());
 }
 /*! @brief Recalculates inertia tensor of a body after translation away from (default) or towards its centroid.
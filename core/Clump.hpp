@@ -6,6 +6,7 @@
 #include<lib/base/Logging.hpp>
 #include<lib/base/Math.hpp>
 #include<core/PartialEngine.hpp>
+#include<core/Scene.hpp>
 
 
 /*! Body representing clump (rigid aggregate) composed by other existing bodies.
@@ -67,10 +68,11 @@ class Clump: public Shape {
 		static void moveMembers(const shared_ptr<Body>& clumpBody, Scene* scene, IntegratorT* integrator=NULL){
 			const shared_ptr<Clump>& clump=YADE_PTR_CAST<Clump>(clumpBody->shape);
 			const shared_ptr<State>& clumpState=clumpBody->state;
-			FOREACH(MemberMap::value_type& B, clump->members){
-				// B.first is Body::id_t, B.second is local Se3r of that body in the clump
-				const shared_ptr<Body>& b = Body::byId(B.first,scene);
-				const shared_ptr<State>& subState=b->state; const Vector3r& subPos(B.second.position); const Quaternionr& subOri(B.second.orientation);
+			if(clump->memberIds.size()!=clump->members.size()) clump->updateMemberArrays();
+			const BodyContainer& bodies=*scene->bodies;
+			for(size_t i=0; i<clump->memberIds.size(); i++){
+				const shared_ptr<Body>& b=bodies[clump->memberIds[i]];
+				const shared_ptr<State>& subState=b->state; const Vector3r& subPos(clump->memberRelPos[i]); const Quaternionr& subOri(clump->memberRelOri[i]);
 				// position update
 				subState->pos=clumpState->pos+clumpState->ori*subPos;
 				subState->ori=clumpState->ori*subOri;
@@ -88,6 +90,14 @@ class Clump: public Shape {
 		//! get force and torque on the clump itself, from forces/torques on members; does not include force on clump itself
 		void addForceTorqueFromMembers(const State* clumpState, Scene* scene, Vector3r& F, Vector3r& T);
 
+		/*! Contiguous copy of members (ids and Se3r relative to the clump, in the same order), used by the integrator instead of traversing the map.
+		Rebuilt by updateMemberArrays, which must be called whenever members change (add, del, updateProperties do so). */
+		vector<Body::id_t> memberIds;
+		vector<Vector3r> memberRelPos;
+		vector<Quaternionr> memberRelOri;
+		void updateMemberArrays();
+		void postLoad(Clump&){ updateMemberArrays(); }
+
 
 		//! Recalculates inertia tensor of a body after translation away from (default) or towards its centroid.
 		static Matrix3r inertiaTensorTranslate(const Matrix3r& I,const Real m, const Vector3r& off);
@@ -21,6 +21,10 @@
 #include <boost/thread/mutex.hpp>
 #include <boost/filesystem.hpp>
 #include <cxxabi.h>
+#include <atomic>
+#ifdef YADE_OPENMP
+	#include <omp.h>
+#endif
 
 
 class RenderMutexLock: public boost::mutex::scoped_lock{
@@ -34,7 +38,9 @@ SINGLETON_SELF(Omega);
 
 const map<string,DynlibDescriptor>& Omega::getDynlibsDescriptor(){return dynlibs;}
 
-const shared_ptr<Scene>& Omega::getScene(){return scenes.at(currentSceneNb);}
+thread_local shared_ptr<Scene> Omega::threadScene;
+
+const shared_ptr<Scene>& Omega::getScene(){ if(threadScene) return threadScene; return scenes.at(currentSceneNb);}
 void Omega::resetCurrentScene(){ RenderMutexLock lock; scenes.at(currentSceneNb) = shared_ptr<Scene>(new Scene);}
 void Omega::resetScene(){ resetCurrentScene(); }
 void Omega::resetAllScenes(){
@@ -57,6 +63,61 @@ void Omega::switchToScene(int i) {
 	currentSceneNb=i;
 }
 
+void Omega::runScenesConcurrently(const vector<int>& sceneIds, long nSteps, int nWorkers, const vector<int>& ompThreads){
+	if(isRunning()) throw runtime_error("Omega::runScenesConcurrently: the simulation is running, stop it first.");
+	if(ompThreads.size()!=1 && ompThreads.size()!=sceneIds.size()) throw std::invalid_argument("Omega::runScenesConcurrently: ompThreads must have one value, or one value per scene.");
+	vector<shared_ptr<Scene> > runScenes;
+	FOREACH(int id, sceneIds){
+		if(id<0 || id>=(int)scenes.size()) throw std::invalid_argument("Omega::runScenesConcurrently: scene "+boost::lexical_cast<string>(id)+" has not been created.");
+		if(std::count(sceneIds.begin(),sceneIds.end(),id)>1) throw std::invalid_argument("Omega::runScenesConcurrently: scene "+boost::lexical_cast<string>(id)+" given more than once.");
+		runScenes.push_back(scenes[id]);
+	}
+	if(runScenes.empty()) return;
+	if(nWorkers<=0) nWorkers=std::max(1,(int)boost::thread::hardware_concurrency()/std::max(1,ompThreads[0]));
+	nWorkers=std::min(nWorkers,(int)runScenes.size());
+
+	// each worker takes the next scene not yet started and runs all its steps
+	std::atomic<size_t> next(0);
+	vector<string> errors(runScenes.size());
+	auto worker=[&](){
+		for(size_t i=next++; i<runScenes.size(); i=next++){
+			const shared_ptr<Scene>& scene=runScenes[i];
+			threadScene=scene;
+			#ifdef YADE_OPENMP
+				// per-thread storage of the ForceContainer is sized once, a scene can not use more threads than it has
+				const int nThreads=std::min(std::max(1,ompThreads.size()==1 ? ompThreads[0] : ompThreads[i]),scene->forces.getNumAllocatedThreads());
+				omp_set_num_threads(nThreads);
+				// threads of the OpenMP team of this worker call getScene() too
+				#pragma omp parallel num_threads(nThreads)
+				threadScene=scene;
+			#endif
+			const bool subStepping=scene->subStepping;
+			try{
+				if(subStepping){ LOG_INFO("Sub-stepping disabled while running scene "<<sceneIds[i]<<" concurrently."); scene->subStepping=false; }
+				for(long step=0; step<nSteps; step++){
+					scene->moveToNextTimeStep();
+					if(scene->stopAtIter>0 && scene->iter==scene->stopAtIter) break;
+					if(scene->stopAtTime>0 && scene->time==scene->stopAtTime) break;
+				}
+			}
+			catch(std::exception& e){ errors[i]=e.what(); }
+			catch(...){ errors[i]="unknown exception (error in python code?)"; }
+			scene->subStepping=subStepping;
+			#ifdef YADE_OPENMP
+				#pragma omp parallel num_threads(nThreads)
+				threadScene.reset();
+			#endif
+			threadScene.reset();
+		}
+	};
+	boost::thread_group pool;
+	for(int w=0; w<nWorkers; w++) pool.create_thread(worker);
+	pool.join_all();
+	for(size_t i=0; i<runScenes.size(); i++){
+		if(!errors[i].empty()) throw runtime_error("Omega::runScenesConcurrently: scene "+boost::lexical_cast<string>(sceneIds[i])+": "+errors[i]);
+	}
+}
+
 Real Omega::getRealTime(){
 	return (boost::posix_time::microsec_clock::local_time()-startupLocalTime).total_milliseconds()/1e3;
 }
@@ -45,6 +45,8 @@ class Omega: public Singleton<Omega>{
 	vector<shared_ptr<Scene> > scenes;
 	int currentSceneNb;
 	shared_ptr<Scene> sceneAnother; // used for temporarily running different simulation, in Omega().switchscene()
+	// scene stepped by the calling thread in runScenesConcurrently; returned by getScene() instead of the current scene
+	static thread_local shared_ptr<Scene> threadScene;
 
   boost::posix_time::ptime startupLocalTime;
 
@@ -93,6 +95,8 @@ class Omega: public Singleton<Omega>{
 		const shared_ptr<Scene>& getScene();
 		int addScene();
 		void switchToScene(int i);
+		//! Step scenes concurrently on a pool of nWorkers threads (all cores if <=0), each nSteps times (or until its stopAtIter/stopAtTime); ompThreads is the number of OpenMP threads of each scene (one value for all, or one per scene).
+		void runScenesConcurrently(const vector<int>& sceneIds, long nSteps, int nWorkers, const vector<int>& ompThreads);
 		//! Return unique temporary filename. May be deleted by the user; if not, will be deleted at shutdown.
 		string tmpFilename();
 		Real getRealTime();
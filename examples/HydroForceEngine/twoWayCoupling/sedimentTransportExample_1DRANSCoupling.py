@@ -3,7 +3,7 @@
 # 24/11/2017
 #
 # Same as sedimentTransportExample but solving a 1D volume averaged fluid momentum balance to determine the fluid velocity profile (i.e. DEM-1D RANS coupling)
-# The resolution therefore include a two-way coupling in time between the fluid and the particle behavior, meaning that the fluid is solved every "fluidResolPeriod"
+# The resolution therefore include a two-way coupling in time between the fluid and the particle behavior, meaning that the fluid is solved by HydroForceEngine every "fluidResolPeriod"
 # and account for the presence of particles and for the momentum transfered to the particle phase through the hydrodynamic forces imposed. The fluid-particle system momentum 
 # is therefore conserved. 
 #
@@ -134,9 +134,7 @@ O.engines = [
    	[Law2_ScGeom_ViscElPhys_Basic()]
 	,label = 'interactionLoop'),				
 	#Apply an hydrodynamic force to the particles
-	HydroForceEngine(densFluid = densFluidPY,viscoDyn = kinematicViscoFluid*densFluidPY,zRef = groundPosition,gravity = gravityVector,deltaZ = dz,expoRZ = expoDrag_PY,lift = False,nCell = ndimz,vCell = length*width*dz,radiusPart=diameterPart/2.,vxFluid = np.array(vxFluidPY),phiPart = phiPartPY,vxPart = vxPartPY,ids = idApplyForce, label = 'hydroEngine', dead = True),
-	#Solve the fluid volume-averaged 1D momentum balance, RANS 1D
-	PyRunner(command = 'fluidModel()', virtPeriod = fluidResolPeriod, label = 'fluidRes', dead = True),
+	HydroForceEngine(densFluid = densFluidPY,viscoDyn = kinematicViscoFluid*densFluidPY,zRef = groundPosition,gravity = gravityVector,deltaZ = dz,expoRZ = expoDrag_PY,lift = False,nCell = ndimz,vCell = length*width*dz,radiusPart=diameterPart/2.,vxFluid = np.array(vxFluidPY),phiPart = phiPartPY,vxPart = vxPartPY,ids = idApplyForce, dtFluid = dtFluid, label = 'hydroEngine', dead = True),
 	#Measurement, output files
 	PyRunner(command = 'measure()', virtPeriod = 0.1, label = 'measurement', dead = True),
 	# Check if the packing is stabilized, if yes activate the hydro force on the grains and the slope.
@@ -171,28 +169,17 @@ def gravityDeposition(lim):
 		hydroEngine.ReynoldStresses = np.ones(ndimz)*1e-4 # Send the simplified fluid Reynolds stresses Rxz/\rho^f used to account for the fluid velocity fluctuations in HydroForceEngine (see c++ code)
 		hydroEngine.turbulentFluctuation() #Initialize the fluid velocity fluctuation associated to particles to zero in HydroForceEngine, necessary to avoid segmentation fault
 		measurement.dead = False	# Activate the measure() PyRunner
-		fluidRes.dead = False		# Activate the 1D fluid resolution
 		hydroEngine.averageProfile()	#Evaluate the solid volume fraction, velocity and drag, necessary for the fluid resolution. 
 		hydroEngine.fluidResolution(1.,dtFluid)	#Initialize the fluid resolution, run the fluid resolution for 1s
+		#Activate the 1D fluid resolution: HydroForceEngine evaluates the average profiles and solves the fluid momentum balance every fluidResolPeriod s (in iterations, with the current time step)
+		hydroEngine.fluidResolIterPeriod = max(1,int(round(fluidResolPeriod/O.dt)))
+		hydroEngine.lastFluidResolIter = O.iter	#The fluid has just been solved
 
 	return
 ###############
 #########################################
 
 
-#######			      ########
-###	    FLUID RESOLUTION	   ###
-#######			      ########
-def fluidModel():
-	global vxFluidPY,taufsi
-	#Evaluate the average vx,vy,vz,phi,drag profiles and store it in hydroEngine, to prepare the fluid resolution
-	hydroEngine.averageProfile()
-	#Fluid resolution
-	hydroEngine.fluidResolution(fluidResolPeriod,dtFluid)	#Solve the fluid momentum balance for a time of fluidResolPeriod s with a time step dtFluid
-	#update the fluid velocity for later save
-	vxFluidPY = np.array(hydroEngine.vxFluid)
-	
-
 #######		      ########
 ###	    OUTPUT	   ###
 #######		      ########
@@ -204,7 +191,9 @@ for i in range(0,ndimz):#z scale used for the possible plot at the end
 
 # Averaging/Save
 def measure():
-	global qsMean,vxPartPY,phiPartPY
+	global qsMean,vxPartPY,phiPartPY,vxFluidPY
+	#Fluid velocity profile from the last fluid resolution done by HydroForceEngine, for later save
+	vxFluidPY = np.array(hydroEngine.vxFluid)
 	#Evaluate the average depth profile of streamwise, spanwise and wall-normal particle velocity, particle volume fraction (and drag force for coupling with RANS fluid resolution), and store it in hydroEngine variables vxPart, phiPart, vyPart, vzPart, averageDrag.
 	hydroEngine.averageProfile()
 	#Extract the calculated vector. They can be saved and plotted afterwards. 
@@ -58,7 +58,7 @@ class FlowBoundingSphere : public Network<_Tesselation>
 		//Pointers to vectors used for user defined boundary pressure
 		vector<Real> *pxpos, *ppval;
 		
-		void initNewTri () {noCache=true; /*isLinearSystemSet=false; areCellsOrdered=false;*/}//set flags after retriangulation
+		void initNewTri () {noCache=true; flat.valid=false; /*isLinearSystemSet=false; areCellsOrdered=false;*/}//set flags after retriangulation
 		bool permeabilityMap;
 
 		bool computeAllCells;//exececute computeHydraulicRadius for all facets and all spheres (double cpu time but needed for now in order to define crossSections correctly)
@@ -72,9 +72,25 @@ class FlowBoundingSphere : public Network<_Tesselation>
 		#define parallel_forces
 		#ifdef parallel_forces
 		int ompThreads;
-		vector< vector<const CVector*> > perVertexUnitForce;
-		vector< vector<const Real*> > perVertexPressure;
 		#endif
+		/// Flat (CSR) image of the pore network, rebuilt once per remeshing (see buildFlatNetwork()).
+		/// The per-step kernels iterate on these contiguous arrays instead of dereferencing cell handles, results are copied back to the cells once per call.
+		struct FlatNetwork {
+			vector<Real> p, dv, invVoidV, invSumK;//per-cell values, indexed by cell->info().id
+			vector<unsigned char> isFree;//1 if the pressure of the cell is unknown (neither imposed nor blocked)
+			vector<int> neighPtr, neighIdx;//finite neighbours of cell i are neighIdx[neighPtr[i]] to neighIdx[neighPtr[i+1]-1]
+			vector<Real> neighK;//kNorm() of the corresponding throats
+			vector<int> vertexPtr, vertexCell;//same CSR layout for the cells contributing to the fluid force on each vertex id
+			vector<CVector> vertexUnitForce;//the cached unit forces (cell->info().unitForceVectors), to be multiplied by the cell pressure
+			vector<int> colorPtr, colorCells;//cells of color c are colorCells[colorPtr[c]] to colorCells[colorPtr[c+1]-1], no two of them are neighbours
+			bool valid;
+			FlatNetwork() : valid(false) {}
+			unsigned int size() const {return p.size();}
+		};
+		FlatNetwork flat;
+		void buildFlatNetwork();//define the CSR adjacency and conductances from the current triangulation
+		void gatherFlatNetwork();//copy the quantities varying between two remeshing (p, dv, boundary conditions) to the flat arrays
+		void scatterFlatPressure();//copy the flat pressures back to the cells
 		vector <double> edgeSurfaces;
 		vector <pair<const VertexInfo*,const VertexInfo*> > edgeIds;
 		vector <Real> edgeNormalLubF;
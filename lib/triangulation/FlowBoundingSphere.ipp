@@ -90,7 +90,73 @@ template <class Tesselation>
 void FlowBoundingSphere<Tesselation>::resetNetwork() {T[currentTes].Clear();this->resetLinearSystem();}
 
 template <class Tesselation> 
-void FlowBoundingSphere<Tesselation>::resetLinearSystem() {noCache=true;}
+void FlowBoundingSphere<Tesselation>::resetLinearSystem() {noCache=true; flat.valid=false;}
+
+template <class Tesselation>
+void FlowBoundingSphere<Tesselation>::buildFlatNetwork()
+{
+	RTriangulation& Tri = T[currentTes].Triangulation();
+	VectorCell& cellHandles = T[currentTes].cellHandles;
+	if (cellHandles.size()!=Tri.number_of_finite_cells()) {//the numbering is defined by the engine usually, define it here if the solver is used standalone
+		cellHandles.clear(); cellHandles.reserve(Tri.number_of_finite_cells());
+		unsigned int k=0;
+		for (FiniteCellsIterator cell = Tri.finite_cells_begin(); cell != Tri.finite_cells_end(); cell++) {
+			cellHandles.push_back(cell); cell->info().id=k++;}
+	}
+	const long size = cellHandles.size();
+	flat.p.resize(size); flat.dv.resize(size); flat.invVoidV.resize(size); flat.invSumK.resize(size); flat.isFree.resize(size);
+	flat.neighPtr.resize(size+1);
+	flat.neighIdx.clear(); flat.neighK.clear();
+	flat.neighIdx.reserve(4*size); flat.neighK.reserve(4*size);
+	flat.neighPtr[0]=0;
+	for (long i=0; i<size; i++) {
+		const CellHandle& cell = cellHandles[i];
+		flat.invVoidV[i]=cell->info().invVoidVolume();
+		for (int j=0; j<4; j++) if (!Tri.is_infinite(cell->neighbor(j))) {
+			flat.neighIdx.push_back(cell->neighbor(j)->info().id);
+			flat.neighK.push_back(cell->info().kNorm()[j]);}
+		flat.neighPtr[i+1]=flat.neighIdx.size();
+	}
+	//greedy coloring of the cells for the parallel Gauss-Seidel sweep, at most 5 colors since cells have 4 neighbours
+	vector<unsigned char> color(size,0);
+	int nColors=0;
+	for (long i=0; i<size; i++) {
+		unsigned char used=0;
+		for (int k=flat.neighPtr[i]; k<flat.neighPtr[i+1]; k++) if (flat.neighIdx[k]<i) used|=1<<color[flat.neighIdx[k]];
+		unsigned char c=0; while (used & (1<<c)) c++;
+		color[i]=c; nColors=max(nColors,c+1);}
+	flat.colorPtr.assign(nColors+1,0);
+	for (long i=0; i<size; i++) flat.colorPtr[color[i]+1]++;
+	for (int c=0; c<nColors; c++) flat.colorPtr[c+1]+=flat.colorPtr[c];
+	flat.colorCells.resize(size);
+	vector<int> pos(flat.colorPtr.begin(),flat.colorPtr.end()-1);
+	for (long i=0; i<size; i++) flat.colorCells[pos[color[i]]++]=i;
+	flat.valid=true;
+}
+
+template <class Tesselation>
+void FlowBoundingSphere<Tesselation>::gatherFlatNetwork()
+{
+	VectorCell& cellHandles = T[currentTes].cellHandles;
+	const long size = cellHandles.size();
+	#pragma omp parallel for num_threads(ompThreads>0 ? ompThreads : 1)
+	for (long i=0; i<size; i++) {
+		const CellHandle& cell = cellHandles[i];
+		flat.p[i]=cell->info().p();
+		flat.dv[i]=cell->info().dv();
+		flat.isFree[i]=!(cell->info().Pcondition || cell->info().blocked);}
+}
+
+template <class Tesselation>
+void FlowBoundingSphere<Tesselation>::scatterFlatPressure()
+{
+	VectorCell& cellHandles = T[currentTes].cellHandles;
+	const long size = cellHandles.size();
+	#pragma omp parallel for num_threads(ompThreads>0 ? ompThreads : 1)
+	for (long i=0; i<size; i++) {
+		cellHandles[i]->info().p()=flat.p[i];
+		cellHandles[i]->info().invSumK=flat.invSumK[i];}
+}
 
 template <class Tesselation>
 void FlowBoundingSphere<Tesselation>::averageRelativeCellVelocity()
@@ -297,10 +363,8 @@ void FlowBoundingSphere<Tesselation>::computeFacetForcesWithCache(bool onlyCache
 	if (!onlyCache) for (FiniteVerticesIterator v = Tri.finite_vertices_begin(); v != Tri.finite_vertices_end(); ++v) v->info().forces=nullVect;
 
 	#ifdef parallel_forces
-	if (noCache) {
-		perVertexUnitForce.clear(); perVertexPressure.clear();
-		perVertexUnitForce.resize(T[currentTes].maxId+1);
-		perVertexPressure.resize(T[currentTes].maxId+1);}
+	//number of cells contributing to each vertex, counted in vertexPtr[id+1]
+	if (noCache) flat.vertexPtr.assign(T[currentTes].maxId+2,0);
 	#endif
 	CellHandle neighbourCell;
 	VertexHandle mirrorVertex;
@@ -349,11 +413,25 @@ void FlowBoundingSphere<Tesselation>::computeFacetForcesWithCache(bool onlyCache
 						}
 					}
 					#ifdef parallel_forces
-					perVertexUnitForce[cell->vertex(j)->info().id()].push_back(&(cell->info().unitForceVectors[j]));
-					perVertexPressure[cell->vertex(j)->info().id()].push_back(&(cell->info().p()));
+					flat.vertexPtr[cell->vertex(j)->info().id()+1]++;
 					#endif
 			}
 		}
+		#ifdef parallel_forces
+		//flat copy of the cached unit forces, grouped by vertex
+		for (int vn=0; vn<=T[currentTes].maxId; vn++) flat.vertexPtr[vn+1]+=flat.vertexPtr[vn];
+		flat.vertexCell.resize(flat.vertexPtr.back()); flat.vertexUnitForce.resize(flat.vertexPtr.back());
+		for (VCellIterator cellIt=T[currentTes].cellHandles.begin(); cellIt!=T[currentTes].cellHandles.end(); cellIt++) {
+			CellHandle& cell = *cellIt;
+			for (int j=0; j<4; j++) if (!Tri.is_infinite(cell->neighbor(j))) {
+				int& pos = flat.vertexPtr[cell->vertex(j)->info().id()];
+				flat.vertexCell[pos]=cell->info().id;
+				flat.vertexUnitForce[pos++]=cell->info().unitForceVectors[j];}
+		}
+		//the fill loop above shifted each offset to the beginning of the next row, shift back
+		for (int vn=T[currentTes].maxId+1; vn>0; vn--) flat.vertexPtr[vn]=flat.vertexPtr[vn-1];
+		flat.vertexPtr[0]=0;
+		#endif
 		noCache=false;//cache should always be defined after execution of this function
 	}
 		if (onlyCache) return;
@@ -363,15 +441,16 @@ void FlowBoundingSphere<Tesselation>::computeFacetForcesWithCache(bool onlyCache
 			for (int yy=0;yy<4;yy++) cell->vertex(yy)->info().forces = cell->vertex(yy)->info().forces + cell->info().unitForceVectors[yy]*cell->info().p();}
 			
 		#else
+		if (flat.size()!=T[currentTes].cellHandles.size()) {flat.p.resize(T[currentTes].cellHandles.size()); flat.dv.resize(flat.p.size()); flat.isFree.resize(flat.p.size());}
+		gatherFlatNetwork();//pressures may come from another solver, take them from the cells
 		#pragma omp parallel for num_threads(ompThreads)
 		for (int vn=0; vn<= T[currentTes].maxId; vn++) {
 			if (T[currentTes].vertexHandles[vn]==NULL) continue;
 			VertexHandle& v = T[currentTes].vertexHandles[vn];
 			const int& id =  v->info().id();
 			CVector tf (0,0,0);
-			int k=0;
-			for (vector<const Real*>::iterator c = perVertexPressure[id].begin(); c != perVertexPressure[id].end(); c++)
-				tf = tf + (*(perVertexUnitForce[id][k++]))*(**c);
+			for (int k=flat.vertexPtr[id]; k<flat.vertexPtr[id+1]; k++)
+				tf = tf + flat.vertexUnitForce[k]*flat.p[flat.vertexCell[k]];
 			v->info().forces = tf;
 		}
 		#endif
@@ -853,119 +932,85 @@ template <class Tesselation>
 void FlowBoundingSphere<Tesselation>::gaussSeidel(Real dt)
 {
 	reApplyBoundaryConditions();
-	RTriangulation& Tri = T[currentTes].Triangulation();
+	if (noCache || !flat.valid || flat.size()!=T[currentTes].cellHandles.size()) buildFlatNetwork();
+	gatherFlatNetwork();
+	const long size = flat.size();
 	int j = 0;
-	double m, n, dp_max, p_max, sum_p, p_moy, dp, sum_dp;
-	double compFlowFactor=0;
-	vector<Real> previousP;
-	previousP.resize(Tri.number_of_finite_cells());
-	const int num_threads=1;
+	double dp_max, p_max, sum_p, p_moy, dp, sum_dp;
+	int numFree=0;
 	bool compressible= (fluidBulkModulus>0);
-#ifdef GS_OPEN_MP
-	omp_set_num_threads(num_threads);
-#endif
+	//fluidBulkModulus*dt*invVoidVolume, only used for compressible fluid
+	vector<Real> compFlowFactor;
+	vector<Real> previousP;
+	if (compressible) {
+		previousP=flat.p;
+		compFlowFactor.resize(size);
+		for (long i=0; i<size; i++) compFlowFactor[i]=fluidBulkModulus*dt*flat.invVoidV[i];}
+	Real* const p = flat.p.data();
+	const int* const neighPtr = flat.neighPtr.data();
+	const int* const neighIdx = flat.neighIdx.data();
+	const Real* const neighK = flat.neighK.data();
 
        if(debugOut){ cout << "tolerance = " << tolerance << endl;
         cout << "relax = " << relax << endl;}
-			vector<Real> t_sum_p, t_dp_max, t_sum_dp, t_p_max;
-			t_sum_dp.resize(num_threads);
-			t_dp_max.resize(num_threads);
-			t_p_max.resize(num_threads);
-			t_sum_p.resize(num_threads);
-        FiniteCellsIterator cellEnd = Tri.finite_cells_end();
-	#ifdef GS_OPEN_MP
-		vector<FiniteCellsIterator> cells_its;
-		for (FiniteCellsIterator cell = Tri.finite_cells_begin(); cell != cellEnd; cell++) if ( !cell->info().Pcondition ) cells_its.push_back(cell);
-		int numCells=cells_its.size();
-		cout<<"cells_its.size() "<<cells_its.size();
+	//relax the pressure of one free cell, return the change of pressure
+	auto relaxCell = [&](long i) -> Real {
+		Real m=0, n=0;
+		for (int k=neighPtr[i]; k<neighPtr[i+1]; k++) {
+			m += neighK[k] * p[neighIdx[k]];
+			if (j==0) n += neighK[k];}
+		if ( std::isinf(m) && j<10 ) cout << "infinite flux in cell "<<i<<endl;
+		const Real previous = p[i];
+		if (n!=0 || j!=0) {
+			if ( compressible ) {
+				/// COMPRESSIBLE p = ( (previousP - compFlowFactor*dv) + compFlowFactor*m ) / (1+compFlowFactor*n) ;
+				if (j==0) flat.invSumK[i]=1/(1+compFlowFactor[i]*n);
+				p[i] = ( ((previousP[i] - compFlowFactor[i]*flat.dv[i]) + compFlowFactor[i]*m) * flat.invSumK[i] - p[i]) * relax + p[i];
+			} else {
+				/// INCOMPRESSIBLE p = - ( dv - m ) / n = ( -dv + m ) / n ;
+				if (j==0) flat.invSumK[i]=1/n;
+				p[i] = (- (flat.dv[i] - m) * flat.invSumK[i] - p[i]) * relax + p[i];
+			}
+		}
+		return previous-p[i];
+	};
+	#ifdef YADE_OPENMP
+	//cells of one color have no common throat, each color is swept in parallel; the sequence of colors replaces the sequential order
+	const bool colored = (ompThreads>1);
 	#endif
-// 	#pragma omp parallel shared(t_sum_dp, t_dp_max, sum_p, sum_dp,cells_its, j, Tri, relax)
-	{
         do {
-                int cell2=0; dp_max = 0;p_max = 0;p_moy=0;sum_p=0;sum_dp=0;
-		#ifdef GS_OPEN_MP
-		cell2=numCells;
-		for (int ii=0;ii<num_threads;ii++) t_p_max[ii] =0;
-		for (int ii=0;ii<num_threads;ii++) t_dp_max[ii] =0;
-		for (int ii=0;ii<num_threads;ii++) t_sum_p[ii]=0;
-                for (int ii=0;ii<num_threads;ii++) t_sum_dp[ii]=0;
-		int kk=0;
-		const int numCells2 = numCells;
-		#pragma omp parallel for private(dp, m, n, kk) shared(tolerance, t_sum_dp, t_dp_max, sum_p, sum_dp,cells_its, j, Tri, relax) schedule(dynamic, 1000)
-		for (kk=0; kk<numCells2; kk++) {
-			const FiniteCellsIterator& cell = cells_its[kk];
-			{
-		#else
-		int bb=-1;
-                for (FiniteCellsIterator cell = Tri.finite_cells_begin(); cell != cellEnd; cell++) {
-			bb++;
-			if ( !cell->info().Pcondition && !cell->info().blocked) {
-		                cell2++;
-		#endif
-				if (compressible && j==0) { previousP[bb]=cell->info().p(); }
-				m=0, n=0;
-				for (int j2=0; j2<4; j2++) {
-					if (!Tri.is_infinite(cell->neighbor(j2))) { 
-						/// COMPRESSIBLE: 
-						if ( compressible ) {
-							compFlowFactor = fluidBulkModulus*dt*cell->info().invVoidVolume();
-							m += compFlowFactor*(cell->info().kNorm())[j2] * cell->neighbor(j2)->info().p();
-							if (j==0) n +=compFlowFactor*(cell->info().kNorm())[j2];
-						} else {							
-						/// INCOMPRESSIBLE 
-							m += (cell->info().kNorm())[j2] * cell->neighbor(j2)->info().p();
-							if ( std::isinf(m) && j<10 ) cout << "(cell->info().kNorm())[j2] = " << (cell->info().kNorm())[j2] << " cell->neighbor(j2)->info().p() = " << cell->neighbor(j2)->info().p() << endl;
-							if (j==0) n += (cell->info().kNorm())[j2];
-						}  
-					}
+                numFree=0; dp_max = 0;p_max = 0;p_moy=0;sum_p=0;sum_dp=0;
+		#ifdef YADE_OPENMP
+		if (colored) {
+			for (unsigned int c=0; c+1<flat.colorPtr.size(); c++) {
+				const long first=flat.colorPtr[c], last=flat.colorPtr[c+1];
+				#pragma omp parallel for num_threads(ompThreads) private(dp) reduction(+:numFree,sum_p,sum_dp) reduction(max:dp_max,p_max) schedule(static)
+				for (long k=first; k<last; k++) {
+					const long i=flat.colorCells[k];
+					if (!flat.isFree[i]) continue;
+					numFree++;
+					dp=relaxCell(i);
+					dp_max = max(dp_max, std::abs(dp));
+					p_max = max(p_max, std::abs(p[i]));
+					sum_p += std::abs(p[i]);
+					sum_dp += std::abs(dp);
 				}
-				dp = cell->info().p();
-				if (n!=0 || j!=0) {
-					if (j==0) { if (compressible) cell->info().invSumK=1/(1+n); else cell->info().invSumK=1/n; }
-					if ( compressible ) {
-					/// COMPRESSIBLE cell->info().p() = ( (previousP - compFlowFactor*cell->info().dv()) + m ) / n ;
-						cell->info().p() = ( ((previousP[bb] - ((fluidBulkModulus*dt*cell->info().invVoidVolume())*(cell->info().dv()))) + m) * cell->info().invSumK - cell->info().p()) * relax + cell->info().p();
-					} else {
-					/// INCOMPRESSIBLE cell->info().p() =   - ( cell->info().dv() - m ) / ( n ) = ( -cell.info().dv() + m ) / n ;
-						cell->info().p() = (- (cell->info().dv() - m) * cell->info().invSumK - cell->info().p()) * relax + cell->info().p();
-					}
-					#ifdef GS_OPEN_MP
-					#endif
-				}
-                                dp -= cell->info().p();
-                                #ifdef GS_OPEN_MP
-                                const int tn=omp_get_thread_num();
-				t_sum_dp[tn] += std::abs(dp);
-				t_dp_max[tn]=max(t_dp_max[tn], std::abs(dp));
-				t_p_max[tn]= max(t_p_max[tn], std::abs(cell->info().p()));
-				t_sum_p[tn]+= std::abs(cell->info().p());
-				#else
-                                dp_max = max(dp_max, std::abs(dp));
-                                p_max = max(p_max, std::abs(cell->info().p()));
-                                sum_p += std::abs(cell->info().p());
-                                sum_dp += std::abs(dp);
-				#endif
-                        }
-                }
-                #ifdef GS_OPEN_MP
-
-                for (int ii=0;ii<num_threads;ii++) p_max =max(p_max, t_p_max[ii]);
-		for (int ii=0;ii<num_threads;ii++) dp_max =max(dp_max, t_dp_max[ii]);
-		for (int ii=0;ii<num_threads;ii++) sum_p+=t_sum_p[ii];
-                for (int ii=0;ii<num_threads;ii++) sum_dp+=t_sum_dp[ii];
-                #endif
-		p_moy = sum_p/cell2;
- 
-		#ifdef GS_OPEN_MP
-		#pragma omp master
+			}
+		} else
 		#endif
+                for (long i=0; i<size; i++) {
+			if (!flat.isFree[i]) continue;
+			numFree++;
+			dp=relaxCell(i);
+			dp_max = max(dp_max, std::abs(dp));
+			p_max = max(p_max, std::abs(p[i]));
+			sum_p += std::abs(p[i]);
+			sum_dp += std::abs(dp);
+                }
+		p_moy = sum_p/numFree;
 		j++;
-	#ifdef GS_OPEN_MP
-	} while (j<1500);
-	#else
-	} while ((dp_max/p_max) > tolerance /*&& j<4000*/ /*&& ( dp_max > tolerance )*//* &&*/ /*( j<50 )*/);
-	#endif
-	}
+	} while ((dp_max/p_max) > tolerance /*&& j<4000*/);
+	scatterFlatPressure();
         if (debugOut) {cout << "pmax " << p_max << "; pmoy : " << p_moy << endl;
         cout << "iteration " << j <<"; erreur : " << dp_max/p_max << endl;}
 	computedOnce=true;
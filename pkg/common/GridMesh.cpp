@@ -0,0 +1,120 @@
+#include<pkg/common/GridMesh.hpp>
+#include<pkg/common/Grid.hpp>
+#include<core/Scene.hpp>
+
+YADE_PLUGIN((GridMesh));
+
+GridMesh::~GridMesh(){}
+
+void GridMesh::update(const Scene* scene){
+	const int n=elements.size();
+	const Real inf=std::numeric_limits<Real>::infinity();
+	elemMin.resize(n); elemMax.resize(n);
+	const BodyContainer& bodies=*scene->bodies;
+	for(int i=0; i<n; i++){
+		if(bodies.exists(elements[i]) && bodies[elements[i]]->bound){ elemMin[i]=bodies[elements[i]]->bound->min; elemMax[i]=bodies[elements[i]]->bound->max; }
+		else { elemMin[i]=Vector3r(inf,inf,inf); elemMax[i]=Vector3r(-inf,-inf,-inf); }
+	}
+	// nodes move, a tree refitted for a long time would have overlapping siblings
+	if((int)bvhElements.size()!=n || ++updates>=rebuildInterval) buildBvh();
+	else refitBvh();
+}
+
+void GridMesh::buildBvh(){
+	bvh.clear(); bvhElements.clear(); updates=0;
+	const int n=elements.size();
+	if(n==0) return;
+	vector<Vector3r> centers(n);
+	bvhElements.resize(n);
+	for(int i=0; i<n; i++){
+		// elements without bound are kept in the tree with an empty box, their center is arbitrary
+		centers[i]=(elemMin[i].array()<=elemMax[i].array()).all() ? Vector3r(.5*(elemMin[i]+elemMax[i])) : Vector3r::Zero();
+		bvhElements[i]=i;
+	}
+	bvh.reserve(2*n/std::max(1,leafSize)+1);
+	buildBvhNode(0,n,centers);
+}
+
+int GridMesh::buildBvhNode(int first, int count, const vector<Vector3r>& centers){
+	const int idx=bvh.size();
+	bvh.push_back(BvhNode());
+	const Real inf=std::numeric_limits<Real>::infinity();
+	Vector3r mn(inf,inf,inf), mx(-inf,-inf,-inf), cMin(mn), cMax(mx);
+	for(int i=first; i<first+count; i++){
+		const int e=bvhElements[i];
+		mn=mn.cwiseMin(elemMin[e]); mx=mx.cwiseMax(elemMax[e]);
+		cMin=cMin.cwiseMin(centers[e]); cMax=cMax.cwiseMax(centers[e]);
+	}
+	// bvh may be reallocated by the recursion, always access the node by index
+	bvh[idx].min=mn; bvh[idx].max=mx; bvh[idx].first=first; bvh[idx].right=-1;
+	if(count<=std::max(1,leafSize)){ bvh[idx].count=count; return idx; }
+	bvh[idx].count=0;
+	// median split along the longest extent of centers, as in TriMesh::buildBvhNode
+	int axis; (cMax-cMin).maxCoeff(&axis);
+	const int mid=first+count/2;
+	std::nth_element(bvhElements.begin()+first,bvhElements.begin()+mid,bvhElements.begin()+first+count,[&centers,axis](int a, int b){ return centers[a][axis]<centers[b][axis]; });
+	buildBvhNode(first,mid-first,centers);
+	const int right=buildBvhNode(mid,first+count-mid,centers);
+	bvh[idx].right=right;
+	return idx;
+}
+
+void GridMesh::refitBvh(){
+	const Real inf=std::numeric_limits<Real>::infinity();
+	// children are stored after their parent, the reverse order visits them first
+	for(int idx=(int)bvh.size()-1; idx>=0; idx--){
+		BvhNode& node=bvh[idx];
+		if(node.count>0){
+			node.min=Vector3r(inf,inf,inf); node.max=Vector3r(-inf,-inf,-inf);
+			for(int i=node.first; i<node.first+node.count; i++){ node.min=node.min.cwiseMin(elemMin[bvhElements[i]]); node.max=node.max.cwiseMax(elemMax[bvhElements[i]]); }
+		} else {
+			node.min=bvh[idx+1].min.cwiseMin(bvh[node.right].min);
+			node.max=bvh[idx+1].max.cwiseMax(bvh[node.right].max);
+		}
+	}
+}
+
+void GridMesh::query(const Vector3r& mn, const Vector3r& mx, vector<Body::id_t>& ret) const {
+	if(bvh.empty()) return;
+	// the stack is deeper than any balanced tree of int-indexed elements
+	int stack[64], top=0;
+	stack[top++]=0;
+	while(top>0){
+		const int idx=stack[--top];
+		const BvhNode& node=bvh[idx];
+		if(!((node.min.array()<=mx.array()).all() && (node.max.array()>=mn.array()).all())) continue;
+		if(node.count>0){
+			for(int i=node.first; i<node.first+node.count; i++){
+				const int e=bvhElements[i];
+				if((elemMin[e].array()<=mx.array()).all() && (elemMax[e].array()>=mn.array()).all()) ret.push_back(elements[e]);
+			}
+			continue;
+		}
+		stack[top++]=node.right; stack[top++]=idx+1;
+	}
+}
+
+namespace {
+	int gridMeshElementNodes(const Body& b, const Body* nodes[3]){
+		const Shape* s=b.shape.get();
+		if(!s) return 0;
+		if(s->getClassIndex()==GridConnection::getClassIndexStatic()){
+			const GridConnection* c=static_cast<const GridConnection*>(s);
+			nodes[0]=c->node1.get(); nodes[1]=c->node2.get();
+			return 2;
+		}
+		if(s->getClassIndex()==PFacet::getClassIndexStatic()){
+			const PFacet* f=static_cast<const PFacet*>(s);
+			nodes[0]=f->node1.get(); nodes[1]=f->node2.get(); nodes[2]=f->node3.get();
+			return 3;
+		}
+		return 0;
+	}
+}
+
+bool GridMesh::adjacent(const Body& b1, const Body& b2){
+	const Body *n1[3], *n2[3];
+	const int k1=gridMeshElementNodes(b1,n1), k2=gridMeshElementNodes(b2,n2);
+	for(int i=0; i<k1; i++) for(int j=0; j<k2; j++) if(n1[i] && n1[i]==n2[j]) return true;
+	return false;
+}
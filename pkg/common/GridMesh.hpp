@@ -0,0 +1,51 @@
+#pragma once
+#include<core/Shape.hpp>
+#include<core/Body.hpp>
+
+class Scene;
+
+/*! Group of GridConnection and PFacet bodies (a membrane or a fibre network) seen by InsertionSortCollider as one body.
+
+Elements remain independent bodies with their own bounds, geometry functors and forces on their GridNodes; only the broad phase
+changes. Element bounds are kept in a bounding volume hierarchy, which is refitted at every run of the collider (nodes move, the
+topology of the tree is rebuilt every rebuildInterval runs); the collider sorts one box per mesh and finds the elements close to
+other bodies by querying the hierarchy.
+*/
+class GridMesh: public Shape{
+	public:
+		/*! Node of the hierarchy, stored depth-first as in TriMesh: the left child of an inner node follows it immediately.
+		Leaves have count>0 and refer to bvhElements[first..first+count). */
+		struct BvhNode{
+			Vector3r min, max;
+			int first, count, right;
+		};
+		vector<BvhNode> bvh;
+		// indices into elements, ordered so that every leaf refers to a contiguous range
+		vector<int> bvhElements;
+		// bounds of elements at the last update, empty (min>max) for elements without bound
+		vector<Vector3r> elemMin, elemMax;
+		//! Copy element bounds and refit the hierarchy, rebuild it if elements changed or every rebuildInterval updates
+		void update(const Scene* scene);
+		void buildBvh();
+		int buildBvhNode(int first, int count, const vector<Vector3r>& centers);
+		void refitBvh();
+		//! Append ids of elements whose bounds overlap the box [mn,mx]
+		void query(const Vector3r& mn, const Vector3r& mx, vector<Body::id_t>& ret) const;
+		//! Whether two elements (GridConnection or PFacet) share a GridNode; such elements never collide
+		static bool adjacent(const Body& b1, const Body& b2);
+		int nNodes() const { return bvh.size(); }
+		virtual ~GridMesh();
+	YADE_CLASS_BASE_DOC_ATTRS_CTOR_PY(GridMesh,Shape,"Membrane or fibre network made of :yref:`GridConnection` and :yref:`PFacet` bodies, collided as one body by :yref:`InsertionSortCollider` (aperiodic simulations only). The collider sorts one bound per mesh, enclosing the bounds of its :yref:`elements<GridMesh.elements>`, instead of one bound per element; elements close to other bodies are then found in a bounding volume hierarchy of element bounds, refitted at every run of the collider. Elements of the mesh colliding with each other are found in the same hierarchy if :yref:`selfCollide<GridMesh.selfCollide>` is set; elements sharing a :yref:`GridNode` are skipped at this stage, since their geometry functors would reject them anyway. Contacts are still computed by the usual functors for GridConnections and PFacets, with forces applied to the nodes; :yref:`GridNodes<GridNode>` keep their own bounds in the collider. The body of the mesh should be non-dynamic and unbounded, see :yref:`yade.gridpfacet.gridMesh`.",
+		((vector<Body::id_t>,elements,,,"Ids of :yref:`GridConnection` and :yref:`PFacet` bodies of the mesh; GridNodes should not be listed."))
+		((bool,selfCollide,true,,"Find contacts between elements of the mesh (not sharing a node)."))
+		((int,leafSize,4,,"Maximum number of elements in leaves of the hierarchy."))
+		((int,rebuildInterval,50,,"Number of updates after which the hierarchy is rebuilt, rather than only refitted to the current bounds of elements."))
+		((int,updates,0,Attr::readonly,"Number of updates since the hierarchy was built."))
+		,
+		/*ctor*/ createIndex();
+		,
+		.add_property("bvhNodes",&GridMesh::nNodes,"Number of nodes of the bounding volume hierarchy (read-only).")
+	);
+	REGISTER_CLASS_INDEX(GridMesh,Shape);
+};
+REGISTER_SERIALIZABLE(GridMesh);
@@ -6,6 +6,7 @@
 #include<pkg/common/Sphere.hpp>
 #include<lib/smoothing/LinearInterpolate.hpp>
 #include<pkg/dem/Shop.hpp>
+#include<lib/base/openmp-accu.hpp>
 
 #include<core/IGeom.hpp>
 #include<core/IPhys.hpp>
@@ -17,10 +18,22 @@
 YADE_PLUGIN((HydroForceEngine));
 
 void HydroForceEngine::action(){
+	/* Coupling with the fluid resolution, without going through python */
+	if (fluidResolIterPeriod>0 && (lastFluidResolIter<0 || scene->iter-lastFluidResolIter>=fluidResolIterPeriod)){
+		const double tfin = (lastFluidResolIter<0 ? fluidResolIterPeriod : scene->iter-lastFluidResolIter)*scene->dt;
+		averageProfile();
+		fluidResolution(tfin,dtFluid);
+		lastFluidResolIter = scene->iter;
+	}
 	/* Application of hydrodynamical forces */
         Vector3r gravityBuoyancy = gravity;
 	if (steadyFlow==true) gravityBuoyancy[0] = 0.;// If the fluid flow is steady, no streamwise buoyancy contribution from gravity
-	FOREACH(Body::id_t id, ids){
+	const long nIds = ids.size();
+	#ifdef YADE_OPENMP
+	#pragma omp parallel for schedule(guided)
+	#endif
+	for(long i=0; i<nIds; i++){
+		const Body::id_t id = ids[i];
 		Body* b=Body::byId(id,scene).get();
 		if (!b) continue;
 		if (!(scene->bodies->exists(id))) continue;
@@ -57,90 +70,76 @@ void HydroForceEngine::action(){
 }
 
 void HydroForceEngine::averageProfile(){
-	//Initialization
-	int minZ;
-	int maxZ;
-	int numLayer;
-	double deltaCenter;
-	double zInf;
-	double zSup;
-	double volPart;
-	Vector3r uRel = Vector3r::Zero();
-	Vector3r fDrag  = Vector3r::Zero();
-
 	int nMax = nCell;
-	vector<double> velAverageX(nMax,0.0);
-        vector<double> velAverageY(nMax,0.0);
-        vector<double> velAverageZ(nMax,0.0);
-	vector<double> phiAverage(nMax,0.0);
-	vector<double> dragAverage(nMax,0.0);
-	vector<double> phiAverage1(nMax,0.0);
-	vector<double> dragAverage1(nMax,0.0);
-	vector<double> velAverageX1(nMax,0.0);
-        vector<double> velAverageY1(nMax,0.0);
-        vector<double> velAverageZ1(nMax,0.0);
-	vector<double> phiAverage2(nMax,0.0);
-	vector<double> dragAverage2(nMax,0.0);
-	vector<double> velAverageX2(nMax,0.0);
-        vector<double> velAverageY2(nMax,0.0);
-        vector<double> velAverageZ2(nMax,0.0);
+	// volume-weighted sums of all slices, accumulated per thread and summed at the end
+	enum { PHI, VX, VY, VZ, DRAG, PHI1, VX1, VY1, VZ1, DRAG1, PHI2, VX2, VY2, VZ2, DRAG2, NQUANT };
+	OpenMPArrayAccumulator<Real> accu(NQUANT*nMax);
 
 	//Loop over the particles
-	FOREACH(const shared_ptr<Body>& b, *Omega::instance().getScene()->bodies){
-		shared_ptr<Sphere> s=YADE_PTR_DYN_CAST<Sphere>(b->shape); if(!s) continue;
+	const shared_ptr<BodyContainer>& bodies = Omega::instance().getScene()->bodies;
+	const long nBodies = bodies->size();
+	#ifdef YADE_OPENMP
+	#pragma omp parallel for schedule(guided)
+	#endif
+	for(long id=0; id<nBodies; id++){
+		const shared_ptr<Body>& b = (*bodies)[id];
+		if(!b) continue;
+		const Sphere* s = dynamic_cast<Sphere*>(b->shape.get()); if(!s) continue;
 		const double zPos = b->state->pos[2]-zRef;
 		int Np = floor(zPos/deltaZ);	//Define the layer number with 0 corresponding to zRef. Let the z position wrt to zero, that way all z altitude are positive. (otherwise problem with volPart evaluation)
 		if ((b->state->blockedDOFs==State::DOF_ALL)&&(zPos > s->radius)) continue;// to remove contribution from the fixed particles on the sidewalls.
 
 		// Relative fluid/particle velocity using also the associated fluid vel. fluct. 
+		Vector3r fDrag = Vector3r::Zero();
 		if ((Np>=0)&&(Np<nCell)){
-			uRel = Vector3r(vxFluid[Np]+vFluctX[b->id], vFluctY[b->id],vFluctZ[b->id]) - b->state->vel;
+			Vector3r uRel = Vector3r(vxFluid[Np]+vFluctX[b->id], vFluctY[b->id],vFluctZ[b->id]) - b->state->vel;
 			// Drag force with a Dallavalle formulation (drag coef.) and Richardson-Zaki Correction (hindrance effect)
 			fDrag = 0.5*Mathr::PI*pow(s->radius,2.0)*densFluid*(0.44*uRel.norm()+24.4*viscoDyn/(densFluid*2.0*s->radius))*pow((1-phiPart[Np]),-expoRZ)*uRel;
 		}
-		else fDrag = Vector3r::Zero();
 
-		minZ= floor((zPos-s->radius)/deltaZ);
-		maxZ= floor((zPos+s->radius)/deltaZ);
-		deltaCenter = zPos - Np*deltaZ;
+		const int minZ= floor((zPos-s->radius)/deltaZ);
+		const int maxZ= floor((zPos+s->radius)/deltaZ);
+		const double deltaCenter = zPos - Np*deltaZ;
+		const Vector3r& vel = b->state->vel;
+		// particles of type 1 or 2 also contribute to the partial profiles
+		const bool type1 = (twoSize==true) && (s->radius==radiusPart1);
+		const bool type2 = (twoSize==true) && (s->radius==radiusPart2);
 	
 		// Loop over the cell in which the particle is contained
-		numLayer = minZ;
-		while (numLayer<=maxZ){
-			if ((numLayer>=0)&&(numLayer<nMax)){ //average under zRef does not interest us, avoid also negative values not compatible with the evaluation of volPart
-				zInf=(numLayer-Np-1)*deltaZ + deltaCenter;
-				zSup=(numLayer-Np)*deltaZ + deltaCenter;
-				if (zInf<-s->radius) zInf = -s->radius;
-				if (zSup>s->radius) zSup = s->radius;
-
-				//Analytical formulation of the volume of a slice of sphere
-				volPart = Mathr::PI*pow(s->radius,2)*(zSup - zInf +(pow(zInf,3)-pow(zSup,3))/(3*pow(s->radius,2)));
-
-				phiAverage[numLayer]+=volPart;
-				velAverageX[numLayer]+=volPart*b->state->vel[0];
-                                velAverageY[numLayer]+=volPart*b->state->vel[1];
-                                velAverageZ[numLayer]+=volPart*b->state->vel[2];
-				dragAverage[numLayer]+=volPart*fDrag[0];
-				if (twoSize==true){
-					if (s->radius==radiusPart1){
-						phiAverage1[numLayer]+=volPart; 
-						dragAverage1[numLayer]+=volPart*fDrag[0];
-						velAverageX1[numLayer]+=volPart*b->state->vel[0];
-						velAverageY1[numLayer]+=volPart*b->state->vel[1];
-						velAverageZ1[numLayer]+=volPart*b->state->vel[2];
-					}
-					if (s->radius==radiusPart2){
-						phiAverage2[numLayer]+=volPart;
-						dragAverage2[numLayer]+=volPart*fDrag[0];
-						velAverageX2[numLayer]+=volPart*b->state->vel[0];
-						velAverageY2[numLayer]+=volPart*b->state->vel[1];
-						velAverageZ2[numLayer]+=volPart*b->state->vel[2];
-					}
-				}
+		for (int numLayer=std::max(minZ,0); numLayer<=std::min(maxZ,nMax-1); numLayer++){ //average under zRef does not interest us, avoid also negative values not compatible with the evaluation of volPart
+			double zInf=(numLayer-Np-1)*deltaZ + deltaCenter;
+			double zSup=(numLayer-Np)*deltaZ + deltaCenter;
+			if (zInf<-s->radius) zInf = -s->radius;
+			if (zSup>s->radius) zSup = s->radius;
+
+			//Analytical formulation of the volume of a slice of sphere
+			const double volPart = Mathr::PI*pow(s->radius,2)*(zSup - zInf +(pow(zInf,3)-pow(zSup,3))/(3*pow(s->radius,2)));
+
+			accu.add(PHI*nMax+numLayer,volPart);
+			accu.add(VX*nMax+numLayer,volPart*vel[0]);
+			accu.add(VY*nMax+numLayer,volPart*vel[1]);
+			accu.add(VZ*nMax+numLayer,volPart*vel[2]);
+			accu.add(DRAG*nMax+numLayer,volPart*fDrag[0]);
+			for (int t=1; t<=2; t++){
+				if (!(t==1 ? type1 : type2)) continue;
+				const int off = (t==1) ? PHI1 : PHI2;
+				accu.add((off+PHI)*nMax+numLayer,volPart);
+				accu.add((off+VX)*nMax+numLayer,volPart*vel[0]);
+				accu.add((off+VY)*nMax+numLayer,volPart*vel[1]);
+				accu.add((off+VZ)*nMax+numLayer,volPart*vel[2]);
+				accu.add((off+DRAG)*nMax+numLayer,volPart*fDrag[0]);
 			}
-			numLayer+=1;
 		}
 	}
+	// reduction over threads
+	vector<double> velAverageX(nMax), velAverageY(nMax), velAverageZ(nMax), phiAverage(nMax), dragAverage(nMax);
+	vector<double> phiAverage1(nMax), dragAverage1(nMax), velAverageX1(nMax), velAverageY1(nMax), velAverageZ1(nMax);
+	vector<double> phiAverage2(nMax), dragAverage2(nMax), velAverageX2(nMax), velAverageY2(nMax), velAverageZ2(nMax);
+	for(int n=0;n<nMax;n++){
+		phiAverage[n]=accu.get(PHI*nMax+n); velAverageX[n]=accu.get(VX*nMax+n); velAverageY[n]=accu.get(VY*nMax+n); velAverageZ[n]=accu.get(VZ*nMax+n); dragAverage[n]=accu.get(DRAG*nMax+n);
+		phiAverage1[n]=accu.get(PHI1*nMax+n); velAverageX1[n]=accu.get(VX1*nMax+n); velAverageY1[n]=accu.get(VY1*nMax+n); velAverageZ1[n]=accu.get(VZ1*nMax+n); dragAverage1[n]=accu.get(DRAG1*nMax+n);
+		phiAverage2[n]=accu.get(PHI2*nMax+n); velAverageX2[n]=accu.get(VX2*nMax+n); velAverageY2[n]=accu.get(VY2*nMax+n); velAverageZ2[n]=accu.get(VZ2*nMax+n); dragAverage2[n]=accu.get(DRAG2*nMax+n);
+	}
 	//Normalized the weighted velocity by the volume of particles contained inside the cell
 	for(int n=0;n<nMax;n++){
 		if (phiAverage[n]!=0){
@@ -48,6 +48,9 @@ class HydroForceEngine: public PartialEngine{
 		((int,viscousSubLayer,0,,"Fluid resolution: solve the viscous sublayer close to the bottom boundary if set to 1"))
 		((bool,fluidWallFriction,false,,"Fluid resolution: if set to true, introduce a sink term to account for the fluid friction at the wall, see [Maurin2015]_ for details. Requires to set the width of the channel. It might slow down significantly the calculation."))
 		((double,channelWidth,1.,,"Fluid resolution: Channel width for the evaluation of the fluid wall friction inside the fluid resolution."))
+		((int,fluidResolIterPeriod,0,,"Fluid resolution: if positive, :yref:`averageProfile<HydroForceEngine.averageProfile>` and :yref:`fluidResolution<HydroForceEngine.fluidResolution>` are called by the engine itself every fluidResolIterPeriod iterations (and at its first run), before applying the fluid forces; the fluid is solved for the time elapsed since the last resolution with the time step :yref:`dtFluid<HydroForceEngine.dtFluid>`. Avoids calling both functions from a :yref:`PyRunner`."))
+		((double,dtFluid,1e-5,,"Fluid resolution: time step of the fluid resolution when called by the engine itself (see :yref:`fluidResolIterPeriod<HydroForceEngine.fluidResolIterPeriod>`)."))
+		((long,lastFluidResolIter,-1,,"Fluid resolution: iteration of the last fluid resolution done by the engine itself (see :yref:`fluidResolIterPeriod<HydroForceEngine.fluidResolIterPeriod>`); set to -1 to force the resolution at the next step."))
 		//// Particle averaged depth profiles
 		((vector<double>,phiPart,,,"Discretized solid volume fraction depth profile. Can be taken as input parameter or evaluated directly inside the engine, calling from python the averageProfile() function"))
 		((vector<double>,vxPart,,,"Discretized streamwise solid velocity depth profile. Can be taken as input parameter, or evaluated directly inside the engine, calling from python the averageProfile() function"))
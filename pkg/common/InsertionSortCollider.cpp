@@ -8,6 +8,8 @@
 #include<pkg/common/Dispatching.hpp>
 #include<pkg/dem/NewtonIntegrator.hpp>
 #include<pkg/common/Sphere.hpp>
+#include<core/Clump.hpp>
+#include<pkg/common/GridMesh.hpp>
 
 #include<boost/static_assert.hpp>
 #ifdef YADE_OPENMP
@@ -22,10 +24,174 @@ CREATE_LOGGER(InsertionSortCollider);
 void InsertionSortCollider::handleBoundInversion(Body::id_t id1, Body::id_t id2, InteractionContainer* interactions, Scene*){
 	assert(!periodic);
 	assert(id1!=id2);
-	if (spatialOverlap(id1,id2) && Collider::mayCollide(Body::byId(id1,scene).get(),Body::byId(id2,scene).get()) && !interactions->found(id1,id2))
+	if(!spatialOverlap(id1,id2)) return;
+	if(isGroupPair(id1,id2)){ groupPairs.push_back(std::make_pair(min(id1,id2),max(id1,id2))); return; }
+	const Body* b1=Body::byId(id1,scene).get(); const Body* b2=Body::byId(id2,scene).get();
+	if(Collider::mayCollide(b1,b2) && !interactions->found(id1,id2))
 		interactions->insert(shared_ptr<Interaction>(new Interaction(id1,id2)));
 }
 
+void InsertionSortCollider::insertPotentialPair(Body::id_t id1, Body::id_t id2, InteractionContainer* interactions){
+	if(isGroupPair(id1,id2)){ groupPairs.push_back(std::make_pair(min(id1,id2),max(id1,id2))); return; }
+	if(!interactions->found(id1,id2)) interactions->insert(shared_ptr<Interaction>(new Interaction(id1,id2)));
+}
+
+void InsertionSortCollider::updateGroupList(){
+	groups.clear(); hasGridMesh=false;
+	const BodyContainer& bodies=*scene->bodies;
+	const int gridMeshIndex=GridMesh::getClassIndexStatic();
+	for(size_t id=0; id<bodies.size(); id++){
+		const shared_ptr<Body>& b=bodies[id];
+		if(!b) continue;
+		const bool isMesh=(b->shape && b->shape->getClassIndex()==gridMeshIndex);
+		if(isMesh || b->isClump()) groups.push_back(id);
+		hasGridMesh|=isMesh;
+	}
+	groupsContainer=scene->bodies.get(); groupsRevision=scene->bodies->revision;
+}
+
+/* Bounds of groups enclose bounds of their members; groups without bounded members get an empty box (min>max).
+Clumps are only groups if clumpLevel is set, grid meshes always are. */
+void InsertionSortCollider::updateGroupBounds(){
+	groupRole.assign(scene->bodies->size(),0);
+	const long nGroups=groups.size();
+	const Real inf=std::numeric_limits<Real>::infinity();
+	// members are distinct for all groups, roles are written by one thread each
+	#ifdef YADE_OPENMP
+	#pragma omp parallel for schedule(dynamic,1) num_threads(ompThreads>0 ? min(ompThreads,omp_get_max_threads()) : omp_get_max_threads())
+	#endif
+	for(long g=0; g<nGroups; g++){
+		const Body::id_t id=groups[g];
+		const shared_ptr<Body>& b=Body::byId(id,scene);
+		if(!b) continue;
+		Vector3r mn(inf,inf,inf), mx(-inf,-inf,-inf);
+		if(b->isClump()){
+			if(!clumpLevel) continue;
+			Clump* clump=static_cast<Clump*>(b->shape.get());
+			if(clump->memberIds.size()!=clump->members.size()) clump->updateMemberArrays();
+			FOREACH(const Body::id_t& memberId, clump->memberIds){
+				const shared_ptr<Body>& m=Body::byId(memberId,scene);
+				if(!m) continue;
+				groupRole[memberId]=2;
+				if(!m->bound) continue;
+				mn=mn.cwiseMin(m->bound->min); mx=mx.cwiseMax(m->bound->max);
+			}
+		} else {
+			GridMesh* mesh=static_cast<GridMesh*>(b->shape.get());
+			mesh->update(scene);
+			FOREACH(const Body::id_t& e, mesh->elements){ if(scene->bodies->exists(e)) groupRole[e]=2; }
+			if(!mesh->bvh.empty()){ mn=mesh->bvh[0].min; mx=mesh->bvh[0].max; }
+		}
+		groupRole[id]=1;
+		for(int k=0; k<3; k++){ minima[3*id+k]=mn[k]; maxima[3*id+k]=mx[k]; }
+	}
+}
+
+/* Members of two groups (or of a group and a standalone body) with overlapping bounds. Members of clumps are filtered
+by the intersection of both bounds; elements of a grid mesh are found in its hierarchy, for the intersection or for every
+candidate member of the other body. Candidates are then tested with their own bounds, as the flat sort would, so that both
+create the same potential interactions. */
+void InsertionSortCollider::collideGroupPair(Body::id_t id1, Body::id_t id2, InteractionContainer* interactions, std::vector<std::pair<Body::id_t,Body::id_t> >& ret) const {
+	Body::id_t ids[2]={id1,id2};
+	const GridMesh* meshes[2];
+	for(int i=0; i<2; i++){
+		const shared_ptr<Body>& b=Body::byId(ids[i],scene);
+		meshes[i]=(groupRole[ids[i]]==1 && !b->isClump()) ? static_cast<GridMesh*>(b->shape.get()) : NULL;
+	}
+	// the hierarchy is queried for the other side
+	if(meshes[0] && !meshes[1]){ std::swap(ids[0],ids[1]); std::swap(meshes[0],meshes[1]); }
+	Vector3r lo, hi;
+	for(int k=0; k<3; k++){ lo[k]=max(minima[3*id1+k],minima[3*id2+k]); hi[k]=min(maxima[3*id1+k],maxima[3*id2+k]); }
+	// only members overlapping the intersection of both bounds may collide with the other body
+	std::vector<Body::id_t> members;
+	const shared_ptr<Body>& b=Body::byId(ids[0],scene);
+	if(meshes[0]) meshes[0]->query(lo,hi,members);
+	else if(!b->isClump() || groupRole[ids[0]]!=1){ if(b->bound) members.push_back(ids[0]); }
+	else FOREACH(const Body::id_t& memberId, static_cast<Clump*>(b->shape.get())->memberIds){
+		const shared_ptr<Body>& m=Body::byId(memberId,scene);
+		if(!m || !m->bound) continue;
+		if((m->bound->min.array()<=hi.array()).all() && (m->bound->max.array()>=lo.array()).all()) members.push_back(memberId);
+	}
+	std::vector<Body::id_t> others;
+	if(!meshes[1]){
+		// the other side is a clump (members filtered as above) or a standalone body
+		const shared_ptr<Body>& b2=Body::byId(ids[1],scene);
+		if(!b2->isClump() || groupRole[ids[1]]!=1){ if(b2->bound) others.push_back(ids[1]); }
+		else FOREACH(const Body::id_t& memberId, static_cast<Clump*>(b2->shape.get())->memberIds){
+			const shared_ptr<Body>& m=Body::byId(memberId,scene);
+			if(!m || !m->bound) continue;
+			if((m->bound->min.array()<=hi.array()).all() && (m->bound->max.array()>=lo.array()).all()) others.push_back(memberId);
+		}
+	}
+	FOREACH(const Body::id_t& m1, members){
+		const Body* mb1=Body::byId(m1,scene).get();
+		if(meshes[1]){
+			others.clear();
+			meshes[1]->query(Vector3r(minima[3*m1],minima[3*m1+1],minima[3*m1+2]),Vector3r(maxima[3*m1],maxima[3*m1+1],maxima[3*m1+2]),others);
+		}
+		FOREACH(const Body::id_t& m2, others){
+			const Body* mb2=Body::byId(m2,scene).get();
+			if(meshes[0] && meshes[1] && GridMesh::adjacent(*mb1,*mb2)) continue;
+			if(spatialOverlap(m1,m2) && Collider::mayCollide(mb1,mb2) && !interactions->found(m1,m2)) ret.push_back(std::make_pair(m1,m2));
+		}
+	}
+}
+
+// elements of one grid mesh colliding with each other; elements sharing a node are skipped, their geometry functors reject them
+void InsertionSortCollider::collideGridMeshSelf(Body::id_t id, InteractionContainer* interactions, std::vector<std::pair<Body::id_t,Body::id_t> >& ret) const {
+	const GridMesh* mesh=static_cast<GridMesh*>(Body::byId(id,scene)->shape.get());
+	std::vector<Body::id_t> others;
+	FOREACH(const Body::id_t& e1, mesh->elements){
+		if(groupRole[e1]!=2) continue;
+		const Body* b1=Body::byId(e1,scene).get();
+		if(!b1->bound) continue;
+		others.clear();
+		mesh->query(b1->bound->min,b1->bound->max,others);
+		FOREACH(const Body::id_t& e2, others){
+			// each pair once
+			if(e2<=e1) continue;
+			const Body* b2=Body::byId(e2,scene).get();
+			if(GridMesh::adjacent(*b1,*b2)) continue;
+			if(spatialOverlap(e1,e2) && Collider::mayCollide(b1,b2) && !interactions->found(e1,e2)) ret.push_back(std::make_pair(e1,e2));
+		}
+	}
+}
+
+void InsertionSortCollider::collideGroupPairs(InteractionContainer* interactions){
+	std::sort(groupPairs.begin(),groupPairs.end());
+	groupPairs.erase(std::unique(groupPairs.begin(),groupPairs.end()),groupPairs.end());
+	// forget pairs which ceased to overlap, they will be found again by the sort if they do
+	size_t n=0;
+	for(size_t i=0; i<groupPairs.size(); i++){
+		const Body::id_t& id1=groupPairs[i].first; const Body::id_t& id2=groupPairs[i].second;
+		if(!Body::byId(id1,scene) || !Body::byId(id2,scene) || !isGroupPair(id1,id2) || !spatialOverlap(id1,id2)) continue;
+		groupPairs[n++]=groupPairs[i];
+	}
+	groupPairs.resize(n);
+	// self-collision of grid meshes is appended as pairs (id,id)
+	std::vector<Body::id_t> selfMeshes;
+	FOREACH(const Body::id_t& id, groups){ if(groupRole[id]==1 && !Body::byId(id,scene)->isClump() && static_cast<GridMesh*>(Body::byId(id,scene)->shape.get())->selfCollide) selfMeshes.push_back(id); }
+	const long nPairs=n, nTasks=n+selfMeshes.size();
+	#ifdef YADE_OPENMP
+		std::vector<std::vector<std::pair<Body::id_t,Body::id_t> > > newInts(ompThreads);
+		#pragma omp parallel for schedule(dynamic,16) num_threads(ompThreads)
+		for(long i=0; i<nTasks; i++){
+			if(i<nPairs) collideGroupPair(groupPairs[i].first,groupPairs[i].second,interactions,newInts[omp_get_thread_num()]);
+			else collideGridMeshSelf(selfMeshes[i-nPairs],interactions,newInts[omp_get_thread_num()]);
+		}
+		// the same members may be found from different threads
+		for(int t=0; t<ompThreads; t++) for(size_t k=0; k<newInts[t].size(); k++)
+			if(!interactions->found(newInts[t][k].first,newInts[t][k].second)) interactions->insert(shared_ptr<Interaction>(new Interaction(newInts[t][k].first,newInts[t][k].second)));
+	#else
+		std::vector<std::pair<Body::id_t,Body::id_t> > newInts;
+		for(long i=0; i<nTasks; i++){
+			if(i<nPairs) collideGroupPair(groupPairs[i].first,groupPairs[i].second,interactions,newInts);
+			else collideGridMeshSelf(selfMeshes[i-nPairs],interactions,newInts);
+		}
+		for(size_t k=0; k<newInts.size(); k++) if(!interactions->found(newInts[k].first,newInts[k].second)) interactions->insert(shared_ptr<Interaction>(new Interaction(newInts[k].first,newInts[k].second)));
+	#endif
+}
+
 void InsertionSortCollider::insertionSort(VecBounds& v, InteractionContainer* interactions, Scene*, bool doCollide){
 	assert(!periodic);
 	assert(v.size==(long)v.vec.size());
@@ -91,7 +257,7 @@ void InsertionSortCollider::insertionSortParallel(VecBounds& v, InteractionConta
 				v[j+1]=v[j];
 				if(isMin && !v[j].flags.isMin && doCollide && viInitBB && v[j].flags.hasBB && (viInit.id!=v[j].id)) {
 					const Body::id_t& id1 = v[j].id; const Body::id_t& id2 = viInit.id; 
-					if (spatialOverlap(id1,id2) && Collider::mayCollide(Body::byId(id1,scene).get(),Body::byId(id2,scene).get()) && !interactions->found(id1,id2))
+					if (spatialOverlap(id1,id2) && (isGroupPair(id1,id2) || (Collider::mayCollide(Body::byId(id1,scene).get(),Body::byId(id2,scene).get()) && !interactions->found(id1,id2))))
 						newInteractions[threadNum].push_back(std::pair<Body::id_t,Body::id_t>(v[j].id,viInit.id));
 				}
 				j--;
@@ -119,7 +285,7 @@ void InsertionSortCollider::insertionSortParallel(VecBounds& v, InteractionConta
 				if(isMin && !v[j].flags.isMin && doCollide && viInitBB && v[j].flags.hasBB && (viInit.id!=v[j].id)) {
 					const Body::id_t& id1 = v[j].id; const Body::id_t& id2 = viInit.id;
 					//FIXME: do we need the check with found(id1,id2) here? It is checked again below...
-					if (spatialOverlap(id1,id2) && Collider::mayCollide(Body::byId(id1,scene).get(),Body::byId(id2,scene).get()) && !interactions->found(id1,id2))
+					if (spatialOverlap(id1,id2) && (isGroupPair(id1,id2) || (Collider::mayCollide(Body::byId(id1,scene).get(),Body::byId(id2,scene).get()) && !interactions->found(id1,id2))))
 						newInteractions[threadNum].push_back(std::pair<Body::id_t,Body::id_t>(v[j].id,viInit.id));}
 				j--;
 			}
@@ -131,8 +297,8 @@ void InsertionSortCollider::insertionSortParallel(VecBounds& v, InteractionConta
 	/// Now insert interactions sequentially
 	for (int n=0;n<ompThreads;n++)
 		for (size_t k=0, kend=newInteractions[n].size();k<kend;k++)
-			/*if (!interactions->found(newInteractions[n][k].first,newInteractions[n][k].second))*/ //Not needed, already checked above
-			interactions->insert(shared_ptr<Interaction>(new Interaction(newInteractions[n][k].first,newInteractions[n][k].second)));
+			/*if (!interactions->found(newInteractions[n][k].first,newInteractions[n][k].second))*/ //Not needed, already checked above (checked again by insertPotentialPair, cheap)
+			insertPotentialPair(newInteractions[n][k].first,newInteractions[n][k].second,interactions);
 	/// If some bounds traversed more than a half-chunk, we complete colliding with the sequential sort
 	if (parallelFailed) return insertionSort(v,interactions, scene, doCollide);
 #endif
@@ -146,7 +312,8 @@ vector<Body::id_t> InsertionSortCollider::probeBoundingVolume(const Bound& bv){
 			it=BB[0].vec.begin(),et=BB[0].vec.end(); it < et; ++it)
 	{		
 		if (it->coord > bv.max[0]) break;
-		if (!it->flags.isMin || !it->flags.hasBB) continue;
+		// hasBB is false for members of groups if they are collided in two levels, check the bound below instead
+		if (!it->flags.isMin) continue;
 		int offset = 3*it->id;
 		const shared_ptr<Body>& b=Body::byId(it->id,scene);
 		if(!b || !b->bound) continue;
@@ -195,6 +362,14 @@ void InsertionSortCollider::action(){
 		for(int i=0; i<3; i++) BB[i].vec.clear();
 		periodic=scene->isPeriodic;
 	}
+	// switching two-level collision of clumps or grid meshes on or off, force reinit
+	if(groupsContainer!=scene->bodies.get() || groupsRevision!=scene->bodies->revision) updateGroupList();
+	if((clumpLevel || hasGridMesh) && periodic){ static bool warnOnce=false; if(!warnOnce){ warnOnce=true; LOG_WARN("Two-level collision (clumpLevel, GridMesh) is not implemented for periodic simulations, clumps and grid elements are collided as usual."); } }
+	if(twoLevelActive!=((clumpLevel || hasGridMesh) && !periodic)){
+		twoLevelActive=((clumpLevel || hasGridMesh) && !periodic);
+		groupPairs.clear();
+		doSort=true;
+	}
 	// pre-conditions
 		// adjust storage size
 		bool doInitSort=false;
@@ -276,6 +451,7 @@ void InsertionSortCollider::action(){
 				newton->updatingDispFactor=updatingDispFactor;
 			} else boundDispatcher->sweepDist=0;
 
+	if(twoLevelActive) updateGroupBounds();
 	ISC_CHECKPOINT("bound");
 
 	// copy bounds along given axis into our arrays 
@@ -287,7 +463,11 @@ void InsertionSortCollider::action(){
 				Bounds& BBji = BBj[i];
 				const Body::id_t id=BBji.id;
 				const shared_ptr<Body>& b=Body::byId(id,scene);
-				if(b){
+				if(b && twoLevelActive && groupRole[id]==1){
+					// bounds from updateGroupBounds, always aperiodic
+					BBji.flags.hasBB=(minima[3*id+j]<=maxima[3*id+j]);
+					BBji.coord=BBji.flags.hasBB ? (BBji.flags.isMin ? minima[3*id+j] : maxima[3*id+j]) : b->state->pos[j];
+				} else if(b){
 					const shared_ptr<Bound>& bv=b->bound;
 					// coordinate is min/max if has bounding volume, otherwise both are the position. Add periodic shift so that we are inside the cell
 					// watch out for the parentheses around ?: within ?: (there was unwanted conversion of the Reals to bools!)
@@ -299,6 +479,8 @@ void InsertionSortCollider::action(){
 					if (BBji.flags.isMin && j==1 &&bv) {
 						 memcpy(&minima[3*id],&bv->min,3*sizeof(Real)); memcpy(&maxima[3*id],&bv->max,3*sizeof(Real)); 
 					}					
+					// members only collide within collideGroupPairs
+					if(twoLevelActive && groupRole[id]==2) BBji.flags.hasBB=false;
 				} else { BBj[i].flags.hasBB=false; /* for vanished body, keep the coordinate as-is, to minimize inversions. */ }
 			}
 		}
@@ -326,6 +508,8 @@ void InsertionSortCollider::action(){
 		}
 		// create initial interactions (much slower)
 		else {
+			// all overlapping group pairs are found again below
+			groupPairs.clear();
 			if(doInitSort){
 				// the initial sort is in independent in 3 dimensions, may be run in parallel; it seems that there is no time gain running in parallel, though
 				// important to reset loInx for periodic simulation (!!)
@@ -357,13 +541,12 @@ void InsertionSortCollider::action(){
 						const Body::id_t& jid=V[j].id;
 						// take 2 of the same condition (only handle collision [min_i..max_i]+min_j, not [min_i..max_i]+min_i (symmetric)
 						if(!(V[j].flags.isMin && V[j].flags.hasBB)) continue;
-						if (spatialOverlap(iid,jid) && Collider::mayCollide(Body::byId(iid,scene).get(),Body::byId(jid,scene).get()) ){
+						if (spatialOverlap(iid,jid) && (isGroupPair(iid,jid) || Collider::mayCollide(Body::byId(iid,scene).get(),Body::byId(jid,scene).get())) ){
 						#ifdef YADE_OPENMP
 							unsigned int threadNum = omp_get_thread_num();
 							newInts[threadNum].push_back(std::pair<Body::id_t,Body::id_t>(iid,jid));
 						#else
-							if (!interactions->found(iid,jid))
-							interactions->insert(shared_ptr<Interaction>(new Interaction(iid,jid)));
+							insertPotentialPair(iid,jid,interactions);
 						#endif
 						}
 					}
@@ -371,8 +554,7 @@ void InsertionSortCollider::action(){
 				//go through newly created candidates sequentially, duplicates coming from different threads may exist so we check existence with found()
 				#ifdef YADE_OPENMP
 				for (int n=0;n<ompThreads;n++) for (size_t k=0, kend=newInts[n].size();k<kend;k++)
-					if (!interactions->found(newInts[n][k].first,newInts[n][k].second))
-						interactions->insert(shared_ptr<Interaction>(new Interaction(newInts[n][k].first,newInts[n][k].second)));
+					insertPotentialPair(newInts[n][k].first,newInts[n][k].second,interactions);
 				#endif
 			} else { // periodic case: see comments above
 				for(long i=0; i<2*nBodies; i++){
@@ -388,6 +570,10 @@ void InsertionSortCollider::action(){
 			}
 		}
 	ISC_CHECKPOINT("sort&collide");
+	if(twoLevelActive){
+		collideGroupPairs(interactions);
+		ISC_CHECKPOINT("groups");
+	}
 }
 
 
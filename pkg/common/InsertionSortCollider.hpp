@@ -132,6 +132,17 @@ class InsertionSortCollider: public Collider{
 	bool periodic;
 	//! Store inverse sizes to avoid repeated divisions within loops 
 	Vector3r invSizes;
+	//! Whether groups (clumps if clumpLevel, GridMesh bodies) are collided as a whole at this step; never in the periodic case
+	bool twoLevelActive;
+	//! Per body: 1 for groups, 2 for their members (clump members or GridMesh elements), 0 otherwise; set by updateGroupBounds
+	std::vector<char> groupRole;
+	//! Clumps and GridMesh bodies, cached until bodies are added or erased (see BodyContainer::revision)
+	std::vector<Body::id_t> groups;
+	const BodyContainer* groupsContainer;
+	unsigned long groupsRevision;
+	bool hasGridMesh;
+	//! Pairs (id1<id2) of bodies with overlapping bounds where at least one is a group; members are collided in collideGroupPairs
+	std::vector<std::pair<Body::id_t,Body::id_t> > groupPairs;
 	// return python representation of the BB struct, as ([...],[...],[...]).
   boost::python::tuple dumpBounds();
 
@@ -141,6 +152,16 @@ class InsertionSortCollider: public Collider{
 	void insertionSort(VecBounds& v,InteractionContainer*,Scene*,bool doCollide=true);
 	void insertionSortParallel(VecBounds& v,InteractionContainer*,Scene*,bool doCollide=true);
 	void handleBoundInversion(Body::id_t,Body::id_t,InteractionContainer*,Scene*);
+	//! insert a new interaction between bodies with overlapping bounds, or remember the pair if a group is involved
+	void insertPotentialPair(Body::id_t,Body::id_t,InteractionContainer*);
+	bool isGroupPair(Body::id_t id1, Body::id_t id2) const { return twoLevelActive && (groupRole[id1]==1 || groupRole[id2]==1); }
+
+	// two-level collision of clumps and grid meshes
+	void updateGroupList();
+	void updateGroupBounds();
+	void collideGroupPairs(InteractionContainer*);
+	void collideGroupPair(Body::id_t,Body::id_t,InteractionContainer*,std::vector<std::pair<Body::id_t,Body::id_t> >&) const;
+	void collideGridMeshSelf(Body::id_t,InteractionContainer*,std::vector<std::pair<Body::id_t,Body::id_t> >&) const;
 
 	// periodic variants
 	void insertionSortPeri(VecBounds& v,InteractionContainer*,Scene*,bool doCollide=true);
@@ -168,7 +189,7 @@ class InsertionSortCollider: public Collider{
 	virtual bool isActivated();
 
 	// force reinitialization at next run
-	virtual void invalidatePersistentData(){ for(int i=0; i<3; i++){ BB[i].vec.clear(); BB[i].size=0; }}
+	virtual void invalidatePersistentData(){ for(int i=0; i<3; i++){ BB[i].vec.clear(); BB[i].size=0; } groupPairs.clear(); }
 
 	vector<Body::id_t> probeBoundingVolume(const Bound&);
 
@@ -206,6 +227,7 @@ class InsertionSortCollider: public Collider{
 		((int,numReinit,0,Attr::readonly,"Cummulative number of bound array re-initialization."))
 		((Real,useless,,,"for compatibility of scripts defining the old collider's attributes - see deprecated attributes")) 
 		((bool,doSort,false,,"Do forced resorting of interactions."))
+		((bool,clumpLevel,false,,"Collide :yref:`clumps<Clump>` in two levels: the bounds of clump members are not checked against each other when sorted; instead, each clump has one bound enclosing the bounds of its members, and members are only collided for pairs of clumps (or clump and standalone body) with overlapping bounds. Members of such pairs are filtered by the intersection of both bounds, then tested with their own bounds, so that the potential interactions are the same as without clumpLevel. Useful with clumps of many members, much less inversions are handled at every sort. Only effective in aperiodic simulations. :yref:`GridMesh` bodies are always collided this way (in aperiodic simulations), independently of this flag."))
 		, /* ctor */
 			#ifdef ISC_TIMING
 				timingDeltas=shared_ptr<TimingDeltas>(new TimingDeltas);
@@ -213,6 +235,10 @@ class InsertionSortCollider: public Collider{
 			for(int i=0; i<3; i++) BB[i].axis=i;
 			periodic=false;
 			strideActive=false;
+			twoLevelActive=false;
+			groupsContainer=NULL;
+			groupsRevision=0;
+			hasGridMesh=false;
 			,
 		/* py */
 		.def_readonly("strideActive",&InsertionSortCollider::strideActive,"Whether striding is active (read-only; for debugging). |yupdate|")
@@ -0,0 +1,44 @@
+#include<pkg/common/PyRunner.hpp>
+
+namespace py=boost::python;
+
+void PyRunner::run(){
+	PyObject* ret=NULL;
+	if(callable.ptr()!=Py_None){
+		ret=PyObject_CallObject(callable.ptr(),NULL);
+	} else {
+		if(command.empty()) return;
+		if(code.ptr()==Py_None || compiledCommand!=command){
+			PyObject* compiled=Py_CompileString(command.c_str(),"<PyRunner>",Py_file_input);
+			if(!compiled){ code=py::object(); PyErr_Print(); return; }
+			code=py::object(py::handle<>(compiled)); compiledCommand=command;
+		}
+		// same namespace as PyRun_SimpleString
+		PyObject* globals=PyModule_GetDict(PyImport_AddModule("__main__"));
+		#if PY_MAJOR_VERSION >= 3
+			ret=PyEval_EvalCode(code.ptr(),globals,globals);
+		#else
+			ret=PyEval_EvalCode((PyCodeObject*)code.ptr(),globals,globals);
+		#endif
+	}
+	if(!ret) PyErr_Print();
+	else Py_DECREF(ret);
+}
+
+void PyRunner::action(){
+	gilLock lock;
+	run();
+	// with sub-stepping, engines must run one at a time
+	if(scene->subStepping) return;
+	const vector<shared_ptr<Engine> >& engines=scene->engines;
+	size_t i=0;
+	while(i<engines.size() && engines[i].get()!=this) i++;
+	for(i++; i<engines.size(); i++){
+		PyRunner* next=dynamic_cast<PyRunner*>(engines[i].get());
+		if(!next) break;
+		next->scene=scene;
+		if(next->dead || !next->isActivated()) continue;
+		next->run();
+		next->batchedIter=scene->iter;
+	}
+}
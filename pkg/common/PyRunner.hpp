@@ -6,12 +6,26 @@
 #include<lib/pyutil/gil.hpp>
 
 class PyRunner: public PeriodicEngine {
+	//! code object compiled from command, and the command it was compiled from
+	boost::python::object code;
+	string compiledCommand;
+	//! set when this engine was already run by the preceding PyRunner in this step
+	long batchedIter;
+	//! python callable run instead of command if not None; python objects can not be serialized, it is only exposed as a property
+	boost::python::object callable;
+	//! run callable or command; the caller must hold the GIL
+	void run();
 	public :
-		/* virtual bool isActivated: not overridden, PeriodicEngine handles that */
-		virtual void action(){ if(command.size()>0) pyRunString(command); }
-	YADE_CLASS_BASE_DOC_ATTRS(PyRunner,PeriodicEngine,
-		"Execute a python command periodically, with defined (and adjustable) periodicity. See :yref:`PeriodicEngine` documentation for details.",
+		virtual bool isActivated(){ if(batchedIter==scene->iter){ batchedIter=-1; return false; } return PeriodicEngine::isActivated(); }
+		virtual void action();
+		boost::python::object callable_get() const { return callable; }
+		void callable_set(const boost::python::object& c){ callable=c; }
+	YADE_CLASS_BASE_DOC_ATTRS_CTOR_PY(PyRunner,PeriodicEngine,
+		"Execute a python command periodically, with defined (and adjustable) periodicity. See :yref:`PeriodicEngine` documentation for details.\n\nThe command is compiled once and recompiled only when it changes. PyRunners immediately following each other in :yref:`O.engines<Omega.engines>` which are due in the same step are run under a single lock of the python interpreter (their timing is then accounted to the first one).",
 		((string,command,"",,"Command to be run by python interpreter. Not run if empty."))
+		,/*ctor*/ batchedIter=-1;
+		,/*py*/
+		.add_property("callable",&PyRunner::callable_get,&PyRunner::callable_set,"Python callable (taking no arguments) to be run instead of :yref:`command<PyRunner.command>` if not None. It is not saved with the simulation and can not be passed to the constructor, assign it after creating the engine.")
 	);
 };
 REGISTER_SERIALIZABLE(PyRunner);
@@ -0,0 +1,188 @@
+#include<pkg/common/TriMesh.hpp>
+#include<pkg/common/Aabb.hpp>
+#include<core/Scene.hpp>
+
+YADE_PLUGIN((TriMesh)(Bo1_TriMesh_Aabb)
+	#ifdef YADE_OPENGL
+		(Gl1_TriMesh)
+	#endif
+	);
+CREATE_LOGGER(TriMesh);
+
+TriMesh::~TriMesh(){}
+
+namespace {
+	bool triMeshIndicesValid(const vector<Vector3r>& v, const vector<Vector3i>& t){
+		const int nv=v.size();
+		FOREACH(const Vector3i& tri, t){ if(tri.minCoeff()<0 || tri.maxCoeff()>=nv) return false; }
+		return true;
+	}
+	// squared distance from p to the box, zero inside
+	Real triMeshBoxDist2(const TriMesh::BvhNode& node, const Vector3r& p){
+		Real ret=0;
+		for(int k=0; k<3; k++){ Real d=std::max(std::max(node.min[k]-p[k],p[k]-node.max[k]),(Real)0.); ret+=d*d; }
+		return ret;
+	}
+}
+
+void TriMesh::postLoad(TriMesh&){
+	// vertices and triangles may be assigned one after another from python, the mesh is only built once they are consistent
+	if(!triMeshIndicesValid(vertices,triangles)){
+		LOG_WARN("TriMesh: some triangles refer to inexistent vertices, the mesh is ignored until fixed.");
+		bvh.clear(); bvhTriangles.clear();
+		return;
+	}
+	buildBvh();
+}
+
+void TriMesh::setMesh(const vector<Vector3r>& v, const vector<Vector3i>& t){
+	if(!triMeshIndicesValid(v,t)) throw std::invalid_argument("TriMesh.setMesh: some triangles refer to inexistent vertices.");
+	vertices=v; triangles=t;
+	buildBvh();
+}
+
+void TriMesh::buildBvh(){
+	bvh.clear(); bvhTriangles.clear();
+	const int n=triangles.size();
+	if(n==0) return;
+	vector<Vector3r> centroids(n);
+	bvhTriangles.resize(n);
+	for(int i=0; i<n; i++){
+		const Vector3i& t=triangles[i];
+		centroids[i]=(vertices[t[0]]+vertices[t[1]]+vertices[t[2]])/3.;
+		bvhTriangles[i]=i;
+	}
+	bvh.reserve(2*n/std::max(1,leafSize)+1);
+	buildBvhNode(0,n,centroids);
+}
+
+int TriMesh::buildBvhNode(int first, int count, const vector<Vector3r>& centroids){
+	const int idx=bvh.size();
+	bvh.push_back(BvhNode());
+	const Real inf=std::numeric_limits<Real>::infinity();
+	Vector3r mn(inf,inf,inf), mx(-inf,-inf,-inf), cMin(mn), cMax(mx);
+	for(int i=first; i<first+count; i++){
+		const Vector3i& t=triangles[bvhTriangles[i]];
+		for(int k=0; k<3; k++){ mn=mn.cwiseMin(vertices[t[k]]); mx=mx.cwiseMax(vertices[t[k]]); }
+		cMin=cMin.cwiseMin(centroids[bvhTriangles[i]]); cMax=cMax.cwiseMax(centroids[bvhTriangles[i]]);
+	}
+	// bvh may be reallocated by the recursion, always access the node by index
+	bvh[idx].min=mn; bvh[idx].max=mx; bvh[idx].first=first; bvh[idx].right=-1;
+	if(count<=std::max(1,leafSize)){ bvh[idx].count=count; return idx; }
+	bvh[idx].count=0;
+	// median split along the longest extent of centroids; the tree is balanced, its depth is about log2(n/leafSize)
+	int axis; (cMax-cMin).maxCoeff(&axis);
+	const int mid=first+count/2;
+	std::nth_element(bvhTriangles.begin()+first,bvhTriangles.begin()+mid,bvhTriangles.begin()+first+count,[&centroids,axis](int a, int b){ return centroids[a][axis]<centroids[b][axis]; });
+	buildBvhNode(first,mid-first,centroids);
+	const int right=buildBvhNode(mid,first+count-mid,centroids);
+	bvh[idx].right=right;
+	return idx;
+}
+
+// Ericson, Real-Time Collision Detection, 5.1.5
+Vector3r TriMesh::closestPointOnTriangle(const Vector3r& p, const Vector3r& a, const Vector3r& b, const Vector3r& c){
+	const Vector3r ab=b-a, ac=c-a, ap=p-a;
+	const Real d1=ab.dot(ap), d2=ac.dot(ap);
+	if(d1<=0 && d2<=0) return a;
+	const Vector3r bp=p-b;
+	const Real d3=ab.dot(bp), d4=ac.dot(bp);
+	if(d3>=0 && d4<=d3) return b;
+	const Real vc=d1*d4-d3*d2;
+	if(vc<=0 && d1>=0 && d3<=0) return a+ab*(d1/(d1-d3));
+	const Vector3r cp=p-c;
+	const Real d5=ab.dot(cp), d6=ac.dot(cp);
+	if(d6>=0 && d5<=d6) return c;
+	const Real vb=d5*d2-d1*d6;
+	if(vb<=0 && d2>=0 && d6<=0) return a+ac*(d2/(d2-d6));
+	const Real va=d3*d6-d5*d4;
+	if(va<=0 && (d4-d3)>=0 && (d5-d6)>=0) return b+(c-b)*((d4-d3)/((d4-d3)+(d5-d6)));
+	const Real denom=1./(va+vb+vc);
+	return a+ab*(vb*denom)+ac*(vc*denom);
+}
+
+int TriMesh::closestTriangle(const Vector3r& p, Real maxDist, Vector3r& closest, int hint) const {
+	if(bvh.empty()) return -1;
+	int best=-1;
+	Real best2=maxDist*maxDist;
+	// the triangle found previously is usually still the closest one, it makes the initial bound tight
+	if(hint>=0 && hint<(int)triangles.size()){
+		const Vector3i& t=triangles[hint];
+		const Vector3r q=closestPointOnTriangle(p,vertices[t[0]],vertices[t[1]],vertices[t[2]]);
+		const Real d2=(q-p).squaredNorm();
+		if(d2<=best2){ best=hint; best2=d2; closest=q; }
+	}
+	// depth-first traversal, nearer child first; the stack is deeper than any balanced tree of int-indexed triangles
+	int stack[64], top=0;
+	stack[top++]=0;
+	while(top>0){
+		const int idx=stack[--top];
+		const BvhNode& node=bvh[idx];
+		if(triMeshBoxDist2(node,p)>best2) continue;
+		if(node.count>0){
+			for(int i=node.first; i<node.first+node.count; i++){
+				const int ti=bvhTriangles[i];
+				if(ti==hint) continue;
+				const Vector3i& t=triangles[ti];
+				const Vector3r q=closestPointOnTriangle(p,vertices[t[0]],vertices[t[1]],vertices[t[2]]);
+				const Real d2=(q-p).squaredNorm();
+				if(d2<best2 || (d2==best2 && best<0)){ best=ti; best2=d2; closest=q; }
+			}
+			continue;
+		}
+		const int left=idx+1, right=node.right;
+		if(triMeshBoxDist2(bvh[left],p)<triMeshBoxDist2(bvh[right],p)){ stack[top++]=right; stack[top++]=left; }
+		else { stack[top++]=left; stack[top++]=right; }
+	}
+	return best;
+}
+
+boost::python::tuple TriMesh::pyClosestTriangle(const Vector3r& p, Real maxDist) const {
+	Vector3r closest(p);
+	int i=closestTriangle(p,maxDist,closest);
+	return boost::python::make_tuple(i,closest);
+}
+
+void Bo1_TriMesh_Aabb::go(const shared_ptr<Shape>& cm, shared_ptr<Bound>& bv, const Se3r& se3, const Body* b){
+	TriMesh* mesh=static_cast<TriMesh*>(cm.get());
+	if(!bv){ bv=shared_ptr<Bound>(new Aabb); }
+	Aabb* aabb=static_cast<Aabb*>(bv.get());
+	if(mesh->bvh.empty()){ aabb->min=aabb->max=(scene->isPeriodic ? scene->cell->unshearPt(se3.position) : se3.position); return; }
+	// corners of the local bounding box are enough, the mesh does not have to be traversed
+	const Matrix3r rot=se3.orientation.toRotationMatrix();
+	const TriMesh::BvhNode& root=mesh->bvh[0];
+	Real inf=std::numeric_limits<Real>::infinity();
+	aabb->min=Vector3r(inf,inf,inf); aabb->max=Vector3r(-inf,-inf,-inf);
+	for(int i=0; i<8; i++){
+		Vector3r v=se3.position+rot*Vector3r((i&1)?root.max[0]:root.min[0],(i&2)?root.max[1]:root.min[1],(i&4)?root.max[2]:root.min[2]);
+		if(scene->isPeriodic) v=scene->cell->unshearPt(v);
+		aabb->min=aabb->min.cwiseMin(v);
+		aabb->max=aabb->max.cwiseMax(v);
+	}
+}
+
+#ifdef YADE_OPENGL
+	#include<lib/opengl/OpenGLWrapper.hpp>
+	void Gl1_TriMesh::go(const shared_ptr<Shape>& cm, const shared_ptr<State>&, bool wire, const GLViewInfo&){
+		TriMesh* mesh=static_cast<TriMesh*>(cm.get());
+		const vector<Vector3r>& v=mesh->vertices;
+		if(mesh->bvh.empty()) return;
+		glColor3v(cm->color);
+		if(cm->wire || wire){
+			FOREACH(const Vector3i& t, mesh->triangles){
+				glBegin(GL_LINE_LOOP);
+					glVertex3v(v[t[0]]); glVertex3v(v[t[1]]); glVertex3v(v[t[2]]);
+				glEnd();
+			}
+		} else {
+			glDisable(GL_CULL_FACE);
+			glBegin(GL_TRIANGLES);
+				for(size_t i=0; i<mesh->triangles.size(); i++){
+					const Vector3i& t=mesh->triangles[i];
+					glNormal3v(mesh->triangleNormal(i));
+					glVertex3v(v[t[0]]); glVertex3v(v[t[1]]); glVertex3v(v[t[2]]);
+				}
+			glEnd();
+		}
+	}
+#endif
@@ -0,0 +1,68 @@
+#pragma once
+#include<core/Shape.hpp>
+#include<pkg/common/Dispatching.hpp>
+
+/*! Rigid triangulated surface as one body.
+
+Triangles are kept in a static bounding volume hierarchy (BVH) built in body-local coordinates, so that the body can move
+and rotate without rebuilding it. Only the whole mesh is seen by the collider; contacts with individual triangles are
+resolved by the geometry functors (see Ig2_TriMesh_Sphere_ScGeom), which query the hierarchy for the closest triangle.
+*/
+class TriMesh: public Shape{
+	public:
+		/*! Node of the hierarchy; nodes are stored depth-first, so that the left child of an inner node follows it immediately.
+		Leaves have count>0 and refer to bvhTriangles[first..first+count). */
+		struct BvhNode{
+			Vector3r min, max;
+			int first, count, right;
+		};
+		vector<BvhNode> bvh;
+		// triangle indices, ordered so that every leaf refers to a contiguous range
+		vector<int> bvhTriangles;
+		void postLoad(TriMesh&);
+		void buildBvh();
+		int buildBvhNode(int first, int count, const vector<Vector3r>& centroids);
+		void setMesh(const vector<Vector3r>& v, const vector<Vector3i>& t);
+		/*! Index of the triangle closest to point p (in local coordinates) not farther than maxDist, or -1 if there is none;
+		the closest point is returned in closest. If hint is a valid triangle index, its distance is used as the initial bound. */
+		int closestTriangle(const Vector3r& p, Real maxDist, Vector3r& closest, int hint=-1) const;
+		static Vector3r closestPointOnTriangle(const Vector3r& p, const Vector3r& a, const Vector3r& b, const Vector3r& c);
+		Vector3r triangleNormal(int i) const { const Vector3i& t=triangles[i]; return (vertices[t[1]]-vertices[t[0]]).cross(vertices[t[2]]-vertices[t[0]]).normalized(); }
+		int nNodes() const { return bvh.size(); }
+		boost::python::tuple pyClosestTriangle(const Vector3r& p, Real maxDist) const;
+		virtual ~TriMesh();
+	YADE_CLASS_BASE_DOC_ATTRS_CTOR_PY(TriMesh,Shape,"Rigid triangulated surface represented by one body, replacing one :yref:`Facet` body per triangle for large meshes (mill liners, drums, imported geometries). The collider only sees one :yref:`Aabb` for the whole mesh; triangles are stored in a bounding volume hierarchy (built in local coordinates when :yref:`vertices<TriMesh.vertices>` or :yref:`triangles<TriMesh.triangles>` are assigned) which is queried by :yref:`Ig2_TriMesh_Sphere_ScGeom`. Forces from all triangles act on the single body. Assign both vertices and triangles in the constructor or with :yref:`setMesh<TriMesh.setMesh>`; the mesh is ignored as long as some triangle refers to an inexistent vertex.",
+		((vector<Vector3r>,vertices,,Attr::triggerPostLoad,"Vertex positions in local coordinates."))
+		((vector<Vector3i>,triangles,,Attr::triggerPostLoad,"Triangles, as triples of indices into :yref:`vertices<TriMesh.vertices>`."))
+		((int,leafSize,4,Attr::triggerPostLoad,"Maximum number of triangles in leaves of the hierarchy."))
+		,
+		/*ctor*/ createIndex();
+		,
+		.def("setMesh",&TriMesh::setMesh,(boost::python::arg("vertices"),boost::python::arg("triangles")),"Assign vertices and triangles at once; raises an exception if some triangle refers to an inexistent vertex.")
+		.def("closestTriangle",&TriMesh::pyClosestTriangle,(boost::python::arg("point"),boost::python::arg("maxDist")=std::numeric_limits<Real>::infinity()),"Return tuple (index, point) of the triangle closest to *point* (in local coordinates) and of the closest point on it, or (-1, point) if no triangle is closer than *maxDist*.")
+		.add_property("nodes",&TriMesh::nNodes,"Number of nodes of the bounding volume hierarchy (read-only).")
+	);
+	DECLARE_LOGGER;
+	REGISTER_CLASS_INDEX(TriMesh,Shape);
+};
+REGISTER_SERIALIZABLE(TriMesh);
+
+/*! Aabb of the whole mesh, from the local bounding box of the hierarchy root. */
+class Bo1_TriMesh_Aabb: public BoundFunctor{
+	public:
+		virtual void go(const shared_ptr<Shape>& cm, shared_ptr<Bound>& bv, const Se3r& se3, const Body*);
+	FUNCTOR1D(TriMesh);
+	YADE_CLASS_BASE_DOC(Bo1_TriMesh_Aabb,BoundFunctor,"Creates/updates an :yref:`Aabb` of a :yref:`TriMesh`, enclosing the (rotated) local bounding box of the mesh.");
+};
+REGISTER_SERIALIZABLE(Bo1_TriMesh_Aabb);
+
+#ifdef YADE_OPENGL
+	#include<pkg/common/GLDrawFunctors.hpp>
+	class Gl1_TriMesh: public GlShapeFunctor{
+		public:
+			virtual void go(const shared_ptr<Shape>&, const shared_ptr<State>&,bool,const GLViewInfo&);
+		RENDERS(TriMesh);
+		YADE_CLASS_BASE_DOC(Gl1_TriMesh,GlShapeFunctor,"Renders :yref:`TriMesh` object");
+	};
+	REGISTER_SERIALIZABLE(Gl1_TriMesh);
+#endif
@@ -9,6 +9,7 @@
 #include<pkg/dem/ScGeom.hpp>
 #include<pkg/dem/FrictPhys.hpp>
 #include<pkg/dem/DemXDofGeom.hpp>
+#include<pkg/dem/Ig2_TriMesh_Sphere_ScGeom.hpp>
 #include<core/Omega.hpp>
 #include<core/Scene.hpp>
 
@@ -93,7 +94,9 @@ bool Law2_ScGeom_FrictPhys_CundallStrack::go(shared_ptr<IGeom>& ig, shared_ptr<I
 		Vector3r force = -phys->normalForce-shearForce;
 		scene->forces.addForce(id1,force);
 		scene->forces.addForce(id2,-force);
-		scene->forces.addTorque(id1,(geom->radius1-0.5*geom->penetrationDepth)* geom->normal.cross(force));
+		// the branch of a mesh is not along the normal, it goes from the (unshifted) mesh to the contact point
+		if(geom->getClassIndex()==TriMeshScGeom::getClassIndexStatic()) scene->forces.addTorque(id1,(geom->contactPoint-Body::byId(id1,scene)->state->pos).cross(force));
+		else scene->forces.addTorque(id1,(geom->radius1-0.5*geom->penetrationDepth)* geom->normal.cross(force));
 		scene->forces.addTorque(id2,(geom->radius2-0.5*geom->penetrationDepth)* geom->normal.cross(force));
 	}
 	return true;
@@ -24,6 +24,7 @@
 #include<Eigen/Core>
 #include <Eigen/LU> 
 #include <Eigen/QR>
+#include <Eigen/Cholesky>
 
 #include <ctime>
 #include <cstdlib>
@@ -32,7 +33,7 @@
 
 
 
-YADE_PLUGIN((Ig2_PB_PB_ScGeom) 
+YADE_PLUGIN((PBScGeom)(Ig2_PB_PB_ScGeom) 
 //#ifdef YADE_OPENGL
 //		(Gl1_Ig2_PB_PB_ScGeom)
 //	#endif 
@@ -41,6 +42,8 @@ YADE_PLUGIN((Ig2_PB_PB_ScGeom)
 
 CREATE_LOGGER(Ig2_PB_PB_ScGeom);
 
+PBScGeom::~PBScGeom(){}
+
 
 bool Ig2_PB_PB_ScGeom::go(const shared_ptr<Shape>& cm1,const shared_ptr<Shape>& cm2,const State& state1, const State& state2, const Vector3r& shift2, const bool& force,const shared_ptr<Interaction>& c)
 {	
@@ -58,6 +61,7 @@ bool Ig2_PB_PB_ScGeom::go(const shared_ptr<Shape>& cm1,const shared_ptr<Shape>&
 	bool hasGeom = false; 
 	Vector3r contactPt(0,0,0); 
 	shared_ptr<ScGeom> scm;
+	shared_ptr<PBScGeom> pbGeom;
 	shared_ptr<KnKsPBPhys> phys;
 
 
@@ -78,11 +82,13 @@ bool Ig2_PB_PB_ScGeom::go(const shared_ptr<Shape>& cm1,const shared_ptr<Shape>&
 	if(c->geom){ 
 		hasGeom = true;
 		scm=YADE_PTR_CAST<ScGeom>(c->geom);
+		pbGeom=YADE_PTR_DYN_CAST<PBScGeom>(c->geom); /* geometries saved before PBScGeom existed have no warm start */
 		if (scm->penetrationDepth>stepBisection ){ stepBisection = 0.5*scm->penetrationDepth;}
 		if(stepBisection<pow(10,-6)){std::cout<<"stepBisection: "<<stepBisection<<", penetrationDepth: "<<scm->penetrationDepth<<endl;}
 		contactPt = scm->contactPoint;
 	}else{
-		scm=shared_ptr<ScGeom>(new ScGeom()); 
+		pbGeom=shared_ptr<PBScGeom>(new PBScGeom());
+		scm=pbGeom;
 		c->geom=scm;
 		contactPt = 0.5*(state1.pos+state2.pos);
 		
@@ -164,32 +170,42 @@ if(s1->isLining == true ||  s2->isLining==true){
 
 	bool convergeFeasibility = true;
 
-	fA= evaluatePB(cm1,state1, contactPt);
-	fB = evaluatePB(cm2,state2, contactPt);
-
-
-	//if (fA < -pow(10.0,-6) && fB < -pow(10.0,-6) ){
-	//	contact = true;
-	//}else{ 	
-	
+	/* Starting point of the analytic centre, strictly inside both particles. The linear program is only solved if it cannot be obtained otherwise: */
+	/* 1. particles farther apart than the sum of circumscribed radii, or separated by the plane found at the previous step, do not touch */
+	/* 2. a point inside both inscribed spheres, if they overlap */
+	/* 3. the previous contact point, if it is still inside both particles */
+	Vector3r branch = state2.pos - state1.pos;
+	double centreDist = branch.norm();
+	bool separated = (s1->outRadius > 0.0 && s2->outRadius > 0.0 && centreDist > s1->outRadius + s2->outRadius);
+	if (separated == false && warmStart == true && pbGeom && pbGeom->separatingPlane >= 0){
+		separated = separatedByPlane(s1, state1, s2, state2, pbGeom->separatingPlane);
+	}
+	if (separated == true){
+		contact = false;
+	}else if (centreDist < s1->inRadius + s2->inRadius){
+		contact = true;
+		contactPt = state1.pos + (centreDist > 0.0 ? 0.5*(s1->inRadius + centreDist - s2->inRadius)/centreDist : 0.0)*branch;
+	}else if (warmStart == true && hasGeom == true && scm->penetrationDepth > 0.0 && insidePlanes(s1, state1, contactPt) && insidePlanes(s2, state2, contactPt)){
+		contact = true;
+	}else{
 		contact = startingPointFeasibilityCLP( cm1,  state1, cm2, state2, contactPt, convergeFeasibility);
+		if (contact == false && warmStart == true && pbGeom){ pbGeom->separatingPlane = findSeparatingPlane(s1, state1, s2, state2); }
 
-     	//}
-
-	fA= evaluatePB(cm1,state1, contactPt);
-	fB = evaluatePB(cm2,state2, contactPt);
-
-if (fA*fB<0.0){
-std::cout<<"after clp fA: "<<fA<<", fB: "<<fB<<", contact: "<<contact<<", convergeFeasibility: "<<convergeFeasibility<<endl;
+		fA= evaluatePB(cm1,state1, contactPt);
+		fB = evaluatePB(cm2,state2, contactPt);
 
-}
+		if (fA*fB<0.0){
+			LOG_DEBUG("after clp fA: "<<fA<<", fB: "<<fB<<", contact: "<<contact<<", convergeFeasibility: "<<convergeFeasibility);
+		}
+	}
+	if (contact == true && pbGeom){ pbGeom->separatingPlane = -1; }
 
 if (contact == true && convergeFeasibility == true){
 		converge = customSolveAnalyticCentre(cm1, state1, cm2, state2, contactPt);
 		fA= evaluatePB(cm1,state1, contactPt);
 		fB = evaluatePB(cm2,state2, contactPt); 
 		if (converge == false){
-			contact = false; contactPt = 0.5*(state1.pos+state2.pos);  std::cout<<"analytic centre did not converge"<<endl;
+			contact = false; contactPt = 0.5*(state1.pos+state2.pos);  LOG_DEBUG("analytic centre did not converge, id1: "<<c->getId1()<<", id2: "<<c->getId2());
 	 	}else if (fA<0.0 && fB < 0.0){
 			contact = true;
 		}else{
@@ -424,13 +440,8 @@ double Ig2_PB_PB_ScGeom::evaluatePhys(const shared_ptr<Shape>& cm1,  const State
 double Ig2_PB_PB_ScGeom::getSignedArea(const Vector3r pt1, const Vector3r pt2, const Vector3r pt3){ 
 	/* if positive, counter clockwise, 2nd point makes a larger angle */
 	/* if negative, clockwise, 3rd point makes a larger angle */ 
-	Eigen::MatrixXd triangle(4,2);
-	triangle(0,0) = pt1.x();  triangle(0,1) = pt1.y(); // triangle(0,2) = pt1.z(); 
-	triangle(1,0) = pt2.x();  triangle(1,1) = pt2.y(); // triangle(1,2) = pt2.z(); 
-	triangle(2,0) = pt3.x();  triangle(2,1) = pt3.y(); // triangle(2,2) = pt3.z(); 
-	triangle(3,0) = pt1.x();  triangle(3,1) = pt1.y(); // triangle(3,2) = pt1.z(); 
-	double determinant = getDet(triangle);
-	return determinant; //triangle.determinant();
+	/* same as getDet of the closed polygon pt1,pt2,pt3,pt1, without allocating the matrix */
+	return (pt1.x()*pt2.y() - pt1.y()*pt2.x()) + (pt2.x()*pt3.y() - pt2.y()*pt3.x()) + (pt3.x()*pt1.y() - pt3.y()*pt1.x());
 }
 
 
@@ -744,7 +755,9 @@ void Ig2_PB_PB_ScGeom::getPtOnParticleArea(const shared_ptr<Shape>& cm1, const S
 
 
 bool Ig2_PB_PB_ScGeom::customSolveAnalyticCentre(const shared_ptr<Shape>& cm1, const State& state1, const shared_ptr<Shape>& cm2, const State& state2, Vector3r& contactPt){
-  	 bool converge = true;
+	/* Analytic centre of the intersection of both particles (planes offset by r): minimum of -sum(log(d_i - a_i.x)) by damped Newton iterations, */
+	/* x relative to contactPt, which must be strictly inside both particles. The 3x3 system is assembled and solved with fixed-size matrices. */
+	 bool converge = true;
 	 PotentialBlock *s1=static_cast<PotentialBlock*>(cm1.get());
 	 PotentialBlock *s2=static_cast<PotentialBlock*>(cm2.get());
 	 int planeNoA = s1->a.size();
@@ -752,221 +765,88 @@ bool Ig2_PB_PB_ScGeom::customSolveAnalyticCentre(const shared_ptr<Shape>& cm1, c
 	 int totalPlanes = planeNoA+planeNoB;
 	 Matrix3r QA = state1.ori.toRotationMatrix(); /*direction cosine */
 	 Matrix3r QB = state2.ori.toRotationMatrix(); /*direction cosine */
-	 double blasQ1[3*3];  double blasQ2[3*3];
-	 double blasP1Q [planeNoA*3]; double d1 [planeNoA];
-	 double blasP2Q [planeNoB*3]; double d2 [planeNoB];
-	 int blasCount = 0;
- 	 for(int i=0; i<3; i++){
-		for(int j=0; j<3; j++){
-			blasQ1[blasCount]=QA(j,i); 
-			blasQ2[blasCount]=QB(j,i); 
-			blasCount++;	
-		}
-	 }
-	 double blasP1[planeNoA*3];
-	 for(int i=0; i<planeNoA; i++){
-		blasP1[3*i]=s1->a[i]; blasP1[3*i+1]=s1->b[i]; blasP1[3*i+2]=s1->c[i]; d1[i] = s1->d[i] + s1->r;	
-         }
-	 double blasP2[planeNoB*3];
-	 for(int i=0; i<planeNoB; i++){
-		blasP2[3*i]=s2->a[i]; blasP2[3*i+1]=s2->b[i]; blasP2[3*i+2]=s2->c[i]; d2[i] = s2->d[i] + s2->r;
-         }
-	 int incx =1; int incy=1;  
-  	 int blas3 = 3; char blasNT = 'N'; char blasT= 'T'; double blas0 = 0.0; double blas1 = 1.0; double blasNeg1 = -1.0; double HessTemp[3*totalPlanes]; 
-	 dgemm_(&blasNT, &blasNT, &blas3, &planeNoA, &blas3, &blas1, &blasQ1[0], &blas3, &blasP1[0], &blas3, &blas0, &blasP1Q[0], &blas3); /*Matrix mulitplication Q1*P1 */
-	 dgemm_(&blasNT, &blasNT, &blas3, &planeNoB, &blas3, &blas1, &blasQ2[0], &blas3, &blasP2[0], &blas3, &blas0, &blasP2Q[0], &blas3); /*Matrix mulitplication Q2*P2 */
-	
-	
-	 for(unsigned int k=0; k<planeNoA; k++){
-		d1[k] = -1.0*(blasP1Q[3*k]*(contactPt.x()-state1.pos.x()) + blasP1Q[3*k+1]*(contactPt.y()-state1.pos.y()) + blasP1Q[3*k+2]*(contactPt.z()-state1.pos.z())-d1[k] );
-	 }
-	 for(unsigned int k=0; k<planeNoB; k++){
-		d2[k] = -1.0*(blasP2Q[3*k]*(contactPt.x()-state2.pos.x()) + blasP2Q[3*k+1]*(contactPt.y()-state2.pos.y()) + blasP2Q[3*k+2]*(contactPt.z()-state2.pos.z())-d2[k] );	
-	 }
-	
-	 int iter=0;
-	 double xx [3]; xx[0]=0.0; xx[1]=0.0; xx[2]=0.0; double blasStep[3];
-	 double grad [3];
-	 double Hess [9];
-	 double Atranspose[totalPlanes*3];
-	 double B [totalPlanes]; double D [totalPlanes]; double Dinvert [totalPlanes]; 
-	 double Ddiag[totalPlanes*totalPlanes];   double oriMinD = 9999999;
-	 memset(Ddiag,0.0,sizeof(Ddiag));
-	 int planeNoA3 = planeNoA*3; int planeNoB3 = planeNoB*3; int totalPlanes3 = totalPlanes*3;
-	 
+	 double Aplanes[3*totalPlanes]; double B[totalPlanes];
 	 for (int i=0; i<planeNoA; i++){
-		Atranspose[3*i] = blasP1Q[3*i];
-		Atranspose[3*i+1] = blasP1Q[3*i+1];
-		Atranspose[3*i+2] = blasP1Q[3*i+2];
-		B[i] = d1[i];
+		Vector3r n = QA*Vector3r(s1->a[i], s1->b[i], s1->c[i]);
+		Aplanes[3*i] = n.x(); Aplanes[3*i+1] = n.y(); Aplanes[3*i+2] = n.z();
+		B[i] = s1->d[i] + s1->r - n.dot(contactPt-state1.pos);
 	 }
 	 for (int i=0; i<planeNoB; i++){
-		Atranspose[3*(planeNoA+i)] =blasP2Q[3*i];
-		Atranspose[3*(planeNoA+i)+1] = blasP2Q[3*i+1];
-		Atranspose[3*(planeNoA+i)+2] = blasP2Q[3*i+2];
-		B[planeNoA+i] = d2[i];
+		Vector3r n = QB*Vector3r(s2->a[i], s2->b[i], s2->c[i]);
+		Aplanes[3*(planeNoA+i)] = n.x(); Aplanes[3*(planeNoA+i)+1] = n.y(); Aplanes[3*(planeNoA+i)+2] = n.z();
+		B[planeNoA+i] = s2->d[i] + s2->r - n.dot(contactPt-state2.pos);
 	 }
+	 /* value of the barrier at xx, smallest distance to the planes in minD */
+	 auto barrier = [&](const Vector3r& xx, double& minD){
+		double val = 0.0; minD = std::numeric_limits<double>::infinity();
+		for (int i=0; i<totalPlanes; i++){
+			double D = B[i] - Aplanes[3*i]*xx[0] - Aplanes[3*i+1]*xx[1] - Aplanes[3*i+2]*xx[2];
+			minD = std::min(minD, D);
+			val -= log(D);
+		}
+		return val;
+	 };
 
-
-
-	 while(iter<50){	
-		double val = 0.0;  double Dinit[totalPlanes];
+	 Vector3r xx = Vector3r::Zero();
+	 for (int iter=0; iter<50; iter++){
+		double val = 0.0; double minD = std::numeric_limits<double>::infinity();
+		Vector3r grad = Vector3r::Zero(); Matrix3r Hess = Matrix3r::Zero();
 		for (int i=0; i<totalPlanes; i++){
-			double a= Atranspose[3*i]; double b= Atranspose[3*i+1]; double c= Atranspose[3*i+2]; 
-			D[i] = B[i]-a*xx[0] -b*xx[1] -c*xx[2];
-			if(iter==0 && D[i] < oriMinD){
-				oriMinD = D[i];
-			}
-			Dinit[i]=D[i];
-			val -= log(D[i]); 
-			Dinvert[i] = 1.0/D[i];
-			Ddiag[i*totalPlanes+i] = pow(Dinvert[i],2);
+			Vector3r a(Aplanes[3*i], Aplanes[3*i+1], Aplanes[3*i+2]);
+			double D = B[i] - a.dot(xx);
+			minD = std::min(minD, D);
+			val -= log(D);
+			/* g = A(T)*(1./d), H = A(t)*diag(1/d^2)*A */
+			grad += a/D;
+			Hess += (a*a.transpose())/(D*D);
 		}
-		double orival = val;	
-		if(iter==0 && Mathr::Sign(oriMinD)*1.0<0.0 ){std::cout<<"oriMinD: "<<oriMinD<<endl; converge = false; break;}
-		/* g = A(T)*(1./d) */
-		memset(grad,0.0,sizeof(grad));
-		dgemv_(&blasNT, &blas3, &totalPlanes, &blas1, &Atranspose[0], &blas3, &Dinvert[0], &incx, &blas0, &grad[0], &incy);
-		/* H = A(t)*diag(1/d^2)*A */
-		memset(HessTemp,0.0,sizeof(HessTemp));
-		memset(Hess,0.0,sizeof(Hess));
-		dgemm_(&blasNT, &blasNT, &blas3, &totalPlanes, &totalPlanes, &blas1, &Atranspose[0], &blas3, &Ddiag[0], &totalPlanes, &blas0, &HessTemp[0], &blas3);
-		dgemm_(&blasNT, &blasT, &blas3, &blas3, &totalPlanes, &blas1, &HessTemp[0], &blas3, &Atranspose[0], &blas3, &blas0, &Hess[0], &blas3);
-
-		/* Cholesky factorization */
-		//#if 0
-		/* L */
-			int varNo = 3;
-			int info; char UPLO ='L'; int KD = varNo-1; int nrhs=1;
-			double HessianChol[varNo][varNo];
-			for( int j=1; j<=varNo ; j++){
-				blasStep[j-1]=-grad[j-1];
-			    for (int i=j; i<=j+KD && i<=varNo; i++){	
-					HessianChol[j-1][1+i-j-1]    = Hess[(i-1)+varNo*(j-1)];
-			    }
-			}
-		//#endif
+		if(iter==0 && !(minD>0.0)){LOG_DEBUG("starting point outside of the planes, oriMinD: "<<minD); converge = false; break;}
 
-		#if 0
-			/* U */
-			for( int j=1; j<=varNo ; j++){
-				blasStep[j-1]=-blasGrad[j-1];
-			    	for (int i=std::max(1,j-KD); i<=j ; i++){	
-					HessianChol[j-1][KD+1+i-j-1]    = blasHess[(i-1)+varNo*(j-1)]; //H(i-1,j-1);
-			    	}
-			}
-		#endif
-		//#if 0
-			dpbsv_( &UPLO, &varNo, &KD, &nrhs, &HessianChol[0][0], &varNo, blasStep, &varNo, &info );
-			if(info != 0){
-			  //	std::cout<<"chol error iter:"<<iter<<endl;
-				//return false;
-			 	/* LU factorization */
-			  	for (int i=0; i<varNo; i++ ){
-					blasStep[i]=-1.0*grad[i]; //g[i];
-			  	}
-			 	int ipiv[varNo];  int bColNo=1;
-			 	dgesv_( &varNo, &bColNo, Hess, &varNo, ipiv, blasStep, &varNo, &info);
-			}
-		//#endif
-		#if 0	
-			/* QR */
-			for (int i=0; i<varNo; i++ ){
-					blasStep[i]=-1.0*grad[i]; //g[i];
-			}
-			double work[30]; int lwork = 30;  
-			dgels_(&blasT, &blas3, &blas3, &nrhs, Hess, &blas3, blasStep, &blas3, work, &lwork, &info);
-		#endif
-			if (info!=0){
-				std::cout<<"linear algebra error, iter:"<<iter<<endl; converge=false;break;
-			}
-		//std::cout<<"blasStep: "<<blasStep[0]<<", "<<blasStep[1]<<", "<<blasStep[2]<<endl;
-		 /*Linesearch */
-		 double backtrack = 1.0; double blasNewX[3];
-		 dcopy_(&varNo, &xx[0], &incx, &blasNewX[0], &incy);
-		 daxpy_(&varNo, &backtrack, &blasStep[0], &incx, &blasNewX[0], &incy);
-		 //fprime = step.transpose()*g; 
-		 double blasFprime = ddot_(&varNo, &blasStep[0], &incx, &grad[0], &incy);
-		 if (-blasFprime*0.5 < pow(10,-8) ){ 
-			//std::cout<<"blasFprime: "<<blasFprime<<", blasStep: "<<blasStep[0]<<", "<<blasStep[1]<<", "<<blasStep[2]<<endl; 
-			break;
-		 }	
-		 double minD = 9999999999;
-		 /* d = B - A*x	*/	
-		 dcopy_(&totalPlanes, &B[0], &incx, &D[0], &incy);
-		 dgemv_(&blasT, &blas3, &totalPlanes, &blasNeg1, &Atranspose[0], &blas3, &blasNewX[0], &incx, &blas1, &D[0], &incy);
-		 for(int i=0; i<totalPlanes; i++){
-			if(D[i] < minD){
-				minD = D[i];
-			}
-		 }		
-		 while (Mathr::Sign(minD)*1.0 < 0.0){
-			 backtrack *= 0.5;
-			 dcopy_(&varNo, &xx[0], &incx, &blasNewX[0], &incy);
-		 	 daxpy_(&varNo, &backtrack, &blasStep[0], &incx, &blasNewX[0], &incy);
-			 minD = 9999999999;
-			 /* d = B - A*x	*/	
-			 dcopy_(&totalPlanes, &B[0], &incx, &D[0], &incy);
-			 dgemv_(&blasT, &blas3, &totalPlanes, &blasNeg1, &Atranspose[0], &blas3, &blasNewX[0], &incx, &blas1, &D[0], &incy);
-			
-			 for(int i=0; i<totalPlanes; i++){
-				if(D[i] < minD){
-					minD = D[i];
-				}
-			 }	
-			if(backtrack<pow(10,-15)){std::cout<<"backtrack: "<<backtrack<<", iter: "<<iter<<", blasStep: "<<blasStep[0]<<","<<blasStep[1]<<","<<blasStep[2]<<", minD: "<<minD<<", oriMinD: "<<oriMinD<<", grad: "<<grad[0]<<","<<grad[1]<<","<<grad[2]<<", xx: "<<xx[0]<<","<<xx[1]<<","<<xx[2]<<", Hess: "<<Hess[0]<<","<<Hess[1]<<","<<Hess[2]<<","<<Hess[3]<<","<<Hess[4]<<","<<Hess[5]<<","<<Hess[6]<<","<<Hess[7]<<","<<Hess[8]<<endl;converge=false;break;}
-		 }
-		
-		/* d = B - A*x	*/	
-		dcopy_(&totalPlanes, &B[0], &incx, &D[0], &incy);
-		dgemv_(&blasT, &blas3, &totalPlanes, &blasNeg1, &Atranspose[0], &totalPlanes, &blasNewX[0], &incx, &blas1, &D[0], &incy);
-		
-		 val = 0.0;
-		 for(int i=0; i<totalPlanes; i++){
-			val -= log(D[i]); 
-		 }	
-		 
-		 double initbacktrack = backtrack;
-		 while (val > orival+ backtrack*0.01*blasFprime){
-
-			 backtrack *= 0.5;
-			 dcopy_(&varNo, &xx[0], &incx, &blasNewX[0], &incy);
-		 	 daxpy_(&varNo, &backtrack, &blasStep[0], &incx, &blasNewX[0], &incy);
-			 /* d = B - A*x	*/	
-			// dcopy_(&totalPlanes, &B[0], &incx, &D[0], &incy);
-			// dgemv_(&blasT, &blas3, &totalPlanes, &blasNeg1, &Atranspose[0], &blas3, &blasNewX[0], &incx, &blas1, &D[0], &incy);
-			 val=0.0;
-			 for(int i=0; i<totalPlanes; i++){
-				double a= Atranspose[3*i]; double b= Atranspose[3*i+1]; double c= Atranspose[3*i+2]; 
-				D[i] = B[i]-a*blasNewX[0] -b*blasNewX[1] -c*blasNewX[2];
-				val -= log(D[i]); 
-			 }
-			 if(backtrack<pow(10,-15)){
-				std::cout<<"initbacktrack: "<<initbacktrack<<", backtrack: "<<backtrack<<", iter: "<<iter<<", blasStep: "<<blasStep[0]<<","<<blasStep[1]<<","<<blasStep[2]<<", blasFprime: "<<blasFprime<<", val: "<<val<<", orival: "<<orival<<", oriMinD: "<<oriMinD<<", minD: "<<minD<<endl;
-				
-				converge=false;break;
-			 }
-		 }
-			 
-		dcopy_(&blas3, &blasNewX[0], &incx, &xx[0], &incy);
-		iter++;
-		   
-		
-		if(iter>49){std::cout<<"custom analytic center iter: "<<iter<<", blasFprime: "<<blasFprime<<endl;converge=false;}
-		if(converge==false){break;}
+		/* Cholesky factorization, LU if the Hessian is not positive definite numerically */
+		Vector3r step;
+		Eigen::LLT<Matrix3r> chol(Hess);
+		if (chol.info() == Eigen::Success){
+			step = chol.solve(-grad);
+		}else{
+			Eigen::FullPivLU<Matrix3r> lu(Hess);
+			if (lu.isInvertible() == false){ LOG_WARN("linear algebra error, singular Hessian at iter: "<<iter); converge=false; break; }
+			step = lu.solve(-grad);
+		}
+		double fprime = step.dot(grad);
+		if (-fprime*0.5 < pow(10,-8) ){ break; }
+
+		/* Linesearch: stay inside all planes, then sufficient decrease */
+		double backtrack = 1.0; double newMinD = 0.0;
+		Vector3r newX = xx + step;
+		double newVal = barrier(newX, newMinD);
+		while (!(newMinD > 0.0)){
+			backtrack *= 0.5;
+			newX = xx + backtrack*step;
+			newVal = barrier(newX, newMinD);
+			if(backtrack<pow(10,-15)){LOG_DEBUG("backtrack: "<<backtrack<<", iter: "<<iter<<", step: "<<step.transpose()<<", minD: "<<newMinD<<", grad: "<<grad.transpose()<<", xx: "<<xx.transpose()); converge=false; break;}
+		}
+		if (converge == false){ break; }
+		double initbacktrack = backtrack;
+		while (newVal > val + backtrack*0.01*fprime){
+			backtrack *= 0.5;
+			newX = xx + backtrack*step;
+			newVal = barrier(newX, newMinD);
+			if(backtrack<pow(10,-15)){LOG_DEBUG("initbacktrack: "<<initbacktrack<<", backtrack: "<<backtrack<<", iter: "<<iter<<", step: "<<step.transpose()<<", fprime: "<<fprime<<", val: "<<newVal<<", orival: "<<val); converge=false; break;}
+		}
+		if (converge == false){ break; }
+		xx = newX;
+		if(iter==49){LOG_WARN("custom analytic center did not converge in "<<iter+1<<" iterations, fprime: "<<fprime); converge=false;}
 	 }
-	 
-	Vector3r solution ((xx[0]-0.0),(xx[1]-0.0), (xx[2]-0.0) ); 
 
 	if(converge == true){
-		contactPt = solution+contactPt;
+		contactPt = xx+contactPt;
 	}
 
 	return converge;
 }
 
 
-double Ig2_PB_PB_ScGeom::getDet(const Eigen::MatrixXd A){ 
+double Ig2_PB_PB_ScGeom::getDet(const Eigen::MatrixXd& A){ 
 	/* if positive, counter clockwise, 2nd point makes a larger angle */
 	/* if negative, clockwise, 3rd point makes a larger angle */ 
 	int rowNo = A.rows();  double firstTerm = 0.0; double secondTerm = 0.0;
@@ -980,10 +860,48 @@ double Ig2_PB_PB_ScGeom::getDet(const Eigen::MatrixXd A){
 
 
 
+bool Ig2_PB_PB_ScGeom::insidePlanes(const PotentialBlock* s1, const State& state1, const Vector3r& pt){
+	/* strictly inside all planes offset by r, as required by the analytic centre */
+	Vector3r localPt = state1.ori.conjugate()*(pt - state1.pos);
+	for (unsigned int i=0; i<s1->a.size(); i++){
+		if (s1->a[i]*localPt.x() + s1->b[i]*localPt.y() + s1->c[i]*localPt.z() - s1->d[i] - s1->r >= 0.0){ return false; }
+	}
+	return true;
+}
+
+
+bool Ig2_PB_PB_ScGeom::separatedByPlane(const PotentialBlock* s1, const State& state1, const PotentialBlock* s2, const State& state2, int plane){
+	/* plane of one particle with all vertices of the other particle strictly on its outer side; planes of s2 are numbered after those of s1 */
+	int planeNoA = s1->a.size();
+	bool onFirst = (plane < planeNoA);
+	const PotentialBlock* owner = onFirst ? s1 : s2;  const State& ownerState = onFirst ? state1 : state2;
+	const PotentialBlock* other = onFirst ? s2 : s1;  const State& otherState = onFirst ? state2 : state1;
+	int i = onFirst ? plane : plane - planeNoA;
+	if (i < 0 || i >= (int)owner->a.size() || other->offsetVertices.empty()){ return false; }
+	/* plane n.x <= d+r of the owner, expressed in local coordinates of the other particle */
+	Vector3r n = otherState.ori.conjugate()*(ownerState.ori*Vector3r(owner->a[i], owner->b[i], owner->c[i]));
+	double offset = owner->d[i] + owner->r - n.dot(otherState.ori.conjugate()*(otherState.pos - ownerState.pos));
+	for (unsigned int j=0; j<other->offsetVertices.size(); j++){
+		if (n.dot(other->offsetVertices[j]) <= offset){ return false; }
+	}
+	return true;
+}
+
+
+int Ig2_PB_PB_ScGeom::findSeparatingPlane(const PotentialBlock* s1, const State& state1, const PotentialBlock* s2, const State& state2){
+	/* particles may also be separated by a plane through edges of both, then no plane is found and the linear program is solved again at the next step */
+	int totalPlanes = s1->a.size() + s2->a.size();
+	for (int i=0; i<totalPlanes; i++){
+		if (separatedByPlane(s1, state1, s2, state2, i)){ return i; }
+	}
+	return -1;
+}
+
+
 bool Ig2_PB_PB_ScGeom::startingPointFeasibilityCLP(const shared_ptr<Shape>& cm1, const State& state1, const shared_ptr<Shape>& cm2, const State& state2, Vector3r &contactPoint, bool &convergeFeasibility){
 
 //timingDeltas->start(); 
-  Vector3r xGlobal (0,0,0); double rescale = 1.0; bool converge = true;
+  Vector3r xGlobal (0,0,0);
 /* minimise s */
 /* s.t. Ax - s <= d*/
   PotentialBlock *s1=static_cast<PotentialBlock*>(cm1.get());
@@ -992,37 +910,12 @@ bool Ig2_PB_PB_ScGeom::startingPointFeasibilityCLP(const shared_ptr<Shape>& cm1,
 /* Parameters for particles A and B */
   int planeNoA = s1->a.size();
   int planeNoB = s2->a.size();
-  Matrix3r Q1 = state1.ori.toRotationMatrix().transpose(); //(state1.ori.conjugate()).toRotationMatrix(); 
-  Matrix3r Q2 = state2.ori.toRotationMatrix().transpose(); //(state2.ori.conjugate()).toRotationMatrix();
-  Eigen::MatrixXd A1 = Eigen::MatrixXd::Zero(planeNoA,3);
-  for (int i=0; i < planeNoA; i++){
-	A1(i,0) = s1->a[i]/rescale; A1(i,1) = s1->b[i]/rescale; A1(i,2) = s1->c[i]/rescale;
-  }
-  Eigen::MatrixXd A2 = Eigen::MatrixXd::Zero(planeNoB,3);
-  for (int i=0; i < planeNoB; i++){
-	A2(i,0) = s2->a[i]/rescale; A2(i,1) =s2->b[i]/rescale; A2(i,2) = s2->c[i]/rescale;
-  }
-  Eigen::MatrixXd AQ1 = A1*Q1;
-  Eigen::MatrixXd AQ2 = A2*Q2;
-
-  Eigen::MatrixXd pos1(3,1); 
-  pos1(0,0) = rescale*state1.pos.x(); 
-  pos1(1,0) = rescale*state1.pos.y(); 
-  pos1(2,0) = rescale*state1.pos.z();
-  Eigen::MatrixXd Q1pos1 = AQ1*pos1;
-  Eigen::MatrixXd pos2(3,1); pos2(0,0) = rescale*state2.pos.x(); pos2(1,0) = rescale*state2.pos.y(); pos2(2,0) = rescale*state2.pos.z();
-  Eigen::MatrixXd Q2pos2 = AQ2*pos2;
-
- // Eigen::MatrixXd xinit(3,1);
-  Eigen::MatrixXd b1 = Q1pos1;// - AQ1*xinit;
-  Eigen::MatrixXd b2 = Q2pos2;// - AQ2*xinit;
-  double constraintInit[planeNoA+planeNoB];
-  for (int i=0; i<planeNoA; i++){
-	constraintInit[i] = b1(i,0);
-  }
-  for (int i=0; i<planeNoB; i++){
-	constraintInit[planeNoA+i] = b2(i,0);
-  }
+  Matrix3r Q1 = state1.ori.toRotationMatrix(); 
+  Matrix3r Q2 = state2.ori.toRotationMatrix();
+  /* rows of A*Q^T are the plane normals in global coordinates */
+  Vector3r AQ1[planeNoA]; Vector3r AQ2[planeNoB];
+  for (int i=0; i < planeNoA; i++){ AQ1[i] = Q1*Vector3r(s1->a[i], s1->b[i], s1->c[i]); }
+  for (int i=0; i < planeNoB; i++){ AQ2[i] = Q2*Vector3r(s2->a[i], s2->b[i], s2->c[i]); }
 /* Parameters for particles A and B */
   double s = 0.0; /* get value of x[3] after optimization */
   int NUMCON = planeNoA + planeNoB; 
@@ -1052,10 +945,10 @@ double rowUpper[numberRows];
 
 // Rows
 for(int i=0; i<planeNoA; i++  ){
-	rowUpper[i] = s1->d[i] + s1->r + Q1pos1(i,0); 
+	rowUpper[i] = s1->d[i] + s1->r + AQ1[i].dot(state1.pos); 
 }
 for(int i=0; i<planeNoB; i++  ){
-	rowUpper[planeNoA + i] = s2->d[i] + s2->r + Q2pos2(i,0); 
+	rowUpper[planeNoA + i] = s2->d[i] + s2->r + AQ2[i].dot(state2.pos); 
 }
 for (int k = 0; k < numberRows; k++) {
          rowLower[k] = -COIN_DBL_MAX; 
@@ -1063,12 +956,12 @@ for (int k = 0; k < numberRows; k++) {
 
 for (int i = 0; i < planeNoA;i++){
 	int rowIndex[] = {0, 1, 2, 3};
-	double rowValue[] = {AQ1(i,0), AQ1(i,1), AQ1(i,2), -1.0};
+	double rowValue[] = {AQ1[i].x(), AQ1[i].y(), AQ1[i].z(), -1.0};
 	model2.addRow(4, rowIndex, rowValue,rowLower[i], rowUpper[i]);
 }        
 for (int i = 0; i < planeNoB;i++){
 	int rowIndex[] = {0, 1, 2, 3};
-	double rowValue[] = {AQ2(i,0), AQ2(i,1), AQ2(i,2), -1.0};
+	double rowValue[] = {AQ2[i].x(), AQ2[i].y(), AQ2[i].z(), -1.0};
 	model2.addRow(4, rowIndex, rowValue,rowLower[planeNoA+i], rowUpper[planeNoA+i]);
 }                
 
@@ -1084,7 +977,7 @@ model2.setLogLevel(0);
           // Alternatively getColSolution()
           double * columnPrimal = model2.primalColumnSolution();
 
-    xGlobal = Vector3r(columnPrimal[0],columnPrimal[1],columnPrimal[2])/rescale;
+    xGlobal = Vector3r(columnPrimal[0],columnPrimal[1],columnPrimal[2]);
     contactPoint = xGlobal; 
     s = columnPrimal[3];
    
@@ -11,6 +11,7 @@
 #include<pkg/dem/PotentialBlock.hpp>
 #include<pkg/common/Dispatching.hpp>
 #include<pkg/common/Sphere.hpp>
+#include<pkg/dem/ScGeom.hpp>
 #include<Python.h>
 #include<Eigen/Core>
 #include <stdio.h>
@@ -35,6 +36,19 @@
 #include <iomanip>
 #include <cassert>
 
+class PBScGeom: public ScGeom
+{
+	public:
+		virtual ~PBScGeom();
+	YADE_CLASS_BASE_DOC_ATTRS_CTOR(PBScGeom,ScGeom,"Geometry of the contact between two :yref:`PotentialBlocks<PotentialBlock>`, keeping the state of :yref:`Ig2_PB_PB_ScGeom` from the previous step (the contact point is :yref:`contactPoint<GenericSpheresContact.contactPoint>`); all constitutive laws for :yref:`ScGeom` apply.",
+		((int, separatingPlane, -1,, "plane separating the particles at the previous step (planes of the second particle are numbered after those of the first one), -1 if none is known"))
+		,
+		createIndex(); /*ctor*/
+	);
+	REGISTER_CLASS_INDEX(PBScGeom,ScGeom);
+};
+REGISTER_SERIALIZABLE(PBScGeom);
+
 class Ig2_PB_PB_ScGeom: public IGeomFunctor
 {
 
@@ -59,13 +73,16 @@ class Ig2_PB_PB_ScGeom: public IGeomFunctor
 		void getPtOnParticleArea(const shared_ptr<Shape>& cm1, const State& state1, Vector3r previousPt, Vector3r normal, Vector3r& newlocalPoint);
 		bool getPtOnParticleAreaNormal(const shared_ptr<Shape>& cm1, const State& state1, const Vector3r previousPt, const Vector3r prevDir, const int prevNo, Vector3r& newlocalPoint, Vector3r& newNormal, int& newNo);
 		bool contactPtMosekF2(const shared_ptr<Shape>& cm1, const State& state1, const shared_ptr<Shape>& cm2, const State& state2, Vector3r &contactPt);
-		double getDet(const Eigen::MatrixXd A);
+		double getDet(const Eigen::MatrixXd& A);
 		bool customSolve(const shared_ptr<Shape>& cm1, const State& state1, const shared_ptr<Shape>& cm2, const State& state2, Vector3r &contactPt, bool warmstart);
 		
 		double evaluatePhys(const shared_ptr<Shape>& cm1,  const State& state1, const Vector3r newTrial, double& phi_b, double& phi_r, double& JRC, double& JSC, double& cohesion, double& sigmaC, double& asperity, double& tension, double &lambda0, double &heatCapacity, double &hwater, bool &intactRock, int &activePlanesNo, int &jointType);
 		Vector3r getNormal(const shared_ptr<Shape>& cm1, const State& state1, const Vector3r newTrial);
 		
 		void BrentZeroSurf(const shared_ptr<Shape>& cm1, const State& state1, const Vector3r bracketA, const Vector3r bracketB, Vector3r& zero);
+		bool insidePlanes(const PotentialBlock* s1, const State& state1, const Vector3r& pt);
+		bool separatedByPlane(const PotentialBlock* s1, const State& state1, const PotentialBlock* s2, const State& state2, int plane);
+		int findSeparatingPlane(const PotentialBlock* s1, const State& state1, const PotentialBlock* s2, const State& state2);
 		bool startingPointFeasibilityCLP(const shared_ptr<Shape>& cm1, const State& state1, const shared_ptr<Shape>& cm2, const State& state2, Vector3r &contactPoint, bool &convergeFeasibility);
 	
 		bool customSolveAnalyticCentre(const shared_ptr<Shape>& cm1, const State& state1, const shared_ptr<Shape>& cm2, const State& state2, Vector3r& contactPt);
@@ -79,7 +96,8 @@ class Ig2_PB_PB_ScGeom: public IGeomFunctor
 			((double, stepAngle, pow(10,-2),, "accuracy desired, tolerance criteria for SOCP"))
 			((double,interactionDetectionFactor,1.0,,"bool to avoid granular ratcheting"))
 			((Vector3r, twoDdir, Vector3r(0,1,0),, "to get radius of curvature"))
-			((bool,twoDimension,false,,"bool to avoid granular ratcheting")),
+			((bool,twoDimension,false,,"bool to avoid granular ratcheting"))
+			((bool,warmStart,true,,"Reuse the previous contact point as starting point of the analytic centre if it lies strictly inside both particles, and the plane found to separate non-overlapping particles at the previous step, instead of solving the linear program for a starting point at every step. Particles whose circumscribed spheres (:yref:`outRadius<PotentialBlock.outRadius>`) do not overlap are skipped, and overlapping inscribed spheres (:yref:`inRadius<PotentialBlock.inRadius>`) give a starting point directly, regardless of this flag.")),
 			//((std::string,myfile,"./PotentialBlocks"+"","string")),
 			//timingDeltas=shared_ptr<TimingDeltas>(new TimingDeltas);
 			//mosekTaskEnv = MSK_makeenv(&mosekEnv,NULL,NULL,NULL,NULL);
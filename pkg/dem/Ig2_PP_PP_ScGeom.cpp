@@ -89,22 +89,27 @@ bool Ig2_PP_PP_ScGeom::go(const shared_ptr<Shape>& cm1,const shared_ptr<Shape>&
 
 	}
 
-	converge = true;
-	fA= evaluatePP(cm1,state1, contactPt);
-	fB = evaluatePP(cm2,state2, contactPt);
-
-//Default does not have warmstart
-	//if(fA < 0.0 && fB <0.0){
-	//	converge = customSolve(cm1,state1,cm2,state2,contactPt,true);
-	//}else{
-	converge = customSolve(cm1,state1,cm2,state2,contactPt,false);
-	//}
+	/* Particles farther apart than the sum of their circumscribed radii (the same as used by PotentialParticle2AABB) do not touch */
+	bool separated = ((state2.pos-state1.pos).norm() > circumscribedRadius(s1)+circumscribedRadius(s2));
+	if (separated == false) {
+		/* Warm start from the previous contact point if it is still inside both particles, cold start if it does not converge */
+		if (warmStart == true && hasGeom == true && scm->penetrationDepth > 0.0) {
+			fA= evaluatePP(cm1,state1, contactPt);
+			fB = evaluatePP(cm2,state2, contactPt);
+			if(fA < 0.0 && fB <0.0) {
+				converge = customSolve(cm1,state1,cm2,state2,contactPt,true);
+			}
+		}
+		if (converge == false) {
+			converge = customSolve(cm1,state1,cm2,state2,contactPt,false);
+		}
+	}
 
 
 // if you have mosek uncomment this.  Mosek is more robust but slightly slower as an external library
 #ifdef YADE_MOSEK
 	/* Mosek */
-	if( converge==false ) {
+	if( converge==false && separated==false ) {
 		//std::cout<<"mosek used"<<endl;
 		contactPt = 0.5*(state1.pos+state2.pos);
 		contactPtMosekF2(cm1,  state1, cm2,  state2, contactPt);
@@ -192,6 +197,15 @@ bool Ig2_PP_PP_ScGeom::go(const shared_ptr<Shape>& cm1,const shared_ptr<Shape>&
 
 
 
+Real Ig2_PP_PP_ScGeom::circumscribedRadius(const PotentialParticle* pp) {
+	if(pp->AabbMinMax == false) {
+		return 1.05*pp->R;
+	}
+	return 1.05*pp->maxAabbRotated.cwiseMax(pp->minAabbRotated).norm();
+}
+
+
+
 void Ig2_PP_PP_ScGeom::BrentZeroSurf(const shared_ptr<Shape>& cm1, const State& state1, const Vector3r bracketA, const Vector3r bracketB, Vector3r& zero) {
 
 	Real a = 0.0;
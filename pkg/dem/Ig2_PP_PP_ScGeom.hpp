@@ -38,13 +38,15 @@ class Ig2_PP_PP_ScGeom: public IGeomFunctor {
 		bool contactPtMosekF2(const shared_ptr<Shape>& cm1, const State& state1, const shared_ptr<Shape>& cm2, const State& state2, Vector3r &contactPt);
 		bool customSolve(const shared_ptr<Shape>& cm1, const State& state1, const shared_ptr<Shape>& cm2, const State& state2, Vector3r &contactPt, bool warmstart);
 		Vector3r getNormal(const shared_ptr<Shape>& cm1, const State& state1, const Vector3r newTrial);
+		Real circumscribedRadius(const PotentialParticle* pp);
 		void BrentZeroSurf(const shared_ptr<Shape>& cm1, const State& state1, const Vector3r bracketA, const Vector3r bracketB, Vector3r& zero);
 
 		/////////////////////////////////////////////////////////////////////////////////////////////////////
 
 		YADE_CLASS_BASE_DOC_ATTRS_CTOR(Ig2_PP_PP_ScGeom,IGeomFunctor,"EXPERIMENTAL. IGeom functor for PotentialParticle - PotentialParticle pair",
 			((Real, accuracyTol, pow(10,-7),, "accuracy desired, tolerance criteria for SOCP"))
-			((Real,interactionDetectionFactor,1.0,,"bool to avoid granular ratcheting")),
+			((Real,interactionDetectionFactor,1.0,,"bool to avoid granular ratcheting"))
+			((bool,warmStart,true,,"Start the solver from the contact point of the previous step (with a smaller initial perturbation) if it is still inside both particles; the solver is started again from scratch if it does not converge.")),
 			//((std::string,myfile,"./PotentialParticles"+"","string")),
 			//timingDeltas=shared_ptr<TimingDeltas>(new TimingDeltas);
 			//mosekTaskEnv = MSK_makeenv(&mosekEnv,NULL,NULL,NULL,NULL);
@@ -0,0 +1,45 @@
+#include"Ig2_TriMesh_Sphere_ScGeom.hpp"
+#include<core/Scene.hpp>
+#include<pkg/common/InteractionLoop.hpp>
+
+YADE_PLUGIN((TriMeshScGeom)(Ig2_TriMesh_Sphere_ScGeom));
+
+TriMeshScGeom::~TriMeshScGeom(){}
+
+bool Ig2_TriMesh_Sphere_ScGeom::go(const shared_ptr<Shape>& cm1, const shared_ptr<Shape>& cm2, const State& state1, const State& state2, const Vector3r& shift2, const bool& force, const shared_ptr<Interaction>& c){
+	TIMING_DELTAS_START();
+	const TriMesh* mesh=static_cast<TriMesh*>(cm1.get());
+	const Real radius=static_cast<Sphere*>(cm2.get())->radius;
+	const Matrix3r meshAxisT=state1.ori.toRotationMatrix();
+	const Vector3r center=meshAxisT.transpose()*(state2.pos+shift2-state1.pos); // sphere center in mesh-local coords
+	shared_ptr<TriMeshScGeom> geom;
+	if(c->geom) geom=YADE_PTR_CAST<TriMeshScGeom>(c->geom);
+	// existing contacts are followed beyond the radius, the constitutive law is responsible for setting Interaction::isReal=false
+	const Real maxDist=((c->isReal() || force) ? std::numeric_limits<Real>::infinity() : radius);
+	Vector3r closest;
+	const int tri=mesh->closestTriangle(center,maxDist,closest,geom ? geom->triangle : -1);
+	if(tri<0){ TIMING_DELTAS_CHECKPOINT("Ig2_TriMesh_Sphere_ScGeom"); return false; }
+	Vector3r normal=center-closest;
+	const Real dist=normal.norm();
+	if(dist>0) normal/=dist;
+	else normal=mesh->triangleNormal(tri); // center exactly on the surface
+	const Real penetrationDepth=radius-dist;
+	if(penetrationDepth<=0 && !c->isReal()){ TIMING_DELTAS_CHECKPOINT("Ig2_TriMesh_Sphere_ScGeom"); return false; }
+
+	const bool isNew=!geom;
+	if(isNew){ geom=shared_ptr<TriMeshScGeom>(new TriMeshScGeom()); c->geom=geom; }
+	normal=meshAxisT*normal; // in global orientation
+	geom->triangle=tri;
+	geom->contactPoint=state2.pos+shift2-(radius-0.5*penetrationDepth)*normal;
+	geom->penetrationDepth=penetrationDepth;
+	geom->radius1=2*radius;
+	geom->radius2=radius;
+	geom->precompute(state1,state2,scene,c,normal,isNew,shift2,false/*avoidGranularRatcheting only for sphere-sphere*/);
+	TIMING_DELTAS_CHECKPOINT("Ig2_TriMesh_Sphere_ScGeom");
+	return true;
+}
+
+bool Ig2_TriMesh_Sphere_ScGeom::goReverse(const shared_ptr<Shape>& cm1, const shared_ptr<Shape>& cm2, const State& state1, const State& state2, const Vector3r& shift2, const bool& force, const shared_ptr<Interaction>& c){
+	c->swapOrder();
+	return go(cm2,cm1,state2,state1,-shift2,force,c);
+}
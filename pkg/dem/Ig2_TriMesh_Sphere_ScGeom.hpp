@@ -0,0 +1,28 @@
+#pragma once
+#include<pkg/common/Dispatching.hpp>
+#include<pkg/common/TriMesh.hpp>
+#include<pkg/common/Sphere.hpp>
+#include<pkg/dem/ScGeom.hpp>
+
+/*! ScGeom remembering which triangle of a TriMesh is in contact. */
+class TriMeshScGeom: public ScGeom{
+	public:
+		virtual ~TriMeshScGeom();
+	YADE_CLASS_BASE_DOC_ATTRS_CTOR(TriMeshScGeom,ScGeom,"Geometry of the contact between :yref:`TriMesh` and :yref:`Sphere`; all constitutive laws for :yref:`ScGeom` apply.",
+		((int,triangle,-1,,"Index of the triangle of the mesh closest to the sphere (the contact point may lie on its edge or vertex)."))
+		,
+		/*ctor*/ createIndex();
+	);
+	REGISTER_CLASS_INDEX(TriMeshScGeom,ScGeom);
+};
+REGISTER_SERIALIZABLE(TriMeshScGeom);
+
+class Ig2_TriMesh_Sphere_ScGeom: public IGeomFunctor{
+	public:
+		virtual bool go(const shared_ptr<Shape>& cm1, const shared_ptr<Shape>& cm2, const State& state1, const State& state2, const Vector3r& shift2, const bool& force, const shared_ptr<Interaction>& c);
+		virtual bool goReverse(const shared_ptr<Shape>& cm1, const shared_ptr<Shape>& cm2, const State& state1, const State& state2, const Vector3r& shift2, const bool& force, const shared_ptr<Interaction>& c);
+	YADE_CLASS_BASE_DOC(Ig2_TriMesh_Sphere_ScGeom,IGeomFunctor,"Create/update a :yref:`TriMeshScGeom` representing the intersection of :yref:`TriMesh` and :yref:`Sphere`. The sphere center is transformed to mesh-local coordinates and the closest point of the mesh is found in its bounding volume hierarchy, starting from the triangle found at the previous step. There is one contact per sphere and mesh, therefore spheres sliding over edges shared by several triangles do not get multiple contacts as with :yref:`Facets<Facet>`; the normal goes from the closest point (on a face, an edge or a vertex) to the sphere center. Like for :yref:`Ig2_Facet_Sphere_ScGeom`, :yref:`radius1<GenericSpheresContact.refR1>` is twice the sphere radius; it does not give the branch vector of the mesh, which is generally far from the contact point. Torques on the mesh must therefore be computed from :yref:`contactPoint<GenericSpheresContact.contactPoint>`: :yref:`Law2_ScGeom_FrictPhys_CundallStrack` does it for :yref:`TriMeshScGeom` regardless of :yref:`sphericalBodies<Law2_ScGeom_FrictPhys_CundallStrack.sphericalBodies>`, other laws need ``sphericalBodies=False`` (when they have it) or a non-rotating mesh.");
+	FUNCTOR2D(TriMesh,Sphere);
+	DEFINE_FUNCTOR_ORDER_2D(TriMesh,Sphere);
+};
+REGISTER_SERIALIZABLE(Ig2_TriMesh_Sphere_ScGeom);
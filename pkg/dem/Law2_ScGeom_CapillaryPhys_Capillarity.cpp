@@ -16,22 +16,33 @@
 #include <core/Scene.hpp>
 #include <lib/base/Math.hpp>
 #include <pkg/common/Sphere.hpp>
+#include <boost/filesystem.hpp>
+#include <cstdint>
 
 YADE_PLUGIN((Law2_ScGeom_CapillaryPhys_Capillarity));
 
-void Law2_ScGeom_CapillaryPhys_Capillarity::postLoad(Law2_ScGeom_CapillaryPhys_Capillarity&){
+shared_ptr<capillarylaw> Law2_ScGeom_CapillaryPhys_Capillarity::readAsciiTables(){
+  shared_ptr<capillarylaw> law(new capillarylaw);
+  law->fill(("M(r=1)"+suffCapFiles).c_str());
+  law->fill(("M(r=1.1)"+suffCapFiles).c_str());
+  law->fill(("M(r=1.25)"+suffCapFiles).c_str());
+  law->fill(("M(r=1.5)"+suffCapFiles).c_str());
+  law->fill(("M(r=1.75)"+suffCapFiles).c_str());
+  law->fill(("M(r=2)"+suffCapFiles).c_str());
+  law->fill(("M(r=3)"+suffCapFiles).c_str());
+  law->fill(("M(r=4)"+suffCapFiles).c_str());
+  law->fill(("M(r=5)"+suffCapFiles).c_str());
+  law->fill(("M(r=10)"+suffCapFiles).c_str());
+  return law;
+}
 
-  capillary = shared_ptr<capillarylaw>(new capillarylaw);
-  capillary->fill(("M(r=1)"+suffCapFiles).c_str());
-  capillary->fill(("M(r=1.1)"+suffCapFiles).c_str());
-  capillary->fill(("M(r=1.25)"+suffCapFiles).c_str());
-  capillary->fill(("M(r=1.5)"+suffCapFiles).c_str());
-  capillary->fill(("M(r=1.75)"+suffCapFiles).c_str());
-  capillary->fill(("M(r=2)"+suffCapFiles).c_str());
-  capillary->fill(("M(r=3)"+suffCapFiles).c_str());
-  capillary->fill(("M(r=4)"+suffCapFiles).c_str());
-  capillary->fill(("M(r=5)"+suffCapFiles).c_str());
-  capillary->fill(("M(r=10)"+suffCapFiles).c_str());
+void Law2_ScGeom_CapillaryPhys_Capillarity::postLoad(Law2_ScGeom_CapillaryPhys_Capillarity&){
+  table.reset();
+  if (binaryTable.empty()) { capillary = readAsciiTables(); return; }
+  // the ASCII files are only needed once, to create the binary table
+  if (!boost::filesystem::exists(binaryTable)) CapillaryTable::convert(*readAsciiTables(),binaryTable,tableGrid[0],tableGrid[1]);
+  table = shared_ptr<CapillaryTable>(new CapillaryTable(binaryTable));
+  capillary.reset();
 }
 
 
@@ -61,7 +72,7 @@ MeniscusParameters::~MeniscusParameters()
 void Law2_ScGeom_CapillaryPhys_Capillarity::action()
 {
 	if (!scene) cerr << "scene not defined!";
-	if (!capillary) postLoad(*this);//when the script does not define arguments, postLoad is never called
+	if (!capillary && !table) postLoad(*this);//when the script does not define arguments, postLoad is never called
 	shared_ptr<BodyContainer>& bodies = scene->bodies;
 	int sphereIndex = Sphere::getClassIndexStatic();
 	
@@ -81,7 +92,14 @@ void Law2_ScGeom_CapillaryPhys_Capillarity::action()
 	
 	if (fusionDetection && !bodiesMenisciiList.initialized) bodiesMenisciiList.prepare(scene,hertzOn);
 
-	FOREACH(const shared_ptr<Interaction>& interaction, *scene->interactions){ // could be done in parallel as soon as OpenMPVector class (lib/base/openmp-accu.hpp) is extended See http://www.mail-archive.com/yade-dev@lists.launchpad.net/msg10842.html and msg11238.html
+	#ifdef YADE_OPENMP
+	const long nInteractions=scene->interactions->size();
+	#pragma omp parallel for schedule(guided) num_threads(ompThreads>0 ? min(ompThreads,omp_get_max_threads()) : omp_get_max_threads())
+	for(long i=0; i<nInteractions; i++){
+		const shared_ptr<Interaction>& interaction=(*scene->interactions)[i];
+	#else
+	FOREACH(const shared_ptr<Interaction>& interaction, *scene->interactions){
+	#endif
 		/// interaction is real
 		if (interaction->isReal()) {
 			CapillaryPhys* cundallContactPhysics=NULL;
@@ -138,14 +156,19 @@ void Law2_ScGeom_CapillaryPhys_Capillarity::action()
 				int* currentIndexes =  hertzOn? mindlinContactPhysics->currentIndexes : cundallContactPhysics->currentIndexes;
 				//If P=0, we use null solution
 				MeniscusParameters
-				solution(Pinterpol? capillary->interpolate(R1,R2,Dinterpol, Pinterpol, currentIndexes) : MeniscusParameters());
+				solution(!Pinterpol ? MeniscusParameters() : (table ? table->interpolate(R1,R2,Dinterpol,Pinterpol) : capillary->interpolate(R1,R2,Dinterpol, Pinterpol, currentIndexes)));
 				/// If no bridge, delete the interaction if necessary and escape
 				if (!solution.V) {
 					if ((fusionDetection) || (hertzOn ? mindlinContactPhysics->isBroken : cundallContactPhysics->isBroken)) bodiesMenisciiList.remove(interaction);
 					if (D>0) {scene->interactions->requestErase(interaction); continue;}
-					else if ((Pinterpol > 0) && (showError)) {
-						LOG_ERROR("No meniscus found at a contact. capillaryPressure may be too large wrt. the loaded data files."); // V=0 at a contact reveals a problem if and only if uc* > 0
-						showError = false;}//show error message once / avoid console spam	
+					else if (Pinterpol > 0) {// V=0 at a contact reveals a problem if and only if uc* > 0
+						bool show;
+						#ifdef YADE_OPENMP
+						#pragma omp critical(capillarityShowError)
+						#endif
+						{ show = showError; showError = false; }//show error message once / avoid console spam, showError is shared by the threads of the loop
+						if (show) LOG_ERROR("No meniscus found at a contact. capillaryPressure may be too large wrt. the loaded data files.");
+					}
 				}
 				/// capillary adhesion force
 				Real Finterpol = solution.F;
@@ -228,69 +251,62 @@ void capillarylaw::fill(const char* filename)
 
 void Law2_ScGeom_CapillaryPhys_Capillarity::checkFusion()
 {
-	//Reset fusion numbers
-	FOREACH(const shared_ptr<Interaction>& interaction, *scene->interactions){ // same remark for parallel loops, the most problematic part ?
+	bodiesMenisciiList.update(scene,hertzOn);
+	const vector< shared_ptr<Interaction> >& menisci = bodiesMenisciiList.menisci;
+	const vector<int>& offsets = bodiesMenisciiList.offsets;
+	const vector<int>& adjacency = bodiesMenisciiList.adjacency;
+	const int nBodies = bodiesMenisciiList.size();
+	const long nMenisci = menisci.size();
+
+	// angle of each meniscus on the body of its range in adjacency, and normal oriented outwards from that body
+	vector<Real> angles(adjacency.size());
+	vector<Vector3r> normals(adjacency.size());
+	vector<short int> fusions(adjacency.size(),0);
+	#ifdef YADE_OPENMP
+	#pragma omp parallel for schedule(guided) num_threads(ompThreads>0 ? min(ompThreads,omp_get_max_threads()) : omp_get_max_threads())
+	#endif
+	for (int i=0; i<nBodies; ++i) {
+		for (int s=offsets[i]; s<offsets[i+1]; ++s) {
+			const Interaction* I = menisci[adjacency[s]].get();
+			const bool first = (i == I->getId1());
+			if (!hertzOn) { const CapillaryPhys* phys = YADE_CAST<CapillaryPhys*>(I->phys.get()); angles[s] = first ? phys->Delta1 : phys->Delta2; }
+			else { const MindlinCapillaryPhys* phys = YADE_CAST<MindlinCapillaryPhys*>(I->phys.get()); angles[s] = first ? phys->Delta1 : phys->Delta2; }
+			const Vector3r& normal = YADE_CAST<ScGeom*>(I->geom.get())->normal;
+			normals[s] = first ? normal : Vector3r(-normal);
+		}
+		// count, for every meniscus on this body, the other menisci of the body overlapping it; each thread only writes the range of its bodies
+		for (int s=offsets[i]; s<offsets[i+1]; ++s) {
+			for (int t=offsets[i]; t<offsets[i+1]; ++t) {
+				if (t==s) continue;
+				const Real normalDot = normals[s].dot(normals[t]);
+				Real normalAngle = 0;
+				if (normalDot >= 0 ) normalAngle = Mathr::FastInvCos0(normalDot);
+				else normalAngle = ((Mathr::PI) - Mathr::FastInvCos0(-(normalDot)));
+				if ((angles[s]+angles[t])*Mathr::DEG_TO_RAD > normalAngle) ++fusions[s];
+			}
+		}
+	}
+
+	//Reset fusion numbers, then sum the overlaps of each meniscus on both bodies
+	const long size = scene->interactions->size();
+	#ifdef YADE_OPENMP
+	#pragma omp parallel for schedule(static) num_threads(ompThreads>0 ? min(ompThreads,omp_get_max_threads()) : omp_get_max_threads())
+	#endif
+	for (long k=0; k<size; ++k) {
+		const shared_ptr<Interaction>& interaction = (*scene->interactions)[k];
 		if ( interaction->isReal()) {
 			if (!hertzOn) static_cast<CapillaryPhys*>(interaction->phys.get())->fusionNumber=0;
 			else static_cast<MindlinCapillaryPhys*>(interaction->phys.get())->fusionNumber=0;
 		}
 	}
-
-	list< shared_ptr<Interaction> >::iterator firstMeniscus, lastMeniscus, currentMeniscus;
-	Real angle1 = -1.0; Real angle2 = -1.0;
-	
-	for ( int i=0; i< bodiesMenisciiList.size(); ++i ) { // i is the index (or id) of the body being tested
-		CapillaryPhys* cundallInteractionPhysics1=NULL;
-		MindlinCapillaryPhys* mindlinInteractionPhysics1=NULL;
-		CapillaryPhys* cundallInteractionPhysics2=NULL;
-		MindlinCapillaryPhys* mindlinInteractionPhysics2=NULL;
-		if ( !bodiesMenisciiList[i].empty() ) {
-			lastMeniscus = bodiesMenisciiList[i].end();
-			for ( firstMeniscus=bodiesMenisciiList[i].begin(); firstMeniscus!=lastMeniscus; ++firstMeniscus ) { //FOR EACH MENISCUS ON THIS BODY...
-				currentMeniscus = firstMeniscus; ++currentMeniscus;
-				if (!hertzOn) {
-					cundallInteractionPhysics1 = YADE_CAST<CapillaryPhys*>((*firstMeniscus)->phys.get());
-					if (i == (*firstMeniscus)->getId1()) angle1=cundallInteractionPhysics1->Delta1;//get angle of meniscus1 on body i
-					else angle1=cundallInteractionPhysics1->Delta2;
-				}
-				else {
-					mindlinInteractionPhysics1 = YADE_CAST<MindlinCapillaryPhys*>((*firstMeniscus)->phys.get());
-					if (i == (*firstMeniscus)->getId1()) angle1=mindlinInteractionPhysics1->Delta1;//get angle of meniscus1 on body i
-					else angle1=mindlinInteractionPhysics1->Delta2;
-				}
-				for ( ;currentMeniscus!= lastMeniscus; ++currentMeniscus) {//... CHECK FUSION WITH ALL OTHER MENISCII ON THE BODY
-					if (!hertzOn) {
-						cundallInteractionPhysics2 = YADE_CAST<CapillaryPhys*>((*currentMeniscus)->phys.get());
-						if (i == (*currentMeniscus)->getId1()) angle2=cundallInteractionPhysics2->Delta1;//get angle of meniscus2 on body i
-						else angle2=cundallInteractionPhysics2->Delta2;
-					}
-					else {
-						mindlinInteractionPhysics2 = YADE_CAST<MindlinCapillaryPhys*>((*currentMeniscus)->phys.get());
-						if (i == (*currentMeniscus)->getId1()) angle2=mindlinInteractionPhysics2->Delta1;//get angle of meniscus2 on body i
-						else angle2=mindlinInteractionPhysics2->Delta2;
-					}
-					if (angle1==0 || angle2==0) cerr << "THIS SHOULD NOT HAPPEN!!"<< endl;
-
-					//cerr << "angle1 = " << angle1 << " | angle2 = " << angle2 << endl;
-
-					Vector3r normalFirstMeniscus = YADE_CAST<ScGeom*>((*firstMeniscus)->geom.get())->normal;
-					Vector3r normalCurrentMeniscus = YADE_CAST<ScGeom*>((*currentMeniscus)->geom.get())->normal;
-
-					Real normalDot = 0;
-					if ((*firstMeniscus)->getId1() ==  (*currentMeniscus)->getId1() ||  (*firstMeniscus)->getId2()  == (*currentMeniscus)->getId2()) normalDot = normalFirstMeniscus.dot(normalCurrentMeniscus);
-					else normalDot = - (normalFirstMeniscus.dot(normalCurrentMeniscus));
-
-					Real normalAngle = 0;
-					if (normalDot >= 0 ) normalAngle = Mathr::FastInvCos0(normalDot);
-					else normalAngle = ((Mathr::PI) - Mathr::FastInvCos0(-(normalDot)));
-
-					if ((angle1+angle2)*Mathr::DEG_TO_RAD > normalAngle) {
-						if (!hertzOn) {++(cundallInteractionPhysics1->fusionNumber); ++(cundallInteractionPhysics2->fusionNumber);}//count +1 if 2 meniscii are overlaping
-						else {++(mindlinInteractionPhysics1->fusionNumber); ++(mindlinInteractionPhysics2->fusionNumber);}
-					}
-				}
-			}
-		}
+	const vector<int>& slots = bodiesMenisciiList.slots;
+	#ifdef YADE_OPENMP
+	#pragma omp parallel for schedule(static) num_threads(ompThreads>0 ? min(ompThreads,omp_get_max_threads()) : omp_get_max_threads())
+	#endif
+	for (long k=0; k<nMenisci; ++k) {
+		const short int fusionNumber = fusions[slots[2*k]]+fusions[slots[2*k+1]];
+		if (!hertzOn) static_cast<CapillaryPhys*>(menisci[k]->phys.get())->fusionNumber=fusionNumber;
+		else static_cast<MindlinCapillaryPhys*>(menisci[k]->phys.get())->fusionNumber=fusionNumber;
 	}
 }
 
@@ -345,6 +361,85 @@ MeniscusParameters capillarylaw::interpolate(Real R1, Real R2, Real D, Real P, i
         return result;
 }
 
+CapillaryTable::CapillaryTable(const string& fileName)
+{
+	file.open(fileName);
+	if (!file.is_open()) throw std::runtime_error("Law2_ScGeom_CapillaryPhys_Capillarity: unable to open the binary table "+fileName);
+	const char* data = file.data();
+	const size_t headerSize = 8+4*sizeof(uint32_t)+2*sizeof(double);
+	uint32_t header[4];
+	if (file.size()<headerSize || string(data,8)!="YADECAP1") throw std::runtime_error(fileName+" is not a binary capillary table.");
+	memcpy(header,data+8,sizeof(header));
+	if (header[0]!=0x01020304) throw std::runtime_error(fileName+" was written on a machine with different byte order, delete it to convert the ASCII files again.");
+	nR = header[1]; nD = header[2]; nP = header[3];
+	double range[2];
+	memcpy(range,data+8+sizeof(header),sizeof(range));
+	dMax = range[0]; pMax = range[1];
+	if (nR<1 || nD<2 || nP<2 || file.size()!=headerSize+nR*sizeof(double)+size_t(nR)*nD*nP*6*sizeof(float)) throw std::runtime_error(fileName+": inconsistent size of the binary capillary table.");
+	rValues.resize(nR);
+	for (int i=0; i<nR; i++) { double r; memcpy(&r,data+headerSize+i*sizeof(double),sizeof(double)); rValues[i]=r; }
+	dD = dMax/(nD-1); dP = pMax/(nP-1);
+	values = reinterpret_cast<const float*>(data+headerSize+nR*sizeof(double)); // offset is a multiple of 8
+}
+
+MeniscusParameters CapillaryTable::interpolate(Real R1, Real R2, Real D, Real P) const
+{
+	MeniscusParameters result;
+	const Real R = std::max(R1,R2)/std::min(R1,R2);
+	if (!(D>=0 && D<=dMax && P>=0 && P<=pMax && R>=rValues[0] && R<=rValues[nR-1])) return result; // no solution tabulated
+	// the few tabulated ratios are scanned, D and P are regularly spaced
+	int i = 0;
+	while (i<nR-2 && rValues[i+1]<R) i++;
+	const int i1 = std::min(i+1,nR-1);
+	const Real tR = (i1>i ? (R-rValues[i])/(rValues[i1]-rValues[i]) : 0);
+	const int j = std::min(int(D/dD),nD-2), k = std::min(int(P/dP),nP-2);
+	const Real tD = D/dD-j, tP = P/dP-k;
+	Real sol[6] = {0,0,0,0,0,0};
+	for (int c=0; c<8; c++) {
+		const float* node = values+((size_t((c&1) ? i1 : i)*nD+j+((c>>1)&1))*nP+k+((c>>2)&1))*6;
+		const Real w = ((c&1) ? tR : 1-tR)*((c&2) ? tD : 1-tD)*((c&4) ? tP : 1-tP);
+		if (w==0) continue;
+		if (node[0]==0) return result; // a corner without meniscus: the bridge is broken
+		for (int l=0; l<6; l++) sol[l] += w*node[l];
+	}
+	result.V = sol[0]; result.F = sol[1]; result.delta1 = sol[2]; result.delta2 = sol[3]; result.nn11 = sol[4]; result.nn33 = sol[5];
+	return result;
+}
+
+void CapillaryTable::convert(capillarylaw& law, const string& fileName, int nD, int nP)
+{
+	if (nD<2 || nP<2) throw std::invalid_argument("Law2_ScGeom_CapillaryPhys_Capillarity.tableGrid: at least 2 samples are needed along each axis.");
+	const int nR = law.data_complete.size();
+	double dMax = 0, pMax = 0;
+	FOREACH(const Tableau& tab, law.data_complete) {
+		if (tab.full_data.empty()) throw std::runtime_error("Law2_ScGeom_CapillaryPhys_Capillarity: the ASCII capillary files are needed to create the binary table.");
+		FOREACH(const TableauD& tabD, tab.full_data) FOREACH(const std::vector<Real>& line, tabD.data) { dMax = max(dMax,double(line[0])); pMax = max(pMax,double(line[1])); }
+	}
+	std::vector<float> values(size_t(nR)*nD*nP*6);
+	#ifdef YADE_OPENMP
+	#pragma omp parallel for schedule(dynamic)
+	#endif
+	for (int ij=0; ij<nR*nD; ij++) {
+		const int i = ij/nD, j = ij%nD;
+		int index[4] = {0,0,0,0}; // search hints, P is increasing along the inner loop
+		for (int k=0; k<nP; k++) {
+			// R=1 for the smaller sphere gives exactly the tabulated ratio
+			MeniscusParameters sol = law.interpolate(1.,law.data_complete[i].R,j*dMax/(nD-1),k*pMax/(nP-1),index);
+			float* node = &values[(size_t(ij)*nP+k)*6];
+			node[0] = sol.V; node[1] = sol.F; node[2] = sol.delta1; node[3] = sol.delta2; node[4] = sol.nn11; node[5] = sol.nn33;
+		}
+	}
+	std::ofstream out(fileName.c_str(),std::ios::binary);
+	const uint32_t header[4] = {0x01020304,uint32_t(nR),uint32_t(nD),uint32_t(nP)};
+	const double range[2] = {dMax,pMax};
+	out.write("YADECAP1",8);
+	out.write((const char*)header,sizeof(header));
+	out.write((const char*)range,sizeof(range));
+	FOREACH(const Tableau& tab, law.data_complete) { double r = tab.R; out.write((const char*)&r,sizeof(r)); }
+	out.write((const char*)&values[0],values.size()*sizeof(float));
+	if (!out.good()) throw std::runtime_error("Law2_ScGeom_CapillaryPhys_Capillarity: I/O error writing the binary table "+fileName);
+}
+
 Tableau::Tableau()
 {}
 
@@ -548,91 +643,75 @@ std::ostream& operator<<(std::ostream& os, Tableau& T)
 BodiesMenisciiList::BodiesMenisciiList(Scene * scene, bool hertzOn)
 {
 	initialized=false;
+	dirty=true;
 	prepare(scene, hertzOn);
 }
 
 
 bool BodiesMenisciiList::prepare(Scene * scene, bool hertzOn)
 {
-	//cerr << "preparing bodiesInteractionsList" << endl;
-	interactionsOnBody.clear();
-	shared_ptr<BodyContainer>& bodies = scene->bodies;
+	initialized=false;
+	update(scene, hertzOn);
+	return initialized;
+}
 
-	Body::id_t MaxId = -1;
-	BodyContainer::iterator bi    = bodies->begin();
-	BodyContainer::iterator biEnd = bodies->end();
-	for(  ; bi!=biEnd ; ++bi )
-	{
-		MaxId=max(MaxId, (*bi)->getId());
+void BodiesMenisciiList::update(Scene * scene, bool hertzOn)
+{
+	if (initialized && !dirty) {
+		// menisci are not removed explicitly when their interaction stops being real
+		FOREACH(const shared_ptr<Interaction>& I, menisci) if (!I->isReal()) { dirty=true; break; }
+		if (!dirty) return;
 	}
-	interactionsOnBody.resize(MaxId+1);
-	for ( unsigned int i=0; i<interactionsOnBody.size(); ++i )
-	{
-		interactionsOnBody[i].clear();
+	// full rebuild: one insertion shifts the ranges of all following bodies, and the menisci change in bulk when they do
+	menisci.clear();
+	FOREACH(const shared_ptr<Interaction>& I, *scene->interactions){
+		if (I->isReal()) {
+			if (!hertzOn) {if (static_cast<CapillaryPhys*>(I->phys.get())->meniscus) menisci.push_back(I);}
+			else {if (static_cast<MindlinCapillaryPhys*>(I->phys.get())->meniscus) menisci.push_back(I);}
+		}
 	}
-	
-	FOREACH(const shared_ptr<Interaction>& I, *scene->interactions){ // parallel version using Engine::ompThreads variable not accessible, this function is not one of the Engine..
-                if (I->isReal()) {
-			if (!hertzOn) {if (static_cast<CapillaryPhys*>(I->phys.get())->meniscus) insert(I);}
-			else {if (static_cast<MindlinCapillaryPhys*>(I->phys.get())->meniscus) insert(I);}
-                }
-        }
-
-	return initialized=true;
+	// counting sort of menisci by body
+	offsets.assign(scene->bodies->size()+1,0);
+	FOREACH(const shared_ptr<Interaction>& I, menisci) { ++offsets[I->getId1()+1]; ++offsets[I->getId2()+1]; }
+	for (unsigned int i=1; i<offsets.size(); ++i) offsets[i]+=offsets[i-1];
+	vector<int> next(offsets.begin(),offsets.end()-1);
+	adjacency.resize(2*menisci.size());
+	slots.resize(2*menisci.size());
+	for (unsigned int k=0; k<menisci.size(); ++k) {
+		slots[2*k] = next[menisci[k]->getId1()]++;
+		slots[2*k+1] = next[menisci[k]->getId2()]++;
+		adjacency[slots[2*k]] = adjacency[slots[2*k+1]] = k;
+	}
+	dirty=false;
+	initialized=true;
 }
 
-bool BodiesMenisciiList::insert(const shared_ptr< Interaction >& interaction)
+bool BodiesMenisciiList::insert(const shared_ptr< Interaction >&)
 {
-  checkLengthBuffer(interaction);
-	interactionsOnBody[interaction->getId1()].push_back(interaction);
-	interactionsOnBody[interaction->getId2()].push_back(interaction);
+	dirty.store(true,std::memory_order_relaxed); // read by update() after the parallel loop
 	return true;
 }
 
 
 bool BodiesMenisciiList::remove(const shared_ptr< Interaction >& interaction)
 {
-  checkLengthBuffer(interaction);
-	interactionsOnBody[interaction->getId1()].remove(interaction);
-	interactionsOnBody[interaction->getId2()].remove(interaction);
+	// menisci of interactions which are not real anymore are found by update()
+	if (interaction->isReal()) dirty.store(true,std::memory_order_relaxed);
 	return true;
 }
 
-void BodiesMenisciiList::checkLengthBuffer(const shared_ptr<Interaction>& interaction) {
-	Body::id_t maxBodyId = std::max(interaction->getId1(), interaction->getId2());
-	if (unsigned(maxBodyId) >= interactionsOnBody.size()) {
-		interactionsOnBody.resize(maxBodyId+1);
-	}
-}
-
-list< shared_ptr<Interaction> >&  BodiesMenisciiList::operator[] (int index)
-{
-	return interactionsOnBody[index];
-}
-
 int BodiesMenisciiList::size()
 {
-	return interactionsOnBody.size();
+	return offsets.empty() ? 0 : offsets.size()-1;
 }
 
 void BodiesMenisciiList::display()
 {
-	list< shared_ptr<Interaction> >::iterator firstMeniscus;
-	list< shared_ptr<Interaction> >::iterator lastMeniscus;
-	for ( unsigned int i=0; i<interactionsOnBody.size(); ++i )
+	for ( int i=0; i<size(); ++i )
 	{
-		if ( !interactionsOnBody[i].empty() )
+		if ( offsets[i]<offsets[i+1] )
 		{
-			lastMeniscus = interactionsOnBody[i].end();
-			//cerr << "size = "<<interactionsOnBody[i].size() << " empty="<<interactionsOnBody[i].empty() <<endl;
-			for ( firstMeniscus=interactionsOnBody[i].begin(); firstMeniscus!=lastMeniscus; ++firstMeniscus )
-			{
-				if ( *firstMeniscus ){
-					if ( firstMeniscus->get() )
-						cerr << "(" << ( *firstMeniscus )->getId1() << ", " << ( *firstMeniscus )->getId2() <<") ";
-					else cerr << "(void)";
-				}
-			}
+			for ( int s=offsets[i]; s<offsets[i+1]; ++s ) cerr << "(" << menisci[adjacency[s]]->getId1() << ", " << menisci[adjacency[s]]->getId2() <<") ";
 			cerr << endl;
 		}
 		else cerr << "empty" << endl;
@@ -642,5 +721,5 @@ void BodiesMenisciiList::display()
 BodiesMenisciiList::BodiesMenisciiList()
 {
 	initialized=false;
+	dirty=true;
 }
-
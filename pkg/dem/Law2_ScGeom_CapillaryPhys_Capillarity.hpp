@@ -11,6 +11,8 @@
 #pragma once
 
 #include <core/GlobalEngine.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <atomic>
 
 /**
 This law allows one to take into account capillary forces/effects between spheres coming from the presence of interparticular liquid bridges (menisci).
@@ -51,26 +53,29 @@ public :
 const int NB_R_VALUES = 10;
 
 class capillarylaw; // the class defined below (end of file)
+class CapillaryTable;
 class Interaction;
 
-///This container class is used to check if meniscii overlap. Wet interactions are put in a series of lists, with one list per body.
+///This container class is used to check if meniscii overlap. Wet interactions are stored in one array, and the wet interactions of each body in compressed sparse row format (one contiguous range per body).
+///insert() and remove() only record that the menisci changed (they are called from the parallel loop, hence the atomic flag); the arrays are rebuilt by update() when needed.
 class BodiesMenisciiList
 {
 	private:
-		vector< list< shared_ptr<Interaction> > > interactionsOnBody; // would require use of OpenMPVector (lib/base/openmp-accu.hpp) for parallel coding, see http://www.mail-archive.com/yade-dev@lists.launchpad.net/msg10842.html and msg11238.html
-		
-		//shared_ptr<Interaction> empty;
-		
+		std::atomic<bool> dirty;
 	public:
+		vector< shared_ptr<Interaction> > menisci; // wet interactions
+		vector<int> offsets; // menisci on body i are adjacency[offsets[i]..offsets[i+1])
+		vector<int> adjacency; // indices into menisci
+		vector<int> slots; // positions of meniscus k in adjacency: slots[2k] in the range of its id1, slots[2k+1] in the range of its id2
+
 		BodiesMenisciiList();
 		BodiesMenisciiList(Scene*,bool);//TODO: remove?
 		bool prepare(Scene*,bool);
 		bool insert(const shared_ptr<Interaction>&);
 		bool remove(const shared_ptr<Interaction>&);
-		list< shared_ptr<Interaction> >& operator[] (int);
+		void update(Scene*,bool);
 		int size();
 		void display();
-		void checkLengthBuffer(const shared_ptr<Interaction>&);
 		
 		bool initialized;
 };
@@ -81,6 +86,8 @@ class Law2_ScGeom_CapillaryPhys_Capillarity : public GlobalEngine
 	public :
 		void checkFusion();
 		shared_ptr<capillarylaw> capillary;
+		shared_ptr<CapillaryTable> table; // used instead of capillary if binaryTable is given
+		shared_ptr<capillarylaw> readAsciiTables();
 		BodiesMenisciiList bodiesMenisciiList;
 		
 		void action();
@@ -97,6 +104,8 @@ class Law2_ScGeom_CapillaryPhys_Capillarity : public GlobalEngine
 	((bool,createDistantMeniscii,false,,"Generate meniscii between distant spheres? Else only maintain the existing ones. For modeling a wetting path this flag should always be false. For a drying path it should be true for one step (initialization) then false, as in the logic of [Scholtes2009c]_"))
         ((Real,surfaceTension,0.073,,"Value of considered surface tension")) // (0.073 N/m is water tension at 20 Celsius degrees)
 	((string,suffCapFiles,"",,"Capillary files suffix: M(r=X)suffCapFiles"))
+	((string,binaryTable,"",,"If not empty, capillary solutions are looked up in this binary table (memory-mapped, with constant-time trilinear interpolation) instead of searching the ASCII files at every step. If the file does not exist, it is created from the ASCII files M(r=X)suffCapFiles, resampled on a regular grid of :yref:`tableGrid<Law2_ScGeom_CapillaryPhys_Capillarity.tableGrid>` points; delete it to convert again. Ruptures are detected within one grid step in distance and suction."))
+	((Vector2i,tableGrid,Vector2i(256,1024),,"Number of regularly spaced samples of the dimensionless distance D and suction P in the :yref:`binaryTable<Law2_ScGeom_CapillaryPhys_Capillarity.binaryTable>` created from the ASCII files (the tabulated radii ratios are kept as they are)."))
 	,,/*constructor*/
 	hertzInitialized = false;
 	hertzOn = false;
@@ -141,6 +150,24 @@ class capillarylaw // class for a whole set of capillary files M(r=..)
 		void fill (const char* filename);
 };
 
+/// Capillary solutions of all files resampled on a regular (D,P) grid for each tabulated R, stored in a binary file which is memory-mapped.
+/// File layout: "YADECAP1", uint32 0x01020304 (byte order check), uint32 nR, nD, nP, float64 Dmax, Pmax, float64 R[nR], then float32 [nR][nD][nP][6] (V,F,delta1,delta2,nn11,nn33).
+class CapillaryTable
+{
+	private:
+		boost::iostreams::mapped_file_source file;
+		int nR, nD, nP;
+		Real dMax, pMax, dD, dP;
+		std::vector<Real> rValues;
+		const float* values;
+	public:
+		CapillaryTable(const string& fileName);
+		/// same arguments as capillarylaw::interpolate, without the search indices; null solution outside of the table
+		MeniscusParameters interpolate(Real R1, Real R2, Real D, Real P) const;
+		/// sample law at nD×nP regular points for each tabulated R and write the result to fileName
+		static void convert(capillarylaw& law, const string& fileName, int nD, int nP);
+};
+
 REGISTER_SERIALIZABLE(Law2_ScGeom_CapillaryPhys_Capillarity);
 
 
@@ -1,7 +1,9 @@
 
 #include "Lubrication.hpp"
+#include<pkg/dem/NewtonIntegrator.hpp>
+#include<pkg/common/InteractionLoop.hpp>
 
-YADE_PLUGIN((Ip2_FrictMat_FrictMat_LubricationPhys)(LubricationPhys)(Law2_ScGeom_ImplicitLubricationPhys))
+YADE_PLUGIN((Ip2_FrictMat_FrictMat_LubricationPhys)(LubricationPhys)(Law2_ScGeom_ImplicitLubricationPhys)(ImplicitLubricationSolver))
 
 LubricationPhys::~LubricationPhys()
 {
@@ -132,6 +134,22 @@ Real Law2_ScGeom_ImplicitLubricationPhys::NRAdimExp_integrate_u(Real const& un,
 }
 
 
+Real Law2_ScGeom_ImplicitLubricationPhys::normalForce_contactOnly(LubricationPhys *phys, ScGeom* geom)
+{
+	Real a((geom->radius1+geom->radius2)/2.);
+	Real gap = -geom->penetrationDepth;
+	
+	phys->contact = gap < 2.*phys->eps*a;
+	phys->normalContactForce = ((phys->contact) ? phys->kn*(gap - 2.*phys->eps*a) : 0.)*geom->normal;
+	phys->normalForce = phys->normalContactForce;
+	// lubrication force is added by ImplicitLubricationSolver, it would be unbounded for vanishing gap
+	phys->u = std::max(gap, phys->eps*a);
+	phys->ue = gap - phys->u;
+	
+	return phys->u;
+}
+
+
 template <typename T> int sign(T val) {
     return (int)(T(0) < val) - (val < T(0));
 }
@@ -397,6 +415,7 @@ bool Law2_ScGeom_ImplicitLubricationPhys::go(shared_ptr<IGeom> &iGeom, shared_pt
 			case 0: normalForce_trapezoidal(phys,geom, undot, isNew); break;
 			case 1: normalForce_NRAdimExp(phys, geom, undot, isNew); break;
 			case 2: normalForce_NewtonRafson(phys, geom, undot, isNew); break;
+			case 3: normalForce_contactOnly(phys, geom); break;
 			default:
 			LOG_WARN("Nonexistant resolution method. Using exact (0).");
 			normalForce_trapezoidal(phys,geom, undot, isNew); break;
@@ -580,3 +599,154 @@ py::tuple Law2_ScGeom_ImplicitLubricationPhys::PyGetTotalStresses()
 }
 
 
+CREATE_LOGGER(ImplicitLubricationSolver);
+
+Vector3r ImplicitLubricationSolver::lubricationForce(long i, const vector<Vector3r>& v, bool withShift) const
+{
+	Vector3r f(Vector3r::Zero());
+	for(int k=bodyPtr[i]; k<bodyPtr[i+1]; k++) {
+		const LubContact& c = contacts[bodyContacts[k]];
+		// force on id1, opposite on id2
+		Real un = c.normal.dot(v[c.id2]-v[c.id1]) + (withShift ? c.shiftVelN : 0.);
+		f += (c.id1==i ? 1. : -1.)*c.cn*un*c.normal;
+	}
+	return f;
+}
+
+Real ImplicitLubricationSolver::dot(const vector<Vector3r>& a, const vector<Vector3r>& b) const
+{
+	const long n = a.size();
+	Real ret = 0;
+	#ifdef YADE_OPENMP
+	#pragma omp parallel for reduction(+:ret) schedule(static)
+	#endif
+	for(long i=0; i<n; i++) ret += a[i].dot(b[i]);
+	return ret;
+}
+
+void ImplicitLubricationSolver::action()
+{
+	if(!newton) {
+		FOREACH(const shared_ptr<Engine>& e, scene->engines) {
+			newton = YADE_PTR_DYN_CAST<NewtonIntegrator>(e);
+			if(newton) break;
+		}
+		if(!newton) throw runtime_error("ImplicitLubricationSolver: NewtonIntegrator not found in O.engines.");
+		// normal lubrication computed twice otherwise
+		FOREACH(const shared_ptr<Engine>& e, scene->engines) {
+			shared_ptr<InteractionLoop> loop = YADE_PTR_DYN_CAST<InteractionLoop>(e);
+			if(!loop) continue;
+			FOREACH(const shared_ptr<LawFunctor>& f, loop->lawDispatcher->functors) {
+				shared_ptr<Law2_ScGeom_ImplicitLubricationPhys> law = YADE_PTR_DYN_CAST<Law2_ScGeom_ImplicitLubricationPhys>(f);
+				if(law && law->resolution!=3 && law->activateNormalLubrication) { newton.reset(); throw runtime_error("ImplicitLubricationSolver: Law2_ScGeom_ImplicitLubricationPhys.resolution must be 3."); }
+			}
+		}
+	}
+	const long nBodies = scene->bodies->size();
+	const Real dt = scene->dt;
+	
+	// lubricated interactions
+	contacts.clear();
+	const int lubIndex = LubricationPhys::getClassIndexStatic();
+	FOREACH(const shared_ptr<Interaction>& I, *scene->interactions) {
+		if(!I->isReal() || I->phys->getClassIndex()!=lubIndex) continue;
+		LubricationPhys* phys = static_cast<LubricationPhys*>(I->phys.get());
+		if(phys->nun<=0. || phys->u<=0.) continue;
+		LubContact c;
+		c.id1 = I->getId1(); c.id2 = I->getId2();
+		c.normal = YADE_CAST<GenericSpheresContact*>(I->geom.get())->normal;
+		c.cn = phys->nun/phys->u;
+		c.shiftVelN = scene->isPeriodic ? c.normal.dot(scene->cell->velGrad*scene->cell->hSize*I->cellDist.cast<Real>()) : 0.;
+		c.phys = phys;
+		contacts.push_back(c);
+	}
+	nContacts = contacts.size();
+	iterations = 0; residual = 0;
+	if(contacts.empty()) return;
+	
+	bodyPtr.assign(nBodies+1,0);
+	FOREACH(const LubContact& c, contacts) { bodyPtr[c.id1+1]++; bodyPtr[c.id2+1]++; }
+	for(long i=0; i<nBodies; i++) bodyPtr[i+1] += bodyPtr[i];
+	bodyContacts.resize(bodyPtr[nBodies]);
+	{
+		vector<int> fill(bodyPtr.begin(),bodyPtr.end()-1);
+		for(size_t k=0; k<contacts.size(); k++) { bodyContacts[fill[contacts[k].id1]++] = k; bodyContacts[fill[contacts[k].id2]++] = k; }
+	}
+	
+	// initial guess: velocities predicted without normal lubrication
+	scene->forces.sync();
+	freeDofs.resize(nBodies); massDt.resize(nBodies); diag.resize(nBodies);
+	x.resize(nBodies); r.resize(nBodies); z.resize(nBodies); p.resize(nBodies); q.resize(nBodies);
+	const Vector3r gravity = newton->gravity;
+	#ifdef YADE_OPENMP
+	#pragma omp parallel for schedule(guided)
+	#endif
+	for(long i=0; i<nBodies; i++) {
+		const shared_ptr<Body>& b = (*scene->bodies)[i];
+		freeDofs[i] = Vector3r::Zero(); massDt[i] = Vector3r::Zero(); x[i] = Vector3r::Zero(); diag[i] = Vector3r::Ones();
+		if(!b) continue;
+		const State* state = b->state.get();
+		x[i] = state->vel;
+		if(!b->isStandalone() || !b->isDynamic() || state->mass<=0) continue;
+		for(int k=0; k<3; k++) if(!(state->blockedDOFs & State::axisDOF(k))) freeDofs[i][k] = 1.;
+		massDt[i] = Vector3r::Constant(state->mass/dt);
+		x[i] += freeDofs[i].cwiseProduct(dt*(scene->forces.getForce(i)/state->mass+gravity));
+		Vector3r d = massDt[i];
+		for(int k=bodyPtr[i]; k<bodyPtr[i+1]; k++) { const LubContact& c = contacts[bodyContacts[k]]; d += c.cn*c.normal.cwiseProduct(c.normal); }
+		diag[i] = d;
+	}
+	
+	// preconditioned conjugate gradient on the velocity correction, free DOFs only
+	#ifdef YADE_OPENMP
+	#pragma omp parallel for schedule(guided)
+	#endif
+	for(long i=0; i<nBodies; i++) {
+		r[i] = freeDofs[i].cwiseProduct(lubricationForce(i,x,true));
+		z[i] = r[i].cwiseQuotient(diag[i]);
+		p[i] = z[i];
+		q[i] = massDt[i].cwiseProduct(x[i]);
+	}
+	Real refNorm = std::sqrt(dot(q,q));
+	Real rz = dot(r,z);
+	Real rNorm = std::sqrt(dot(r,r));
+	// free bodies at rest (e.g. pushed by a moving fixed body): the tolerance is relative to the initial residual instead
+	if(!(refNorm>0)) refNorm = rNorm;
+	while(rNorm>tolerance*refNorm && rNorm>0 && iterations<maxIter) {
+		#ifdef YADE_OPENMP
+		#pragma omp parallel for schedule(guided)
+		#endif
+		for(long i=0; i<nBodies; i++) q[i] = freeDofs[i].cwiseProduct(massDt[i].cwiseProduct(p[i]) - lubricationForce(i,p,false));
+		const Real alpha = rz/dot(p,q);
+		#ifdef YADE_OPENMP
+		#pragma omp parallel for schedule(static)
+		#endif
+		for(long i=0; i<nBodies; i++) { x[i] += alpha*p[i]; r[i] -= alpha*q[i]; z[i] = r[i].cwiseQuotient(diag[i]); }
+		const Real rzNew = dot(r,z);
+		const Real beta = rzNew/rz;
+		rz = rzNew;
+		#ifdef YADE_OPENMP
+		#pragma omp parallel for schedule(static)
+		#endif
+		for(long i=0; i<nBodies; i++) p[i] = z[i] + beta*p[i];
+		rNorm = std::sqrt(dot(r,r));
+		iterations++;
+	}
+	residual = refNorm>0 ? rNorm/refNorm : rNorm;
+	if(iterations>=maxIter) LOG_WARN("ImplicitLubricationSolver: no convergence after "<<maxIter<<" iterations, relative residual "<<residual);
+	
+	// forces for velocities at the end of the step
+	#ifdef YADE_OPENMP
+	#pragma omp parallel for schedule(guided)
+	#endif
+	for(long k=0; k<(long)contacts.size(); k++) {
+		const LubContact& c = contacts[k];
+		Vector3r f = c.cn*(c.normal.dot(x[c.id2]-x[c.id1]) + c.shiftVelN)*c.normal;
+		c.phys->normalLubricationForce = f;
+		c.phys->normalForce += f;
+		c.phys->cn = c.cn;
+	}
+	#ifdef YADE_OPENMP
+	#pragma omp parallel for schedule(guided)
+	#endif
+	for(long i=0; i<nBodies; i++) if(bodyPtr[i+1]>bodyPtr[i]) scene->forces.addForce(i,lubricationForce(i,x,true));
+}
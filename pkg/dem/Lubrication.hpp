@@ -12,6 +12,7 @@
 #include<pkg/dem/FrictPhys.hpp>
 #include<pkg/dem/ElasticContactLaw.hpp>
 #include<pkg/dem/ViscoelasticPM.hpp>
+#include<core/GlobalEngine.hpp>
 
 
 namespace py=boost::python;
@@ -82,6 +83,9 @@ class Law2_ScGeom_ImplicitLubricationPhys: public LawFunctor{
 			Real newton_integrate_u(Real const& un, Real const& nu, Real const& dt, Real const& k, Real const& g, Real const& u_prev, Real const& eps, int depth=0);
 			
 			Real normalForce_NRAdimExp(LubricationPhys *phys, ScGeom* geom, Real undot, bool isNew);
+
+			// contact force only, the normal lubrication is resolved globally by ImplicitLubricationSolver
+			Real normalForce_contactOnly(LubricationPhys *phys, ScGeom* geom);
 			Real NRAdimExp_integrate_u(Real const& un, Real const& eps, Real const& alpha, Real & prevDotU, Real const& dt, Real const& prev_d, Real const& undot, int depth=0);
 			
 			void shearForce_firstOrder(LubricationPhys *phys, ScGeom* geom);
@@ -103,7 +107,7 @@ class Law2_ScGeom_ImplicitLubricationPhys: public LawFunctor{
 			((bool,verbose,false,,"Write all debug informations"))
 			((int,maxSubSteps,4,,"max recursion depth of adaptative timestepping in the theta-method, the minimal time interval is thus :yref:`Omega::dt<O.dt>`$/2^{depth}$. If still not converged the integrator will switch to backward Euler."))
 			((Real,theta,0.55,,"parameter of the 'theta'-method, 1: backward Euler, 0.5: trapezoidal rule, 0: not used,  0.55: suggested optimum)"))
-			((int,resolution,0,,"Change normal component resolution method, 0: Iterative exact resolution (theta method, linear contact), 1: Newton-Rafson dimentionless resolution (theta method, linear contact), 2: Newton-Rafson with nonlinear surface deflection (Hertzian-like contact)"))
+			((int,resolution,0,,"Change normal component resolution method, 0: Iterative exact resolution (theta method, linear contact), 1: Newton-Rafson dimentionless resolution (theta method, linear contact), 2: Newton-Rafson with nonlinear surface deflection (Hertzian-like contact), 3: linear contact only, the normal lubrication of all interactions is resolved together by :yref:`ImplicitLubricationSolver` (which must be in :yref:`O.engines<Omega.engines>` after :yref:`InteractionLoop`); the gap used in lubrication terms is bounded by half of the roughness."))
 			((Real, NewtonRafsonTol, 1.e-10,,"Tolerance for Newton-Rafson resolution"))
 			((int, NewtonRafsonMaxIter, 20,,"Maximum iterations for Newton-Rafson resolution"))
 			,// CTOR
@@ -116,3 +120,41 @@ class Law2_ScGeom_ImplicitLubricationPhys: public LawFunctor{
                 DECLARE_LOGGER;
 };
 REGISTER_SERIALIZABLE(Law2_ScGeom_ImplicitLubricationPhys);
+
+class NewtonIntegrator;
+
+/*! Implicit integration of normal lubrication for all interactions at once.
+
+The normal lubrication forces couple velocities of all particles in near-contact; integrated per interaction, they require time steps
+much smaller than the contact stiffness alone. Here, velocities at the end of the step are solved from
+	(M/dt+R) v = M/dt v*,
+where v* are velocities predicted from the other forces, M is the (diagonal) mass matrix and R the symmetric positive semi-definite matrix of normal
+lubrication resistances, assembled from interactions. The system is solved with the preconditioned conjugate gradient method, without assembling
+the matrix: its product with a vector is computed for each body from the list of its interactions (in parallel). The resulting forces -R v are added
+to the force container, so that NewtonIntegrator ends the step with velocities v.
+*/
+class ImplicitLubricationSolver: public GlobalEngine{
+	private:
+		struct LubContact{ Body::id_t id1, id2; Vector3r normal; Real cn, shiftVelN; LubricationPhys* phys; };
+		vector<LubContact> contacts;
+		// interactions of each body, in CSR format: bodyContacts[bodyPtr[i]..bodyPtr[i+1])
+		vector<int> bodyPtr, bodyContacts;
+		// 1 for free translational DOFs, 0 otherwise; mass/dt; diagonal of the matrix (Jacobi preconditioner)
+		vector<Vector3r> freeDofs, massDt, diag;
+		vector<Vector3r> x, r, z, p, q;
+		shared_ptr<NewtonIntegrator> newton;
+		// normal lubrication force acting on body i for velocities v, with or without the velocity of periodic images
+		Vector3r lubricationForce(long i, const vector<Vector3r>& v, bool withShift) const;
+		Real dot(const vector<Vector3r>& a, const vector<Vector3r>& b) const;
+	public:
+		virtual void action();
+	YADE_CLASS_BASE_DOC_ATTRS(ImplicitLubricationSolver,GlobalEngine,"Implicit resolution of the normal lubrication forces of all :yref:`LubricationPhys` interactions together, for dense suspensions where the lubrication couples many particles. The time step is then limited by the contact stiffness rather than by lubrication. Requires :yref:`Law2_ScGeom_ImplicitLubricationPhys.resolution` =3 (which computes the contact and tangential forces only) and must be placed after :yref:`InteractionLoop` and before :yref:`NewtonIntegrator`.\n\nVelocities at the end of the step solve $(M/\\Delta t+R)v=M/\\Delta t\\,v^*$, with $v^*$ predicted from other forces and gravity (damping of :yref:`NewtonIntegrator` is not taken into account), and $R$ the resistance matrix of normal lubrication ($\\nu_n/u$ for each interaction); the system is solved by the preconditioned conjugate gradient method in parallel. Only translations of standalone dynamic bodies are solved for; other bodies move with their current velocity. Lubrication forces are stored in :yref:`LubricationPhys.normalLubricationForce`.",
+		((Real,tolerance,1e-8,,"Relative tolerance on the residual of the linear system, with respect to the norm of $M/\\Delta t\\,v^*$, or to the initial residual if $v^*$ vanishes for all free bodies."))
+		((int,maxIter,1000,,"Maximum number of iterations of the conjugate gradient method."))
+		((int,iterations,0,Attr::readonly,"Number of iterations done at the last step."))
+		((Real,residual,0,Attr::readonly,"Relative residual at the last step."))
+		((int,nContacts,0,Attr::readonly,"Number of lubricated interactions at the last step."))
+	);
+	DECLARE_LOGGER;
+};
+REGISTER_SERIALIZABLE(ImplicitLubricationSolver);
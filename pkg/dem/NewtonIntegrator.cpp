@@ -84,6 +84,13 @@ void NewtonIntegrator::saveMaximaDisplacement(const shared_ptr<Body>& b){
 	#endif
 }
 
+void NewtonIntegrator::updateClumpList(){
+	clumps.clear();
+	const BodyContainer& bodies=*scene->bodies;
+	for(size_t id=0; id<bodies.size(); id++){ if(bodies[id] && bodies[id]->isClump()) clumps.push_back(id); }
+	clumpsContainer=scene->bodies.get(); clumpsRevision=scene->bodies->revision;
+}
+
 void NewtonIntegrator::action()
 {
 	scene->forces.sync();
@@ -123,24 +130,31 @@ void NewtonIntegrator::action()
 	#ifdef YADE_OPENMP
 		FOREACH(Real& thrMaxVSq, threadMaxVelocitySq) { thrMaxVSq=0; }
 	#endif
+	if(clumpsContainer!=scene->bodies.get() || clumpsRevision!=scene->bodies->revision) updateClumpList();
+	const long nClumps=clumps.size();
+	// forces of members acting on clumps, before the main loop; dynamic scheduling balances clumps of different sizes
+	#ifdef YADE_OPENMP
+	#pragma omp parallel for schedule(dynamic,64)
+	#endif
+	for(long i=0; i<nClumps; i++){
+		const shared_ptr<Body>& b=(*scene->bodies)[clumps[i]];
+		if(!b || !b->isClump()) continue;
+		Vector3r f=Vector3r::Zero(), m=Vector3r::Zero();
+		b->shape->cast<Clump>().addForceTorqueFromMembers(b->state.get(),scene,f,m);
+		#ifdef YADE_OPENMP
+		//it is safe here, since only one thread is adding forces/torques
+		scene->forces.addTorqueUnsynced(b->id,m);
+		scene->forces.addForceUnsynced(b->id,f);
+		#else
+		scene->forces.addTorque(b->id,m);
+		scene->forces.addForce(b->id,f);
+		#endif
+	}
 	YADE_PARALLEL_FOREACH_BODY_BEGIN(const shared_ptr<Body>& b, scene->bodies){
 			// clump members are handled inside clumps
 			if(b->isClumpMember()) continue;
 			State* state=b->state.get(); const Body::id_t& id=b->getId();
-			Vector3r f=Vector3r::Zero(); 
-			Vector3r m=Vector3r::Zero();
-			// clumps forces
-			if(b->isClump()) {
-				b->shape->cast<Clump>().addForceTorqueFromMembers(state,scene,f,m);
-				#ifdef YADE_OPENMP
-				//it is safe here, since only one thread is adding forces/torques
-				scene->forces.addTorqueUnsynced(id,m);
-				scene->forces.addForceUnsynced(id,f);
-				#else
-				scene->forces.addTorque(id,m);
-				scene->forces.addForce(id,f);
-				#endif
-			}
+			Vector3r f, m;
 			//in most cases, the initial force on clumps will be zero and next line is not changing f and m, but make sure we don't miss something (e.g. user defined forces on clumps)
 			f=scene->forces.getForce(id); m=scene->forces.getTorque(id);
 			#ifdef YADE_DEBUG
@@ -190,8 +204,6 @@ void NewtonIntegrator::action()
 			else leapfrogAsphericalRotate(state,id,dt,m);
 			
 			saveMaximaDisplacement(b);
-			// move individual members of the clump, save maxima velocity (for collider stride)
-			if(b->isClump()) Clump::moveMembers(b,scene,this);
 			
 			#ifdef YADE_BODY_CALLBACK
 				// process callbacks
@@ -201,6 +213,14 @@ void NewtonIntegrator::action()
 				}
 			#endif
 	} YADE_PARALLEL_FOREACH_BODY_END();
+	// move individual members of clumps, save maxima velocity (for collider stride)
+	#ifdef YADE_OPENMP
+	#pragma omp parallel for schedule(dynamic,64)
+	#endif
+	for(long i=0; i<nClumps; i++){
+		const shared_ptr<Body>& b=(*scene->bodies)[clumps[i]];
+		if(b && b->isClump()) Clump::moveMembers(b,scene,this);
+	}
 	#ifdef YADE_OPENMP
 		FOREACH(const Real& thrMaxVSq, threadMaxVelocitySq) { maxVelocitySq=max(maxVelocitySq,thrMaxVSq); }
 	#endif
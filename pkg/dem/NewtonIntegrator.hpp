@@ -47,6 +47,12 @@ class NewtonIntegrator : public FieldApplier{
 	Matrix3r dVelGrad;
 	Vector3r dSpin;
 
+	// ids of clumps, processed in separate passes before (member forces) and after (member motion) the main loop;
+	// rebuilt when bodies are inserted or erased
+	vector<Body::id_t> clumps;
+	const BodyContainer* clumpsContainer; unsigned long clumpsRevision;
+	void updateClumpList();
+
 	public:
 		bool densityScaling;// internal for density scaling
 		Real updatingDispFactor;//(experimental) Displacement factor used to trigger bound update: the bound is updated only if updatingDispFactor*disp>sweepDist when >0, else all bounds are updated.
@@ -81,6 +87,7 @@ class NewtonIntegrator : public FieldApplier{
 		,
 		/*ctor*/
 			densityScaling=false;
+			clumpsContainer=NULL; clumpsRevision=0;
 			#ifdef YADE_OPENMP
 				threadMaxVelocitySq.resize(omp_get_max_threads()); syncEnsured=false;
 			#endif
@@ -166,6 +166,24 @@ void Polyhedra::Initialize(){
 			rot_mat(2,0),rot_mat(2,1),rot_mat(2,2),1.);
 		std::transform( P.points_begin(), P.points_end(), P.points_begin(), t_rot);
 	}
+	//faces as flat arrays, for the contact detection without CGAL
+	faceStart.assign(1,0); faceVertices.clear(); faceNormals.clear(); faceOffsets.clear();
+	for (Polyhedron::Facet_iterator f = P.facets_begin(); f != P.facets_end(); f++){
+		Polyhedron::Halfedge_around_facet_circulator h=f->facet_begin();
+		Vector3r normal(Vector3r::Zero()), center(Vector3r::Zero());
+		int n = 0;
+		do {
+			const Vector3r a = FromCGALPoint(h->vertex()->point()), b = FromCGALPoint(h->next()->vertex()->point());
+			normal += a.cross(b); // Newell's method
+			center += a;
+			faceVertices.push_back(std::distance(P.vertices_begin(), h->vertex()));
+			n++;
+		} while (++h != f->facet_begin());
+		normal.normalize();
+		faceNormals.push_back(normal);
+		faceOffsets.push_back(normal.dot(center/n));
+		faceStart.push_back(faceVertices.size());
+	}
 	//initialization done
 	init = 1;
 }
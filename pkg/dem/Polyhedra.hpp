@@ -73,6 +73,11 @@ class Polyhedra: public Shape{
 		void Clear();
 		void setVertices(const std::vector<Vector3r>& v);
 		void setVertices4(const Vector3r& v0, const Vector3r& v1,const Vector3r& v2,const Vector3r& v3);
+		//faces in flat arrays (local coordinates, filled by Initialize): vertices of face i are v[faceVertices[faceStart[i]..faceStart[i+1])],
+		//counterclockwise seen from outside; the face lies in the plane faceNormals[i].dot(x)=faceOffsets[i] with outward unit normal
+		vector<int> faceStart, faceVertices;
+		vector<Vector3r> faceNormals;
+		vector<Real> faceOffsets;
 
 	protected:
 		//triangulation of facets for plotting
@@ -137,7 +142,8 @@ class PolyhedraGeom: public IGeom{
 			((Vector3r,shearInc,Vector3r::Zero(),,"Shear displacement increment in the last step"))
 			((Vector3r,normal,Vector3r::Zero(),,"Normal direction of the interaction"))
 			((Vector3r,twist_axis,Vector3r::Zero(),,""))
-			((Vector3r,orthonormal_axis,Vector3r::Zero(),,"")),
+			((Vector3r,orthonormal_axis,Vector3r::Zero(),,""))
+			((Vector3r,sepAxis,Vector3r::Zero(),,"Direction (in the local frame of the first body) which separated the polyhedra when they were last found apart, or the contact normal; used to warm-start :yref:`Ig2_Polyhedra_Polyhedra_PolyhedraGeomGJK`.")),
 			createIndex();
 			sep_plane.assign(3,0);
 		);
@@ -8,7 +8,7 @@
 #endif
 #include "Polyhedra_Ig2.hpp"
 
-YADE_PLUGIN(/* self-contained in hpp: */ (Ig2_Polyhedra_Polyhedra_PolyhedraGeom) (Ig2_Wall_Polyhedra_PolyhedraGeom) (Ig2_Facet_Polyhedra_PolyhedraGeom) (Ig2_Sphere_Polyhedra_ScGeom) 
+YADE_PLUGIN(/* self-contained in hpp: */ (Ig2_Polyhedra_Polyhedra_PolyhedraGeom) (Ig2_Polyhedra_Polyhedra_PolyhedraGeomGJK) (Ig2_Wall_Polyhedra_PolyhedraGeom) (Ig2_Facet_Polyhedra_PolyhedraGeom) (Ig2_Sphere_Polyhedra_ScGeom) 
 	(Ig2_Polyhedra_Polyhedra_ScGeom) (Ig2_Polyhedra_Polyhedra_PolyhedraGeomOrScGeom)
 );
 
@@ -141,6 +141,234 @@ bool Ig2_Polyhedra_Polyhedra_PolyhedraGeom::goReverse(
 		const shared_ptr<Interaction>& c) {
 			return go(shape1,shape2,state2,state1,-shift2,force,c);
 		}
+//**********************************************************************************
+/*! Create PolyhedraGeom from colliding Polyhedras using GJK and clipping. */
+
+namespace {
+	// support point of a vertex cloud (polyhedra have tens of vertices, a linear scan is the fastest)
+	const Vector3r& gjkSupport(const vector<Vector3r>& pts, const Vector3r& d){
+		int best = 0;
+		Real bestDot = pts[0].dot(d);
+		for (int i=1; i<(int)pts.size(); i++) { const Real dot = pts[i].dot(d); if (dot>bestDot) { bestDot = dot; best = i; } }
+		return pts[best];
+	}
+
+	// line and triangle cases of GJK; s[0] is the newest point, the origin is searched in direction d
+	void gjkLine(Vector3r* s, int& n, Vector3r& d){
+		const Vector3r ab = s[1]-s[0], ao = -s[0];
+		if (ab.dot(ao)>0) { n = 2; d = ab.cross(ao).cross(ab); }
+		else { n = 1; d = ao; }
+	}
+	void gjkTriangle(Vector3r* s, int& n, Vector3r& d){
+		const Vector3r a = s[0], b = s[1], c = s[2];
+		const Vector3r ab = b-a, ac = c-a, ao = -a, abc = ab.cross(ac);
+		if (abc.cross(ac).dot(ao)>0) {
+			if (ac.dot(ao)>0) { s[1] = c; n = 2; d = ac.cross(ao).cross(ac); }
+			else { s[1] = b; gjkLine(s,n,d); }
+		} else if (ab.cross(abc).dot(ao)>0) { s[1] = b; gjkLine(s,n,d); }
+		else {
+			n = 3;
+			if (abc.dot(ao)>0) d = abc;
+			else { s[1] = c; s[2] = b; d = -abc; }
+		}
+	}
+	// returns true if the origin is enclosed by the tetrahedron s[0..3]
+	bool gjkTetrahedron(Vector3r* s, int& n, Vector3r& d){
+		const Vector3r a = s[0], ao = -a;
+		const Vector3r others[3][3] = {{s[1],s[2],s[3]},{s[2],s[3],s[1]},{s[3],s[1],s[2]}};
+		for (int f=0; f<3; f++) {
+			// face (a,p,q) opposite to r, normal oriented away from r
+			const Vector3r& p = others[f][0]; const Vector3r& q = others[f][1]; const Vector3r& r = others[f][2];
+			Vector3r normal = (p-a).cross(q-a);
+			if (normal.dot(r-a)>0) normal = -normal;
+			if (normal.dot(ao)>0) { s[1] = p; s[2] = q; n = 3; gjkTriangle(s,n,d); return false; }
+		}
+		return true;
+	}
+
+	/*! GJK boolean test of two convex vertex clouds in the same frame. On input, d is the initial search direction (pointing from A to B is best);
+	 * if false is returned, d is a separating direction: max over A of x.d is smaller than min over B of x.d. */
+	bool gjkIntersect(const vector<Vector3r>& A, const vector<Vector3r>& B, Vector3r& d){
+		if (d.squaredNorm()==0) d = Vector3r::UnitX();
+		Vector3r s[4];
+		int n = 0;
+		for (int iter=0; iter<100; iter++) {
+			// support of the Minkowski difference B-A, so that d keeps pointing from A to B
+			const Vector3r p = gjkSupport(B,-d)-gjkSupport(A,d);
+			if (p.dot(d)>0) return false; // B is entirely beyond A along d
+			for (int i=n; i>0; i--) s[i] = s[i-1];
+			s[0] = p; n++;
+			// search direction goes toward the origin, -d is the current separating candidate
+			Vector3r dir;
+			if (n==1) dir = -p;
+			else if (n==2) gjkLine(s,n,dir);
+			else if (n==3) gjkTriangle(s,n,dir);
+			else if (gjkTetrahedron(s,n,dir)) return true;
+			if (dir.squaredNorm()<1e-30) return true; // touching
+			d = -dir;
+		}
+		return true; // no convergence: decided by clipping
+	}
+
+	/*! Clip convex polyhedron given by its faces (vertex loops counterclockwise seen from outside, tagged by origin) by the half-space n.x<=offset.
+	 * The new face lying in the plane is tagged with tag. Returns false if nothing remains. */
+	bool polyClip(vector<vector<Vector3r> >& faces, vector<char>& tags, const Vector3r& n, Real offset, char tag, Real eps){
+		bool allIn = true, allOut = true;
+		FOREACH(const vector<Vector3r>& f, faces) FOREACH(const Vector3r& p, f) {
+			const Real dist = n.dot(p)-offset;
+			if (dist>eps) allIn = false;
+			if (dist<-eps) allOut = false;
+		}
+		if (allIn) return true;
+		if (allOut) { faces.clear(); tags.clear(); return false; }
+		vector<vector<Vector3r> > clipped; vector<char> clippedTags;
+		vector<Vector3r> cap;
+		vector<Vector3r> out;
+		bool coplanar = false; // a face already lies in the plane, it is the cap
+		for (unsigned int i=0; i<faces.size(); i++) {
+			const vector<Vector3r>& f = faces[i];
+			out.clear();
+			bool onPlane = true;
+			for (unsigned int j=0; j<f.size(); j++) {
+				const Vector3r& p = f[j]; const Vector3r& q = f[(j+1)%f.size()];
+				const Real dp = n.dot(p)-offset, dq = n.dot(q)-offset;
+				if (std::abs(dp)>eps) onPlane = false;
+				if (dp<=eps) { out.push_back(p); if (dp>=-eps) cap.push_back(p); }
+				if ((dp<-eps && dq>eps) || (dp>eps && dq<-eps)) { const Vector3r x = p+(q-p)*(dp/(dp-dq)); out.push_back(x); cap.push_back(x); }
+			}
+			if (out.size()>=3) { clipped.push_back(out); clippedTags.push_back(tags[i]); }
+			coplanar = coplanar || onPlane;
+		}
+		// cap polygon: points in the plane, ordered counterclockwise around the outward normal n
+		if (cap.size()>=3 && !coplanar) {
+			Vector3r center(Vector3r::Zero());
+			FOREACH(const Vector3r& p, cap) center += p;
+			center /= cap.size();
+			const Vector3r u = (std::abs(n[0])<0.9 ? Vector3r::UnitX() : Vector3r::UnitY()).cross(n).normalized(), v = n.cross(u);
+			vector<std::pair<Real,Vector3r> > sorted;
+			FOREACH(const Vector3r& p, cap) sorted.push_back(std::make_pair(atan2((p-center).dot(v),(p-center).dot(u)),p));
+			std::sort(sorted.begin(),sorted.end(),[](const std::pair<Real,Vector3r>& a, const std::pair<Real,Vector3r>& b){ return a.first<b.first; });
+			out.clear();
+			for (unsigned int i=0; i<sorted.size(); i++) if (out.empty() || (sorted[i].second-out.back()).squaredNorm()>eps*eps) out.push_back(sorted[i].second);
+			while (out.size()>1 && (out.front()-out.back()).squaredNorm()<=eps*eps) out.pop_back();
+			if (out.size()>=3) { clipped.push_back(out); clippedTags.push_back(tag); }
+		}
+		faces.swap(clipped); tags.swap(clippedTags);
+		return !faces.empty();
+	}
+}
+
+bool Ig2_Polyhedra_Polyhedra_PolyhedraGeomGJK::go(
+		const shared_ptr<Shape>& shape1,
+		const shared_ptr<Shape>& shape2,
+		const State& state1,
+		const State& state2,
+		const Vector3r& shift2,
+		const bool& force,
+		const shared_ptr<Interaction>& interaction) {
+	Polyhedra* A = static_cast<Polyhedra*>(shape1.get());
+	Polyhedra* B = static_cast<Polyhedra*>(shape2.get());
+	if (!A->IsInitialized()) A->Initialize();
+	if (!B->IsInitialized()) B->Initialize();
+	const bool isNew = !interaction->geom;
+	const Real& s = interactionDetectionFactor;
+
+	//everything in the local frame of A: x = rotAB*xB + transAB for local coordinates xB of B
+	const Matrix3r rotA = state1.ori.toRotationMatrix();
+	const Matrix3r rotAB = rotA.transpose()*state2.ori.toRotationMatrix();
+	const Vector3r transAB = rotA.transpose()*(state2.pos+shift2-state1.pos);
+	vector<Vector3r> vA(A->v.size()), vB(B->v.size());
+	Real size = 0;
+	for (unsigned int i=0; i<vA.size(); i++) { vA[i] = s*A->v[i]; size = max(size,vA[i].squaredNorm()); }
+	for (unsigned int i=0; i<vB.size(); i++) vB[i] = rotAB*(s*B->v[i])+transAB;
+	const Real eps = 1e-10*sqrt(size);
+
+	shared_ptr<PolyhedraGeom> bang;
+	if (isNew) {
+		bang = shared_ptr<PolyhedraGeom>(new PolyhedraGeom());
+		bang->contactPoint = Vector3r(0,0,0);
+		bang->isShearNew = true;
+		// kept on the potential interaction as well, so that the separating axis survives until the polyhedra touch
+		interaction->geom = bang;
+	} else {
+		bang = YADE_PTR_CAST<PolyhedraGeom>(interaction->geom);
+		bang->isShearNew = bang->equivalentPenetrationDepth<=0;
+	}
+
+	//separation, warm-started by the previous axis
+	Vector3r axis = (bang->sepAxis.squaredNorm()>0 ? bang->sepAxis : transAB);
+	if (!gjkIntersect(vA,vB,axis)) {
+		bang->sepAxis = axis;
+		bang->equivalentPenetrationDepth = 0;
+		return interaction->isReal();
+	}
+
+	//intersection: faces of A clipped by the planes of B
+	vector<vector<Vector3r> > faces(A->faceNormals.size());
+	vector<char> tags(faces.size(),0);
+	for (unsigned int f=0; f<faces.size(); f++) for (int j=A->faceStart[f]; j<A->faceStart[f+1]; j++) faces[f].push_back(vA[A->faceVertices[j]]);
+	for (unsigned int f=0; f<B->faceNormals.size() && !faces.empty(); f++) {
+		const Vector3r n = rotAB*B->faceNormals[f];
+		polyClip(faces,tags,n,s*B->faceOffsets[f]+n.dot(transAB),1,eps);
+	}
+	Real volume = 0;
+	Vector3r centroid(Vector3r::Zero()), normal(Vector3r::Zero());
+	if (!faces.empty()) {
+		Vector3r ref(Vector3r::Zero());
+		int nPts = 0;
+		FOREACH(const vector<Vector3r>& f, faces) FOREACH(const Vector3r& p, f) { ref += p; nPts++; }
+		ref /= nPts;
+		for (unsigned int i=0; i<faces.size(); i++) {
+			const vector<Vector3r>& f = faces[i];
+			Vector3r area(Vector3r::Zero());
+			for (unsigned int j=1; j+1<f.size(); j++) {
+				const Vector3r cross = (f[j]-f[0]).cross(f[j+1]-f[0]);
+				const Real vol = (f[0]-ref).dot((f[j]-ref).cross(f[j+1]-ref))/6.;
+				volume += vol;
+				centroid += vol*(ref+f[0]+f[j]+f[j+1])/4.;
+				area += .5*cross;
+			}
+			if (tags[i]==0) normal += area; // outward normals of A enclosed in B point from A to B
+		}
+	}
+	if (!(volume>1E-25) || volume>min(A->GetVolume(),B->GetVolume())*s*s*s) {
+		// touching or numerically empty: keep the direction between centers for the next warm start
+		bang->sepAxis = transAB;
+		bang->equivalentPenetrationDepth = 0;
+		return interaction->isReal();
+	}
+	centroid /= volume;
+	if (normal.squaredNorm()==0) normal = transAB; // one polyhedron inside the other
+	normal.normalize();
+	bang->sepAxis = normal;
+
+	//back to global coordinates
+	centroid = state1.pos+rotA*centroid;
+	normal = rotA*normal;
+	if ((state2.pos+shift2-centroid).dot(normal)<0) normal *= -1;
+
+	Real area = std::pow(volume,2./3.);
+	bang->equivalentCrossSection = area;
+	bang->contactPoint = centroid;
+	bang->penetrationVolume = volume;
+	bang->equivalentPenetrationDepth = volume/area;
+	bang->precompute(state1,state2,scene,interaction,normal,bang->isShearNew,shift2);
+	bang->normal = normal;
+	return true;
+}
+
+bool Ig2_Polyhedra_Polyhedra_PolyhedraGeomGJK::goReverse(
+		const shared_ptr<Shape>& shape1,
+		const shared_ptr<Shape>& shape2,
+		const State& state1,
+		const State& state2,
+		const Vector3r& shift2,
+		const bool& force,
+		const shared_ptr<Interaction>& c) {
+	c->swapOrder();
+	return go(shape2,shape1,state2,state1,-shift2,force,c);
+}
+
 //**********************************************************************************
 /*! Create Polyhedra (collision geometry) from colliding Polyhedron and Wall. */
 
@@ -23,6 +23,25 @@ class Ig2_Polyhedra_Polyhedra_PolyhedraGeom: public IGeomFunctor
 };
 REGISTER_SERIALIZABLE(Ig2_Polyhedra_Polyhedra_PolyhedraGeom);
 
+//***************************************************************************
+/*! Create PolyhedraGeom from colliding Polyhedras without CGAL constructions: GJK for separation, clipping of flat face arrays for the overlap. */
+class Ig2_Polyhedra_Polyhedra_PolyhedraGeomGJK: public IGeomFunctor
+{
+	public:
+		virtual ~Ig2_Polyhedra_Polyhedra_PolyhedraGeomGJK(){};
+		virtual bool go(const shared_ptr<Shape>& shape1, const shared_ptr<Shape>& shape2, const State& state1,
+			const State& state2, const Vector3r& shift2, const bool& force, const shared_ptr<Interaction>& c);
+		virtual bool goReverse(const shared_ptr<Shape>& shape1, const shared_ptr<Shape>& shape2, const State& state1,
+			const State& state2, const Vector3r& shift2, const bool& force, const shared_ptr<Interaction>& c);
+		FUNCTOR2D(Polyhedra,Polyhedra);
+		DEFINE_FUNCTOR_ORDER_2D(Polyhedra,Polyhedra);
+		YADE_CLASS_BASE_DOC_ATTRS(Ig2_Polyhedra_Polyhedra_PolyhedraGeomGJK,IGeomFunctor,"Create/update geometry of collision between 2 Polyhedras, as :yref:`Ig2_Polyhedra_Polyhedra_PolyhedraGeom` but without copying and intersecting CGAL polyhedra. Both shapes are expressed in the local frame of the first one; separation is detected by the GJK algorithm, warm-started with the axis which separated them (or the contact normal) at the previous step (:yref:`PolyhedraGeom.sepAxis`); the geometry is therefore created as soon as the bounds overlap and kept on the potential interaction. Overlapping polyhedra are clipped by the face planes of each other to get the volume and centroid of the intersection. The normal is the area-weighted normal of the faces of the first polyhedron enclosed in the second one (for a closed intersection, it is opposite to the one of the faces of the second polyhedron), which is the gradient of the overlap volume with respect to the relative displacement.",
+			((Real,interactionDetectionFactor,1,,"see :yref:`Ig2_Sphere_Sphere_ScGeom.interactionDetectionFactor`"))
+		);
+		DECLARE_LOGGER;
+};
+REGISTER_SERIALIZABLE(Ig2_Polyhedra_Polyhedra_PolyhedraGeomGJK);
+
 //***************************************************************************
 /*! Create Polyhedra (collision geometry) from colliding Wall & Polyhedra. */
 class Ig2_Wall_Polyhedra_PolyhedraGeom: public IGeomFunctor
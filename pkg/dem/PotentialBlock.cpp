@@ -27,6 +27,7 @@ PotentialBlock::~PotentialBlock()
 void PotentialBlock::postLoad(PotentialBlock&)
 {
 	 int planeNo = a.size();
+	 planeStruct.clear(); vertexStruct.clear(); offsetVertices.clear();
 	 for (int i=0; i<planeNo; i++){
 		addPlaneStruct();
 	 }
@@ -92,7 +93,7 @@ void PotentialBlock::postLoad(PotentialBlock&)
 							planeStruct[i].vertexID.push_back(vertexID);	/* planes store information on vertexIDs */
 							planeStruct[j].vertexID.push_back(vertexID);	
 							planeStruct[k].vertexID.push_back(vertexID);	
-							
+							offsetVertices.push_back(vertex);
 
 						}
 					}
@@ -100,6 +101,14 @@ void PotentialBlock::postLoad(PotentialBlock&)
 			}		
 		}
 	  }
+	 /* Bounding spheres used by Ig2_PB_PB_ScGeom to skip the contact solver */
+	 outRadius = 0.0; inRadius = (planeNo>0) ? std::numeric_limits<Real>::infinity() : 0.0;
+	 for (unsigned int i=0; i<offsetVertices.size(); i++){ outRadius = std::max(outRadius, offsetVertices[i].norm()); }
+	 for (int i=0; i<planeNo; i++){
+		Real n = Vector3r(a[i],b[i],c[i]).norm();
+		if (n>0.0){ inRadius = std::min(inRadius, (d[i]+r)/n); }
+	 }
+	 if (offsetVertices.empty() || inRadius<0.0 || std::isinf(inRadius)){ inRadius = 0.0; outRadius = 0.0; }
 }
 //#endif
 
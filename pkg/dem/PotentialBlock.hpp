@@ -36,6 +36,7 @@ class PotentialBlock : public Shape
 	
 		Eigen::MatrixXd Amatrix;
 		Eigen::MatrixXd Dmatrix;
+		vector<Vector3r> offsetVertices; // vertices of the polyhedron with planes offset by r (local coordinates), computed in postLoad
 		virtual ~PotentialBlock ();
 		void postLoad(PotentialBlock&);
 	
@@ -65,6 +66,8 @@ class PotentialBlock : public Shape
 		((Real , R, 1.0,, "R "))
 		((Real , k, 0.1,, "k "))
 		((Real , volume, 0.1,, "k "))
+		((Real , inRadius, 0.0, Attr::readonly|Attr::noSave, "radius of the sphere centred at the local origin inscribed in the polyhedron with planes offset by :yref:`r<PotentialBlock.r>` (computed in postLoad)"))
+		((Real , outRadius, 0.0, Attr::readonly|Attr::noSave, "radius of the sphere centred at the local origin circumscribed to the polyhedron with planes offset by :yref:`r<PotentialBlock.r>` (computed in postLoad)"))
 		((int, id, -1,, " for graphics"))
 		((bool, erase, false,, " for graphics"))
 		((vector<bool>, intactRock, false,, " for graphics"))
@@ -832,6 +832,7 @@ void Shop::growParticles(Real multiplier, bool updateMass, bool dynamicOnly)
 				FOREACH(Clump::MemberMap::value_type& B, YADE_PTR_CAST<Clump>(b->shape)->members){
 					// B.first is Body::id_t, B.second is local Se3r of that body in the clump
 					B.second.position *= multiplier;}
+				YADE_PTR_CAST<Clump>(b->shape)->updateMemberArrays();
 				// for clumps we are done
 				continue;
 			}
@@ -12,6 +12,9 @@
 #include <boost/random/variate_generator.hpp>
 
 #include<core/Timing.hpp>
+#ifdef YADE_OPENMP
+	#include<omp.h>
+#endif
 
 // not a serializable in the sense of YADE_PLUGIN
 
@@ -83,6 +86,59 @@ void SpherePack::fromSimulation() {
 	}
 }
 
+/* Uniform grid used by makeCloud to test trial positions against nearby spheres only.
+Cells are defined in reduced coordinates (fractions of the box, or of hSize for periodic cells) and are at least 2*rMax wide in space, so two overlapping spheres are always in the same or in adjacent cells (across the period for periodic cells). */
+class CloudGrid{
+	bool periodic, useInvH;
+	Vector3r mn, size;
+	Matrix3r invH;
+	Vector3i n;
+	vector<vector<size_t> > cells;
+	Vector3r reduced(const Vector3r& c) const {
+		if(useInvH) return invH*(c-mn);
+		Vector3r s;
+		for(int k=0; k<3; k++) s[k]=(size[k] ? (c[k]-mn[k])/size[k] : 0);
+		return s;
+	}
+	int wrap(int i, int k) const { return periodic ? ((i%n[k])+n[k])%n[k] : max(0,min(n[k]-1,i)); }
+	Vector3i cellOf(const Vector3r& c) const {
+		const Vector3r s=reduced(c); Vector3i ijk;
+		for(int k=0; k<3; k++) ijk[k]=wrap((int)floor(s[k]*n[k]),k);
+		return ijk;
+	}
+	size_t linear(int i, int j, int k) const { return ((size_t)i*n[1]+j)*n[2]+k; }
+	public:
+	CloudGrid(bool _periodic, const Vector3r& _mn, const Vector3r& _size, bool hSizeFound, const Matrix3r& hSize, const Matrix3r& invHsize, Real rMax): periodic(_periodic), useInvH(_periodic && hSizeFound), mn(_mn), size(_size), invH(invHsize){
+		const Real h=2.02*rMax; // a bit more than the largest contact distance, against roundoff
+		for(int k=0; k<3; k++){
+			// length of the box along the k-th reduced axis, measured perpendicular to the two other axes
+			const Real extent=(useInvH ? 1./invH.row(k).norm() : size[k]);
+			n[k]=((extent>0 && h>0) ? max(1,(int)min(1e6,floor(extent/h))) : 1);
+		}
+		while((long)n[0]*n[1]*n[2]>(1L<<24)) for(int k=0; k<3; k++) n[k]=max(1,n[k]/2);
+		cells.resize((size_t)n[0]*n[1]*n[2]);
+	}
+	void add(const Vector3r& c, size_t id){ const Vector3i ijk=cellOf(c); cells[linear(ijk[0],ijk[1],ijk[2])].push_back(id); }
+	//! return true as soon as overlap(c,r,j) is true for some sphere j in the neighbourhood of c
+	template<class OverlapT> bool overlaps(const Vector3r& c, Real r, const OverlapT& overlap) const {
+		const Vector3i ijk=cellOf(c);
+		int range[3][3]; int nRange[3];
+		for(int k=0; k<3; k++){
+			nRange[k]=0;
+			// with fewer than 3 cells along a periodic axis, every cell is a neighbour (only once)
+			if(periodic && n[k]<3){ for(int i=0; i<n[k]; i++) range[k][nRange[k]++]=i; continue; }
+			for(int i=ijk[k]-1; i<=ijk[k]+1; i++){
+				if(!periodic && (i<0 || i>=n[k])) continue;
+				range[k][nRange[k]++]=wrap(i,k);
+			}
+		}
+		for(int a=0; a<nRange[0]; a++) for(int b=0; b<nRange[1]; b++) for(int d=0; d<nRange[2]; d++){
+			FOREACH(size_t j, cells[linear(range[0][a],range[1][b],range[2][d])]) if(overlap(c,r,j)) return true;
+		}
+		return false;
+	}
+};
+
 long SpherePack::makeCloud(Vector3r mn, Vector3r mx, Real rMean, Real rRelFuzz, int num, bool periodic, Real porosity, const vector<Real>& psdSizes, const vector<Real>& psdCumm, bool distributeMass, int seed, Matrix3r hSize){
 	isPeriodic = periodic;
 	static boost::minstd_rand randGen(seed!=0?seed:(int)TimingInfo::getNow(/* get the number even if timing is disabled globally */ true));
@@ -151,6 +207,57 @@ long SpherePack::makeCloud(Vector3r mn, Vector3r mx, Real rMean, Real rRelFuzz,
 	// adjust uniform distribution parameters with distributeMass; rMean has the meaning (dimensionally) of _volume_
 	const int maxTry=1000;
 	if(periodic && volume && !hSizeFound)(cellSize=size);
+	// largest radius that can be generated (or is already in the packing), it sets the size of the search grid
+	Real rMax=0;
+	if(mode==RDIST_PSD) rMax=*std::max_element(psdRadii.begin(),psdRadii.end());
+	else rMax=rMean*(1+std::abs(rRelFuzz));
+	FOREACH(const Sph& s, pack) rMax=max(rMax,s.r);
+	CloudGrid grid(periodic,mn,size,hSizeFound,hSize,invHsize,rMax);
+	for(size_t j=0; j<pack.size(); j++) grid.add(pack[j].c,j);
+	// same overlap test as for the whole packing, applied to spheres from neighbouring grid cells only
+	auto overlap=[&](const Vector3r& c, Real rad, size_t j)->bool{
+		if(!periodic) return pow(pack[j].r+rad,2)>=(pack[j].c-c).squaredNorm();
+		Vector3r dr=Vector3r::Zero();
+		if (!hSizeFound) {//The box is axis-aligned, use the wrap methods
+			for(int axis=0; axis<3; axis++) {
+				if (size[axis]) {
+					dr[axis]=min(cellWrapRel(c[axis],pack[j].c[axis],pack[j].c[axis]+size[axis]),
+											 cellWrapRel(pack[j].c[axis],c[axis],c[axis]+size[axis]));
+				} else {
+					dr[axis]=0;
+				}
+			}
+		} else {//not aligned, find closest neighbor in a cube of size 1, then transform distance to cartesian coordinates
+			Vector3r c1c2=invHsize*(pack[j].c-c);
+			for(int axis=0; axis<3; axis++) {
+				if (std::abs(c1c2[axis])<std::abs(c1c2[axis] - Mathr::Sign(c1c2[axis]))) dr[axis]=c1c2[axis];
+				else dr[axis] = c1c2[axis] - Mathr::Sign(c1c2[axis]);
+			}
+			dr=hSize*dr;//now in cartesian coordinates
+		}
+		return pow(pack[j].r+rad,2) >= dr.squaredNorm();
+	};
+	auto trialCenter=[&](Real rad)->Vector3r{
+		Vector3r c = Vector3r::Zero();
+		if(!periodic) {
+			//we handle 2D with the special case size[axis]==0
+			for(int axis=0; axis<3; axis++) {
+				c[axis]=mn[axis]+(size[axis]?(size[axis]-2*rad)*rnd()+rad:0);
+			}
+		} else {
+			for(int axis=0; axis<3; axis++) {
+				c[axis]=rnd();//coordinates in [0,1]
+			}
+			c = hSize*c + mn; //coordinates in reference frame (inside the base cell)
+		}
+		return c;
+	};
+	const int trialBatch=64;
+	#ifdef YADE_OPENMP
+		const bool parallelTrials=(omp_get_max_threads()>1);
+	#else
+		const bool parallelTrials=false;
+	#endif
 	Real r=0;
 	for(int i=0; (i<num) || (num<0); i++) {
 		Real norm, rand;
@@ -175,59 +282,28 @@ long SpherePack::makeCloud(Vector3r mn, Vector3r mx, Real rMean, Real rRelFuzz,
 					r=psdRadii[piece]+norm*(psdRadii[piece+1]-psdRadii[piece]);}
 		}
 		// try to put the sphere into a free spot
-		for(t=0; t<maxTry; ++t) {
-			Vector3r c = Vector3r::Zero();
-			if(!periodic) {
-				//we handle 2D with the special case size[axis]==0
-				for(int axis=0; axis<3; axis++) {
-					c[axis]=mn[axis]+(size[axis]?(size[axis]-2*r)*rnd()+r:0);
-				}
-			} else {
-				for(int axis=0; axis<3; axis++) {
-					c[axis]=rnd();//coordinates in [0,1]
-				}
-				c = hSize*c + mn; //coordinates in reference frame (inside the base cell)
-			}
-			
-			size_t packSize=pack.size();
-			bool overlap=false;
-			if(!periodic) {
-				for(size_t j=0;j<packSize;j++) {
-					if(pow(pack[j].r+r,2)>=(pack[j].c-c).squaredNorm()) {
-						overlap=true; 
-						break;
-					}
-				}
-			} else {
-				for(size_t j=0; j<packSize; j++) {
-					Vector3r dr=Vector3r::Zero();
-					if (!hSizeFound) {//The box is axis-aligned, use the wrap methods
-						for(int axis=0; axis<3; axis++) {
-							if (size[axis]) {
-								dr[axis]=min(cellWrapRel(c[axis],pack[j].c[axis],pack[j].c[axis]+size[axis]),
-														 cellWrapRel(pack[j].c[axis],c[axis],c[axis]+size[axis]));
-							} else {
-								dr[axis]=0;
-							}
-						}
-					} else {//not aligned, find closest neighbor in a cube of size 1, then transform distance to cartesian coordinates
-						Vector3r c1c2=invHsize*(pack[j].c-c);
-						for(int axis=0; axis<3; axis++) {
-							if (std::abs(c1c2[axis])<std::abs(c1c2[axis] - Mathr::Sign(c1c2[axis]))) dr[axis]=c1c2[axis];
-							else dr[axis] = c1c2[axis] - Mathr::Sign(c1c2[axis]);
-						}
-						dr=hSize*dr;//now in cartesian coordinates
-					}
-					if(pow(pack[j].r+r,2) >= dr.squaredNorm()) {
-						overlap=true;
-						break;
-					}
-				}
-			}
-			if(!overlap) {
-				pack.push_back(Sph(c,r));
-				break;
+		t=0;
+		while(t<maxTry) {
+			// test one trial position at a time first; in crowded packings test batches in parallel, rewinding the generator to the accepted trial so that the random sequence (hence the packing) is the same as in the serial case
+			const int batch=min(maxTry-t, (parallelTrials && t>=4) ? trialBatch : 1);
+			if(batch==1) {
+				const Vector3r c=trialCenter(r);
+				if(!grid.overlaps(c,r,overlap)) { pack.push_back(Sph(c,r)); grid.add(c,pack.size()-1); break; }
+				t++;
+				continue;
 			}
+			const boost::minstd_rand saved=randGen;
+			vector<Vector3r> trials(batch); vector<char> isFree(batch);
+			for(int k=0; k<batch; k++) trials[k]=trialCenter(r);
+			#ifdef YADE_OPENMP
+			#pragma omp parallel for schedule(static,1)
+			#endif
+			for(int k=0; k<batch; k++) isFree[k]=!grid.overlaps(trials[k],r,overlap);
+			int accepted=-1;
+			for(int k=0; k<batch; k++) if(isFree[k]) { accepted=k; break; }
+			if(accepted<0) { t+=batch; continue; }
+			randGen=saved; for(int k=0; k<=accepted; k++) trialCenter(r);
+			pack.push_back(Sph(trials[accepted],r)); grid.add(trials[accepted],pack.size()-1); t+=accepted; break;
 		}
 		if (t==maxTry) {
 			if(num>0) {
@@ -0,0 +1,152 @@
+#include <pkg/dem/StatsEngine.hpp>
+#include <pkg/dem/NewtonIntegrator.hpp>
+#include <pkg/dem/DemXDofGeom.hpp>
+#include <pkg/common/NormShearPhys.hpp>
+#include <pkg/common/Sphere.hpp>
+#include <pkg/common/Grid.hpp>
+#include <core/Clump.hpp>
+#include <lib/base/openmp-accu.hpp>
+
+YADE_PLUGIN((StatsEngine));
+CREATE_LOGGER(StatsEngine);
+
+void StatsEngine::action(){
+	const bool doUnbalanced=computeUnbalanced, doKinetic=computeKinetic, doStress=computeStress, doFabric=computeFabric, doBodyStress=computeBodyStress;
+	const bool isPeriodic=scene->isPeriodic;
+	const BodyContainer& bodies=*scene->bodies;
+	const long nBodies=bodies.size();
+	if(doUnbalanced) scene->forces.sync();
+	Vector3r gravity=Vector3r::Zero();
+	if(doUnbalanced){ FOREACH(const shared_ptr<Engine>& e, scene->engines){ NewtonIntegrator* newton=dynamic_cast<NewtonIntegrator*>(e.get()); if(newton){ gravity=newton->gravity; break; } } }
+	const Vector3r spin=scene->cell->getSpin();
+	if(doBodyStress) bodyStresses.assign(nBodies,Matrix3r::Zero());
+	// ** bodies ** (Shop::unbalancedForce, Shop::kineticEnergy, Shop::aabbExtrema, Shop::getStressLWForEachBody)
+	Real sumF=0, maxF=0, kin=0; long nDyn=0;
+	const Real inf=std::numeric_limits<Real>::infinity();
+	Real mnX=inf, mnY=inf, mnZ=inf, mxX=-inf, mxY=-inf, mxZ=-inf;
+	#ifdef YADE_OPENMP
+	#pragma omp parallel for reduction(+:sumF,kin,nDyn) reduction(max:maxF,mxX,mxY,mxZ) reduction(min:mnX,mnY,mnZ) schedule(guided)
+	#endif
+	for(long id=0; id<nBodies; id++){
+		const shared_ptr<Body>& b=bodies[id];
+		if(!b) continue;
+		const State* state=b->state.get();
+		const Sphere* sphere=dynamic_cast<Sphere*>(b->shape.get());
+		if(sphere){
+			mnX=min(mnX,state->pos[0]-sphere->radius); mnY=min(mnY,state->pos[1]-sphere->radius); mnZ=min(mnZ,state->pos[2]-sphere->radius);
+			mxX=max(mxX,state->pos[0]+sphere->radius); mxY=max(mxY,state->pos[1]+sphere->radius); mxZ=max(mxZ,state->pos[2]+sphere->radius);
+		}
+		if(doBodyStress){
+			Matrix3r& bStress=bodyStresses[id];
+			for(Body::MapId2IntrT::const_iterator it=b->intrs.begin(); it!=b->intrs.end(); ++it){
+				const Interaction* I=it->second.get();
+				if(!I->isReal()) continue;
+				const GenericSpheresContact* geom=dynamic_cast<GenericSpheresContact*>(I->geom.get());
+				const NormShearPhys* phys=dynamic_cast<NormShearPhys*>(I->phys.get());
+				if(!geom || !phys) continue;
+				const Vector3r f=phys->normalForce+phys->shearForce;
+				if(I->getId1()==id) bStress-=(3.0/(4.0*Mathr::PI*pow(geom->refR1,3)))*f*((geom->contactPoint-state->pos).transpose());
+				else {
+					Vector3r pos2=state->pos;
+					if(isPeriodic) pos2+=scene->cell->hSize*I->cellDist.cast<Real>();
+					bStress+=(3.0/(4.0*Mathr::PI*pow(geom->refR2,3)))*f*((geom->contactPoint-pos2).transpose());
+				}
+			}
+		}
+		if(!b->isDynamic() || b->isClumpMember()) continue;
+		if(doUnbalanced){
+			Real currF=(scene->forces.getForce(id)+state->mass*gravity).norm();
+			if(b->isClump() && currF==0){ // see Shop::unbalancedForce
+				Vector3r f(scene->forces.getForce(id)),m(Vector3r::Zero());
+				b->shape->cast<Clump>().addForceTorqueFromMembers(state,scene,f,m);
+				currF=(f+state->mass*gravity).norm();
+			}
+			maxF=max(maxF,currF); sumF+=currF; nDyn++;
+		}
+		if(doKinetic){
+			Real E;
+			if(isPeriodic) E=.5*state->mass*scene->cell->bodyFluctuationVel(state->pos-state->vel*scene->dt,state->vel,scene->cell->velGrad).squaredNorm();
+			else E=.5*(state->mass*state->vel.squaredNorm());
+			const Vector3r angVel=(isPeriodic ? Vector3r(state->angVel-spin) : state->angVel);
+			if(b->isAspherical()){
+				Matrix3r T(state->ori);
+				Matrix3r mI(state->inertia.asDiagonal());
+				E+=.5*angVel.transpose().dot((T*mI*T.transpose())*angVel);
+			} else E+=0.5*angVel.dot(state->inertia.cwiseProduct(angVel));
+			kin+=E;
+		}
+	}
+	const Vector3r bbMin(mnX,mnY,mnZ), bbMax(mxX,mxY,mxZ);
+	Real vol=volume;
+	if(vol==0) vol=(isPeriodic ? scene->cell->hSize.determinant() : (bbMax-bbMin).prod());
+	const Vector3r dim=bbMax-bbMin;
+	const Vector3r fabMin=bbMin+.5*fabricCutoff*dim, fabMax=bbMax-.5*fabricCutoff*dim;
+
+	// ** interactions ** (mean contact force, Shop::getStress, Shop::fabricTensor)
+	const bool interactionPass=doUnbalanced || doStress || doFabric;
+	const long nIntrs=scene->interactions->size();
+	Real sumIntrF=0, sumFn=0; long nIntrF=0, nFabric=0;
+	OpenMPAccumulator<Matrix3r> stressAccu, fabricAccu;
+	if(interactionPass){
+		#ifdef YADE_OPENMP
+		#pragma omp parallel for reduction(+:sumIntrF,sumFn,nIntrF,nFabric) schedule(guided)
+		#endif
+		for(long i=0; i<nIntrs; i++){
+			const shared_ptr<Interaction>& I=(*scene->interactions)[i];
+			if(!I->isReal()) continue;
+			const NormShearPhys* phys=dynamic_cast<NormShearPhys*>(I->phys.get());
+			if(!phys) continue;
+			const Vector3r f=phys->normalForce+phys->shearForce;
+			if(doUnbalanced){ sumIntrF+=f.norm(); nIntrF++; }
+			if(doStress && bodies[I->getId1()]->shape->getClassIndex()!=GridNode::getClassIndexStatic()){
+				Vector3r branch=bodies[I->getId1()]->state->pos-bodies[I->getId2()]->state->pos;
+				if(isPeriodic) branch-=scene->cell->hSize*I->cellDist.cast<Real>();
+				stressAccu+=f*branch.transpose();
+			}
+			if(doFabric){
+				const GenericSpheresContact* geom=dynamic_cast<GenericSpheresContact*>(I->geom.get());
+				if(!geom) continue;
+				const Vector3r& cp=geom->contactPoint;
+				if(!(cp.array()>=fabMin.array()).all() || !(cp.array()<=fabMax.array()).all()) continue;
+				const Vector3r& n=geom->normal;
+				fabricAccu+=n*n.transpose();
+				sumFn+=-phys->normalForce.dot(n); // < 0 in compression
+				nFabric++;
+			}
+		}
+	}
+	if(doUnbalanced){
+		const Real meanIntrF=sumIntrF/nIntrF;
+		unbalancedForce=(sumF/nDyn)/meanIntrF;
+		maxUnbalancedForce=maxF/meanIntrF;
+	}
+	if(doKinetic) kineticEnergy=kin;
+	if(doStress) stress=stressAccu.get()/vol;
+	if(doFabric){
+		meanNormalForce=sumFn/nFabric;
+		fabric=fabricAccu.get()/nFabric;
+		if(splitFabric){
+			// the split needs the mean normal force, hence one more pass
+			const Real fSplit=(std::isnan(thresholdForce) ? meanNormalForce : thresholdForce);
+			OpenMPAccumulator<Matrix3r> strongAccu, weakAccu;
+			long nStrong=0, nWeak=0;
+			#ifdef YADE_OPENMP
+			#pragma omp parallel for reduction(+:nStrong,nWeak) schedule(guided)
+			#endif
+			for(long i=0; i<nIntrs; i++){
+				const shared_ptr<Interaction>& I=(*scene->interactions)[i];
+				if(!I->isReal()) continue;
+				const NormShearPhys* phys=dynamic_cast<NormShearPhys*>(I->phys.get());
+				const GenericSpheresContact* geom=dynamic_cast<GenericSpheresContact*>(I->geom.get());
+				if(!phys || !geom) continue;
+				const Vector3r& cp=geom->contactPoint;
+				if(!(cp.array()>=fabMin.array()).all() || !(cp.array()<=fabMax.array()).all()) continue;
+				const Vector3r& n=geom->normal;
+				if(-phys->normalForce.dot(n)<fSplit){ strongAccu+=n*n.transpose(); nStrong++; }
+				else { weakAccu+=n*n.transpose(); nWeak++; }
+			}
+			fabricStrong=strongAccu.get()/nStrong;
+			fabricWeak=weakAccu.get()/nWeak;
+		}
+	}
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <pkg/common/PeriodicEngines.hpp>
+
+class StatsEngine: public PeriodicEngine {
+	public:
+		virtual void action();
+	YADE_CLASS_BASE_DOC_ATTRS_CTOR(StatsEngine,PeriodicEngine,"Periodic engine computing several global quantities of the packing in one parallel pass over bodies and one over interactions (plus one more for the split fabric tensor), and caching the results as attributes. It gives the same values as :yref:`yade.utils.unbalancedForce`, :yref:`yade.utils.kineticEnergy`, :yref:`yade.utils.getStress`, :yref:`yade.utils.fabricTensor` and :yref:`yade.utils.getStressLWForEachBody`, so that python callbacks can read them instead of scanning the scene again:\n\n\t O.engines=O.engines+[StatsEngine(iterPeriod=100,computeFabric=True,label='stats')]\n\t ...\n\t if stats.unbalancedForce<0.01: ...\n\nOnly enabled quantities are computed; the others keep their last value.",
+		((bool,computeUnbalanced,true,,"Compute :yref:`unbalancedForce<StatsEngine.unbalancedForce>` and :yref:`maxUnbalancedForce<StatsEngine.maxUnbalancedForce>`."))
+		((bool,computeKinetic,true,,"Compute :yref:`kineticEnergy<StatsEngine.kineticEnergy>`."))
+		((bool,computeStress,true,,"Compute :yref:`stress<StatsEngine.stress>`."))
+		((bool,computeFabric,false,,"Compute :yref:`fabric<StatsEngine.fabric>` (and :yref:`fabricStrong<StatsEngine.fabricStrong>`, :yref:`fabricWeak<StatsEngine.fabricWeak>` if :yref:`splitFabric<StatsEngine.splitFabric>`)."))
+		((bool,computeBodyStress,false,,"Compute :yref:`bodyStresses<StatsEngine.bodyStresses>`."))
+		((Real,volume,0,,"Volume used for :yref:`stress<StatsEngine.stress>`; if 0, the periodic cell volume or the volume of the spheres' bounding box is used, like in :yref:`yade.utils.getStress`."))
+		((Real,fabricCutoff,0,,"Relative cutoff of the spheres' bounding box for the fabric tensor, see :yref:`yade.utils.fabricTensor`."))
+		((bool,splitFabric,false,,"Split the fabric tensor between strong and weak contacts, see :yref:`yade.utils.fabricTensor`."))
+		((Real,thresholdForce,NaN,,"Normal force separating strong and weak contacts; the mean normal force if NaN."))
+		((Real,unbalancedForce,NaN,Attr::readonly,"Mean resultant force on dynamic bodies divided by the mean contact force. |yupdate|"))
+		((Real,maxUnbalancedForce,NaN,Attr::readonly,"Maximum resultant force on dynamic bodies divided by the mean contact force. |yupdate|"))
+		((Real,kineticEnergy,NaN,Attr::readonly,"Kinetic energy of dynamic bodies (fluctuation only in periodic simulations). |yupdate|"))
+		((Matrix3r,stress,Matrix3r::Zero(),Attr::readonly,"Stress tensor from contact forces. |yupdate|"))
+		((Matrix3r,fabric,Matrix3r::Zero(),Attr::readonly,"Fabric tensor of all contacts. |yupdate|"))
+		((Matrix3r,fabricStrong,Matrix3r::Zero(),Attr::readonly,"Fabric tensor of strong contacts. |yupdate|"))
+		((Matrix3r,fabricWeak,Matrix3r::Zero(),Attr::readonly,"Fabric tensor of weak contacts. |yupdate|"))
+		((Real,meanNormalForce,NaN,Attr::readonly,"Mean normal force of contacts used for the fabric tensor (negative in compression). |yupdate|"))
+		((vector<Matrix3r>,bodyStresses,,(Attr::readonly|Attr::noSave),"Love-Weber stress of each body, indexed by id. |yupdate|"))
+		,/*ctor*/ initRun=true;
+	);
+	DECLARE_LOGGER;
+};
+REGISTER_SERIALIZABLE(StatsEngine);
@@ -0,0 +1,147 @@
+#include"TrajectoryRecorder.hpp"
+#include<core/Scene.hpp>
+#include<pkg/common/Sphere.hpp>
+#include<cstdint>
+
+YADE_PLUGIN((TrajectoryRecorder));
+CREATE_LOGGER(TrajectoryRecorder);
+
+namespace {
+	enum {SCALAR_RADIUS=0,SCALAR_MASS,SCALAR_KINETIC,SCALAR_FORCE,SCALAR_TORQUE,SCALAR_COORD};
+	template<typename T> void put(std::ofstream& out, const T& val){ out.write((const char*)&val,sizeof(T)); }
+	template<typename T> void putArray(std::ofstream& out, const vector<T>& vals){ if(!vals.empty()) out.write((const char*)&vals[0],vals.size()*sizeof(T)); }
+}
+
+void TrajectoryRecorder::openFile(){
+	if(file.empty()) throw std::invalid_argument("TrajectoryRecorder.file: must not be empty.");
+	bool empty=true;
+	if(!truncate){ std::ifstream probe(file.c_str(),std::ios::binary|std::ios::ate); empty=(!probe.is_open() || probe.tellg()<=0); }
+	out.open(file.c_str(),std::ios::binary|(truncate ? std::ios::trunc : std::ios::app));
+	if(!out.good()) throw std::runtime_error("TrajectoryRecorder: I/O error opening file `"+file+"'.");
+	// file header: magic and a probe of the byte order, once per file (appended frames follow the previous ones)
+	if(empty){ out.write("YADETRJ1",8); put<uint32_t>(out,0x01020304); }
+}
+
+void TrajectoryRecorder::action(){
+	if(!out.is_open()) openFile();
+	vector<int> codes;
+	FOREACH(const string& s, scalars){
+		if(s=="radius") codes.push_back(SCALAR_RADIUS);
+		else if(s=="mass") codes.push_back(SCALAR_MASS);
+		else if(s=="kineticEnergy") codes.push_back(SCALAR_KINETIC);
+		else if(s=="forceNorm") codes.push_back(SCALAR_FORCE);
+		else if(s=="torqueNorm") codes.push_back(SCALAR_TORQUE);
+		else if(s=="coordNumber") codes.push_back(SCALAR_COORD);
+		else throw std::invalid_argument("TrajectoryRecorder.scalars: unknown scalar `"+s+"' (supported are: radius, mass, kineticEnergy, forceNorm, torqueNorm, coordNumber).");
+	}
+	if(std::find(codes.begin(),codes.end(),SCALAR_FORCE)!=codes.end() || std::find(codes.begin(),codes.end(),SCALAR_TORQUE)!=codes.end()) scene->forces.sync();
+
+	vector<Body::id_t> ids;
+	FOREACH(const shared_ptr<Body>& b, *scene->bodies){
+		if(!b) continue;
+		if(mask!=0 && !b->maskCompatible(mask)) continue;
+		if(skipNondynamic && !b->isDynamic()) continue;
+		ids.push_back(b->id);
+	}
+	// values are stored field by field: pos (n×3), ori (n×4, w first), vel (n×3), angVel (n×3)
+	const long n=ids.size(), nSc=codes.size();
+	const long oriOff=3*n, velOff=oriOff+(recordOri?4*n:0), angVelOff=velOff+(recordVel?3*n:0);
+	vector<Real> values(angVelOff+(recordAngVel?3*n:0));
+	vector<float> scalarValues(nSc*n);
+	#ifdef YADE_OPENMP
+	#pragma omp parallel for schedule(static)
+	#endif
+	for(long i=0; i<n; i++){
+		const shared_ptr<Body>& b=Body::byId(ids[i],scene);
+		const State& st=*b->state;
+		for(int k=0; k<3; k++) values[3*i+k]=st.pos[k];
+		if(recordOri){ values[oriOff+4*i]=st.ori.w(); values[oriOff+4*i+1]=st.ori.x(); values[oriOff+4*i+2]=st.ori.y(); values[oriOff+4*i+3]=st.ori.z(); }
+		if(recordVel) for(int k=0; k<3; k++) values[velOff+3*i+k]=st.vel[k];
+		if(recordAngVel) for(int k=0; k<3; k++) values[angVelOff+3*i+k]=st.angVel[k];
+		for(long s=0; s<nSc; s++){
+			Real v=0;
+			switch(codes[s]){
+				case SCALAR_RADIUS: { const Sphere* sphere=dynamic_cast<Sphere*>(b->shape.get()); v=(sphere ? sphere->radius : std::numeric_limits<Real>::quiet_NaN()); break; }
+				case SCALAR_MASS: v=st.mass; break;
+				case SCALAR_KINETIC: { Vector3r angVelLocal=st.ori.conjugate()*st.angVel; v=.5*st.mass*st.vel.squaredNorm()+.5*angVelLocal.dot(st.inertia.asDiagonal()*angVelLocal); break; }
+				case SCALAR_FORCE: v=scene->forces.getForce(b->id).norm(); break;
+				case SCALAR_TORQUE: v=scene->forces.getTorque(b->id).norm(); break;
+				case SCALAR_COORD: v=b->coordNumber(); break;
+			}
+			scalarValues[s*n+i]=v;
+		}
+	}
+	writeFrame(ids,values,scalarValues);
+}
+
+void TrajectoryRecorder::writeFrame(const vector<Body::id_t>& ids, vector<Real>& values, const vector<float>& scalarValues){
+	const long n=ids.size(), size=values.size();
+	const long oriOff=3*n, velOff=oriOff+(recordOri?4*n:0);
+	bool key=(framesSinceKey<0 || framesSinceKey+1>=keyframeInterval || ids!=keyIds || size!=(long)keyValues.size());
+	vector<int32_t> quantized;
+	long maxAbs=0;
+	if(!key){
+		// q and -q are the same rotation, take the one closer to the keyframe
+		if(recordOri){
+			#ifdef YADE_OPENMP
+			#pragma omp parallel for schedule(static)
+			#endif
+			for(long i=0; i<n; i++){
+				Real* q=&values[oriOff+4*i]; const Real* qKey=&keyValues[oriOff+4*i];
+				if(q[0]*qKey[0]+q[1]*qKey[1]+q[2]*qKey[2]+q[3]*qKey[3]<0) for(int k=0; k<4; k++) q[k]=-q[k];
+			}
+		}
+		quantized.resize(size);
+		bool overflow=false;
+		#ifdef YADE_OPENMP
+		#pragma omp parallel for schedule(static) reduction(||:overflow) reduction(max:maxAbs)
+		#endif
+		for(long j=0; j<size; j++){
+			const Real prec=(j<oriOff ? posPrecision : (j<velOff ? oriPrecision : velPrecision));
+			const Real d=(values[j]-keyValues[j])/prec;
+			if(!(std::abs(d)<2147483647.)){ overflow=true; continue; } // also catches NaN
+			quantized[j]=(int32_t)std::lround(d);
+			maxAbs=std::max(maxAbs,(long)std::abs(quantized[j]));
+		}
+		if(overflow) key=true;
+	}
+	const uint8_t intBytes=(key ? 0 : (maxAbs<=32767 ? 2 : 4));
+	const long nSc=scalars.size();
+
+	// payload size, so that readers can skip the frame
+	uint64_t payload=nSc*n*sizeof(float);
+	if(key){
+		FOREACH(const string& s, scalars) payload+=1+std::min(s.size(),(size_t)255);
+		payload+=n*sizeof(int32_t)+size*sizeof(double);
+	} else payload+=size*intBytes;
+
+	// fixed-size frame header (64 bytes)
+	out.write("FRAM",4);
+	put<uint8_t>(out,key ? 0 : 1);
+	put<uint8_t>(out,(recordOri?1:0)|(recordVel?2:0)|(recordAngVel?4:0));
+	put<uint8_t>(out,intBytes);
+	put<uint8_t>(out,nSc);
+	put<int64_t>(out,scene->iter);
+	put<double>(out,scene->time);
+	put<uint32_t>(out,n);
+	put<uint32_t>(out,0);
+	put<double>(out,posPrecision); put<double>(out,oriPrecision); put<double>(out,velPrecision);
+	put<uint64_t>(out,payload);
+
+	if(key){
+		FOREACH(const string& s, scalars){ const uint8_t len=std::min(s.size(),(size_t)255); put<uint8_t>(out,len); out.write(s.data(),len); }
+		vector<int32_t> ids32(ids.begin(),ids.end());
+		putArray(out,ids32);
+		vector<double> vals(values.begin(),values.end());
+		putArray(out,vals);
+		keyIds=ids; keyValues=values; framesSinceKey=0; nKeyframes++;
+	} else {
+		if(intBytes==2){ vector<int16_t> q16(quantized.begin(),quantized.end()); putArray(out,q16); }
+		else putArray(out,quantized);
+		framesSinceKey++;
+	}
+	putArray(out,scalarValues);
+	out.flush();
+	if(!out.good()) throw std::runtime_error("TrajectoryRecorder: I/O error writing file `"+file+"'.");
+	nFrames++;
+}
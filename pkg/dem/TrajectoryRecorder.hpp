@@ -0,0 +1,43 @@
+#pragma once
+#include<pkg/common/PeriodicEngines.hpp>
+#include<fstream>
+
+/*! Record positions, orientations and velocities of bodies in a compact binary file.
+
+Frames are grouped behind keyframes storing exact values; the frames in between store the difference to their keyframe,
+quantized with a given precision and packed as 16 or 32 bits integers (similar to the XTC format of molecular dynamics).
+Every frame starts with a fixed-size header giving the size of its payload, so that a reader can index the file without
+reading the data. The format is documented in :yref:`yade.trajectory`, which also provides the reader.
+*/
+class TrajectoryRecorder: public PeriodicEngine {
+	private:
+		std::ofstream out;
+		// ids and exact values (pos, ori, vel, angVel concatenated) of the last keyframe
+		vector<Body::id_t> keyIds;
+		vector<Real> keyValues;
+		int framesSinceKey;
+		void openFile();
+		void writeFrame(const vector<Body::id_t>& ids, vector<Real>& values, const vector<float>& scalarValues);
+	public:
+		virtual void action();
+	YADE_CLASS_BASE_DOC_ATTRS_CTOR(TrajectoryRecorder,PeriodicEngine,"Periodically save the dynamic state of bodies (position, orientation, velocities and optional scalars) in a compact binary file, to be read with :yref:`yade.trajectory.TrajectoryReader`. Frames are stored as quantized differences to the last keyframe (see :yref:`keyframeInterval<TrajectoryRecorder.keyframeInterval>` and precision attributes); a new keyframe is also written whenever the set of recorded bodies changes or when a difference would not fit in 32 bits.\n\n:yref:`PeriodicEngine.initRun` is initialized to ``True`` automatically.",
+		((string,file,"",,"Name of the output file; must not be empty."))
+		((bool,truncate,false,,"Whether to delete current file contents, if any, when opening; otherwise frames are appended."))
+		((int,mask,0,,"If non-zero, only bodies with compatible :yref:`groupMask<Body.groupMask>` are recorded."))
+		((bool,skipNondynamic,false,,"Do not record bodies which are not :yref:`dynamic<Body.dynamic>`."))
+		((bool,recordOri,true,,"Record orientations (quaternions)."))
+		((bool,recordVel,true,,"Record linear velocities."))
+		((bool,recordAngVel,false,,"Record angular velocities."))
+		((vector<string>,scalars,,,"Additional per-body scalars, stored as 32 bits floats in every frame. Supported: ``radius`` (NaN for non-spherical bodies), ``mass``, ``kineticEnergy``, ``forceNorm``, ``torqueNorm``, ``coordNumber``."))
+		((int,keyframeInterval,10,,"A keyframe is written every *keyframeInterval* frames; other frames are stored as quantized differences to the keyframe."))
+		((Real,posPrecision,1e-6,,"Absolute precision of positions in non-key frames."))
+		((Real,oriPrecision,1e-5,,"Absolute precision of quaternion components in non-key frames."))
+		((Real,velPrecision,1e-6,,"Absolute precision of linear and angular velocities in non-key frames."))
+		((long,nFrames,0,Attr::readonly,"Number of frames written by this engine."))
+		((long,nKeyframes,0,Attr::readonly,"Number of keyframes written by this engine."))
+		,
+		/*ctor*/ initRun=true; framesSinceKey=-1;
+	);
+	DECLARE_LOGGER;
+};
+REGISTER_SERIALIZABLE(TrajectoryRecorder);
@@ -12,6 +12,9 @@
 #include<vtkPolyData.h>
 #include<vtkXMLUnstructuredGridWriter.h>
 #include<vtkXMLPolyDataWriter.h>
+#include<vtkXMLWriter.h>
+#include<vtkDataSet.h>
+#include<vtkIdList.h>
 #include<vtkZLibDataCompressor.h>
 #include<vtkTriangle.h>
 #include<vtkLine.h>
@@ -46,8 +49,15 @@ CREATE_LOGGER(VTKRecorder);
 #include <boost/unordered_map.hpp>
 #include <boost/fusion/support/pair.hpp>
 #include <boost/fusion/include/pair.hpp>
+#include <boost/bind.hpp>
+#include <iomanip>
+
+// run a writer from the job list; bind cannot call members through vtkSmartPointer
+static void writeVtk(vtkSmartPointer<vtkXMLWriter> writer){ writer->Write(); }
 
 void VTKRecorder::action(){
+	// the previous snapshot must be on disk before the next one is queued
+	waitForWriter();
 	vector<bool> recActive(REC_SENTINEL,false);
 	FOREACH(string& rec, recorders){
 		if(rec=="all"){
@@ -553,144 +563,166 @@ void VTKRecorder::action(){
 	  Shop::getStressLWForEachBody(bStresses);
 	}
 	
-	FOREACH(const shared_ptr<Body>& b, *scene->bodies){
-		if (!b) continue;
-		if(mask!=0 && !b->maskCompatible(mask)) continue;
-		if (recActive[REC_SPHERES]){
-			const Sphere* sphere = dynamic_cast<Sphere*>(b->shape.get()); 
-			if (sphere){
-				if(skipNondynamic && b->state->blockedDOFs==State::DOF_ALL) continue;
-				vtkIdType pid[1];
-				Vector3r pos(scene->isPeriodic ? scene->cell->wrapShearedPt(b->state->pos) : b->state->pos);
-				pid[0] = spheresPos->InsertNextPoint(pos[0], pos[1], pos[2]);
-				spheresCells->InsertNextCell(1,pid);
-				radii->InsertNextValue(sphere->radius);
-				
-				if (recActive[REC_BSTRESS]) {
-				  const Matrix3r& bStress = bStresses[b->getId()];
-				  Eigen::SelfAdjointEigenSolver<Matrix3r> solver(bStress); // bStress is probably not symmetric (= self-adjoint for real matrices), but the solver hopefully works (considering only one half of bStress). And, moreover, existence of (real) eigenvalues is not sure for not symmetric bStress..
-				  Matrix3r dirAll = solver.eigenvectors();
-				  Vector3r eigenVal = solver.eigenvalues(); // cf http://eigen.tuxfamily.org/dox/classEigen_1_1SelfAdjointEigenSolver.html#a30caf3c3884a7f4a46b8ec94efd23c5e to be sure that eigenVal[i] * dirAll.col(i) = bStress * dirAll.col(i)
-				  int whereSigI(-1), whereSigII(-1), whereSigIII(-1); // all whereSig_i are in [0;2] : whereSigI = 2 => sigI=eigenVal[2]
-				  if ( eigenVal[0] > std::max(eigenVal[1],eigenVal[2]) ) {
-				    whereSigI = 0;
-				    if (eigenVal[1]>eigenVal[2]) {
-				      whereSigII=1;
-				      whereSigIII=2; }
-				    else { //eigenVal[0] > eigenVal[2] >= eigenVal[1]
-				      whereSigII = 2;
-				      whereSigIII=1; } }
-				  else { // max(lambda1,lambda2) >= lambda0 // lambda = eigenVal in the comments
-				    if (eigenVal[1]>=eigenVal[2]) {//max(lambda1,lambda2) = lambda1 : lambda 1 >= lambda2
-				      whereSigI = 1;
-				      if (eigenVal[2]>=eigenVal[0]) {//lambda1 >= lambda2 >= lambda0
-					whereSigII=2;
-					whereSigIII=0; }
-				      else { //lambda1 >= lambda0 > lambda2
-					whereSigII=0;
-					whereSigIII=2; } }
-				    else { //max(lambda1,lambda2) = lambda2 : lambda2 > lambda1
-				      whereSigI = 2;
-				      if (eigenVal[1] > eigenVal[0]) {
-					whereSigII = 1;
-					whereSigIII = 0; }
-				      else {
-					whereSigIII = 1;
-					whereSigII = 0; } } }
-					
-				  spheresSigI->InsertNextValue(eigenVal[whereSigI]);
-				  spheresSigII->InsertNextValue(eigenVal[whereSigII]);
-				  spheresSigIII->InsertNextValue(eigenVal[whereSigIII]);
-				  Real dirI[3] { (Real) dirAll(0,whereSigI), (Real) dirAll(1,whereSigI), (Real) dirAll(2,whereSigI) };
-				  spheresDirI->InsertNextTupleValue(dirI);
-				  
-				  Real dirII[3] { (Real) dirAll(0,whereSigII), (Real) dirAll(1,whereSigII), (Real) dirAll(2,whereSigII) };
-				  spheresDirII->InsertNextTupleValue(dirII);
-				  
-				  Real dirIII[3] { (Real) dirAll(0,whereSigIII), (Real) dirAll(1,whereSigIII), (Real) dirAll(2,whereSigIII) };
-				  spheresDirIII->InsertNextTupleValue(dirIII); }
-				
-				if (recActive[REC_ID]) spheresId->InsertNextValue(b->getId()); 
-				if (recActive[REC_MASK]) spheresMask->InsertNextValue(GET_MASK(b));
-				if (recActive[REC_MASS]) spheresMass->InsertNextValue(b->state->mass);
-				if (recActive[REC_CLUMPID]) clumpId->InsertNextValue(b->clumpId);
-				if (recActive[REC_COLORS]){
-					const Vector3r& color = sphere->color;
-					Real c[3] = { (Real) color[0], (Real) color[1], (Real) color[2]};
-					spheresColors->InsertNextTupleValue(c);
-				}
-				if(recActive[REC_VELOCITY]){
-					const Vector3r& vel = b->state->vel;
-					Real v[3] = { (Real) vel[0], (Real) vel[1], (Real) vel[2] };
-					spheresLinVelVec->InsertNextTupleValue(v);
-					spheresLinVelLen->InsertNextValue(vel.norm());
-					
-					const Vector3r& angVel = b->state->angVel;
-					Real av[3] = { (Real) angVel[0], (Real) angVel[1], (Real) angVel[2] };
-					spheresAngVelVec->InsertNextTupleValue(av);
-					spheresAngVelLen->InsertNextValue(angVel.norm());
-				}
-				if(recActive[REC_STRESS]){
-					const Vector3r& stress = bodyStates[b->getId()].normStress;
-					const Vector3r& shear = bodyStates[b->getId()].shearStress;
-					Real n[3] = { (Real)  stress[0], (Real) stress[1], (Real) stress[2] };
-					Real s[3] = { (Real)  shear [0], (Real) shear [1], (Real) shear [2] };
-					spheresNormalStressVec->InsertNextTupleValue(n);
-					spheresShearStressVec->InsertNextTupleValue(s);
-					spheresNormalStressNorm->InsertNextValue(stress.norm());
-				}
-				if(recActive[REC_FORCE]){
-					scene->forces.sync();
-					const Vector3r& f = scene->forces.getForce(b->getId());
-					const Vector3r& t = scene->forces.getTorque(b->getId());
-					Real ff[3] = { (Real)  f[0], (Real) f[1], (Real) f[2] };
-					Real tt[3] = { (Real)  t[0], (Real) t[1], (Real) t[2] };
-					Real fn = f.norm();
-					Real tn = t.norm();
-					spheresForceVec->InsertNextTupleValue(ff);
-					spheresForceLen->InsertNextValue(fn);
-					spheresTorqueVec->InsertNextTupleValue(tt);
-					spheresTorqueLen->InsertNextValue(tn);
-				}
-				
-				if (recActive[REC_CPM]){
-					cpmDamage->InsertNextValue(YADE_PTR_CAST<CpmState>(b->state)->normDmg);
-					const Matrix3r& ss=YADE_PTR_CAST<CpmState>(b->state)->stress;
-					//Real s[3]={ss[0],ss[1],ss[2]};
-					Real s[9]={ (Real) ss(0,0), (Real) ss(0,1), (Real) ss(0,2), (Real) ss(1,0), (Real) ss(1,1), (Real) ss(1,2), (Real) ss(2,0), (Real) ss(2,1), (Real) ss(2,2)};
-					cpmStress->InsertNextTupleValue(s);
-				}
-				
-				if (recActive[REC_JCFPM]){
-					nbCracks->InsertNextValue(YADE_PTR_CAST<JCFpmState>(b->state)->nbBrokenBonds);
-					jcfpmDamage->InsertNextValue(YADE_PTR_CAST<JCFpmState>(b->state)->damageIndex);
-				}
-				if (recActive[REC_COORDNUMBER]){
-					spheresCoordNumb->InsertNextValue(b->coordNumber());
-				}
+	/* Spheres are written in two passes: the bodies to export are collected serially first, then all arrays are sized
+	   at once and filled in parallel, each thread writing its own slots. Everything called in the parallel loop is read-only
+	   (forces are synced beforehand). */
+	vector<shared_ptr<Body> > sphereBodies;
+	if (recActive[REC_SPHERES]){
+		FOREACH(const shared_ptr<Body>& b, *scene->bodies){
+			if (!b) continue;
+			if(mask!=0 && !b->maskCompatible(mask)) continue;
+			if(!dynamic_cast<Sphere*>(b->shape.get())) continue;
+			if(skipNondynamic && b->state->blockedDOFs==State::DOF_ALL) continue;
+			sphereBodies.push_back(b);
+		}
+	}
+	const long nSpheres=sphereBodies.size();
+	if (nSpheres>0){
+		if(recActive[REC_FORCE]) scene->forces.sync();
+		spheresPos->SetNumberOfPoints(nSpheres);
+		for(vtkIdType i=0; i<nSpheres; i++) spheresCells->InsertNextCell(1,&i);
+		// size the array (if active) and return its raw storage
+		auto alloc=[nSpheres](vtkDoubleArray* a, bool active)->double* { if(!active) return NULL; a->SetNumberOfTuples(nSpheres); return a->GetPointer(0); };
+		double* rad=alloc(radii,true);
+		double *sigI=alloc(spheresSigI,recActive[REC_BSTRESS]), *sigII=alloc(spheresSigII,recActive[REC_BSTRESS]), *sigIII=alloc(spheresSigIII,recActive[REC_BSTRESS]);
+		double *dirI=alloc(spheresDirI,recActive[REC_BSTRESS]), *dirII=alloc(spheresDirII,recActive[REC_BSTRESS]), *dirIII=alloc(spheresDirIII,recActive[REC_BSTRESS]);
+		double* ids=alloc(spheresId,recActive[REC_ID]);
+		double* masks=alloc(spheresMask,recActive[REC_MASK]);
+		double* masses=alloc(spheresMass,recActive[REC_MASS]);
+		double* clumpIds=alloc(clumpId,recActive[REC_CLUMPID]);
+		double* colors=alloc(spheresColors,recActive[REC_COLORS]);
+		double *linVelVec=alloc(spheresLinVelVec,recActive[REC_VELOCITY]), *linVelLen=alloc(spheresLinVelLen,recActive[REC_VELOCITY]);
+		double *angVelVec=alloc(spheresAngVelVec,recActive[REC_VELOCITY]), *angVelLen=alloc(spheresAngVelLen,recActive[REC_VELOCITY]);
+		double *normStressVec=alloc(spheresNormalStressVec,recActive[REC_STRESS]), *shearStressVec=alloc(spheresShearStressVec,recActive[REC_STRESS]), *normStressNorm=alloc(spheresNormalStressNorm,recActive[REC_STRESS]);
+		double *forceVec=alloc(spheresForceVec,recActive[REC_FORCE]), *forceLen=alloc(spheresForceLen,recActive[REC_FORCE]);
+		double *torqueVec=alloc(spheresTorqueVec,recActive[REC_FORCE]), *torqueLen=alloc(spheresTorqueLen,recActive[REC_FORCE]);
+		double *cpmDmg=alloc(cpmDamage,recActive[REC_CPM]), *cpmStr=alloc(cpmStress,recActive[REC_CPM]);
+		double *jcfCracks=alloc(nbCracks,recActive[REC_JCFPM]), *jcfDmg=alloc(jcfpmDamage,recActive[REC_JCFPM]);
+		double* coordNumb=alloc(spheresCoordNumb,recActive[REC_COORDNUMBER]);
+		double* materialIds=alloc(spheresMaterialId,recActive[REC_MATERIALID]);
+#ifdef YADE_SPH
+		double *rhoSPH=alloc(spheresRhoSPH,true), *pressSPH=alloc(spheresPressSPH,true), *coordNumbSPH=alloc(spheresCoordNumbSPH,true);
+#endif
+#ifdef YADE_DEFORM
+		double* realRad=alloc(spheresRealRad,true);
+#endif
+#ifdef YADE_LIQMIGRATION
+		double *liqVolB=alloc(spheresLiqVol,recActive[REC_LIQ]), *liqVolIterB=alloc(spheresLiqVolIter,recActive[REC_LIQ]), *liqVolTotalB=alloc(spheresLiqVolTotal,recActive[REC_LIQ]);
+#endif
+		auto set3=[](double* arr, long i, const Vector3r& v){ arr[3*i]=v[0]; arr[3*i+1]=v[1]; arr[3*i+2]=v[2]; };
+		#ifdef YADE_OPENMP
+		#pragma omp parallel for schedule(static)
+		#endif
+		for(long i=0; i<nSpheres; i++){
+			const shared_ptr<Body>& b=sphereBodies[i];
+			const Sphere* sphere=static_cast<Sphere*>(b->shape.get());
+			Vector3r pos(scene->isPeriodic ? scene->cell->wrapShearedPt(b->state->pos) : b->state->pos);
+			spheresPos->SetPoint(i, pos[0], pos[1], pos[2]);
+			rad[i]=sphere->radius;
+
+			if (recActive[REC_BSTRESS]) {
+			  const Matrix3r& bStress = bStresses[b->getId()];
+			  Eigen::SelfAdjointEigenSolver<Matrix3r> solver(bStress); // bStress is probably not symmetric (= self-adjoint for real matrices), but the solver hopefully works (considering only one half of bStress). And, moreover, existence of (real) eigenvalues is not sure for not symmetric bStress..
+			  Matrix3r dirAll = solver.eigenvectors();
+			  Vector3r eigenVal = solver.eigenvalues(); // cf http://eigen.tuxfamily.org/dox/classEigen_1_1SelfAdjointEigenSolver.html#a30caf3c3884a7f4a46b8ec94efd23c5e to be sure that eigenVal[i] * dirAll.col(i) = bStress * dirAll.col(i)
+			  int whereSigI(-1), whereSigII(-1), whereSigIII(-1); // all whereSig_i are in [0;2] : whereSigI = 2 => sigI=eigenVal[2]
+			  if ( eigenVal[0] > std::max(eigenVal[1],eigenVal[2]) ) {
+			    whereSigI = 0;
+			    if (eigenVal[1]>eigenVal[2]) {
+			      whereSigII=1;
+			      whereSigIII=2; }
+			    else { //eigenVal[0] > eigenVal[2] >= eigenVal[1]
+			      whereSigII = 2;
+			      whereSigIII=1; } }
+			  else { // max(lambda1,lambda2) >= lambda0 // lambda = eigenVal in the comments
+			    if (eigenVal[1]>=eigenVal[2]) {//max(lambda1,lambda2) = lambda1 : lambda 1 >= lambda2
+			      whereSigI = 1;
+			      if (eigenVal[2]>=eigenVal[0]) {//lambda1 >= lambda2 >= lambda0
+				whereSigII=2;
+				whereSigIII=0; }
+			      else { //lambda1 >= lambda0 > lambda2
+				whereSigII=0;
+				whereSigIII=2; } }
+			    else { //max(lambda1,lambda2) = lambda2 : lambda2 > lambda1
+			      whereSigI = 2;
+			      if (eigenVal[1] > eigenVal[0]) {
+				whereSigII = 1;
+				whereSigIII = 0; }
+			      else {
+				whereSigIII = 1;
+				whereSigII = 0; } } }
+			  sigI[i]=eigenVal[whereSigI];
+			  sigII[i]=eigenVal[whereSigII];
+			  sigIII[i]=eigenVal[whereSigIII];
+			  set3(dirI,i,dirAll.col(whereSigI));
+			  set3(dirII,i,dirAll.col(whereSigII));
+			  set3(dirIII,i,dirAll.col(whereSigIII)); }
+
+			if (recActive[REC_ID]) ids[i]=b->getId();
+			if (recActive[REC_MASK]) masks[i]=GET_MASK(b);
+			if (recActive[REC_MASS]) masses[i]=b->state->mass;
+			if (recActive[REC_CLUMPID]) clumpIds[i]=b->clumpId;
+			if (recActive[REC_COLORS]) set3(colors,i,sphere->color);
+			if(recActive[REC_VELOCITY]){
+				set3(linVelVec,i,b->state->vel);
+				linVelLen[i]=b->state->vel.norm();
+				set3(angVelVec,i,b->state->angVel);
+				angVelLen[i]=b->state->angVel.norm();
+			}
+			if(recActive[REC_STRESS]){
+				const Vector3r& stress = bodyStates[b->getId()].normStress;
+				const Vector3r& shear = bodyStates[b->getId()].shearStress;
+				set3(normStressVec,i,stress);
+				set3(shearStressVec,i,shear);
+				normStressNorm[i]=stress.norm();
+			}
+			if(recActive[REC_FORCE]){
+				const Vector3r& f = scene->forces.getForce(b->getId());
+				const Vector3r& t = scene->forces.getTorque(b->getId());
+				set3(forceVec,i,f);
+				forceLen[i]=f.norm();
+				set3(torqueVec,i,t);
+				torqueLen[i]=t.norm();
+			}
+
+			if (recActive[REC_CPM]){
+				cpmDmg[i]=YADE_PTR_CAST<CpmState>(b->state)->normDmg;
+				const Matrix3r& ss=YADE_PTR_CAST<CpmState>(b->state)->stress;
+				for(int k=0; k<9; k++) cpmStr[9*i+k]=ss(k/3,k%3);
+			}
+
+			if (recActive[REC_JCFPM]){
+				jcfCracks[i]=YADE_PTR_CAST<JCFpmState>(b->state)->nbBrokenBonds;
+				jcfDmg[i]=YADE_PTR_CAST<JCFpmState>(b->state)->damageIndex;
+			}
+			if (recActive[REC_COORDNUMBER]) coordNumb[i]=b->coordNumber();
 #ifdef YADE_SPH
-				spheresRhoSPH->InsertNextValue(b->state->rho); 
-				spheresPressSPH->InsertNextValue(b->state->press); 
-				spheresCoordNumbSPH->InsertNextValue(b->coordNumber()); 
+			rhoSPH[i]=b->state->rho;
+			pressSPH[i]=b->state->press;
+			coordNumbSPH[i]=b->coordNumber();
 #endif
 
 #ifdef YADE_DEFORM
-				const Sphere* sphere = dynamic_cast<Sphere*>(b->shape.get());
-				spheresRealRad->InsertNextValue(b->state->dR + sphere->radius);
+			realRad[i]=b->state->dR + sphere->radius;
 #endif
 
 #ifdef YADE_LIQMIGRATION
-				if (recActive[REC_LIQ]) {
-					spheresLiqVol->InsertNextValue(b->state->Vf);
-					const Real tmpVolIter = liqVolIterBody(b);
-					spheresLiqVolIter->InsertNextValue(tmpVolIter);
-					spheresLiqVolTotal->InsertNextValue(tmpVolIter + b->state->Vf);
-				}
-#endif
-				if (recActive[REC_MATERIALID]) spheresMaterialId->InsertNextValue(b->material->id);
-				continue;
+			if (recActive[REC_LIQ]) {
+				liqVolB[i]=b->state->Vf;
+				const Real tmpVolIter = liqVolIterBody(b);
+				liqVolIterB[i]=tmpVolIter;
+				liqVolTotalB[i]=tmpVolIter + b->state->Vf;
 			}
+#endif
+			if (recActive[REC_MATERIALID]) materialIds[i]=b->material->id;
 		}
+	}
+
+	FOREACH(const shared_ptr<Body>& b, *scene->bodies){
+		if (!b) continue;
+		if(mask!=0 && !b->maskCompatible(mask)) continue;
+		// spheres were handled above
+		if (recActive[REC_SPHERES] && dynamic_cast<Sphere*>(b->shape.get())) continue;
 		if (recActive[REC_FACETS]){
 			const Facet* facet = dynamic_cast<Facet*>(b->shape.get()); 
 			if (facet){
@@ -845,6 +877,11 @@ void VTKRecorder::action(){
 	
 	vtkSmartPointer<vtkDataCompressor> compressor;
 	if(compress) compressor=vtkSmartPointer<vtkZLibDataCompressor>::New();
+	bool oneFilePerBlock=!xdmf;
+	#ifdef YADE_VTK_MULTIBLOCK
+		if(multiblock) oneFilePerBlock=false;
+	#endif
+	vector<XdmfBlock> xdmfBlocks;
 
 	vtkSmartPointer<vtkUnstructuredGrid> spheresUg = vtkSmartPointer<vtkUnstructuredGrid>::New();
 	if (recActive[REC_SPHERES]){
@@ -911,9 +948,8 @@ void VTKRecorder::action(){
 		if (recActive[REC_MATERIALID]) spheresUg->GetPointData()->AddArray(spheresMaterialId);
 		if (recActive[REC_COORDNUMBER]) spheresUg->GetCellData()->AddArray(spheresCoordNumb);
 
-		#ifdef YADE_VTK_MULTIBLOCK
-		if(!multiblock)
-		#endif
+		if(xdmf) xdmfBlocks.push_back(XdmfBlock("spheres",spheresUg));
+		if(oneFilePerBlock)
 			{
 			vtkSmartPointer<vtkXMLUnstructuredGridWriter> writer = vtkSmartPointer<vtkXMLUnstructuredGridWriter>::New();
 			if(compress) writer->SetCompressor(compressor);
@@ -925,7 +961,7 @@ void VTKRecorder::action(){
 			#else
 				writer->SetInput(spheresUg);
 			#endif
-			writer->Write();
+			writeJobs.push_back(boost::bind(writeVtk,vtkSmartPointer<vtkXMLWriter>(writer)));
 		}
 	}
 	vtkSmartPointer<vtkUnstructuredGrid> facetsUg = vtkSmartPointer<vtkUnstructuredGrid>::New();
@@ -946,9 +982,8 @@ void VTKRecorder::action(){
 		if (recActive[REC_MATERIALID]) facetsUg->GetCellData()->AddArray(facetsMaterialId);
 		if (recActive[REC_MASK]) facetsUg->GetCellData()->AddArray(facetsMask);
 		if (recActive[REC_COORDNUMBER]) facetsUg->GetCellData()->AddArray(facetsCoordNumb);
-		#ifdef YADE_VTK_MULTIBLOCK
-			if(!multiblock)
-		#endif
+		if(xdmf) xdmfBlocks.push_back(XdmfBlock("facets",facetsUg));
+		if(oneFilePerBlock)
 			{
 			vtkSmartPointer<vtkXMLUnstructuredGridWriter> writer = vtkSmartPointer<vtkXMLUnstructuredGridWriter>::New();
 			if(compress) writer->SetCompressor(compressor);
@@ -960,7 +995,7 @@ void VTKRecorder::action(){
 			#else
 				writer->SetInput(facetsUg);
 			#endif
-			writer->Write();
+			writeJobs.push_back(boost::bind(writeVtk,vtkSmartPointer<vtkXMLWriter>(writer)));
 		}
 	}
 	vtkSmartPointer<vtkUnstructuredGrid> boxesUg = vtkSmartPointer<vtkUnstructuredGrid>::New();
@@ -980,9 +1015,8 @@ void VTKRecorder::action(){
 		}
 		if (recActive[REC_MATERIALID]) boxesUg->GetCellData()->AddArray(boxesMaterialId);
 		if (recActive[REC_MASK]) boxesUg->GetCellData()->AddArray(boxesMask);
-		#ifdef YADE_VTK_MULTIBLOCK
-			if(!multiblock)
-		#endif
+		if(xdmf) xdmfBlocks.push_back(XdmfBlock("boxes",boxesUg));
+		if(oneFilePerBlock)
 			{
 			vtkSmartPointer<vtkXMLUnstructuredGridWriter> writer = vtkSmartPointer<vtkXMLUnstructuredGridWriter>::New();
 			if(compress) writer->SetCompressor(compressor);
@@ -994,7 +1028,7 @@ void VTKRecorder::action(){
 			#else
 				writer->SetInput(boxesUg);
 			#endif
-			writer->Write();	
+			writeJobs.push_back(boost::bind(writeVtk,vtkSmartPointer<vtkXMLWriter>(writer)));	
 		}
 	}
 	vtkSmartPointer<vtkPolyData> intrPd = vtkSmartPointer<vtkPolyData>::New();
@@ -1018,9 +1052,8 @@ void VTKRecorder::action(){
 			intrPd->GetCellData()->AddArray(wpmNormalForce);
 			intrPd->GetCellData()->AddArray(wpmLimitFactor);
 		}
-		#ifdef YADE_VTK_MULTIBLOCK
-			if(!multiblock)
-		#endif
+		if(xdmf) xdmfBlocks.push_back(XdmfBlock("intrs",intrPd));
+		if(oneFilePerBlock)
 			{
 			vtkSmartPointer<vtkXMLPolyDataWriter> writer = vtkSmartPointer<vtkXMLPolyDataWriter>::New();
 			if(compress) writer->SetCompressor(compressor);
@@ -1032,16 +1065,15 @@ void VTKRecorder::action(){
 			#else
 				writer->SetInput(intrPd);
 			#endif
-			writer->Write();
+			writeJobs.push_back(boost::bind(writeVtk,vtkSmartPointer<vtkXMLWriter>(writer)));
 		}
 	}
 	vtkSmartPointer<vtkUnstructuredGrid> pericellUg = vtkSmartPointer<vtkUnstructuredGrid>::New();
 	if (recActive[REC_PERICELL]){
 		pericellUg->SetPoints(pericellPoints);
 		pericellUg->SetCells(12,pericellHexa);
-		#ifdef YADE_VTK_MULTIBLOCK
-			if(!multiblock)
-		#endif
+		if(xdmf) xdmfBlocks.push_back(XdmfBlock("pericell",pericellUg));
+		if(oneFilePerBlock)
 			{
 			vtkSmartPointer<vtkXMLUnstructuredGridWriter> writer = vtkSmartPointer<vtkXMLUnstructuredGridWriter>::New();
 			if(compress) writer->SetCompressor(compressor);
@@ -1053,7 +1085,7 @@ void VTKRecorder::action(){
 			#else
 				writer->SetInput(pericellUg);
 			#endif
-			writer->Write();
+			writeJobs.push_back(boost::bind(writeVtk,vtkSmartPointer<vtkXMLWriter>(writer)));
 		}
 	}
 
@@ -1094,17 +1126,21 @@ void VTKRecorder::action(){
                 crackUg->GetPointData()->AddArray(crackNrg);
                 crackUg->GetPointData()->AddArray(crackOnJnt);
 
-		vtkSmartPointer<vtkXMLUnstructuredGridWriter> writer = vtkSmartPointer<vtkXMLUnstructuredGridWriter>::New();
-		if(compress) writer->SetCompressor(compressor);
-		if(ascii) writer->SetDataModeToAscii();
-		string fn=fileName+"cracks."+boost::lexical_cast<string>(scene->iter)+".vtu";
-		writer->SetFileName(fn.c_str());
-		#ifdef YADE_VTK6
-			writer->SetInputData(crackUg);
-		#else
-			writer->SetInput(crackUg);
-		#endif
-		writer->Write(); }
+		if(xdmf) xdmfBlocks.push_back(XdmfBlock("cracks",crackUg));
+		else{
+			vtkSmartPointer<vtkXMLUnstructuredGridWriter> writer = vtkSmartPointer<vtkXMLUnstructuredGridWriter>::New();
+			if(compress) writer->SetCompressor(compressor);
+			if(ascii) writer->SetDataModeToAscii();
+			string fn=fileName+"cracks."+boost::lexical_cast<string>(scene->iter)+".vtu";
+			writer->SetFileName(fn.c_str());
+			#ifdef YADE_VTK6
+				writer->SetInputData(crackUg);
+			#else
+				writer->SetInput(crackUg);
+			#endif
+			writeJobs.push_back(boost::bind(writeVtk,vtkSmartPointer<vtkXMLWriter>(writer)));
+		}
+	}
 
 // doing same thing for moments that we did for cracks:
 	if (recActive[REC_MOMENTS]) {
@@ -1139,20 +1175,24 @@ void VTKRecorder::action(){
 		momentUg->GetPointData()->AddArray(momentNumInts);
 		momentUg->GetPointData()->AddArray(momentEventNum);
 
-		vtkSmartPointer<vtkXMLUnstructuredGridWriter> writer = vtkSmartPointer<vtkXMLUnstructuredGridWriter>::New();
-		if(compress) writer->SetCompressor(compressor);
-		if(ascii) writer->SetDataModeToAscii();
-		string fn=fileName+"moments."+boost::lexical_cast<string>(scene->iter)+".vtu";
-		writer->SetFileName(fn.c_str());
-		#ifdef YADE_VTK6
-			writer->SetInputData(momentUg);
-		#else
-			writer->SetInput(momentUg);
-		#endif
-		writer->Write(); }
+		if(xdmf) xdmfBlocks.push_back(XdmfBlock("moments",momentUg));
+		else{
+			vtkSmartPointer<vtkXMLUnstructuredGridWriter> writer = vtkSmartPointer<vtkXMLUnstructuredGridWriter>::New();
+			if(compress) writer->SetCompressor(compressor);
+			if(ascii) writer->SetDataModeToAscii();
+			string fn=fileName+"moments."+boost::lexical_cast<string>(scene->iter)+".vtu";
+			writer->SetFileName(fn.c_str());
+			#ifdef YADE_VTK6
+				writer->SetInputData(momentUg);
+			#else
+				writer->SetInput(momentUg);
+			#endif
+			writeJobs.push_back(boost::bind(writeVtk,vtkSmartPointer<vtkXMLWriter>(writer)));
+		}
+	}
 
 	#ifdef YADE_VTK_MULTIBLOCK
-		if(multiblock){
+		if(multiblock && !xdmf){
 			vtkSmartPointer<vtkMultiBlockDataSet> multiblockDataset = vtkSmartPointer<vtkMultiBlockDataSet>::New();
 			int i=0;
 			if(recActive[REC_SPHERES]) multiblockDataset->SetBlock(i++,spheresUg);
@@ -1168,11 +1208,130 @@ void VTKRecorder::action(){
 			#else
 				writer->SetInput(multiblockDataset);
 			#endif
-			writer->Write();	
+			writeJobs.push_back(boost::bind(writeVtk,vtkSmartPointer<vtkXMLWriter>(writer)));	
 		}
 	#endif
+	if(xdmf) writeJobs.push_back(boost::bind(&VTKRecorder::writeXdmfFrame,fileName,xdmfState,xdmfBlocks,scene->time,scene->iter));
+
+	// grids are created anew for each snapshot, so the writer can use them while the simulation goes on
+	if(asyncWrite) writerThread=shared_ptr<boost::thread>(new boost::thread(boost::bind(&VTKRecorder::runJobs,writeJobs)));
+	else runJobs(writeJobs);
+	writeJobs.clear();
 };
 
+VTKRecorder::~VTKRecorder(){ waitForWriter(); }
+
+void VTKRecorder::waitForWriter(){
+	if(!writerThread) return;
+	writerThread->join();
+	writerThread.reset();
+}
+
+void VTKRecorder::runJobs(const vector<boost::function<void()> >& jobs){
+	FOREACH(const boost::function<void()>& job, jobs) job();
+}
+
+/* XDMF output: heavy data (points, connectivity, point and cell arrays) of all snapshots is appended to one raw binary file,
+   and each snapshot adds a spatial collection of blocks to the temporal collection in the light XML index. The index is
+   kept valid after each snapshot by overwriting its closing tags with the new frame and writing them again. */
+void VTKRecorder::writeXdmfFrame(const string& fileName, const shared_ptr<XdmfState>& state, const vector<XdmfBlock>& blocks, Real time, long iter){
+	const string heavyName=fileName+"xdmf.bin", lightName=fileName+"xmf";
+	// the index refers to the heavy file relative to its own location
+	const string heavyRef=heavyName.substr(heavyName.find_last_of('/')==string::npos ? 0 : heavyName.find_last_of('/')+1);
+	const string footer="  </Grid>\n </Domain>\n</Xdmf>\n";
+	// a new fileName starts new files
+	if(!state->started || state->fileName!=fileName){
+		std::ofstream light(lightName.c_str(),std::ios::out|std::ios::trunc);
+		std::ofstream heavy(heavyName.c_str(),std::ios::out|std::ios::trunc|std::ios::binary);
+		if(!light || !heavy){ LOG_ERROR("Unable to create "<<lightName<<" and "<<heavyName<<", snapshot at iteration "<<iter<<" not saved."); return; }
+		light<<"<?xml version=\"1.0\" ?>\n<Xdmf Version=\"2.0\">\n <Domain>\n  <Grid Name=\"VTKRecorder\" GridType=\"Collection\" CollectionType=\"Temporal\">\n";
+		state->footerPos=light.tellp(); state->heavyPos=0;
+		light<<footer;
+		state->started=true; state->fileName=fileName;
+	}
+	std::ofstream heavy(heavyName.c_str(),std::ios::out|std::ios::app|std::ios::binary);
+	if(!heavy){ LOG_ERROR("Unable to open "<<heavyName<<", snapshot at iteration "<<iter<<" not saved."); return; }
+	// append raw data to the heavy file, return the DataItem referencing it
+	auto dataItem=[&](const void* data, size_t itemSize, long rows, int cols, const char* numberType)->string {
+		std::ostringstream oss;
+		oss<<"<DataItem Format=\"Binary\" Endian=\"Native\" NumberType=\""<<numberType<<"\" Precision=\""<<itemSize<<"\" Dimensions=\""<<rows; if(cols>1) oss<<" "<<cols;
+		oss<<"\" Seek=\""<<state->heavyPos<<"\">"<<heavyRef<<"</DataItem>";
+		const size_t bytes=itemSize*rows*cols;
+		heavy.write((const char*)data,bytes); state->heavyPos+=bytes;
+		return oss.str();
+	};
+	std::ostringstream frame; frame<<std::setprecision(17);
+	frame<<"   <Grid Name=\"iter"<<iter<<"\" GridType=\"Collection\" CollectionType=\"Spatial\">\n    <Time Value=\""<<time<<"\"/>\n";
+	FOREACH(const XdmfBlock& block, blocks){
+		vtkDataSet* ds=block.second;
+		const long nPts=ds->GetNumberOfPoints(), nCells=ds->GetNumberOfCells();
+		if(nPts==0 || nCells==0) continue;
+		frame<<"    <Grid Name=\""<<block.first<<"\" GridType=\"Uniform\">\n";
+		// topology: uniform if all cells are of the same type, mixed otherwise
+		vtkSmartPointer<vtkIdList> ids=vtkSmartPointer<vtkIdList>::New();
+		int cellType=(nCells>0 ? ds->GetCellType(0) : VTK_VERTEX);
+		bool uniform=true;
+		for(long c=1; c<nCells && uniform; c++) uniform=(ds->GetCellType(c)==cellType);
+		// xdmf name and mixed-topology code of vtk cell types; other types are written as polyvertices
+		auto xdmfType=[](int vtkType, const char** name)->int {
+			switch(vtkType){
+				case VTK_LINE: *name="Polyline"; return 2;
+				case VTK_TRIANGLE: *name="Triangle"; return 4;
+				case VTK_QUAD: *name="Quadrilateral"; return 5;
+				case VTK_TETRA: *name="Tetrahedron"; return 6;
+				case VTK_HEXAHEDRON: *name="Hexahedron"; return 9;
+				default: *name="Polyvertex"; return 1;
+			}
+		};
+		vector<int64_t> conn;
+		const char* typeName;
+		if(uniform){
+			xdmfType(cellType,&typeName);
+			int nodesPerCell=(nCells>0 ? ds->GetCell(0)->GetNumberOfPoints() : 1);
+			conn.reserve(nCells*nodesPerCell);
+			for(long c=0; c<nCells; c++){ ds->GetCellPoints(c,ids); for(vtkIdType k=0; k<ids->GetNumberOfIds(); k++) conn.push_back(ids->GetId(k)); }
+			frame<<"     <Topology TopologyType=\""<<typeName<<"\" NodesPerElement=\""<<nodesPerCell<<"\" NumberOfElements=\""<<nCells<<"\">\n      "<<dataItem(conn.data(),sizeof(int64_t),nCells,nodesPerCell,"Int")<<"\n     </Topology>\n";
+		} else {
+			for(long c=0; c<nCells; c++){
+				ds->GetCellPoints(c,ids);
+				int code=xdmfType(ds->GetCellType(c),&typeName);
+				conn.push_back(code);
+				if(code<=2) conn.push_back(ids->GetNumberOfIds()); // polyvertex and polyline carry their node count
+				for(vtkIdType k=0; k<ids->GetNumberOfIds(); k++) conn.push_back(ids->GetId(k));
+			}
+			frame<<"     <Topology TopologyType=\"Mixed\" NumberOfElements=\""<<nCells<<"\">\n      "<<dataItem(conn.data(),sizeof(int64_t),conn.size(),1,"Int")<<"\n     </Topology>\n";
+		}
+		vector<double> buf(3*nPts);
+		for(long i=0; i<nPts; i++) ds->GetPoint(i,&buf[3*i]);
+		frame<<"     <Geometry GeometryType=\"XYZ\">\n      "<<dataItem(buf.data(),sizeof(double),nPts,3,"Float")<<"\n     </Geometry>\n";
+		// point and cell arrays, converted to doubles
+		for(int center=0; center<2; center++){
+			vtkFieldData* fields=(center==0 ? (vtkFieldData*)ds->GetPointData() : (vtkFieldData*)ds->GetCellData());
+			const long n=(center==0 ? nPts : nCells);
+			for(int a=0; a<fields->GetNumberOfArrays(); a++){
+				vtkDataArray* arr=fields->GetArray(a);
+				if(!arr || arr->GetNumberOfTuples()!=n) continue;
+				const int nc=arr->GetNumberOfComponents();
+				buf.resize(n*nc);
+				for(long i=0; i<n; i++) arr->GetTuple(i,&buf[nc*i]);
+				// arrays are normally named, make up a name otherwise
+				const string name=(arr->GetName() ? string(arr->GetName()) : string(center==0 ? "pointArray" : "cellArray")+boost::lexical_cast<string>(a));
+				const char* attrType=(nc==1 ? "Scalar" : (nc==3 ? "Vector" : (nc==6 ? "Tensor6" : (nc==9 ? "Tensor" : "Matrix"))));
+				frame<<"     <Attribute Name=\""<<name<<"\" AttributeType=\""<<attrType<<"\" Center=\""<<(center==0 ? "Node" : "Cell")<<"\">\n      "<<dataItem(buf.data(),sizeof(double),n,nc,"Float")<<"\n     </Attribute>\n";
+			}
+		}
+		frame<<"    </Grid>\n";
+	}
+	frame<<"   </Grid>\n";
+	heavy.close();
+	std::fstream light(lightName.c_str(),std::ios::in|std::ios::out);
+	if(!light){ LOG_ERROR("Unable to open "<<lightName<<", snapshot at iteration "<<iter<<" not indexed."); return; }
+	light.seekp(state->footerPos);
+	light<<frame.str();
+	state->footerPos=light.tellp();
+	light<<footer;
+}
+
 void VTKRecorder::addWallVTK (vtkSmartPointer<vtkQuad>& boxes, vtkSmartPointer<vtkPoints>& boxesPos, Vector3r& W1, Vector3r& W2, Vector3r& W3, Vector3r& W4) {
 	//Function for exporting walls of boxes
 	vtkIdType nbPoints=boxesPos->GetNumberOfPoints();
@@ -2,6 +2,11 @@
 #include<pkg/common/PeriodicEngines.hpp>
 #include<vtkQuad.h>
 #include<vtkSmartPointer.h>
+#include<boost/thread/thread.hpp>
+#include<boost/function.hpp>
+#include<fstream>
+
+class vtkDataSet;
 
 // multiblock features don't seem to exist prioor to 5.2 
 #if (VTK_MAJOR_VERSION==5 && VTK_MINOR_VERSION>=2) || (VTK_MAJOR_VERSION > 5)
@@ -13,10 +18,13 @@ class VTKRecorder: public PeriodicEngine {
 	public:
   enum {REC_SPHERES=0,REC_FACETS,REC_BOXES,REC_COLORS,REC_MASS,REC_CPM,REC_INTR,REC_VELOCITY,REC_ID,REC_CLUMPID,REC_SENTINEL,REC_MATERIALID,REC_STRESS,REC_MASK,REC_RPM,REC_JCFPM,REC_CRACKS,REC_MOMENTS,REC_WPM,REC_PERICELL,REC_LIQ,REC_BSTRESS,REC_FORCE,REC_COORDNUMBER};
 		virtual void action();
+		virtual ~VTKRecorder();
 		void addWallVTK (vtkSmartPointer<vtkQuad>& boxes, vtkSmartPointer<vtkPoints>& boxesPos, Vector3r& W1, Vector3r& W2, Vector3r& W3, Vector3r& W4);
 	YADE_CLASS_BASE_DOC_ATTRS_CTOR(VTKRecorder,PeriodicEngine,"Engine recording snapshots of simulation into series of \\*.vtu files, readable by VTK-based postprocessing programs such as Paraview. Both bodies (spheres and facets) and interactions can be recorded, with various vector/scalar quantities that are defined on them.\n\n:yref:`PeriodicEngine.initRun` is initialized to ``True`` automatically.",
 		((bool,compress,false,,"Compress output XML files [experimental]."))
 		((bool,ascii,false,,"Store data as readable text in the XML file (sets `vtkXMLWriter <http://www.vtk.org/doc/nightly/html/classvtkXMLWriter.html>`__ data mode to ``vtkXMLWriter::Ascii``, while the default is ``Appended``"))
+		((bool,asyncWrite,false,,"Write files from a background thread, so that the simulation continues while the previous snapshot is being written. The writer is joined before the next snapshot is assembled and when the engine is destroyed; files of the last snapshot may therefore appear only after :yref:`O.run<Omega.run>` has returned."))
+		((bool,xdmf,false,,"Append all snapshots to a single raw binary file ``{fileName}xdmf.bin`` indexed by the XDMF file ``{fileName}xmf`` (a temporal collection, readable by Paraview's XDMF reader), instead of writing one file per block and per snapshot. :yref:`multiblock<VTKRecorder.multiblock>`, :yref:`compress<VTKRecorder.compress>` and :yref:`ascii<VTKRecorder.ascii>` are ignored in this mode. Existing files are overwritten when the first snapshot is written."))
 		((bool,skipFacetIntr,true,,"Skip interactions that are not of sphere-sphere type (e.g. sphere-facet, sphere-box...), when saving interactions"))
 		((bool,skipNondynamic,false,,"Skip non-dynamic spheres (but not facets)."))
 		#ifdef YADE_VTK_MULTIBLOCK
@@ -27,9 +35,26 @@ class VTKRecorder: public PeriodicEngine {
 		((string,Key,"",,"Necessary if :yref:`recorders<VTKRecorder.recorders>` contains 'cracks'. A string specifying the name of file 'cracks___.txt' that is considered in this case (see :yref:`corresponding attribute<Law2_ScGeom_JCFpmPhys_JointedCohesiveFrictionalPM.Key>`)."))
 		((int,mask,0,,"If mask defined, only bodies with corresponding groupMask will be exported. If 0, all bodies will be exported.")),
 		/*ctor*/
-		initRun=true;
+		initRun=true; xdmfState=shared_ptr<XdmfState>(new XdmfState);
 	);
 	DECLARE_LOGGER;
+	private:
+		typedef std::pair<string,vtkSmartPointer<vtkDataSet> > XdmfBlock;
+		// pending writes of the current snapshot, run serially (in the background thread if asyncWrite)
+		vector<boost::function<void()> > writeJobs;
+		shared_ptr<boost::thread> writerThread;
+		void waitForWriter();
+		static void runJobs(const vector<boost::function<void()> >& jobs);
+		// xdmf: files being written, offset of the next frame in the heavy data file, position of the closing tags in the index
+		struct XdmfState {
+			string fileName;
+			bool started;
+			std::streamoff heavyPos, footerPos;
+			XdmfState(): started(false), heavyPos(0), footerPos(0) {}
+		};
+		// only used by write jobs, which run one snapshot at a time; jobs get copies of everything else, not this
+		shared_ptr<XdmfState> xdmfState;
+		static void writeXdmfFrame(const string& fileName, const shared_ptr<XdmfState>& state, const vector<XdmfBlock>& blocks, Real time, long iter);
 };
 
 
@@ -30,13 +30,15 @@
 #include<pkg/common/Sphere.hpp>
 #include<pkg/dem/CohesiveFrictionalContactLaw.hpp>
 #include <boost/filesystem.hpp>
+#include <boost/bind.hpp>
+#include <cstdint>
 
 namespace bfs=boost::filesystem;
 
 inline Vector3i vect3rToVect3i(Vector3r vect){Vector3i newvect((int)vect[0],(int)vect[1],(int)vect[2]);return(newvect);}
 
 
-HydrodynamicsLawLBM::~HydrodynamicsLawLBM() {};
+HydrodynamicsLawLBM::~HydrodynamicsLawLBM() {waitForSave();};
 
 bool HydrodynamicsLawLBM::isActivated(){
     DEM_ITER=scene->iter;//+1;
@@ -177,6 +179,8 @@ void HydrodynamicsLawLBM::action()
         res=LBMSavedData.find("NewNode");       if(res>=0&&res<ll) {SAVE_NODEISNEW   =true; CreateLbmDir=true;}
         res=LBMSavedData.find("newNode");       if(res>=0&&res<ll) {SAVE_NODEISNEW   =true; CreateLbmDir=true;}
         res=LBMSavedData.find("bz2");           if(res>=0&&res<ll) COMPRESS_DATA    =true;
+        res=LBMSavedData.find("binary");        if(res>=0&&res<ll) SAVE_BINARY      =true;
+        res=LBMSavedData.find("Binary");        if(res>=0&&res<ll) SAVE_BINARY      =true;
         res=LBMSavedData.find("ObservedPtc");   if(res>=0&&res<ll) SAVE_OBSERVEDPTC =true;
         res=LBMSavedData.find("observedptc");   if(res>=0&&res<ll) SAVE_OBSERVEDPTC =true;
 	res=LBMSavedData.find("observedPtc");   if(res>=0&&res<ll) SAVE_OBSERVEDPTC =true;
@@ -275,6 +279,8 @@ void HydrodynamicsLawLBM::action()
         /*---------------------------------------------------------------*/
         LBMnode aa;
         for(int nidx=0; nidx<Nx*Ny; nidx++) {nodes.push_back(aa);}
+        neighbours.assign(NbDir*Nx*Ny,-1);
+        nodeLinks.assign(NbDir*Nx*Ny,-1);
         bool j_update=false;
         int j=0;
         for (int nidx=0; nidx<Nx*Ny; nidx++){
@@ -286,13 +292,10 @@ void HydrodynamicsLawLBM::action()
             nodes[nidx].DispatchBoundaryConditions(Nx,Ny,Nz);
             NbNodes++;
             for (int dndx=0; dndx<NbDir; dndx++){
-                nodes[nidx].links_id.push_back(-1);
                 I=nodes[nidx].i+eib[dndx].x();
                 J=nodes[nidx].j+eib[dndx].y();
-                if(((I==i)&&(J==j)) || (I==-1) || (J==-1) || (I==Nx) || (J==Ny)  ){
-                    nodes[nidx].neighbour_id.push_back(-1);
-                }
-                else {nodes[nidx].neighbour_id.push_back(I+J*Nx);}
+                if(((I==i)&&(J==j)) || (I==-1) || (J==-1) || (I==Nx) || (J==Ny)  ) continue;
+                neighbours[dndx*Nx*Ny+nidx]=I+J*Nx;
             }
         if(j_update) {j++;j_update=false;}
         }
@@ -310,36 +313,36 @@ void HydrodynamicsLawLBM::action()
                 bb.PointingOutside=false;
                 if((!strcmp(model.c_str(), "d2q9" )) && ((dndx==1)||(dndx==2)||(dndx==5)||(dndx==6))){
                     link_id++;bb.i=dndx;bb.nid1=nidx;
-                    bb.nid2=nodes[nidx].neighbour_id[dndx];
+                    bb.nid2=neighbours[dndx*Nx*Ny+nidx];
                     if(bb.nid2==-1) bb.PointingOutside=true;
                     links.push_back(bb);
-                    nodes[bb.nid1].links_id[dndx]=link_id;
-                    if(bb.nid2!=-1) nodes[bb.nid2].links_id[opp[dndx]]=link_id;
+                    nodeLinks[dndx*Nx*Ny+bb.nid1]=link_id;
+                    if(bb.nid2!=-1) nodeLinks[opp[dndx]*Nx*Ny+bb.nid2]=link_id;
                 }else if(!strcmp(model.c_str(), "d2q9" )){
                     if((I==0)&&(J!=0)&&((dndx==3)||(dndx==7))){
                         link_id++;bb.i=dndx; bb.nid1=nidx;
-                        bb.nid2=nodes[nidx].neighbour_id[dndx];
+                        bb.nid2=neighbours[dndx*Nx*Ny+nidx];
                         bb.PointingOutside=true;
                         if(bb.nid2!=-1) {cerr<<"ERROR: bb.id2!=-1"<<endl;exit(-1);}
                         links.push_back(bb);
-                        nodes[bb.nid1].links_id[dndx]=link_id;
-                        if(bb.nid2!=-1) nodes[bb.nid2].links_id[opp[dndx]]=link_id;
+                        nodeLinks[dndx*Nx*Ny+bb.nid1]=link_id;
+                        if(bb.nid2!=-1) nodeLinks[opp[dndx]*Nx*Ny+bb.nid2]=link_id;
                     } else if((J==0)&&(I!=0)&&((dndx==4)||(dndx==7)||(dndx==8))){
                         link_id++;bb.i=dndx; bb.nid1=nidx;
-                        bb.nid2=nodes[nidx].neighbour_id[dndx];
+                        bb.nid2=neighbours[dndx*Nx*Ny+nidx];
                         bb.PointingOutside=true;
                         if(bb.nid2!=-1) {cerr<<"ERROR: bb.id2!=-1"<<endl;exit(-1);}
                         links.push_back(bb);
-                        nodes[bb.nid1].links_id[dndx]=link_id;
-                        if(bb.nid2!=-1) nodes[bb.nid2].links_id[opp[dndx]]=link_id;
+                        nodeLinks[dndx*Nx*Ny+bb.nid1]=link_id;
+                        if(bb.nid2!=-1) nodeLinks[opp[dndx]*Nx*Ny+bb.nid2]=link_id;
                     } else if((I==0)&&(J==0)&&((dndx==3)||(dndx==4)||(dndx==7)||(dndx==8))){
                         link_id++;bb.i=dndx; bb.nid1=nidx;
-                        bb.nid2=nodes[nidx].neighbour_id[dndx];
+                        bb.nid2=neighbours[dndx*Nx*Ny+nidx];
                         bb.PointingOutside=true;
                         if(bb.nid2!=-1) {cerr<<"ERROR: bb.id2!=-1"<<endl;exit(-1);}
                         links.push_back(bb);
-                        nodes[bb.nid1].links_id[dndx]=link_id;
-                        if(bb.nid2!=-1) nodes[bb.nid2].links_id[opp[dndx]]=link_id;
+                        nodeLinks[dndx*Nx*Ny+bb.nid1]=link_id;
+                        if(bb.nid2!=-1) nodeLinks[opp[dndx]*Nx*Ny+bb.nid2]=link_id;
                     }
                 }else {cerr<<"ERROR: Unknow model type: "<<model<<endl;exit(-1);}
             }
@@ -384,62 +387,24 @@ void HydrodynamicsLawLBM::action()
     State* sWallZp=Body::byId(WallZp_id,scene)->state.get();
     State* sWallZm=Body::byId(WallZm_id,scene)->state.get();
 
-    timingDeltas->checkpoint("Reinit:Nodes0");
-    #pragma omp parallel for
-    for (int nidx=0; nidx<Nx*Ny; nidx++){
-        /*------------------------------------------*/
-        /* Reinitialization:                        */
-        /*------------------------------------------*/
-        nodes[nidx].body_id=-1;
-        nodes[nidx].setAsFluid();
-        nodes[nidx].isObstacleBoundary=false;
-        nodes[nidx].isFluidBoundary=false;
-        nodes[nidx].isNewObstacle=false;
-        nodes[nidx].isNewFluid=false;
-
-        /*--- according to X+ ---*/
-        if (useWallXp&&(nodes[nidx].i>=invdx*(sWallXp->se3.position.x() - halfWallthickness))){
-            nodes[nidx].setAsObstacle();
-            nodes[nidx].isObstacleBoundary=true;
-            nodes[nidx].body_id=WallXp_id;
-            NbSolidNodes++;}
-        /*--- according to X- ---*/
-        else if (useWallXm&&(nodes[nidx].i<=invdx*(sWallXm->se3.position.x() + halfWallthickness))){
-            nodes[nidx].setAsObstacle();
-            nodes[nidx].isObstacleBoundary=true;
-            nodes[nidx].body_id=WallXm_id;
-            NbSolidNodes++;}
-        /*--- according to Y+ ---*/
-        else if (useWallYp&&(nodes[nidx].j>=invdx*(sWallYp->se3.position.y() - halfWallthickness))){
-            nodes[nidx].setAsObstacle();
-            nodes[nidx].isObstacleBoundary=true;
-            nodes[nidx].body_id=WallYp_id;
-            NbSolidNodes++;}
-        /*--- according to Y- ---*/
-        else if (useWallYm&&(nodes[nidx].j<=invdx*(sWallYm->se3.position.y() + halfWallthickness))){
-            nodes[nidx].setAsObstacle();
-            nodes[nidx].isObstacleBoundary=true;
-            nodes[nidx].body_id=WallYm_id;
-            NbSolidNodes++;}
-         /*--- according to Z+ ---*/
-        else if (useWallZp&&(nodes[nidx].k>=invdx*(sWallZp->se3.position.z() - halfWallthickness))){
-            nodes[nidx].setAsObstacle();
-            nodes[nidx].isObstacleBoundary=true;
-            nodes[nidx].body_id=WallZp_id;
-            NbSolidNodes++;}
-        /*--- according to Z- ---*/
-        else if (useWallZm&&(nodes[nidx].k<=invdx*(sWallZm->se3.position.z() + halfWallthickness))){
-            nodes[nidx].setAsObstacle();
-            nodes[nidx].isObstacleBoundary=true;
-            nodes[nidx].body_id=WallZm_id;
-            NbSolidNodes++;}
-
-        if(firstRun){nodes[nidx].wasObstacle=nodes[nidx].isObstacle;}
-    }
+    /*---------------------------------------------------------------*/
+    /* The particle map is only rebuilt from scratch if the walls    */
+    /* moved or the set of spheres changed, otherwise only particles */
+    /* that moved enough to change the status of a node are remapped */
+    /*---------------------------------------------------------------*/
+    bool fullObstacleUpdate = firstRun || !incrementalObstacles;
+    const Vector3r wallPos[6]={sWallXp->se3.position,sWallXm->se3.position,sWallYp->se3.position,
+                               sWallYm->se3.position,sWallZp->se3.position,sWallZm->se3.position};
+    if(mappedWallPos.size()!=6) {fullObstacleUpdate=true; mappedWallPos.resize(6);}
+    for(int wl=0;wl<6;wl++){
+        if(mappedWallPos[wl]!=wallPos[wl]) fullObstacleUpdate=true;
+        mappedWallPos[wl]=wallPos[wl];}
 
     /*---------------------------------------------------------------*/
     /*- Solid particle detection and recording of their properties --*/
     /*---------------------------------------------------------------*/
+    vector<int> remappedPtc;
+    int nbSpheres=0;
     NumberOfDynamicParticles=0;
     if(removingCriterion!=0) IdOfNextErodedPtc.clear();
     FOREACH(const shared_ptr<Body>& b, *scene->bodies){
@@ -454,28 +419,15 @@ void HydrodynamicsLawLBM::action()
             LBbodies[id].vel=(state->vel)/c;
             LBbodies[id].AVel= (state->angVel)*dt;
 	    LBbodies[id].radius=invdx*RadFactor*(sphere->radius);
+            if (LBbodies[id].radius < Rmin) Rmin = LBbodies[id].radius;
+            nbSpheres++;
 
             CurMinVelOfPtc=min(CurMinVelOfPtc,state->vel.norm());
             CurMaxVelOfPtc=max(CurMaxVelOfPtc,state->vel.norm());
 
-            Vector3r posMax=LBbodies[id].pos+ Vector3r(LBbodies[id].radius,LBbodies[id].radius,LBbodies[id].radius);
-            Vector3r posMin=LBbodies[id].pos- Vector3r(LBbodies[id].radius,LBbodies[id].radius,LBbodies[id].radius);
-
-            Vector3r dist=Vector3r::Zero();
-            for(int ii=posMin[0]-1;ii<=posMax[0]+1;ii++)
-                for(int jj=posMin[1]-1;jj<=posMax[1]+1;jj++){
-                    if((ii==-1)||(ii==Nx)||(jj==-1)||(jj==Ny)) continue;
-                    if((ii<-1)||(ii>Nx)||(jj<-1)||(jj>Ny)) continue;
-                    if (LBbodies[id].radius < Rmin) Rmin = LBbodies[id].radius;
-                    int nidx=ii+jj*Nx;
-                    dist=nodes[nidx].posb-LBbodies[id].pos;
-                    if(dist.norm()<LBbodies[id].radius){
-                        nodes[nidx].body_id = id;
-                        nodes[nidx].setAsObstacle();
-                        NbSolidNodes++;
-                        NbParticleNodes++;}
-                    if(firstRun){nodes[nidx].wasObstacle=nodes[nidx].isObstacle;}
-                }
+            /* no node can change status while the displacement stays below the mapping margin */
+            if((LBbodies[id].pos-LBbodies[id].mappedPos).norm()+std::abs(LBbodies[id].radius-LBbodies[id].mappedRadius)>=LBbodies[id].mappedMargin)
+                remappedPtc.push_back(id);
             /*-------------------------------------------------------------------*/
             /* ///NOTE : this should be removed since it can be done with python */
 			 ///Fck: pas en MODE 1
@@ -506,6 +458,82 @@ void HydrodynamicsLawLBM::action()
         LBbodies[id].force=Vector3r::Zero();
         LBbodies[id].momentum=Vector3r::Zero();
     }
+    /* erased and inserted bodies: ids may have been reused by other spheres */
+    if(nbSpheres!=NbMappedParticles || scene->bodies->revision!=mappedBodiesRevision) fullObstacleUpdate=true;
+    mappedBodiesRevision=scene->bodies->revision;
+
+    timingDeltas->checkpoint("Reinit:Particles");
+    if(!fullObstacleUpdate){
+        /* remove all moved particles first, a node left covered by another particle needs a full update */
+        for(unsigned int p=0;p<remappedPtc.size();p++)
+            if(!removeParticleFromLattice(remappedPtc[p])) {fullObstacleUpdate=true; break;}
+    }
+    if(fullObstacleUpdate){
+        particleOwner.assign(Nx*Ny,-1);
+        coverCount.assign(Nx*Ny,0);
+        NbMappedParticles=0;
+        NbParticleNodes=0;
+        FOREACH(const shared_ptr<Body>& b, *scene->bodies){
+            if(!b) continue;
+            if(b->shape->getClassName()=="Sphere") {addParticleToLattice(b->getId()); NbMappedParticles++;}
+        }
+    }else{
+        for(unsigned int p=0;p<remappedPtc.size();p++) addParticleToLattice(remappedPtc[p]);
+    }
+
+    timingDeltas->checkpoint("Reinit:Nodes0");
+    #pragma omp parallel for
+    for (int nidx=0; nidx<Nx*Ny; nidx++){
+        /*------------------------------------------*/
+        /* Reinitialization:                        */
+        /*------------------------------------------*/
+        nodes[nidx].body_id=-1;
+        nodes[nidx].setAsFluid();
+        nodes[nidx].isObstacleBoundary=false;
+        nodes[nidx].isFluidBoundary=false;
+        nodes[nidx].isNewObstacle=false;
+        nodes[nidx].isNewFluid=false;
+        nodes[nidx].wasSolidInterior=(firstRun ? false : nodes[nidx].isSolidInterior);
+        nodes[nidx].isSolidInterior=false;
+
+        /*--- according to X+ ---*/
+        if (useWallXp&&(nodes[nidx].i>=invdx*(sWallXp->se3.position.x() - halfWallthickness))){
+            nodes[nidx].setAsObstacle();
+            nodes[nidx].isObstacleBoundary=true;
+            nodes[nidx].body_id=WallXp_id;}
+        /*--- according to X- ---*/
+        else if (useWallXm&&(nodes[nidx].i<=invdx*(sWallXm->se3.position.x() + halfWallthickness))){
+            nodes[nidx].setAsObstacle();
+            nodes[nidx].isObstacleBoundary=true;
+            nodes[nidx].body_id=WallXm_id;}
+        /*--- according to Y+ ---*/
+        else if (useWallYp&&(nodes[nidx].j>=invdx*(sWallYp->se3.position.y() - halfWallthickness))){
+            nodes[nidx].setAsObstacle();
+            nodes[nidx].isObstacleBoundary=true;
+            nodes[nidx].body_id=WallYp_id;}
+        /*--- according to Y- ---*/
+        else if (useWallYm&&(nodes[nidx].j<=invdx*(sWallYm->se3.position.y() + halfWallthickness))){
+            nodes[nidx].setAsObstacle();
+            nodes[nidx].isObstacleBoundary=true;
+            nodes[nidx].body_id=WallYm_id;}
+         /*--- according to Z+ ---*/
+        else if (useWallZp&&(nodes[nidx].k>=invdx*(sWallZp->se3.position.z() - halfWallthickness))){
+            nodes[nidx].setAsObstacle();
+            nodes[nidx].isObstacleBoundary=true;
+            nodes[nidx].body_id=WallZp_id;}
+        /*--- according to Z- ---*/
+        else if (useWallZm&&(nodes[nidx].k<=invdx*(sWallZm->se3.position.z() + halfWallthickness))){
+            nodes[nidx].setAsObstacle();
+            nodes[nidx].isObstacleBoundary=true;
+            nodes[nidx].body_id=WallZm_id;}
+
+        /*--- particles (the one with the highest id owns the node) ---*/
+        if(particleOwner[nidx]!=-1){
+            nodes[nidx].body_id=particleOwner[nidx];
+            nodes[nidx].setAsObstacle();}
+
+        if(firstRun){nodes[nidx].wasObstacle=nodes[nidx].isObstacle;}
+    }
 
 
     /*------------------------------------------------------------------*/
@@ -514,14 +542,16 @@ void HydrodynamicsLawLBM::action()
     #pragma omp parallel for
     for (int nidx=0; nidx<Nx*Ny; nidx++)
         if(nodes[nidx].isObstacle){
-            for(unsigned int n=0;n<nodes[nidx].neighbour_id.size();n++){
-                if(nodes[nidx].neighbour_id[n]!=-1){
-                    int nidx2=nodes[nidx].neighbour_id[n];
+            bool interior=true;
+            for(int n=0;n<NbDir;n++){
+                if(neighbours[n*Nx*Ny+nidx]!=-1){
+                    int nidx2=neighbours[n*Nx*Ny+nidx];
                     if(nodes[nidx].isObstacle!=nodes[nidx2].isObstacle) {
+                        interior=false;
                         nodes[nidx].isObstacleBoundary=true;
                         nodes[nidx2].isFluidBoundary=true;
                         int BodyId=nodes[nidx].body_id;
-                        int lid=nodes[nidx].links_id[n];
+                        int lid=nodeLinks[n*Nx*Ny+nidx];
                         links[lid].isBd=true;
                         links[lid].sid=nidx;
                         links[lid].fid=nidx2;
@@ -538,16 +568,53 @@ void HydrodynamicsLawLBM::action()
                         }
                 }
             }
+            nodes[nidx].isSolidInterior=interior;
         }
      #pragma omp parallel for
      for (int nidx=0; nidx<Nx*Ny; nidx++)
         if((nodes[nidx].isObstacle)&&(!nodes[nidx].isObstacleBoundary)){
                 nodes[nidx].setAsFluid();
-                NbSolidNodes--;
                 if(firstRun) nodes[nidx].wasObstacle=nodes[nidx].isObstacle;
         }
+    boundaryLinks.clear();
+    for(unsigned int lid=0;lid<links.size();lid++) if(links[lid].isBd) boundaryLinks.push_back(lid);
+
+    /*------------------------------------------------------------------*/
+    /* Nodes deep inside a solid are not swept by the collide-stream    */
+    /* kernel; when uncovered they restart from the equilibrium of      */
+    /* their active neighbours                                          */
+    /*------------------------------------------------------------------*/
+    /* interior nodes of particles were set as fluid above; when skipped, they are not counted as fluid nodes either */
+    NbSolidNodes=0;
+    NbFluidNodes=0;
+    activeNodes.clear();
+    for (int nidx=0; nidx<Nx*Ny; nidx++){
+        if(nodes[nidx].isObstacle) NbSolidNodes++;
+        if(skipSolidNodes && nodes[nidx].isSolidInterior) continue;
+        activeNodes.push_back(nidx);
+        if(!nodes[nidx].isObstacle) NbFluidNodes++;
+    }
+    if(skipSolidNodes && !firstRun){
+        #pragma omp parallel for
+        for (int nidx=0; nidx<Nx*Ny; nidx++){
+            if(!nodes[nidx].wasSolidInterior || nodes[nidx].isSolidInterior) continue;
+            Real rho=0.; Vector3r vel=Vector3r::Zero(); int count=0;
+            for(int n=0;n<NbDir;n++){
+                const int nidx2=neighbours[n*Nx*Ny+nidx];
+                if(nidx2==-1 || nodes[nidx2].wasSolidInterior) continue;
+                rho+=nodes[nidx2].rhob; vel+=nodes[nidx2].velb; count++;
+            }
+            if(count>0) {rho/=count; vel/=count;} else {rho=1.;}
+            nodes[nidx].rhob=rho;
+            nodes[nidx].velb=vel;
+            const Real usq=1.5*((vel.x()*vel.x())+(vel.y()*vel.y()));
+            for (int dndx=0; dndx<NbDir; dndx++){
+                const Real cu=3.0* eib[dndx].dot(vel);
+                fdist[dndx*Nx*Ny+nidx]=w[dndx]*rho*(1.0 + cu + 0.5*(cu*cu) - usq);
+            }
+        }
+    }
 
-    NbFluidNodes=NbNodes-NbSolidNodes;
     /*----------------------------------------------------------------------*/
 
     if(firstRun){
@@ -578,15 +645,16 @@ void HydrodynamicsLawLBM::action()
         /*------------------------------------------*/
         /* Initialization of distribution functions */
         /*------------------------------------------*/
+        fdist.resize(NbDir*Nx*Ny);
+        fdistNext.resize(NbDir*Nx*Ny);
         for (int nidx=0; nidx<Nx*Ny; nidx++){
             nodes[nidx].rhob=1.;
             nodes[nidx].velb=Vector3r::Zero();
             for (int didx=0; didx<NbDir; didx++){
                 cub = 3.0* eib[didx].dot(nodes[nidx].velb);
                 feqb = w[didx]*nodes[nidx].rhob*(1.0 + cub + 0.5*(cub*cub) - 1.5*((nodes[nidx].velb.x()*nodes[nidx].velb.x()) + (nodes[nidx].velb.y()*nodes[nidx].velb.y())));
-                nodes[nidx].f.push_back(feqb);
-                nodes[nidx].fpostcol.push_back(0.);
-                nodes[nidx].fprecol.push_back(0.);
+                fdist[didx*Nx*Ny+nidx]=feqb;
+                fdistNext[didx*Nx*Ny+nidx]=feqb;
             }
         }
         firstRun  = false;
@@ -619,186 +687,196 @@ void HydrodynamicsLawLBM::action()
         /*------------------------------------------------------------------*/
         // Vector3r WallBottomVel=Vector3r::Zero();//m s-1
         FmoyCur=0.;
-        VmeanFluidC=0.; VmaxC=-1000000.;    VminC=1000000.;
-        RhomaxC=-1000000.;  RhominC=1000000.;RhoTot=0.;
         /*------------------------------------------------------------------*/
-        /*                          Loop on nodes                           */
+        /* Corner nodes take the density of their neighbour, read before    */
+        /* the node loop so that the result does not depend on scheduling   */
         /*------------------------------------------------------------------*/
-        #pragma omp parallel for
-        for (int nidx=0; nidx<Nx*Ny; nidx++){
-            if(nodes[nidx].checkIsNewObstacle()) {newObstacleCells_couter++;}
-            else{if(nodes[nidx].checkIsNewFluid()) {newFluidCells_couter++;}}
-            if(nodes[nidx].applyBC){
+        const int nn=Nx*Ny;
+        const Real rhoYmXm=nodes[1].rhob;
+        const Real rhoYpXm=nodes[(Ny-1)*Nx+1].rhob;
+        const Real rhoYmXp=nodes[Nx-2].rhob;
+        const Real rhoYpXp=nodes[nn-2].rhob;
+        Real forcing[9];
+        for (int dndx=0; dndx<NbDir; dndx++) forcing[dndx]=w[dndx]/c2*eib[dndx].dot(CstBodyForce);
+
+        /*------------------------------------------------------------------*/
+        /*    Loop on nodes: boundary conditions, moments, BGK collision    */
+        /*    and streaming (push) towards fdistNext in a single pass       */
+        /*------------------------------------------------------------------*/
+        Real vmax=-1000000., vmin=1000000., rhomax=-1000000., rhomin=1000000., rhoTot=0., vmean=0.;
+        int newObstacles=0, newFluids=0;
+        const Real* fcur=&fdist[0];
+        Real* fnew=&fdistNext[0];
+        const int* nbr=&neighbours[0];
+        const int nbActive=activeNodes.size();
+        #pragma omp parallel for reduction(+:rhoTot,vmean,newObstacles,newFluids) reduction(max:vmax,rhomax) reduction(min:vmin,rhomin)
+        for (int a=0; a<nbActive; a++){
+            const int nidx=activeNodes[a];
+            LBMnode& node=nodes[nidx];
+            if(node.checkIsNewObstacle()) {newObstacles++;}
+            else{if(node.checkIsNewFluid()) {newFluids++;}}
+
+            Real fl[9]; // d2q9 only (checked during the lattice setup)
+            for (int dndx=0; dndx<NbDir; dndx++) fl[dndx]=fcur[dndx*nn+nidx];
+
+            if(node.applyBC){
                 Vector3r U=Vector3r::Zero();
                 Real density=0.;
                 /*----------- inlet ------------*/
-                if(nodes[nidx].applyXmBC){
+                if(node.applyXmBC){
                     if(XmBCType==1){
-						density=1.0 + dP.x()/(Rho*cs*cs);
-                        U=Vector3r(1.0-((nodes[nidx].f[0]+nodes[nidx].f[2]+nodes[nidx].f[4]) +  2.0*(nodes[nidx].f[3]+nodes[nidx].f[6]+nodes[nidx].f[7]))/density,0.,0.);
+                        density=1.0 + dP.x()/(Rho*cs*cs);
+                        U=Vector3r(1.0-((fl[0]+fl[2]+fl[4]) +  2.0*(fl[3]+fl[6]+fl[7]))/density,0.,0.);
                     }else if(XmBCType==2){
                         U=Vector3r::Zero();
-                        density=(nodes[nidx].f[0]+nodes[nidx].f[2]+nodes[nidx].f[4]+2.*(nodes[nidx].f[3]+nodes[nidx].f[6]+nodes[nidx].f[7]))/(1.-U.x());
+                        density=(fl[0]+fl[2]+fl[4]+2.*(fl[3]+fl[6]+fl[7]))/(1.-U.x());
                     }
-                    nodes[nidx].MixteBC(model,density,U,"Xm");
+                    node.MixteBC(model,density,U,"Xm",fl);
                 /*----------- outlet ------------*/
-                }else if( nodes[nidx].applyXpBC){
+                }else if(node.applyXpBC){
                     if(XpBCType==1){
                         density=1.0;
-                        U=Vector3r(-1.0 + ((nodes[nidx].f[0]+nodes[nidx].f[2]+nodes[nidx].f[4]) +  2.0*(nodes[nidx].f[1]+nodes[nidx].f[5]+nodes[nidx].f[8]))/density,0.,0.);
+                        U=Vector3r(-1.0 + ((fl[0]+fl[2]+fl[4]) +  2.0*(fl[1]+fl[5]+fl[8]))/density,0.,0.);
                     }else if(XpBCType==2){
                         U=Vector3r::Zero();
-                        density=(nodes[nidx].f[0]+nodes[nidx].f[2]+nodes[nidx].f[4]+2.*(nodes[nidx].f[1]+nodes[nidx].f[5]+nodes[nidx].f[8]))/(1.+U.x());
+                        density=(fl[0]+fl[2]+fl[4]+2.*(fl[1]+fl[5]+fl[8]))/(1.+U.x());
                     }
-                    nodes[nidx].MixteBC(model,density,U,"Xp");
+                    node.MixteBC(model,density,U,"Xp",fl);
                 /*----------- top ------------*/
-                } else if( nodes[nidx].applyYpBC){
+                } else if(node.applyYpBC){
                     if(YpBCType==1){
                         density=1.0;
-                        U=Vector3r(0.,-1.0 + ((nodes[nidx].f[0]+nodes[nidx].f[1]+nodes[nidx].f[3]) +  2.0*(nodes[nidx].f[2]+nodes[nidx].f[5]+nodes[nidx].f[6]))/density,0.);
+                        U=Vector3r(0.,-1.0 + ((fl[0]+fl[1]+fl[3]) +  2.0*(fl[2]+fl[5]+fl[6]))/density,0.);
                     }else if(YpBCType==2){
                         U=Vector3r::Zero();
-                        density=(nodes[nidx].f[0]+nodes[nidx].f[1]+nodes[nidx].f[3]+2.*(nodes[nidx].f[2]+nodes[nidx].f[5]+nodes[nidx].f[6]))/(1.+U.y());
+                        density=(fl[0]+fl[1]+fl[3]+2.*(fl[2]+fl[5]+fl[6]))/(1.+U.y());
                     }
-                    nodes[nidx].MixteBC(model,density,U,"Yp");
+                    node.MixteBC(model,density,U,"Yp",fl);
                 /*----------- bottom ------------*/
-                }else if( nodes[nidx].applyYmBC){
+                }else if(node.applyYmBC){
                     if(YmBCType==1){
                         density=1.0;
-                        U=Vector3r(0.,1.0-((nodes[nidx].f[0]+nodes[nidx].f[1]+nodes[nidx].f[3]) +  2.0*(nodes[nidx].f[4]+nodes[nidx].f[7]+nodes[nidx].f[8]))/density,0.);
+                        U=Vector3r(0.,1.0-((fl[0]+fl[1]+fl[3]) +  2.0*(fl[4]+fl[7]+fl[8]))/density,0.);
                     }else if(YmBCType==2){
                         U=Vector3r::Zero();
-                        density=(nodes[nidx].f[0]+nodes[nidx].f[1]+nodes[nidx].f[3]+2.*(nodes[nidx].f[4]+nodes[nidx].f[7]+nodes[nidx].f[8]))/(1.-U.y());
+                        density=(fl[0]+fl[1]+fl[3]+2.*(fl[4]+fl[7]+fl[8]))/(1.-U.y());
                     }
-                    nodes[nidx].MixteBC(model,density,U,"Ym");
+                    node.MixteBC(model,density,U,"Ym",fl);
                 /*----------- bottom-left ------------*/
-                }else if(nodes[nidx].applyYmXmBC){
+                }else if(node.applyYmXmBC){
                     if(XmYmZpBCType==1){
                         cerr <<"XmYmZpType=1 not implemented . Exit"<<endl;
                         exit(-1);
                     }else if(XmYmZpBCType==2){
                         U=Vector3r::Zero();
-                        density=nodes[nidx+1].rhob;
+                        density=rhoYmXm;
                     }
-                    nodes[nidx].MixteBC(model,density,U,"XmYmZp");
+                    node.MixteBC(model,density,U,"XmYmZp",fl);
                 /*----------- top-left ------------*/
-                }else if(nodes[nidx].applyYpXmBC){
+                }else if(node.applyYpXmBC){
                     if(XmYpZpBCType==1){
                         cerr <<"XmYpZpBCType=1 not implemented . Exit"<<endl;
                         exit(-1);
                     }else if(XmYpZpBCType==2){
                         U=Vector3r::Zero();
-                        density=nodes[nidx+1].rhob;
+                        density=rhoYpXm;
                     }
-                    nodes[nidx].MixteBC(model,density,U,"XmYpZp");
+                    node.MixteBC(model,density,U,"XmYpZp",fl);
                 /*----------- bottom-right ------------*/
-                }else if(nodes[nidx].applyYmXpBC){
+                }else if(node.applyYmXpBC){
                     if(XpYmZpBCType==1){
                         cerr <<"XpYmZpBCType=1 not implemented . Exit"<<endl;
                         exit(-1);
                     }else if(XpYmZpBCType==2){
                         U=Vector3r::Zero();
-                        density=nodes[nidx-1].rhob;
+                        density=rhoYmXp;
                     }
-                    nodes[nidx].MixteBC(model,density,U,"XpYmZp");
+                    node.MixteBC(model,density,U,"XpYmZp",fl);
                 /*----------- top-right ------------*/
-                }else if(nodes[nidx].applyYpXpBC){
+                }else if(node.applyYpXpBC){
                     if(XpYpZpBCType==1){
                         cerr <<"XpYpZpBCType=1 not implemented . Exit"<<endl;
                         exit(-1);
                     }else if(XpYpZpBCType==2){
                         U=Vector3r::Zero();
-                        density=nodes[nidx-1].rhob;
+                        density=rhoYpXp;
                     }
-                    nodes[nidx].MixteBC(model,density,U,"XpYpZp");
+                    node.MixteBC(model,density,U,"XpYpZp",fl);
                 }else{
                     cerr << "ERROR: node "<<nidx<<". Looking for a BC to apply ..."<<endl;
                     exit(-1);
                 }
             }
 
-            nodes[nidx].rhob=0.;
-            nodes[nidx].velb=Vector3r::Zero();
-            nodes[nidx].IsolNb=0;
-            if(nodes[nidx].isFluidBoundary){nodes[nidx].IsolNb=8;}
-
+            Real rho=0.;
+            Vector3r vel=Vector3r::Zero();
+            node.IsolNb=0;
+            if(node.isFluidBoundary){node.IsolNb=8;}
             for (int dndx=0; dndx<NbDir; dndx++){
-              nodes[nidx].fprecol[dndx] = nodes[nidx].f[dndx];
-              nodes[nidx].velb += eib[dndx]*nodes[nidx].f[dndx];
-              nodes[nidx].rhob += nodes[nidx].f[dndx];
-              if((nodes[nidx].isFluidBoundary)&&(nodes[nidx].neighbour_id[dndx]!=-1)){
-                int ns=nodes[nidx].neighbour_id[dndx];
-                if(!nodes[ns].isObstacle) nodes[nidx].IsolNb=nodes[nidx].IsolNb-1;
-                if(nodes[nidx].IsolNb<0) {cerr<<"isolNb<0"<<endl;exit(-1);}}
-
+              vel += eib[dndx]*fl[dndx];
+              rho += fl[dndx];
+              if((node.isFluidBoundary)&&(nbr[dndx*nn+nidx]!=-1)){
+                if(!nodes[nbr[dndx*nn+nidx]].isObstacle) node.IsolNb=node.IsolNb-1;
+                if(node.IsolNb<0) {cerr<<"isolNb<0"<<endl;exit(-1);}}
             }
-            nodes[nidx].velb /= nodes[nidx].rhob;
-
-            Real temp0=1.5*((nodes[nidx].velb.x()*nodes[nidx].velb.x())+(nodes[nidx].velb.y()*nodes[nidx].velb.y()));
-            Real cub0 = 3.0* eib[0].dot(nodes[nidx].velb);
-            nodes[nidx].fpostcol[0]= nodes[nidx].f[0] - omega * (nodes[nidx].f[0]-(nodes[nidx].rhob* w[0]*( 1. + cub0 + 0.5*(cub0*cub0) - temp0)));
-
-
-            nodes[nidx].fpostcol[0] = nodes[nidx].fpostcol[0] + (nodes[nidx].rhob* w[0])/c2 * eib[0].dot(CstBodyForce);
-            nodes[nidx].f[0]=nodes[nidx].fpostcol[0];
-            RhoTot+=nodes[nidx].rhob;
-            if(nodes[nidx].body_id==-1)if(VmaxC<c*nodes[nidx].velb.norm()) VmaxC=c*nodes[nidx].velb.norm();
-            if(VminC>c*nodes[nidx].velb.norm()) VminC=c*nodes[nidx].velb.norm();
-            if(RhomaxC<Rho*nodes[nidx].rhob)    RhomaxC=Rho*nodes[nidx].rhob;
-            if(RhominC>Rho*nodes[nidx].rhob)    RhominC=Rho*nodes[nidx].rhob;
-            if(!nodes[nidx].isObstacle)         VmeanFluidC+=c*nodes[nidx].velb.norm();
-        }
-
-        #pragma omp parallel for
-        for(unsigned int lid=0;lid<links.size();lid++){
-            int nidx1 = links[lid].nid1;
-            int nidx2 = links[lid].nid2;
-            int dndx1 = links[lid].i;
-            int dndx2 = opp[links[lid].i];
-
-            /*-------------------------------------------------- ---------------*/
-            /* equilibrium functions and collisions                             */
-            /*------------------------------------------------------------------*/
-            Real temp1=1.5*((nodes[nidx1].velb.x()*nodes[nidx1].velb.x())+(nodes[nidx1].velb.y()*nodes[nidx1].velb.y()));
-            Real cub1 = 3.0* eib[dndx1].dot(nodes[nidx1].velb);
-            nodes[nidx1].fpostcol[dndx1] = nodes[nidx1].fprecol[dndx1] - omega * (nodes[nidx1].fprecol[dndx1]-(nodes[nidx1].rhob* w[dndx1]*( 1. + cub1 + 0.5*(cub1*cub1) - temp1)));
-            nodes[nidx1].fpostcol[dndx1] = nodes[nidx1].fpostcol[dndx1] + (nodes[nidx1].rhob* w[dndx1])/c2 * eib[dndx1].dot(CstBodyForce);
-            if(!links[lid].PointingOutside){
-                Real temp2=1.5*((nodes[nidx2].velb.x()*nodes[nidx2].velb.x())+(nodes[nidx2].velb.y()*nodes[nidx2].velb.y()));
-                Real cub2 = 3.0* eib[dndx2].dot(nodes[nidx2].velb);
-                nodes[nidx2].fpostcol[dndx2] = nodes[nidx2].fprecol[dndx2] - omega * (nodes[nidx2].fprecol[dndx2]-(nodes[nidx2].rhob* w[dndx2]*( 1. + cub2 + 0.5*(cub2*cub2) - temp2)));
-                nodes[nidx2].fpostcol[dndx2] = nodes[nidx2].fpostcol[dndx2] + (nodes[nidx2].rhob* w[dndx2])/c2 * eib[dndx2].dot(CstBodyForce);
+            vel /= rho;
+            node.rhob=rho;
+            node.velb=vel;
+
+            /*--------------------------------------------------------------*/
+            /* collision, then push to the downstream node. Populations     */
+            /* coming from outside the lattice or from a skipped node keep  */
+            /* their current value, they are overwritten by the boundary    */
+            /* conditions if needed.                                        */
+            /*--------------------------------------------------------------*/
+            const Real usq=1.5*((vel.x()*vel.x())+(vel.y()*vel.y()));
+            for (int dndx=0; dndx<NbDir; dndx++){
+                const Real cu = 3.0* eib[dndx].dot(vel);
+                const Real fpost = fl[dndx] - omega * (fl[dndx]-(rho* w[dndx]*( 1. + cu + 0.5*(cu*cu) - usq))) + rho*forcing[dndx];
+                if(dndx==0) {fnew[nidx]=fpost; continue;}
+                const int down=nbr[dndx*nn+nidx];
+                if(down!=-1) fnew[dndx*nn+down]=fpost;
+                const int up=nbr[opp[dndx]*nn+nidx];
+                if(up==-1 || (skipSolidNodes && nodes[up].isSolidInterior)) fnew[dndx*nn+nidx]=fl[dndx];
             }
 
-            /*-------------------------------------------------- ---------------*/
-            /* Streaming                                                        */
-            /*------------------------------------------------------------------*/
-            if(links[lid].PointingOutside){
-                /// Periodicity is currently disabled until it is implemented through the link list.
-///FIXME
-                I=nodes[nidx1].i+eib[dndx1].x();
-                J=nodes[nidx1].j+eib[dndx1].y();
-                if(Xperiodicity){ if (I==Nx) {I=0;} else {if (I==-1) { I=Nx-1;}} }
-                if(Yperiodicity){ if (J==Ny) {J=0;} else {if (J==-1) { J=Ny-1;}} }
-            }else{
-                nodes[nidx1].f[dndx2]=nodes[nidx2].fpostcol[dndx2];
-                nodes[nidx2].f[dndx1]=nodes[nidx1].fpostcol[dndx1];
-            }
+            const Real vnorm=c*vel.norm();
+            rhoTot+=rho;
+            if(node.body_id==-1)if(vmax<vnorm) vmax=vnorm;
+            if(vmin>vnorm) vmin=vnorm;
+            if(rhomax<Rho*rho)    rhomax=Rho*rho;
+            if(rhomin>Rho*rho)    rhomin=Rho*rho;
+            if(!node.isObstacle)  vmean+=vnorm;
+        }
+        fdist.swap(fdistNext);
+        newObstacleCells_couter+=newObstacles;
+        newFluidCells_couter+=newFluids;
+        VmaxC=vmax; VminC=vmin; RhomaxC=rhomax; RhominC=rhomin; RhoTot=rhoTot; VmeanFluidC=vmean;
 
-            if(links[lid].isBd==false) continue;
+        /*------------------------------------------------------------------*/
+        /* Boundary links: after streaming, the post-collision population   */
+        /* of the fluid node sits in the solid node and vice versa.         */
+        /* Serial loop: several links contribute to the same body.          */
+        /*------------------------------------------------------------------*/
+        for(unsigned int bl=0;bl<boundaryLinks.size();bl++){
+            LBMlink& link=links[boundaryLinks[bl]];
+            if(link.isBd==false) continue;
 
-            int idx_sigma_i=links[lid].idx_sigma_i;
-            int sid= links[lid].sid;
-            int fid= links[lid].fid;
+            int idx_sigma_i=link.idx_sigma_i;
+            int sid= link.sid;
+            int fid= link.fid;
             int BodyId=nodes[sid].body_id;
-
+            Real& fToSolid=fdist[idx_sigma_i*nn+sid];
+            Real& fToFluid=fdist[opp[idx_sigma_i]*nn+fid];
+            const Real fpostFluid=fToSolid;
+            const Real fpostSolid=fToFluid;
 
             /*--- forces and momenta for this boundary link ---*/
-            links[lid].ct=3.0*w[idx_sigma_i]*nodes[sid].rhob*eib[links[lid].idx_sigma_i].dot(links[lid].VbMid);
-            Vector3r force_ij          = eib[links[lid].idx_sigma_i] * (nodes[fid].fpostcol[idx_sigma_i] - links[lid].ct);
+            link.ct=3.0*w[idx_sigma_i]*nodes[sid].rhob*eib[idx_sigma_i].dot(link.VbMid);
+            Vector3r force_ij          = eib[idx_sigma_i] * (fpostFluid - link.ct);
             Vector3r lubforce_ij       = Vector3r::Zero();
             Vector3r totalforce_ij     = force_ij+lubforce_ij;
-            Vector3r totalmomentum_ij  = links[lid].DistMid.cross(totalforce_ij);
+            Vector3r totalmomentum_ij  = link.DistMid.cross(totalforce_ij);
 
             /* Sum over all boundary links of all boundary nodes  */
             LBbodies[BodyId].force=LBbodies[BodyId].force+totalforce_ij;
@@ -806,11 +884,10 @@ void HydrodynamicsLawLBM::action()
 
             /*------------------------------------------------------*/
             /*              Modified Bounce back rule               */
-            if(nodes[fid].IsolNb>=5) {links[lid].VbMid=Vector3r::Zero();links[lid].ct=0.;}
-            nodes[fid].f[opp[idx_sigma_i]]  = nodes[fid].fpostcol[idx_sigma_i] - 2.0*links[lid].ct;
-            nodes[sid].f[idx_sigma_i]      = nodes[sid].fpostcol[opp[idx_sigma_i]]+ 2.0*links[lid].ct;
-            if( (MODE==2)||((MODE==3)&&(IterMax==1)) ) {links[lid].ReinitDynamicalProperties();}
-
+            if(nodes[fid].IsolNb>=5) {link.VbMid=Vector3r::Zero();link.ct=0.;}
+            fToFluid = fpostFluid - 2.0*link.ct;
+            fToSolid = fpostSolid + 2.0*link.ct;
+            if( (MODE==2)||((MODE==3)&&(IterMax==1)) ) {link.ReinitDynamicalProperties();}
         }
         VmeanFluidC=VmeanFluidC/NbFluidNodes;
 
@@ -971,7 +1048,7 @@ if(applyForcesAndTorques) CalculateAndApplyForcesAndTorquesOnBodies(true,true);
     }
 }
 
-void HydrodynamicsLawLBM::save(int iter_number, Real timestep)
+void HydrodynamicsLawLBM::saveLatticeText(int iter_number)
 {
     
     /*--------------------------------------------*/
@@ -1137,6 +1214,101 @@ void HydrodynamicsLawLBM::save(int iter_number, Real timestep)
     if(SAVE_NODEISNEW) {NewNodefile.close();cmd<<" "<<NewNodefile_name.str().c_str();}
     //cmd<<"&";
     if(COMPRESS_DATA) {if(std::system(cmd.str().c_str())) cerr<<"bzip error"<<endl;}
+}
+
+/*! Copy of the lattice fields of one saved iteration, written by a background thread*/
+struct LbmFrame{
+    int iter, Nx, Ny;
+    Real timestep;
+    vector<std::pair<string,vector<double> > > reals;
+    vector<std::pair<string,vector<int32_t> > > ints;
+};
+
+static void writeLbmFrame(shared_ptr<LbmFrame> frame, string fileName)
+{
+    const int one=1;
+    const bool little=(*(const char*)&one==1);
+    // offsets are counted from the end of the header
+    std::ostringstream header; header.precision(17);
+    header<<"{\"iter\": "<<frame->iter<<", \"timestep\": "<<frame->timestep<<", \"shape\": ["<<frame->Ny<<", "<<frame->Nx<<"], \"byteOrder\": \""<<(little?"little":"big")<<"\", \"fields\": [";
+    size_t offset=0; bool first=true;
+    for(unsigned int f=0;f<frame->reals.size();f++){
+        header<<(first?"":", ")<<"{\"name\": \""<<frame->reals[f].first<<"\", \"dtype\": \"float64\", \"offset\": "<<offset<<"}";
+        offset+=frame->reals[f].second.size()*sizeof(double); first=false;}
+    for(unsigned int f=0;f<frame->ints.size();f++){
+        header<<(first?"":", ")<<"{\"name\": \""<<frame->ints[f].first<<"\", \"dtype\": \"int32\", \"offset\": "<<offset<<"}";
+        offset+=frame->ints[f].second.size()*sizeof(int32_t); first=false;}
+    header<<"]}\n";
+    const string h=header.str();
+    const uint32_t hLen=h.size();
+
+    std::ofstream file(fileName.c_str(),std::ios::out|std::ios::binary|std::ios::trunc);
+    if(!file){cerr<<"Unable to write "<<fileName<<endl; return;}
+    file.write("YADELBM1",8);
+    file.write((const char*)&hLen,sizeof(hLen));
+    file.write(h.data(),hLen);
+    for(unsigned int f=0;f<frame->reals.size();f++) file.write((const char*)frame->reals[f].second.data(),frame->reals[f].second.size()*sizeof(double));
+    for(unsigned int f=0;f<frame->ints.size();f++) file.write((const char*)frame->ints[f].second.data(),frame->ints[f].second.size()*sizeof(int32_t));
+}
+
+void HydrodynamicsLawLBM::waitForSave()
+{
+    if(!saveThread) return;
+    saveThread->join();
+    saveThread.reset();
+}
+
+void HydrodynamicsLawLBM::saveLatticeBinary(int iter_number, Real timestep)
+{
+    if(!(SAVE_VELOCITY||SAVE_VELOCITYCOMP||SAVE_FORCES||SAVE_RHO||SAVE_BODIES||SAVE_NODEBD||SAVE_NODEISNEW)) return;
+    // the previous iteration must be written before its file name can be reused
+    waitForSave();
+    cerr << "| Saving ("<<iter_number<<", binary)"<<endl;
+
+    const int n=Nx*Ny;
+    shared_ptr<LbmFrame> frame(new LbmFrame);
+    frame->iter=iter_number; frame->Nx=Nx; frame->Ny=Ny; frame->timestep=timestep;
+    vector<double> *V=0, *Vx=0, *Vy=0, *Fx=0, *Fy=0, *Mz=0, *Rhof=0;
+    vector<int32_t> *Bodies=0, *NodeBoundary=0, *NewNode=0;
+    // reserve first: pointers to the elements must not be invalidated by later push_back
+    frame->reals.reserve(7); frame->ints.reserve(3);
+    auto addReal=[&](const char* name)->vector<double>* {frame->reals.push_back(std::make_pair(string(name),vector<double>(n))); return &frame->reals.back().second;};
+    auto addInt=[&](const char* name)->vector<int32_t>* {frame->ints.push_back(std::make_pair(string(name),vector<int32_t>(n))); return &frame->ints.back().second;};
+    if(SAVE_VELOCITY) V=addReal("V");
+    if(SAVE_VELOCITYCOMP){Vx=addReal("Vx"); Vy=addReal("Vy");}
+    if(SAVE_FORCES){Fx=addReal("Fx"); Fy=addReal("Fy"); Mz=addReal("Mz");}
+    if(SAVE_RHO) Rhof=addReal("Rho");
+    if(SAVE_BODIES) Bodies=addInt("Bodies");
+    if(SAVE_NODEBD) NodeBoundary=addInt("NodeBoundary");
+    if(SAVE_NODEISNEW) NewNode=addInt("NewNode");
+
+    // same values as the text files, copied in parallel
+    #pragma omp parallel for
+    for (int nidx=0; nidx<n; nidx++){
+        const LBMnode& node=nodes[nidx];
+        if(Bodies) (*Bodies)[nidx]=node.body_id;
+        if(V) (*V)[nidx]=c*node.velb.norm();
+        if(Vx){(*Vx)[nidx]=c*node.velb.x(); (*Vy)[nidx]=c*node.velb.y();}
+        if(Fx){
+            if(node.body_id>=0){
+                (*Fx)[nidx]=2.*Rho*c2*dx*LBbodies[node.body_id].force.x();
+                (*Fy)[nidx]=2.*Rho*c2*dx*LBbodies[node.body_id].force.y();
+                (*Mz)[nidx]=2.*Rho*c2*dx2*LBbodies[node.body_id].momentum.z();
+            } else {(*Fx)[nidx]=0.; (*Fy)[nidx]=0.; (*Mz)[nidx]=0.;}}
+        if(Rhof) (*Rhof)[nidx]=Rho*node.rhob;
+        if(NodeBoundary) (*NodeBoundary)[nidx]=(node.isFluidBoundary ? -1 : (node.isObstacleBoundary ? 1 : 0));
+        if(NewNode) (*NewNode)[nidx]=(node.isNewFluid ? -1 : (node.isNewObstacle ? 1 : 0));
+    }
+
+    std::stringstream fileName;
+    fileName<<lbm_dir<<"/LBM_"; fileName.width(10); fileName.fill('0'); fileName<<iter_number<<".bin";
+    saveThread=shared_ptr<boost::thread>(new boost::thread(boost::bind(writeLbmFrame,frame,fileName.str())));
+}
+
+void HydrodynamicsLawLBM::save(int iter_number, Real timestep)
+{
+    if(SAVE_BINARY) saveLatticeBinary(iter_number,timestep);
+    else saveLatticeText(iter_number);
 
 
     /*--------------------------------------------*/
@@ -1332,6 +1504,50 @@ void HydrodynamicsLawLBM::LbmEnd(){
     Omega::instance().saveSimulation ("end.xml");
 }
 
+void HydrodynamicsLawLBM::addParticleToLattice(int id){
+    /*--- the nodes inside the sphere are covered by the body, the smallest distance between a node and the surface is kept as mapping margin ---*/
+    LBMbody& body=LBbodies[id];
+    Vector3r posMax=body.pos+ Vector3r(body.radius,body.radius,body.radius);
+    Vector3r posMin=body.pos- Vector3r(body.radius,body.radius,body.radius);
+    Real margin=1.;
+    for(int ii=posMin[0]-1;ii<=posMax[0]+1;ii++)
+        for(int jj=posMin[1]-1;jj<=posMax[1]+1;jj++){
+            if((ii<=-1)||(ii>=Nx)||(jj<=-1)||(jj>=Ny)) continue;
+            int nidx=ii+jj*Nx;
+            Real dist=(nodes[nidx].posb-body.pos).norm();
+            margin=min(margin,std::abs(dist-body.radius));
+            if(dist<body.radius){
+                coverCount[nidx]++;
+                particleOwner[nidx]=max(particleOwner[nidx],id);
+                NbParticleNodes++;}
+        }
+    body.mappedPos=body.pos;
+    body.mappedRadius=body.radius;
+    body.mappedMargin=margin;
+}
+
+bool HydrodynamicsLawLBM::removeParticleFromLattice(int id){
+    /*--- returns false if a node owned by the body is still covered by another one (its new owner is unknown) ---*/
+    LBMbody& body=LBbodies[id];
+    bool consistent=true;
+    Vector3r posMax=body.mappedPos+ Vector3r(body.mappedRadius,body.mappedRadius,body.mappedRadius);
+    Vector3r posMin=body.mappedPos- Vector3r(body.mappedRadius,body.mappedRadius,body.mappedRadius);
+    for(int ii=posMin[0]-1;ii<=posMax[0]+1;ii++)
+        for(int jj=posMin[1]-1;jj<=posMax[1]+1;jj++){
+            if((ii<=-1)||(ii>=Nx)||(jj<=-1)||(jj>=Ny)) continue;
+            int nidx=ii+jj*Nx;
+            if((nodes[nidx].posb-body.mappedPos).norm()<body.mappedRadius){
+                coverCount[nidx]--;
+                NbParticleNodes--;
+                if(particleOwner[nidx]==id){
+                    if(coverCount[nidx]>0) consistent=false;
+                    else particleOwner[nidx]=-1;}
+            }
+        }
+    body.mappedMargin=-1.;
+    return consistent;
+}
+
 void HydrodynamicsLawLBM::CalculateAndApplyForcesAndTorquesOnBodies(bool mean,bool apply){
     /*--------------------------------------------------------------------------------*/
     /*---------------- APPLICATION OF HYDRODYNAMIC FORCES ON SPHERES -----------------*/
@@ -28,12 +28,14 @@
 #include<pkg/lbm/LBMlink.hpp>
 #include<pkg/lbm/LBMbody.hpp>
 #include<core/GlobalEngine.hpp>
+#include<boost/thread/thread.hpp>
 
 
 class HydrodynamicsLawLBM : public GlobalEngine
 {
     private :
         std::ofstream ofile;
+        shared_ptr<boost::thread> saveThread;   /*! writes the binary lattice data of the last saved iteration*/
 
     public :
         bool    firstRun,                       /*!  = 1 if it is the first iteration during 1 YADE simulation*/
@@ -50,6 +52,7 @@ class HydrodynamicsLawLBM : public GlobalEngine
                 SAVE_OBSERVEDNODE,              /*! Switch to save properties of the observed node*/
                 SAVE_CONTACTINFO,               /*! Switch to save contact properties*/
 		SAVE_SPHERES,			/*! Switch to save spheres properties*/
+                SAVE_BINARY,                    /*! Switch to save lattice data in binary files written in background*/
                 COMPRESS_DATA,                  /*! Switch to enable file compression*/
                 Xperiodicity,                   /*! Switch to activate lattice periodicity in x direction*/
                 Yperiodicity,                   /*! Switch to activate lattice periodicity in y direction*/
@@ -74,6 +77,7 @@ class HydrodynamicsLawLBM : public GlobalEngine
                 NumberOfDynamicParticles,       /*! Number of dynamic particles*/
                 Ny,                             /*! Number of grid divisions in y direction */
                 Nz,                             /*! Number of grid divisions in z direction */
+                NbMappedParticles,              /*! Number of spheres currently mapped on the lattice*/
                 NumberPtcEroded,                /*! The bumber of eroded/removed particles*/
                 iter,                           /*! LBM Iteration number in current DEM loop (=1 in mode=2)*/
                 IdFirstSphere;                  /*! Id of the first sphere*/
@@ -142,6 +146,16 @@ class HydrodynamicsLawLBM : public GlobalEngine
 
         vector <LBMnode> nodes;                 /*! the LBM nodes*/
         vector <LBMlink> links;                 /*! the LBM links*/
+        vector <int> boundaryLinks;             /*! ids of the links crossing a fluid-solid interface*/
+        vector <int> neighbours;                /*! neighbour of node n in direction d stored at [d*NbNodes+n] (-1 if none)*/
+        vector <int> nodeLinks;                 /*! link of node n in direction d stored at [d*NbNodes+n] (-1 if none)*/
+        vector <Real> fdist;                    /*! distribution functions, direction-major: [d*NbNodes+n]*/
+        vector <Real> fdistNext;                /*! distribution functions being streamed during the current iteration*/
+        vector <int> activeNodes;               /*! nodes swept by the collide-stream kernel*/
+        vector <int> particleOwner;             /*! highest id of the spheres covering a node (-1 if none)*/
+        vector <unsigned short> coverCount;     /*! number of spheres covering a node*/
+        vector <Vector3r> mappedWallPos;        /*! wall positions when the lattice was last fully mapped*/
+        unsigned long mappedBodiesRevision;     /*! revision of the body container when the lattice was last fully mapped*/
        vector <LBMbody> LBbodies;                /*! the LBM bodies*/
 
         vector <Vector3r>   eib;                /*! node velocity directions*/
@@ -152,6 +166,9 @@ class HydrodynamicsLawLBM : public GlobalEngine
         virtual bool isActivated();
         virtual void action();
         void save(int iter_number, Real timestep);
+        void saveLatticeText(int iter_number);
+        void saveLatticeBinary(int iter_number, Real timestep);
+        void waitForSave();
         void saveStats(int iter_number, Real timestep);
         void saveEroded(int iter_number, Real timestep);
         void saveContacts(int iter_number, Real timestep);
@@ -164,6 +181,8 @@ class HydrodynamicsLawLBM : public GlobalEngine
         void modeTransition();
         void LbmEnd();
         void CalculateAndApplyForcesAndTorquesOnBodies(bool mean,bool apply);
+        void addParticleToLattice(int id);
+        bool removeParticleFromLattice(int id);
 
 	YADE_CLASS_BASE_DOC_ATTRS_CTOR(HydrodynamicsLawLBM,GlobalEngine,"Engine to simulate fluid flow (with the lattice Boltzmann method) with a coupling with the discrete element method.\n If you use this Engine, please cite and refer to F. Lominé et al. International Journal For Numerical and Analytical Method in Geomechanics, 2012, doi: 10.1002/nag.1109",
 
@@ -226,7 +245,7 @@ class HydrodynamicsLawLBM : public GlobalEngine
 				((int,ObservedPtc,-1,,"The identifier of the particle that will be observed (-1 means the first one)"))
 				((Real,RadFactor,1.0,,"The radius of DEM particules seen by the LBM is the real radius of particules*RadFactor"))
 				((Real,ConvergenceThreshold,0.000001,,""))
-				((std::string,LBMSavedData," ",,"a list of data that will be saved. Can use velocity,velXY,forces,rho,bodies,nodeBD,newNode,observedptc,observednode,contacts,spheres,bz2"))
+				((std::string,LBMSavedData," ",,"a list of data that will be saved. Can use velocity,velXY,forces,rho,bodies,nodeBD,newNode,observedptc,observednode,contacts,spheres,bz2,binary. With binary, the lattice fields of each saved iteration are copied and written by a background thread in a single file lbm-nodes/LBM_<iter>.bin: the 8 bytes ``YADELBM1``, the length of the header as a 32 bits unsigned integer, a JSON header (lattice shape, iteration, time step, byte order and, for each field, its name, dtype and offset after the header), then the raw fields in the same row order as the text files (bz2 does not apply to them)."))
 				((std::string,periodicity," ",,"periodicity"))
 				((std::string,bc," ",,"Boundary condition"))
                 ((std::string,model,"d2q9",,"The LB model. Until now only d2q9 is implemented"))
@@ -235,6 +254,8 @@ class HydrodynamicsLawLBM : public GlobalEngine
 				((Real,EndTime,-1,,"the time to stop the simulation"))
                 ((Vector3r,CstBodyForce,Vector3r::Zero(),,"A constant body force (=that does not vary in time or space, otherwise the implementation introduces errors)"))
 				((Real,VbCutOff,-1,,"the minimum boundary velocity that is taken into account"))
+				((bool,incrementalObstacles,false,,"Only map again on the lattice the spheres which moved far enough to change the status of a node since they were last mapped. A full mapping is done when walls move, when bodies are inserted or erased or when a node is left covered by overlapping spheres."))
+				((bool,skipSolidNodes,false,,"Do not compute nodes having no fluid neighbour (inside particles and walls), their distributions are frozen and populations they would stream to their neighbours are replaced by the current ones of the receiving node. Uncovered nodes are restarted from the equilibrium distribution of their neighbours. Skipped nodes inside particles are not counted as fluid nodes, and skipped nodes are left out of the lattice statistics (mean fluid velocity, total density, minimum and maximum velocity and density), which are therefore not the same as with the dense kernel. Memory is still allocated for the whole lattice."))
                                 ,
     			firstRun  = true;
     			omega = 1.0/tau;
@@ -249,6 +270,8 @@ class HydrodynamicsLawLBM : public GlobalEngine
     			NbFluidNodes=0;
     			NbSolidNodes=0;
     			NbParticleNodes=0;
+    			NbMappedParticles=0;
+    			mappedBodiesRevision=0;
     			NbContacts=0;
     			InitialNumberOfDynamicParticles=0;
     			NumberOfDynamicParticles=0;
@@ -280,6 +303,7 @@ class HydrodynamicsLawLBM : public GlobalEngine
     			SAVE_OBSERVEDNODE=false;
     			SAVE_CONTACTINFO =false;
 			SAVE_SPHERES    = false;  //to save spheres_* files only if it is required by the operator
+    			SAVE_BINARY     = false;
     			Xperiodicity    = false;
     			Yperiodicity    = false;
     			Zperiodicity    = false;
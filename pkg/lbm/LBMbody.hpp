@@ -38,6 +38,9 @@ class LBMbody:  public Serializable{
         ((bool,isEroded,false,,"Hydrodynamical force on body"))
         ((bool,saveProperties,false,,"To save properties of the body"))
         ((short int,type,-1,," "))
+        ((Vector3r,mappedPos,Vector3r::Zero(),,"Position (LB unit) at which the body was last mapped on the lattice"))
+        ((Real,mappedRadius,-1000.,,"Radius (LB unit) with which the body was last mapped on the lattice"))
+        ((Real,mappedMargin,-1.,,"Smallest distance between a node and the surface of the body when it was mapped, the body is mapped again when it moves further (negative: not mapped)"))
         ,
         );
 };
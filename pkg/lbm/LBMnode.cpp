@@ -17,7 +17,7 @@ LBMnode::~LBMnode(){};
 
 
 
-void LBMnode::MixteBC(string lbmodel,Real density, Vector3r U, string where){
+void LBMnode::MixteBC(string lbmodel,Real density, Vector3r U, string where, Real* f){
     Real rhoVx=density*U.x();
     Real rhoVy=density*U.y();
     if(!strcmp(lbmodel.c_str(), "d2q9" )){
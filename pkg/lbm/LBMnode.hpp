@@ -22,6 +22,7 @@ class LBMnode: public Serializable{
 
         short int IsolNb;               /*! number of boundary links of a fluid boundary nodes*/
 
+        /* distributions are stored by HydrodynamicsLawLBM (structure of arrays); flags stay plain bools, nodes are read by neighbours while their own flags are written in parallel loops */
         bool
                 isObstacle,             /*! the node belongs to an obstacle  */
                 isObstacleBoundary,     /*! the node is an obstacle boundary  */
@@ -39,22 +40,19 @@ class LBMnode: public Serializable{
                 applyYmXmBC,            /*! the node is subject to the bottom-left boundary condition */
                 applyYpXmBC,            /*! the node is subject to the top-left boundary condition */
                 applyYmXpBC,            /*! the node is subject to the bottom-right boundary condition */
-                applyYpXpBC;            /*! the node is subject to the top-right boundary condition */
+                applyYpXpBC,            /*! the node is subject to the top-right boundary condition */
+                isSolidInterior,        /*! the node is an obstacle without any fluid neighbour, it is not computed */
+                wasSolidInterior;       /*! the node was an obstacle without any fluid neighbour */
 
         Vector3r    posb,               /*! the node position  */
                     velb;               /*! the node velocity  */
 
-        Real rhob;                      /*! the node density  */                    /*! the node density  */
-        vector<int> neighbour_id;       /*! list of adjacent nodes  */
-        vector<int> links_id;            /*! list of links  */
-        vector<Real> f;
-        vector<Real> fprecol;
-        vector<Real> fpostcol;
+        Real rhob;                      /*! the node density  */
 
         void DispatchBoundaryConditions(int SizeNx,int SizeNy,int SizeNz);
         bool checkIsNewFluid();
         bool checkIsNewObstacle();
-        void MixteBC(string lbmodel,Real density, Vector3r U, string where);
+        void MixteBC(string lbmodel,Real density, Vector3r U, string where, Real* f);
         void SetCellIndexesAndPosition(int indI, int indJ, int indK);
         void setAsObstacle(){isObstacle=true;}
         void setAsFluid(){isObstacle=false;}
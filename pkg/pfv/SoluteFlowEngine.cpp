@@ -14,15 +14,21 @@
 #include "FlowEngine_SoluteFlowEngineT.hpp"
 
 #include <Eigen/Sparse>
+#include <Eigen/IterativeLinearSolvers>
 
 class SoluteCellInfo : public FlowCellInfo_SoluteFlowEngineT
 {	
 	public:
 	Real solute_concentration;
+	std::vector<Real> extraSolutes;//concentrations of species 1..n-1 when more than one solute is transported, species 0 is solute_concentration
 	SoluteCellInfo (void) : FlowCellInfo_SoluteFlowEngineT() {solute_concentration=0;}
 	inline Real& solute (void) {return solute_concentration;}
 	inline const Real& solute (void) const {return solute_concentration;}
-	inline void getInfo (const SoluteCellInfo& otherCellInfo) {FlowCellInfo_SoluteFlowEngineT::getInfo(otherCellInfo); solute()=otherCellInfo.solute();}
+	inline Real& solute (unsigned int species) {
+		if (species==0) return solute_concentration;
+		if (extraSolutes.size()<species) extraSolutes.resize(species,0);
+		return extraSolutes[species-1];}
+	inline void getInfo (const SoluteCellInfo& otherCellInfo) {FlowCellInfo_SoluteFlowEngineT::getInfo(otherCellInfo); solute()=otherCellInfo.solute(); extraSolutes=otherCellInfo.extraSolutes;}
 };
 
 typedef TemplateFlowEngine_SoluteFlowEngineT<SoluteCellInfo,FlowVertexInfo_SoluteFlowEngineT> SoluteFlowEngineT;
@@ -31,29 +37,51 @@ YADE_PLUGIN((SoluteFlowEngineT));
 
 class SoluteFlowEngine : public SoluteFlowEngineT
 {
+	private:
+		//the advection-diffusion operator is kept between calls, it is factorized (direct solver) or preconditioned (iterative solver) only when the mesh or dt change
+		typedef Eigen::SparseMatrix<double, Eigen::RowMajor> SoluteMatrix;//row-major for multithreaded products in the iterative solver
+		SoluteMatrix soluteMatrix;
+		Eigen::SparseLU<Eigen::SparseMatrix<double,Eigen::ColMajor>,Eigen::COLAMDOrdering<int> > soluteLU;
+		Eigen::BiCGSTAB<SoluteMatrix, Eigen::IncompleteLUT<double> > soluteIterative;
+		bool soluteMatrixOutdated;
+		const FlowSolver* soluteMatrixSolver;//the solver (hence mesh) for which the matrix was assembled
+		double soluteMatrixDt;//the timestep for which the matrix was assembled
+		int soluteMatrixSolverType;
+		double soluteStableDt;//stable timestep found during the last assembly
+		void assembleSoluteMatrix(double deltatime);
 	public :
 		void initializeSoluteTransport();
 		void soluteTransport ();
-		double getConcentration(unsigned int id){return solver->T[solver->currentTes].cellHandles[id]->info().solute();	}
-		double insertConcentration(unsigned int id,double conc){
-			solver->T[solver->currentTes].cellHandles[id]->info().solute() = conc;
+		//any retriangulation invalidates the operator
+		void trickPermeability(Solver* flow) {soluteMatrixOutdated=true;}
+		void resetSoluteMatrix() {soluteMatrixOutdated=true;}
+		double getConcentration(unsigned int id, unsigned int species){return solver->T[solver->currentTes].cellHandles[id]->info().solute(species);	}
+		double insertConcentration(unsigned int id,double conc, unsigned int species){
+			solver->T[solver->currentTes].cellHandles[id]->info().solute(species) = conc;
 			return conc;}
-		void soluteBC(unsigned int bc_id1, unsigned int bc_id2, double bc_concentration1, double bc_concentration2,unsigned int s);
-		double getConcentrationPlane (double Yobs,double Yr, int xyz);
-                double getAverageConcentration();
+		void soluteBC(unsigned int bc_id1, unsigned int bc_id2, double bc_concentration1, double bc_concentration2,unsigned int s, unsigned int species);
+		double getConcentrationPlane (double Yobs,double Yr, int xyz, unsigned int species);
+                double getAverageConcentration(unsigned int species);
 		///Elaborate the description as you wish
 		YADE_CLASS_BASE_DOC_ATTRS_INIT_CTOR_PY(SoluteFlowEngine,SoluteFlowEngineT,"A variant of :yref:`FlowEngine` with solute transport).",
 		///No additional variable yet, else input here
 // 		((Vector3r, gradP, Vector3r::Zero(),,"Macroscopic pressure gradient"))
                 ((double,DiffusionCoefficient,0,,"Diffusion coefficient for molecular diffusion"))
-		,,,
+		((unsigned int,numberOfSolutes,1,,"Number of solute species transported simultaneously by :yref:`SoluteFlowEngine::soluteTransport`, they share the same advection-diffusion operator and are solved as multiple right-hand sides."))
+		((int,soluteSolver,0,,"Linear solver used by :yref:`SoluteFlowEngine::soluteTransport`. 0: direct sparse LU; 1: BiCGSTAB with incomplete LU preconditioning, warm-started from the current concentrations and multithreaded by Eigen (faster on large meshes)."))
+		((bool,reuseSoluteMatrix,false,,"If true the advection-diffusion operator is assembled and factorized once per triangulation and timestep, else at every call of :yref:`SoluteFlowEngine::soluteTransport`. The operator depends on the fluxes, which are not tracked: only enable it if pressure does not change significantly between two triangulations, or call :yref:`SoluteFlowEngine::resetSoluteMatrix` when it does. The stable timestep is only updated when the operator is assembled."))
+		((double,soluteTolerance,1e-10,,"Tolerance of the iterative solver (:yref:`SoluteFlowEngine::soluteSolver` =1)"))
+		,,
+		soluteMatrixOutdated=true; soluteMatrixSolver=NULL; soluteMatrixDt=0; soluteMatrixSolverType=-1; soluteStableDt=1e9;
+		,
 		.def("soluteTransport",&SoluteFlowEngine::soluteTransport,"Solute transport (advection and diffusion) engine for diffusion use a diffusion coefficient (D) other than 0.")
-		.def("getConcentration",&SoluteFlowEngine::getConcentration,(boost::python::arg("id")),"get concentration of pore with ID")
-		.def("insertConcentration",&SoluteFlowEngine::insertConcentration,(boost::python::arg("id"),boost::python::arg("conc")),"Insert Concentration (ID, Concentration)")
-		.def("solute_BC",&SoluteFlowEngine::soluteBC,(boost::python::arg("bc_id1"),boost::python::arg("bc_id2"),boost::python::arg("bc_concentration1"),boost::python::arg("bc_concentration2"),boost::python::arg("s")),"Enter X,Y,Z for concentration observation'.")
+		.def("resetSoluteMatrix",&SoluteFlowEngine::resetSoluteMatrix,"Force the assembly and factorization of the advection-diffusion operator at the next call of soluteTransport (see :yref:`SoluteFlowEngine::reuseSoluteMatrix`)")
+		.def("getConcentration",&SoluteFlowEngine::getConcentration,(boost::python::arg("id"),boost::python::arg("species")=0),"get concentration of pore with ID")
+		.def("insertConcentration",&SoluteFlowEngine::insertConcentration,(boost::python::arg("id"),boost::python::arg("conc"),boost::python::arg("species")=0),"Insert Concentration (ID, Concentration)")
+		.def("solute_BC",&SoluteFlowEngine::soluteBC,(boost::python::arg("bc_id1"),boost::python::arg("bc_id2"),boost::python::arg("bc_concentration1"),boost::python::arg("bc_concentration2"),boost::python::arg("s"),boost::python::arg("species")=0),"Enter X,Y,Z for concentration observation'.")
                 .def("initializeSoluteTransport",&SoluteFlowEngine::initializeSoluteTransport,"Initialize Solute Transport")
-                .def("getConcentrationPlane",&SoluteFlowEngine::getConcentrationPlane,(boost::python::arg("Yobs"),boost::python::arg("Yr"),boost::python::arg("xyz")),"get concentration of pore with ID")
-                .def("getAverageConcentration",&SoluteFlowEngine::getAverageConcentration,"The the volume averaged concentration")
+                .def("getConcentrationPlane",&SoluteFlowEngine::getConcentrationPlane,(boost::python::arg("Yobs"),boost::python::arg("Yr"),boost::python::arg("xyz"),boost::python::arg("species")=0),"get concentration of pore with ID")
+                .def("getAverageConcentration",&SoluteFlowEngine::getAverageConcentration,(boost::python::arg("species")=0),"The the volume averaged concentration")
 
 		)
 };
@@ -67,17 +95,13 @@ void SoluteFlowEngine::initializeSoluteTransport ()
     FOREACH(CellHandle& cell, solver->T[solver->currentTes].cellHandles)
     {
 	 cell->info().solute() = 0.0;
+	 cell->info().extraSolutes.assign(numberOfSolutes>0 ? numberOfSolutes-1 : 0, 0.0);
     }
+    soluteMatrixOutdated=true;
 }
 
-
-void SoluteFlowEngine::soluteTransport ()
-{       
-        double deltatime = scene->dt;
-	//soluteTransport is a function to solve transport of solutes for advection (+diffusion).
-	//Call this function with a pyRunner in the python script, implement a diffusion coefficient and a dt.
-	//Optimalization has to be done such that the coefficient matrix is not solved for each time step,only after triangulation.
-	//Extensive testing has to be done to check its ability to simulate a deforming porous media.
+void SoluteFlowEngine::assembleSoluteMatrix (double deltatime)
+{
 	double coeff = 0.00;    //Ratio of dt and void volume   
 	double coeff1 = 0.00;	//Coefficient for off-diagonal element
 	double coeff2 = 0.00;   //Coefficient for diagonal element
@@ -87,20 +111,10 @@ void SoluteFlowEngine::soluteTransport ()
 	double invdistance = 0.0;	//Fluid facet area divided by pore throat length for each pore throat
 	double invdistancelocal = 0.0;  //Sum of invdistance
 	
-	
-	//Set vectors & matrix
 	int ncells=solver->T[solver->currentTes].cellHandles.size();
-	Eigen::SparseMatrix<double, Eigen::ColMajor> Aconc(ncells,ncells);
 	typedef Eigen::Triplet<double> ETriplet2;
 	std::vector<ETriplet2> tripletList2;
-	Eigen::SparseLU<Eigen::SparseMatrix<double,Eigen::ColMajor>,Eigen::COLAMDOrdering<int> > eSolver2;	
-	// Prepare (copy) concentration vector
-	Eigen::VectorXd eb2(ncells); Eigen::VectorXd ex2(ncells);
-	FOREACH(CellHandle& cell, solver->T[solver->currentTes].cellHandles){
-	  eb2[cell->info().id]=cell->info().solute();
-	}
-	
-	
+	tripletList2.reserve(5*ncells);
 	
 	// Fill coefficient matrix
 	FOREACH(CellHandle& cell, solver->T[solver->currentTes].cellHandles){
@@ -130,28 +144,60 @@ void SoluteFlowEngine::soluteTransport ()
                 invdistancelocal = 0.0;
                 invdistance = 0.0;
 	}   
+	soluteMatrix.resize(ncells,ncells);
+	soluteMatrix.setFromTriplets(tripletList2.begin(), tripletList2.end());
+	if (soluteSolver==1) {
+		soluteIterative.setTolerance(soluteTolerance);
+		soluteIterative.compute(soluteMatrix);
+	} else {
+		//if (soluteLU.signDeterminant() < 1){cerr << "determinant is negative!!!!!!! " << soluteLU.signDeterminant()<<endl;}
+		//soluteLU.setPivotThreshold(10e-8);
+		Eigen::SparseMatrix<double,Eigen::ColMajor> Aconc = soluteMatrix;
+		soluteLU.analyzePattern(Aconc);
+		soluteLU.factorize(Aconc);
+	}
+	soluteStableDt = dt;
+	soluteMatrixDt = deltatime;
+	soluteMatrixSolver = solver.get();
+	soluteMatrixSolverType = soluteSolver;
+	soluteMatrixOutdated = false;
+}
+
+void SoluteFlowEngine::soluteTransport ()
+{       
+        double deltatime = scene->dt;
+	//soluteTransport is a function to solve transport of solutes for advection (+diffusion).
+	//Call this function with a pyRunner in the python script, implement a diffusion coefficient and a dt.
+	//The coefficient matrix is factorized only after triangulation or when dt changes (unless reuseSoluteMatrix=False), all species are solved with the same factorization.
+	//Extensive testing has to be done to check its ability to simulate a deforming porous media.
+	const bool assembled = !reuseSoluteMatrix || soluteMatrixOutdated || soluteMatrixSolver!=solver.get() || soluteMatrixDt!=deltatime || soluteMatrixSolverType!=soluteSolver;
+	if (assembled) assembleSoluteMatrix(deltatime);
+	
+	// Prepare (copy) concentration vectors, one column per species
+	const int ncells=solver->T[solver->currentTes].cellHandles.size();
+	const unsigned int nSpecies = std::max(numberOfSolutes,1u);
+	Eigen::MatrixXd eb2(ncells,nSpecies); Eigen::MatrixXd ex2(ncells,nSpecies);
+	FOREACH(CellHandle& cell, solver->T[solver->currentTes].cellHandles){
+		for (unsigned int k=0; k<nSpecies; k++) eb2(cell->info().id,k)=cell->info().solute(k);
+	}
 	
         //Solve Matrix
-	Aconc.setFromTriplets(tripletList2.begin(), tripletList2.end());
-	//if (eSolver2.signDeterminant() < 1){cerr << "determinant is negative!!!!!!! " << eSolver2.signDeterminant()<<endl;}
-	//eSolver2.setPivotThreshold(10e-8);
-        eSolver2.analyzePattern(Aconc); 						
-        eSolver2.factorize(Aconc); 		
-        eSolver2.compute(Aconc);
-        ex2 = eSolver2.solve(eb2);
-
+	if (soluteSolver==1) {
+		for (unsigned int k=0; k<nSpecies; k++) {
+			ex2.col(k) = soluteIterative.solveWithGuess(eb2.col(k),eb2.col(k));
+			if (soluteIterative.info()!=Eigen::Success) LOG_WARN("BiCGSTAB did not converge for species "<<k<<" (error "<<soluteIterative.error()<<" after "<<soluteIterative.iterations()<<" iterations)");}
+	} else ex2 = soluteLU.solve(eb2);
 	    
         //Copy data to concentration array
-
         FOREACH(CellHandle& cell, solver->T[solver->currentTes].cellHandles){
-		cell->info().solute()= ex2[cell->info().id];
+		for (unsigned int k=0; k<nSpecies; k++) cell->info().solute(k)= ex2(cell->info().id,k);
         }
-        tripletList2.clear();
-        if(dt != 1e9){scene->dt = dt;}
+        //the stable timestep depends on the fluxes, a cached operator does not say anything about the current ones
+        if(assembled && soluteStableDt != 1e9){scene->dt = soluteStableDt;}
 	    
   }
 
-void SoluteFlowEngine::soluteBC(unsigned int bcid1, unsigned int bcid2, double bcconcentration1, double bcconcentration2, unsigned int s)
+void SoluteFlowEngine::soluteBC(unsigned int bcid1, unsigned int bcid2, double bcconcentration1, double bcconcentration2, unsigned int s, unsigned int species)
 {
 	//Boundary conditions according to soluteTransport.
 	//It simply assigns boundary concentrations to cells with a common vertices (e.g. infinite large sphere which makes up the boundary condition in flowEngine)
@@ -160,13 +206,13 @@ void SoluteFlowEngine::soluteBC(unsigned int bcid1, unsigned int bcid2, double b
     	FOREACH(CellHandle& cell, solver->T[solver->currentTes].cellHandles)
 	{
 		for (unsigned int ngb=0;ngb<4;ngb++){ 
-			if (cell->vertex(ngb)->info().id() == bcid1){cell->info().solute() = bcconcentration1;}
-			if (s > 0){if (cell->vertex(ngb)->info().id() == bcid2){cell->info().solute() = bcconcentration2;}}
+			if (cell->vertex(ngb)->info().id() == bcid1){cell->info().solute(species) = bcconcentration1;}
+			if (s > 0){if (cell->vertex(ngb)->info().id() == bcid2){cell->info().solute(species) = bcconcentration2;}}
 		}
 	}
 }
 
-double SoluteFlowEngine::getConcentrationPlane (double Yobs,double Yr, int xyz)
+double SoluteFlowEngine::getConcentrationPlane (double Yobs,double Yr, int xyz, unsigned int species)
 {
 	//Get the concentration within a certain plane (Y_obs), whilst the cells are located in a small volume around this plane
 	//The concentration in cells are weighed for their distance to the observation point
@@ -181,7 +227,7 @@ double SoluteFlowEngine::getConcentrationPlane (double Yobs,double Yr, int xyz)
             CGT::Point& p1 = cell->info();
             if (std::abs(p1[xyz]) < std::abs(std::abs(Yobs) + std::abs(Yr))){
                 if(std::abs(p1[xyz]) > std::abs(std::abs(Yobs) - std::abs(Yr))){
-                    sumConcentration += cell->info().solute()*(1-(std::abs(p1[xyz])-std::abs(Yobs))/std::abs(Yr));
+                    sumConcentration += cell->info().solute(species)*(1-(std::abs(p1[xyz])-std::abs(Yobs))/std::abs(Yr));
                     sumFraction += (1-(std::abs(p1[xyz])-std::abs(Yobs))/std::abs(Yr));
                 }
             }
@@ -191,14 +237,14 @@ double SoluteFlowEngine::getConcentrationPlane (double Yobs,double Yr, int xyz)
 }
 
 
-double SoluteFlowEngine::getAverageConcentration()
+double SoluteFlowEngine::getAverageConcentration(unsigned int species)
 {
         //Get volume-averaged concentration
         double summConc = 0.0, summVol = 0.0;
 	FOREACH(CellHandle& cell, solver->T[solver->currentTes].cellHandles)
 	{
             if(!cell->info().isFictious){
-                summConc += cell->info().solute() * (std::abs(cell->info().volume()) - std::abs(solver->volumeSolidPore(cell) ));
+                summConc += cell->info().solute(species) * (std::abs(cell->info().volume()) - std::abs(solver->volumeSolidPore(cell) ));
                 summVol += (std::abs(cell->info().volume()) - std::abs(solver->volumeSolidPore(cell) ));
             }
 	}
@@ -10,6 +10,7 @@
 #ifdef TWOPHASEFLOW
 #include "TwoPhaseFlowEngine.hpp"
 #include <boost/range/algorithm_ext/erase.hpp>
+#include <queue>
 
 YADE_PLUGIN((TwoPhaseFlowEngineT));
 YADE_PLUGIN((TwoPhaseFlowEngine));
@@ -3221,6 +3222,139 @@ double TwoPhaseFlowEngine::getMaxImbibitionPc()
     else return nextEntry;
 }
 
+///union-find over cell ids for trapped clusters detection in invasionPercolation(), without path compression so that the merging history is preserved
+struct InvasionUnionFind {
+	vector<int> parent, rank;
+	vector<int> trapEvent;//index of the invasion event which disconnected the cluster rooted here from its reservoir (-1 if none)
+	vector<bool> connected;//at roots: is the cluster connected to the reservoir
+	InvasionUnionFind(int n) : parent(n,-1), rank(n,0), trapEvent(n,-1), connected(n,false) {}
+	bool contains(int i) const {return parent[i]>=0;}
+	void insert(int i) {parent[i]=i;}
+	int find(int i) const {while (parent[i]!=i) i=parent[i]; return i;}
+	void unite(int a, int b, int event) {
+		a=find(a); b=find(b);
+		if (a==b) return;
+		if (connected[a]!=connected[b]) {//a trapped cluster is reconnected (backward in time), it was disconnected by event
+			if (connected[a]) std::swap(a,b);
+			trapEvent[a]=event; parent[a]=b; return;}
+		if (rank[a]<rank[b]) std::swap(a,b);
+		parent[b]=a;
+		if (rank[a]==rank[b]) rank[a]++;
+	}
+	int trappedBy(int i) const {//the first trapping event met on the way to the root
+		while (trapEvent[i]<0 && parent[i]!=i) i=parent[i];
+		return trapEvent[i];}
+};
+
+boost::python::list TwoPhaseFlowEngine::invasionPercolation(double pc, bool drainage)
+{
+	boost::python::list curve;
+	updatePressure();
+	RTriangulation& tri = solver->T[solver->currentTes].Triangulation();
+	vector<CellHandle>& cells = solver->T[solver->currentTes].cellHandles;
+	const int nCells = cells.size();
+	//in drainage NW invades W through max(entry pc of throat, entry pc of pore body), in imbibition W invades NW through the min of them, sign makes both a min-heap
+	const double sign = drainage ? 1 : -1;
+	const int reservoir = drainage ? 2 : 3;//the boundary of the phase which is displaced, for trapping
+	std::vector<bool> isReservoirCell(nCells,false);
+	for (FlowSolver::VCellIterator it = solver->boundingCells[reservoir].begin(); it != solver->boundingCells[reservoir].end(); it++)
+		if ((*it)!=NULL) isReservoirCell[(*it)->info().id]=true;
+	std::vector<bool> invaded(nCells,false);
+	std::vector<bool> displaced(nCells,false);//cells initially filled with the displaced phase and connected to its reservoir
+	for (int i=0; i<nCells; i++) displaced[i] = !cells[i]->info().Pcondition && (drainage ? cells[i]->info().isWRes : cells[i]->info().isNWRes);
+
+	typedef std::pair<double,int> Entry;//(sign*entry pc, target cell)
+	std::priority_queue<Entry, vector<Entry>, std::greater<Entry> > front;
+	auto pushThroats = [&](const CellHandle& cell) {
+		for (int facet=0; facet<4; facet++) {
+			const CellHandle& nCell = cell->neighbor(facet);
+			if (tri.is_infinite(nCell)) continue;
+			const int id = nCell->info().id;
+			if (!displaced[id] || invaded[id] || cell->info().poreThroatRadius[facet]<=0) continue;
+			const double pcThroat = surfaceTension/cell->info().poreThroatRadius[facet];
+			const double pcBody = surfaceTension/nCell->info().poreBodyRadius;
+			front.push(Entry(sign*(drainage ? std::max(pcThroat,pcBody) : std::min(pcThroat,pcBody)), id));}
+	};
+	for (int i=0; i<nCells; i++)
+		if (drainage ? cells[i]->info().isNWRes : cells[i]->info().isWRes) pushThroats(cells[i]);
+
+	//invasion order ignoring trapping, with the (signed) entry pressure of each event
+	vector<Entry> events;
+	while (!front.empty() && front.top().first<=sign*pc) {
+		const Entry e = front.top(); front.pop();
+		if (invaded[e.second]) continue;
+		invaded[e.second]=true;
+		events.push_back(Entry(e.first,e.second));
+		pushThroats(cells[e.second]);
+	}
+
+	//trapping: rebuild the displaced phase backward in time, an event is valid only if the invaded cell was still connected to the reservoir
+	std::vector<bool> valid(events.size(),true);
+	std::vector<bool> trapped(nCells,false);
+	InvasionUnionFind uf(nCells+1);
+	const int res = nCells;
+	uf.insert(res); uf.connected[res]=true;
+	if (isPhaseTrapped) {
+		auto addCell = [&](int id, int event) {
+			uf.insert(id);
+			const CellHandle& cell = cells[id];
+			for (int facet=0; facet<4; facet++) {
+				const CellHandle& nCell = cell->neighbor(facet);
+				if (tri.is_infinite(nCell)) continue;
+				const int nId = nCell->info().id;
+				if (isReservoirCell[nId]) uf.unite(id,res,event);
+				else if (uf.contains(nId)) uf.unite(id,nId,event);}
+		};
+		//final state, the merging order is arbitrary here and does not define trapping events (hence -1)
+		for (int i=0; i<nCells; i++) if (displaced[i] && !invaded[i]) addCell(i,-1);
+		for (int i=0; i<nCells; i++) if (displaced[i] && !invaded[i]) trapped[i] = (uf.find(i)!=uf.find(res));
+		for (int k=events.size()-1; k>=0; k--) {
+			addCell(events[k].second,k);
+			valid[k] = (uf.find(events[k].second)==uf.find(res));}
+	}
+	//capillary pressure at each event: running max (min in imbibition) of the entry pressures of the events which really invade, trapped ones are skipped
+	vector<double> eventPc(events.size());
+	double currentPc = -std::numeric_limits<double>::infinity();
+	for (unsigned k=0; k<events.size(); k++) {
+		if (valid[k]) currentPc = std::max(currentPc,events[k].first);
+		eventPc[k] = sign*currentPc;}
+
+	//apply valid events and record the (pc, saturation) curve
+	double poresVolume = 0, wVolume = 0;
+	for (int i=0; i<nCells; i++) {
+		const CellHandle& cell = cells[i];
+		if (cell->info().Pcondition || cell->info().isFictious) continue;
+		poresVolume += cell->info().poreBodyVolume;
+		wVolume += cell->info().poreBodyVolume*cell->info().saturation;}
+	int last = -1;//last valid event
+	for (unsigned k=0; k<events.size(); k++) {
+		if (!valid[k]) {trapped[events[k].second]=true; continue;}
+		if (last>=0 && eventPc[k]!=eventPc[last]) curve.append(boost::python::make_tuple(eventPc[last],wVolume/poresVolume));
+		last = k;
+		TwoPhaseCellInfo& info = cells[events[k].second]->info();
+		const double newSaturation = drainage ? 0 : 1;
+		if (!info.isFictious) wVolume += info.poreBodyVolume*(newSaturation-info.saturation);
+		info.saturation = newSaturation;
+		info.isNWRes = drainage; info.isWRes = !drainage;
+		info.hasInterface = false;
+	}
+	if (last>=0) curve.append(boost::python::make_tuple(eventPc[last],wVolume/poresVolume));
+
+	//cells of the displaced phase disconnected from their reservoir are now trapped
+	for (int i=0; i<nCells; i++) {
+		if (!trapped[i]) continue;
+		TwoPhaseCellInfo& info = cells[i]->info();
+		const int trapEvent = uf.trappedBy(i);
+		info.trapCapP = trapEvent<0 ? pc : eventPc[trapEvent];
+		if (drainage) {info.isWRes = false; info.isTrapW = true;}
+		else {info.isNWRes = false; info.isTrapNW = true;}
+	}
+	bndCondValue[3] = bndCondValue[2]+pc;
+	updatePressure();
+	if (isCellLabelActivated) updateCellLabel();
+	return curve;
+}
+
 double TwoPhaseFlowEngine::getSaturation(bool isSideBoundaryIncluded)
 {
     if( (!isInvadeBoundary) && (isSideBoundaryIncluded)) cerr<<"In isInvadeBoundary=false drainage, isSideBoundaryIncluded can't set true."<<endl;
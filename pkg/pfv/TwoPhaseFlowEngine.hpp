@@ -282,6 +282,7 @@ class TwoPhaseFlowEngine : public TwoPhaseFlowEngineT
 	void updateReservoirLabel();
 	void invasion2();//without-trap
 	void updateReservoirs2();
+	boost::python::list invasionPercolation(double pc, bool drainage);//event-driven invasion up to capillary pressure pc, using a heap of entry pressures instead of repeated scans, returns the (pc,saturation) curve
 	///end of invasion model
 	
 	//## Clusters ##
@@ -590,6 +591,7 @@ class TwoPhaseFlowEngine : public TwoPhaseFlowEngineT
 	.def("getMaxImbibitionPc",&TwoPhaseFlowEngine::getMaxImbibitionPc,"Get the maximum entry capillary pressure for the next imbibition step.")
 	.def("getSaturation",&TwoPhaseFlowEngine::getSaturation,(boost::python::arg("isSideBoundaryIncluded")),"Get saturation of entire packing. If isSideBoundaryIncluded=false (default), the pores of side boundary are excluded in saturation calculating; if isSideBoundaryIncluded=true (only in isInvadeBoundary=true drainage mode), the pores of side boundary are included in saturation calculating.")
 	.def("invasion",&TwoPhaseFlowEngine::invasion,"Run the drainage invasion.")
+	.def("invasionPercolation",&TwoPhaseFlowEngine::invasionPercolation,(boost::python::arg("pc"),boost::python::arg("drainage")=true),"Quasi-static invasion up to capillary pressure *pc* in a single call. Throats on the invasion front are kept in a heap sorted by entry pressure and invaded one at a time, trapping (if :yref:`TwoPhaseFlowEngine::isPhaseTrapped`) is detected afterwards with a union-find, so that a complete drainage (resp. imbibition if drainage=False) curve costs O(N log N) instead of O(N) per pressure step. :yref:`FlowEngine::bndCondValue` [3] is set to bndCondValue[2]+pc and the cell states are updated as in :yref:`TwoPhaseFlowEngine::invasion`. Returns the list of (pc, saturation) points at which invasion occured, with saturation defined as in :yref:`TwoPhaseFlowEngine::getSaturation`.")
 	.def("computeCapillaryForce",&TwoPhaseFlowEngine::computeCapillaryForce,"Compute capillary force. ")
 // 	.def("saveVtk",&TwoPhaseFlowEngine::saveVtk,(boost::python::arg("folder")="./VTK",boost::python::arg("withBoundaries")=false),"Save pressure field in vtk format. Specify a folder name for output.")
 	.def("getPotentialPendularSpheresPair",&TwoPhaseFlowEngine::getPotentialPendularSpheresPair,"Get the list of sphere ID pairs of potential pendular liquid bridge.")
@@ -0,0 +1,210 @@
+// columnar storage for yade.plot data
+
+#include<lib/base/Logging.hpp>
+#include<lib/base/Math.hpp>
+#include<lib/pyutil/doc_opts.hpp>
+#include<lib/pyutil/numpy_boost.hpp>
+
+#include<fstream>
+#include<cstring>
+#include<stdint.h>
+
+namespace py=boost::python;
+
+/*
+Table of named numeric columns, all of the same length (missing values are NaN).
+
+Each column is stored in fixed-size chunks, so that appending never moves existing data and memory
+grows with the number of rows only (no per-value python object). Columns are handed to python as
+numpy arrays, optionally decimated for plotting.
+*/
+class DataStore{
+	typedef vector<double> Chunk;
+	typedef vector<Chunk> Column;
+	map<string,Column> cols;
+	size_t nRows;
+	size_t chunkSize;
+	static void raise(PyObject* type, const string& msg){ PyErr_SetString(type,msg.c_str()); py::throw_error_already_set(); }
+	const Column& getColumn(const string& name) const {
+		map<string,Column>::const_iterator I=cols.find(name);
+		if(I==cols.end()) raise(PyExc_KeyError,name);
+		return I->second;
+	}
+	static void push(Column& col, size_t row, double val, size_t chunkSize){
+		if(row%chunkSize==0){ col.push_back(Chunk()); col.back().reserve(chunkSize); }
+		col.back().push_back(val);
+	}
+	double at(const Column& col, size_t row) const { return col[row/chunkSize][row%chunkSize]; }
+	void copyColumn(const Column& col, double* out) const {
+		FOREACH(const Chunk& ch, col){ if(!ch.empty()) memcpy(out,&ch[0],ch.size()*sizeof(double)); out+=ch.size(); }
+	}
+	static py::object toNumpy(const vector<double>& v){
+		int dims[]={(int)v.size()}; numpy_boost<double,1> ret(dims);
+		if(!v.empty()) memcpy(ret.data(),&v[0],v.size()*sizeof(double));
+		return py::object(py::handle<>(py::borrowed(ret.py_ptr())));
+	}
+	void addEmptyColumn(const string& name){
+		Column& col=cols[name];
+		for(size_t r=0; r<nRows; r++) push(col,r,NaN,chunkSize);
+	}
+	public:
+	DataStore(size_t _chunkSize=4096): nRows(0), chunkSize(max((size_t)1,_chunkSize)){}
+	size_t numColumns() const { return cols.size(); }
+	size_t rows() const { return nRows; }
+	bool hasColumn(const string& name) const { return cols.count(name)>0; }
+	py::list keys() const { py::list ret; for(map<string,Column>::const_iterator I=cols.begin(); I!=cols.end(); ++I) ret.append(I->first); return ret; }
+	py::object iter() const { return keys().attr("__iter__")(); }
+	void clear(){ cols.clear(); nRows=0; }
+	//! append one row; names not yet present create new columns (NaN in previous rows), columns not given get NaN
+	void addRow(const py::dict& d){
+		py::list items(d.items());
+		const size_t n=py::len(items);
+		// convert everything first, so that a bad value leaves the store untouched
+		vector<pair<string,double> > vals; vals.reserve(n);
+		for(size_t i=0; i<n; i++){
+			py::tuple kv=py::extract<py::tuple>(items[i]);
+			vals.push_back(make_pair(string(py::extract<string>(kv[0])),double(py::extract<double>(kv[1]))));
+		}
+		for(size_t i=0; i<n; i++) if(!hasColumn(vals[i].first)) addEmptyColumn(vals[i].first);
+		for(map<string,Column>::iterator I=cols.begin(); I!=cols.end(); ++I) push(I->second,nRows,NaN,chunkSize);
+		for(size_t i=0; i<n; i++){ Column& col=cols[vals[i].first]; col.back().back()=vals[i].second; }
+		nRows++;
+	}
+	void addColumns(const vector<string>& names){ FOREACH(const string& name, names) if(!hasColumn(name)) addEmptyColumn(name); }
+	//! column as a (copied) numpy array
+	py::object column(const string& name) const {
+		vector<double> v(nRows);
+		if(nRows>0) copyColumn(getColumn(name),&v[0]);
+		return toNumpy(v);
+	}
+	//! set whole column; the sequence must have one item per row, unless the store is empty (then it sets the number of rows)
+	void setColumn(const string& name, py::object seq){
+		const size_t n=py::len(seq);
+		if(cols.empty() || (cols.size()==1 && hasColumn(name))) nRows=n;
+		else if(n!=nRows) raise(PyExc_ValueError,"Column length ("+boost::lexical_cast<string>(n)+") must be equal to the number of rows ("+boost::lexical_cast<string>(nRows)+").");
+		Column col;
+		for(size_t r=0; r<n; r++) push(col,r,py::extract<double>(seq[r]),chunkSize);
+		cols[name]=col;
+	}
+	void reverse(){
+		for(map<string,Column>::iterator I=cols.begin(); I!=cols.end(); ++I){
+			Column& col=I->second;
+			for(size_t a=0, b=nRows-1; nRows>0 && a<b; a++, b--) std::swap(col[a/chunkSize][a%chunkSize],col[b/chunkSize][b%chunkSize]);
+		}
+	}
+	/*! return (x,y) numpy arrays with at most about nOut points, for plotting.
+	method "lttb" is largest-triangle-three-buckets (points with NaN are dropped),
+	method "minmax" keeps the minimum and maximum y of each bucket (and NaN, to keep gaps in lines). */
+	py::tuple decimated(const string& xName, const string& yName, size_t nOut, const string& method) const {
+		const Column &xc=getColumn(xName), &yc=getColumn(yName);
+		vector<double> xs, ys;
+		if(nOut==0 || nRows<=nOut || nOut<3){
+			xs.resize(nRows); ys.resize(nRows);
+			if(nRows>0){ copyColumn(xc,&xs[0]); copyColumn(yc,&ys[0]); }
+		} else if(method=="lttb"){
+			vector<double> x, y; x.reserve(nRows); y.reserve(nRows);
+			for(size_t r=0; r<nRows; r++){ const double xx=at(xc,r), yy=at(yc,r); if(std::isnan(xx) || std::isnan(yy)) continue; x.push_back(xx); y.push_back(yy); }
+			const size_t n=x.size();
+			if(n<=nOut){ xs=x; ys=y; }
+			else {
+				xs.reserve(nOut); ys.reserve(nOut);
+				const double every=double(n-2)/(nOut-2);
+				size_t a=0; xs.push_back(x[0]); ys.push_back(y[0]);
+				for(size_t i=0; i<nOut-2; i++){
+					// average of the next bucket
+					size_t avgStart=(size_t)((i+1)*every)+1, avgEnd=min(n,(size_t)((i+2)*every)+1);
+					double avgX=0, avgY=0;
+					for(size_t j=avgStart; j<avgEnd; j++){ avgX+=x[j]; avgY+=y[j]; }
+					if(avgEnd>avgStart){ avgX/=(avgEnd-avgStart); avgY/=(avgEnd-avgStart); }
+					// point of the current bucket making the largest triangle with the last selected point and the average
+					const size_t start=(size_t)(i*every)+1, end=(size_t)((i+1)*every)+1;
+					double maxArea=-1; size_t next=start;
+					for(size_t j=start; j<end; j++){
+						const double area=std::abs((x[a]-avgX)*(y[j]-y[a])-(x[a]-x[j])*(avgY-y[a]));
+						if(area>maxArea){ maxArea=area; next=j; }
+					}
+					xs.push_back(x[next]); ys.push_back(y[next]); a=next;
+				}
+				xs.push_back(x[n-1]); ys.push_back(y[n-1]);
+			}
+		} else if(method=="minmax"){
+			const size_t nBuckets=max((size_t)1,nOut/2);
+			const double every=double(nRows)/nBuckets;
+			xs.reserve(nOut+nBuckets); ys.reserve(nOut+nBuckets);
+			for(size_t i=0; i<nBuckets; i++){
+				const size_t start=(size_t)(i*every), end=min(nRows,(size_t)((i+1)*every));
+				size_t iMin=nRows, iMax=nRows; bool gap=false;
+				for(size_t j=start; j<end; j++){
+					const double yy=at(yc,j);
+					if(std::isnan(yy) || std::isnan(at(xc,j))){ gap=true; continue; }
+					if(iMin==nRows || yy<at(yc,iMin)) iMin=j;
+					if(iMax==nRows || yy>at(yc,iMax)) iMax=j;
+				}
+				if(iMin!=nRows){
+					const size_t first=min(iMin,iMax), second=max(iMin,iMax);
+					xs.push_back(at(xc,first)); ys.push_back(at(yc,first));
+					if(second!=first){ xs.push_back(at(xc,second)); ys.push_back(at(yc,second)); }
+				}
+				if(gap){ xs.push_back(NaN); ys.push_back(NaN); }
+			}
+		} else raise(PyExc_ValueError,"Unknown decimation method '"+method+"' (lttb, minmax).");
+		return py::make_tuple(toNumpy(xs),toNumpy(ys));
+	}
+	/*! binary file: "YADEDATA", uint32 version, uint64 number of columns, uint64 number of rows,
+	then for each column uint32 name length and name, then columns one after another as float64 */
+	void saveBinary(const string& fileName, py::object pyNames) const {
+		vector<string> names;
+		if(pyNames.ptr()==Py_None){ for(map<string,Column>::const_iterator I=cols.begin(); I!=cols.end(); ++I) names.push_back(I->first); }
+		else names=py::extract<vector<string> >(pyNames)();
+		FOREACH(const string& name, names) getColumn(name); // raise before opening the file
+		std::ofstream f(fileName.c_str(),std::ios::binary);
+		if(!f.good()) raise(PyExc_IOError,"Unable to open "+fileName+" for writing.");
+		const uint32_t version=1; const uint64_t nc=names.size(), nr=nRows;
+		f.write("YADEDATA",8); f.write((const char*)&version,sizeof(version)); f.write((const char*)&nc,sizeof(nc)); f.write((const char*)&nr,sizeof(nr));
+		FOREACH(const string& name, names){ const uint32_t len=name.size(); f.write((const char*)&len,sizeof(len)); f.write(name.data(),len); }
+		FOREACH(const string& name, names){ FOREACH(const Chunk& ch, getColumn(name)) if(!ch.empty()) f.write((const char*)&ch[0],ch.size()*sizeof(double)); }
+		if(!f.good()) raise(PyExc_IOError,"Error writing "+fileName+".");
+	}
+	void loadBinary(const string& fileName){
+		std::ifstream f(fileName.c_str(),std::ios::binary);
+		if(!f.good()) raise(PyExc_IOError,"Unable to open "+fileName+" for reading.");
+		char magic[8]; uint32_t version; uint64_t nc, nr;
+		f.read(magic,8); f.read((char*)&version,sizeof(version)); f.read((char*)&nc,sizeof(nc)); f.read((char*)&nr,sizeof(nr));
+		if(!f.good() || memcmp(magic,"YADEDATA",8)!=0 || version!=1) raise(PyExc_IOError,fileName+" is not a yade.plot binary data file.");
+		vector<string> names(nc);
+		for(size_t i=0; i<nc; i++){ uint32_t len; f.read((char*)&len,sizeof(len)); names[i].resize(len); if(len>0) f.read(&names[i][0],len); }
+		clear(); nRows=nr;
+		vector<double> buf(chunkSize);
+		FOREACH(const string& name, names){
+			Column& col=cols[name];
+			for(size_t r=0; r<nr; r+=chunkSize){
+				const size_t n=min((size_t)nr-r,chunkSize);
+				f.read((char*)&buf[0],n*sizeof(double));
+				col.push_back(Chunk(buf.begin(),buf.begin()+n)); col.back().reserve(chunkSize);
+			}
+		}
+		if(!f.good()){ clear(); raise(PyExc_IOError,"Truncated data in "+fileName+"."); }
+	}
+};
+
+BOOST_PYTHON_MODULE(_plotData){
+	YADE_SET_DOCSTRING_OPTS;
+	py::scope().attr("__doc__")="Columnar storage backend for :yref:`yade.plot` data.";
+	if(_import_array()<0){ PyErr_Print(); LOG_ERROR("Unable to import numpy."); }
+	py::class_<DataStore>("DataStore","Table of named float columns of equal length (missing values are NaN), stored in chunks of *chunkSize* rows, used as :yref:`yade.plot.data` if :yref:`yade.plot.columnar` is set. It behaves like a dictionary of numpy arrays; columns are returned as copies.",py::init<py::optional<size_t> >(py::args("chunkSize")))
+		.def("__len__",&DataStore::numColumns,"Number of columns.")
+		.def("__contains__",&DataStore::hasColumn)
+		.def("__iter__",&DataStore::iter)
+		.def("__getitem__",&DataStore::column,"Column as numpy array.")
+		.def("__setitem__",&DataStore::setColumn,"Replace or create column; the sequence must have one item per row (any length if it is the only column).")
+		.def("keys",&DataStore::keys,"Column names.")
+		.def("rows",&DataStore::rows,"Number of rows.")
+		.def("clear",&DataStore::clear,"Remove all columns.")
+		.def("addRow",&DataStore::addRow,(py::arg("d")),"Append one row given as {name:value}; new names create new columns with NaN in previous rows, missing names get NaN.")
+		.def("addColumns",&DataStore::addColumns,(py::arg("names")),"Add columns filled with NaN (existing columns are left untouched).")
+		.def("reverse",&DataStore::reverse,"Reverse the order of rows.")
+		.def("decimated",&DataStore::decimated,(py::arg("x"),py::arg("y"),py::arg("nOut"),py::arg("method")="lttb"),"Return (x,y) numpy arrays reduced to about *nOut* points for plotting, using ``lttb`` (largest-triangle-three-buckets, rows with NaN are dropped) or ``minmax`` (min and max of each bucket, gaps kept). All rows are returned if there are at most *nOut* of them.")
+		.def("saveBinary",&DataStore::saveBinary,(py::arg("fileName"),py::arg("names")=py::object()),"Save columns *names* (all if None) to a binary file (header and float64 columns, see source for the layout).")
+		.def("loadBinary",&DataStore::loadBinary,(py::arg("fileName")),"Replace contents by data from a file written by :yref:`saveBinary<yade._plotData.DataStore.saveBinary>`.")
+	;
+}
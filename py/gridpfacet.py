@@ -233,6 +233,23 @@ def pfacet(id1,id2,id3,wire=True,color=None,highlight=False,material=-1,mask=1,c
 	return b
 
 
+def gridMesh(elements,selfCollide=True):
+	"""
+	Create a :yref:`GridMesh` body grouping :yref:`GridConnections<GridConnection>` and :yref:`PFacets<PFacet>` of a membrane or a fibre network, so that :yref:`InsertionSortCollider` handles them as one body (aperiodic simulations only).
+
+	:param elements: ids of :yref:`GridConnections<GridConnection>` and :yref:`PFacets<PFacet>` (e.g. *cylIds* and *pfIds* filled by :yref:`yade.gridpfacet.pfacetCreator1`); ids of :yref:`GridNodes<GridNode>` are ignored.
+	:param bool selfCollide: find contacts between elements of the mesh, see :yref:`GridMesh.selfCollide`.
+
+	:return: Body object with the :yref:`GridMesh` :yref:`shape<Body.shape>`, non-dynamic and without :yref:`bound<Body.bound>`; it must be added to :yref:`O.bodies<Omega.bodies>`.
+	"""
+	ids=[i for i in elements if isinstance(O.bodies[i].shape,(GridConnection,PFacet))]
+	b=Body()
+	b.shape=GridMesh(elements=ids,selfCollide=selfCollide)
+	b.dynamic=False
+	b.bounded=False
+	return b
+
+
 #TODO: find a better way of handling the Id lists for checking duplicated gridNodes or gridConnections with the same coordinates etc. It would be better to handle this globally, maybe implement something like O.bodies.getGridNodes
 def pfacetCreator1(vertices,radius,nodesIds=[],cylIds=[],pfIds=[],wire=False,fixed=True,materialNodes=-1,material=-1,color=None):
 	"""
@@ -104,11 +104,16 @@ if not (noPredicate):
     if self.cellSize!=Vector3.Zero and self.isPeriodic:
       O.cell.hSize=rot*Matrix3(self.cellSize[0],0,0, 0,self.cellSize[1],0, 0,0,self.cellSize[2])
       O.cell.trsf=Matrix3.Identity
+    # bulk creation in c++ whenever utils.sphere arguments allow it (no callable material, no deprecated/extra arguments)
+    if set(kw.keys())<=set(['material','mask','fixed','color','wire']) and not callable(kw.get('material',-1)):
+      def appendAll(): return O.bodies.appendSpheres([rot*c for c,r in self],[r for c,r in self],**kw) if len(self)>0 else []
+    else:
+      def appendAll(): return O.bodies.append([utils.sphere(rot*c,r,**kw) for c,r in self])
     if not self.hasClumps():
-      return O.bodies.append([utils.sphere(rot*c,r,**kw) for c,r in self])
+      return appendAll()
     else:
       standalone,clumps=self.getClumps()
-      ids=O.bodies.append([utils.sphere(rot*c,r,**kw) for c,r in self]) # append all spheres first
+      ids=appendAll() # append all spheres first
       clumpIds=[]
       userColor='color' in kw
       for clump in clumps:
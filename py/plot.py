@@ -6,7 +6,7 @@ Module containing utility functions for plotting inside yade. See :ysrc:`example
 """
 
 ## all exported names
-__all__=['data','plots','labels','live','liveInterval','autozoom','plot','reset','resetData','splitData','reverseData','addData','addAutoData','saveGnuplot','saveDataTxt','savePlotSequence']
+__all__=['data','plots','labels','live','liveInterval','autozoom','plot','reset','resetData','splitData','reverseData','addData','addAutoData','saveGnuplot','saveDataTxt','saveDataBinary','loadDataBinary','savePlotSequence','columnar','livePoints']
 
 # multi-threaded support for Tk
 # safe to import even if Tk will not be used
@@ -46,8 +46,16 @@ from minieigen import *
 matplotlib.rc('axes',grid=True) # put grid in all figures
 import pylab
 
+from yade._plotData import DataStore
+
 data={}
 "Global dictionary containing all data values, common for all plots, in the form {'name':[value,...],...}. Data should be added using plot.addData function. All [value,...] columns have the same length, they are padded with NaN if unspecified."
+columnar=False
+"Keep :yref:`yade.plot.data` in a :yref:`yade._plotData.DataStore` (c++ float columns, read as numpy arrays) rather than in a dictionary of python lists. Memory then grows with the number of rows only and live plots are decimated (see :yref:`yade.plot.livePoints`). Set it before adding data, or call :yref:`yade.plot.resetData` afterwards; values must be numbers."
+livePoints=2000
+"Number of points each line is decimated to when plots are updated, if :yref:`yade.plot.columnar` is set (0 to plot all points)."
+liveDecimation='lttb'
+"Decimation method for :yref:`yade.plot.livePoints`, ``lttb`` (largest-triangle-three-buckets) or ``minmax`` (keeps extrema and gaps)."
 imgData={}
 "Dictionary containing lists of strings, which have the meaning of images corresponding to respective :yref:`yade.plot.data` rows. See :yref:`yade.plot.plots` on how to plot images."
 plots={} # dictionary x-name -> (yspec,...), where yspec is either y-name or (y-name,'line-specification')
@@ -82,16 +90,24 @@ componentSeparator='_'
 componentSuffixes={Vector2:{0:'x',1:'y'},Vector3:{0:'x',1:'y',2:'z'},Matrix3:{(0,0):'xx',(1,1):'yy',(2,2):'zz',(0,1):'xy',(0,2):'xz',(1,2):'yz',(1,0):'yx',(2,0):'zx',(2,1):'zy'}}
 # if a type with entry in componentSuffixes is given in addData, columns for individual components are synthesized using indices and suffixes given for each type, e.g. foo=Vector3r(1,2,3) will result in columns foox=1,fooy=2,fooz=3
 
+def _emptyData():
+	return DataStore() if columnar else {}
+
+def _numSamples():
+	"Number of rows in data, without copying columns."
+	if isinstance(data,DataStore): return data.rows()
+	return len(data[data.keys()[0]]) if len(data)>0 else 0
+
 def reset():
 	"Reset all plot-related variables (data, plots, labels)"
 	global data, plots, labels # plotLines
-	data={}; plots={}; imgData={} # plotLines={};
+	data=_emptyData(); plots={}; imgData={} # plotLines={};
 	pylab.close('all')
 
 def resetData():
 	"Reset all plot data; keep plots and labels intact."
 	global data
-	data={}
+	data=_emptyData()
 
 from yade.wrapper import *
 
@@ -104,11 +120,15 @@ def reverseData():
 	
 	Useful for tension-compression test, where the initial (zero) state is loaded and, to make data continuous, last part must *end* in the zero state.
 	"""
-	for k in data: data[k].reverse()
+	if isinstance(data,DataStore): data.reverse()
+	else:
+		for k in data: data[k].reverse()
 
 def addDataColumns(dd):
 	'''Add new columns with NaN data, without adding anything to other columns. Does nothing for columns that already exist'''
-	numSamples=len(data[data.keys()[0]]) if len(data)>0 else 0
+	if isinstance(data,DataStore):
+		data.addColumns(list(dd)); return
+	numSamples=_numSamples()
 	for d in dd:
 		if d in data.keys(): continue
 		data[d]=[nan for i in range(numSamples)]
@@ -239,8 +259,7 @@ def addData(*d_in,**kw):
 
 	"""
 	import numpy
-	if len(data)>0: numSamples=len(data[data.keys()[0]])
-	else: numSamples=0
+	numSamples=_numSamples()
 	# align with imgData, if there is more of them than data
 	if len(imgData)>0 and numSamples==0: numSamples=max(numSamples,len(imgData[imgData.keys()[0]]))
 	d=(d_in[0] if len(d_in)>0 else {})
@@ -255,6 +274,10 @@ def addData(*d_in,**kw):
 			del d[name]
 		elif hasattr(d[name],'__len__'):
 			raise ValueError('plot.addData given unhandled sequence type (is a '+type(d[name]).__name__+', must be number or '+'/'.join([k.__name__ for k in componentSuffixes])+')')
+	if isinstance(data,DataStore):
+		for i in range(numSamples-data.rows()): data.addRow({})
+		data.addRow(d)
+		return
 	for name in d:
 		if not name in data.keys(): data[name]=[]
 	for name in data:
@@ -269,12 +292,15 @@ def addImgData(**kw):
 		if k not in imgData: imgData[k]=[]
 	# align imgData with data
 	if len(data.keys())>0 and len(imgData.keys())>0:
-		nData,nImgData=len(data[data.keys()[0]]),len(imgData[imgData.keys()[0]])
+		nData,nImgData=_numSamples(),len(imgData[imgData.keys()[0]])
 		#if nImgData>nData-1: raise RuntimeError("imgData is already the same length as data?")
 		if nImgData<nData-1: # repeat last value
 			for k in imgData.keys():
 				lastValue=imgData[k][-1] if len(imgData[k])>0 else None
 				imgData[k]+=(nData-len(imgData[k])-1)*[lastValue]
+		elif nData<nImgData and isinstance(data,DataStore):
+			last=dict([(k,data[k][-1]) for k in data.keys()]) if nData>0 else {}
+			for i in range(nImgData-nData): data.addRow(last)
 		elif nData<nImgData:
 			for k in data.keys():
 				lastValue=data[k][-1] if len(data[k])>0 else nan
@@ -311,8 +337,9 @@ def xlateLabel(l):
 class LineRef:
 	"""Holds reference to plot line and to original data arrays (which change during the simulation),
 	and updates the actual line using those data upon request."""
-	def __init__(self,line,scatter,line2,xdata,ydata,dataName=None):
+	def __init__(self,line,scatter,line2,xdata,ydata,dataName=None,xName=None,yName=None):
 		self.line,self.scatter,self.line2,self.xdata,self.ydata,self.dataName=line,scatter,line2,xdata,ydata,dataName
+		self.xName,self.yName=xName,yName # column names, to fetch fresh (decimated) arrays from columnar data
 	def update(self):
 		if isinstance(self.line,matplotlib.image.AxesImage):
 			# image name
@@ -325,6 +352,9 @@ class LineRef:
 		else:
 			# regular data
 			import numpy
+			if isinstance(data,DataStore) and self.yName in data and self.xName in data:
+				# decimated lines only when there is no current point to show (its index refers to all rows)
+				self.xdata,self.ydata=data.decimated(self.xName,self.yName,livePoints if (current==None or current==-1) else 0,liveDecimation)
 			# current==-1 avoids copy slicing data in the else part
 			if current==None or current==-1 or afterCurrentAlpha==1:
 				self.line.set_xdata(self.xdata); self.line.set_ydata(self.ydata)
@@ -436,7 +466,7 @@ def createPlots(subPlots=True,scatterSize=60,wider=False):
 				scatterPt=[0,0] if len(data[pStrip])==0 else (data[pStrip][current],data[d[0]][current])
 				# if current value is NaN, use zero instead
 				scatter=pylab.scatter(scatterPt[0] if not math.isnan(scatterPt[0]) else 0,scatterPt[1] if not math.isnan(scatterPt[1]) else 0,s=scatterSize,color=line.get_color(),**scatterMarkerKw)
-				currLineRefs.append(LineRef(line,scatter,line2,data[pStrip],data[d[0]]))
+				currLineRefs.append(LineRef(line,scatter,line2,data[pStrip],data[d[0]],xName=pStrip,yName=d[0]))
 			axes=line.axes
 			labelLoc=(legendLoc[0 if isY1 else 1] if y2Exists>0 else 'best')
 			l=pylab.legend(loc=labelLoc)
@@ -476,6 +506,7 @@ def liveUpdate(timestamp):
 			figs.add(l.line.get_figure())
 			axes.add(l.line.axes)
 			linesData.add(id(l.ydata))
+			if getattr(l,'yName',None): linesData.add(l.yName) # columnar data are copied on access, compare names
 		# find callables in y specifiers, create new lines if necessary
 		for ax in axes:
 			if not hasattr(ax,'yadeYFuncs') or not ax.yadeYFuncs: continue # not defined of empty
@@ -489,15 +520,15 @@ def liveUpdate(timestamp):
 			if not news: continue
 			for new in news:
 				ax.yadeYNames.add(new)
-				if new in data.keys() and id(data[new]) in linesData: continue # do not add when reloaded and the old lines are already there
+				if new in data.keys() and (new in linesData or id(data[new]) in linesData): continue # do not add when reloaded and the old lines are already there
 				print 'yade.plot: creating new line for',new
-				if not new in data.keys(): data[new]=len(data[ax.yadeXName])*[nan] # create data entry if necessary
+				if not new in data.keys(): addDataColumns([new]) # create data entry if necessary
 				#print 'data',len(data[ax.yadeXName]),len(data[new]),data[ax.yadeXName],data[new]
 				line,=ax.plot(data[ax.yadeXName],data[new],label=xlateLabel(new)) # no line specifier
 				line2,=ax.plot([],[],color=line.get_color(),alpha=afterCurrentAlpha)
 				scatterPt=(0 if len(data[ax.yadeXName])==0 or math.isnan(data[ax.yadeXName][current]) else data[ax.yadeXName][current]),(0 if len(data[new])==0 or math.isnan(data[new][current]) else data[new][current])
 				scatter=ax.scatter(scatterPt[0],scatterPt[1],s=60,color=line.get_color(),**scatterMarkerKw)
-				currLineRefs.append(LineRef(line,scatter,line2,data[ax.yadeXName],data[new]))
+				currLineRefs.append(LineRef(line,scatter,line2,data[ax.yadeXName],data[new],xName=ax.yadeXName,yName=new))
 				ax.set_ylabel(ax.get_ylabel()+(', ' if ax.get_ylabel() else '')+xlateLabel(new))
 			# it is possible that the legend has not yet been created
 			l=ax.legend(loc=ax.yadeLabelLoc)
@@ -646,10 +677,29 @@ def saveDataTxt(fileName,vars=None, headers=None):
 			f.write("# "+k[i]+"=\t"+str(headers[k[i]])+"\n");
 	
 	f.write("# "+"\t\t".join(vars)+"\n")
-	for i in range(len(data[vars[0]])):
-		f.write("\t".join([str(data[var][i]) for var in vars])+"\n")
+	cols=[data[var] for var in vars] # fetch each column once (columnar data are copied on access)
+	for i in range(len(cols[0])):
+		f.write("\t".join([str(col[i]) for col in cols])+"\n")
 	f.close()
 
+def saveDataBinary(fileName,vars=None):
+	"""Save plot data into a binary file (float64 columns with a small header, see :yref:`yade._plotData.DataStore.saveBinary`), which is much faster and smaller than :yref:`yade.plot.saveDataTxt` for long histories. Data can be read back with :yref:`yade.plot.loadDataBinary`.
+
+	:param vars: Sequence of variable names to be saved; all if ``None``.
+	"""
+	if isinstance(data,DataStore): store=data
+	else:
+		store=DataStore()
+		for k in (vars if vars else data.keys()): store[k]=data[k]
+	store.saveBinary(fileName,list(vars) if vars else None)
+
+def loadDataBinary(fileName):
+	"""Replace :yref:`yade.plot.data` by data saved with :yref:`yade.plot.saveDataBinary`."""
+	global data
+	store=DataStore(); store.loadBinary(fileName)
+	if columnar: data=store
+	else: data=dict([(k,list(store[k])) for k in store.keys()])
+
 
 def savePylab(baseName,timestamp=False,title=None):
 	'''This function is not finished, do not use it.'''
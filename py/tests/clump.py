@@ -67,3 +67,37 @@ class TestSimpleClump(unittest.TestCase):
 		self.assertEqual(s1.angVel,sC.angVel);
 		self.assertEqual(s2.angVel,sC.angVel);
 
+
+class TestClumpLevel(unittest.TestCase):
+	"Collision of clumps in two levels (InsertionSortCollider.clumpLevel) finds the contacts of the flat collider."
+	def simulate(self,clumpLevel):
+		O.reset()
+		random.seed(1)
+		O.bodies.append(utils.wall(0,axis=2,sense=1))
+		for i in range(4):
+			for j in range(4):
+				for k in range(3):
+					c=Vector3(.35*i+.02*random.random(),.35*j+.02*random.random(),.2+.35*k)
+					d=Vector3(random.random()-.5,random.random()-.5,random.random()-.5).normalized()
+					if (i+j+k)%5==0: O.bodies.append(utils.sphere(c,.1))
+					else: O.bodies.appendClumped([utils.sphere(c-.07*d,.1),utils.sphere(c+.07*d,.08)])
+		for b in O.bodies:
+			if b.dynamic and not b.isClumpMember: b.state.vel=(0,0,-2)
+		O.engines=[
+			ForceResetter(),
+			InsertionSortCollider([Bo1_Sphere_Aabb(),Bo1_Wall_Aabb()],clumpLevel=clumpLevel),
+			InteractionLoop([Ig2_Sphere_Sphere_ScGeom(),Ig2_Wall_Sphere_ScGeom()],[Ip2_FrictMat_FrictMat_FrictPhys()],[Law2_ScGeom_FrictPhys_CundallStrack()]),
+			NewtonIntegrator(damping=.2,gravity=(0,0,-9.81))
+		]
+		O.dt=.5*utils.PWaveTimeStep()
+		ret=[]
+		for n in range(5):
+			O.run(200,True)
+			ret.append(sorted([(min(i.id1,i.id2),max(i.id1,i.id2)) for i in O.interactions if i.isReal]))
+		return ret
+	def testSameContacts(self):
+		"Clump: real interactions are the same with and without clumpLevel"
+		flat=self.simulate(False)
+		twoLevel=self.simulate(True)
+		self.assert_(len(flat[-1])>0)
+		for n in range(len(flat)): self.assertEqual(twoLevel[n],flat[n])
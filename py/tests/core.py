@@ -82,6 +82,54 @@ class TestLoop(unittest.TestCase):
 			
 
 
+class TestConcurrentScenes(unittest.TestCase):
+	"O.runScenes steps several scenes at once, each giving the same result as when run alone."
+	def setUp(self): O.reset()
+	def tearDown(self): O.resetAllScenes()
+	def build(self,nSpheres):
+		O.reset()
+		O.bodies.append(utils.wall(0,axis=2))
+		O.bodies.append([utils.sphere((.3*(i%4),.3*(i//4),.2+.05*i),.1) for i in range(nSpheres)])
+		O.engines=[
+			ForceResetter(),
+			InsertionSortCollider([Bo1_Sphere_Aabb(),Bo1_Wall_Aabb()]),
+			InteractionLoop([Ig2_Sphere_Sphere_ScGeom(),Ig2_Wall_Sphere_ScGeom()],[Ip2_FrictMat_FrictMat_FrictPhys()],[Law2_ScGeom_FrictPhys_CundallStrack()]),
+			NewtonIntegrator(damping=0.2,gravity=(0,0,-9.81)),
+			PyRunner(iterPeriod=10)
+		]
+		O.dt=.5*utils.PWaveTimeStep()
+		return O.sceneToString()
+	def watch(self):
+		"Make the PyRunner of the current scene record the number of bodies of the scene O refers to."
+		seen=[]
+		O.engines[-1].callable=lambda: seen.append(len(O.bodies))
+		return seen
+	def testRunScenes(self):
+		"Loop: two scenes run concurrently give the same states as run one after the other"
+		nSteps=300
+		scenes=[self.build(8),self.build(12)]
+		ref=[]
+		for s in scenes:
+			O.stringToScene(s); O.run(nSteps,True)
+			ref.append([b.state.pos for b in O.bodies])
+		O.resetAllScenes()
+		ids,seen=[],[]
+		for k,s in enumerate(scenes):
+			ids.append(0 if k==0 else O.addScene())
+			O.switchToScene(ids[-1]); O.stringToScene(s)
+			seen.append(self.watch())
+		O.subStepping=True # restored after the concurrent run
+		O.runScenes(ids,nSteps=nSteps,workers=2,ompThreads=2)
+		for k,id in enumerate(ids):
+			O.switchToScene(id)
+			self.assertEqual(O.iter,nSteps)
+			self.assertEqual(O.subStepping,k==len(ids)-1)
+			# python code run by engines of a scene sees that scene
+			self.assertEqual(seen[k],len(seen[k])*[len(O.bodies)])
+			self.assert_(len(seen[k])>0)
+			# summation order of forces may differ with several threads
+			for b,pos in zip(O.bodies,ref[k]): self.assert_((b.state.pos-pos).norm()<1e-6)
+
 class TestIO(unittest.TestCase):
 	def testSaveAllClasses(self):
 		'I/O: All classes can be saved and loaded with boost::serialization'
@@ -180,6 +228,105 @@ class TestBodies(unittest.TestCase):
 		O.run(1, True)
 		self.assert_(O.bodies[id1].bound!=None and O.bodies[id2].bound!=None and O.bodies[id4].bound!=None)
 		
+class TestBulkArrays(unittest.TestCase):
+	"Numpy accessors (O.bodies.array and friends) give the same values as per-body access."
+	def setUp(self):
+		O.reset()
+		random.seed(1)
+		O.bodies.append([utils.sphere([random.random(),random.random(),random.random()],.1+.1*random.random()) for i in range(0,50)])
+		O.bodies.append(utils.wall(0,axis=2))
+		O.bodies.erase(3)
+		O.engines=[
+			ForceResetter(),
+			InsertionSortCollider([Bo1_Sphere_Aabb(),Bo1_Wall_Aabb()]),
+			InteractionLoop([Ig2_Sphere_Sphere_ScGeom(),Ig2_Wall_Sphere_ScGeom()],[Ip2_FrictMat_FrictMat_FrictPhys()],[Law2_ScGeom_FrictPhys_CundallStrack()]),
+			NewtonIntegrator(damping=0.1,gravity=(0,0,-9.81))
+		]
+		O.dt=.5*utils.PWaveTimeStep()
+		O.run(20,True)
+	def testBodyArrays(self):
+		"Bodies: array() matches per-body attributes, erased bodies give NaN or -1"
+		import numpy
+		pos,vel,ori,mass,radius,dyn=[O.bodies.array(a) for a in ('pos','vel','ori','mass','radius','isDynamic')]
+		self.assertEqual(pos.shape,(len(O.bodies),3)); self.assertEqual(ori.shape,(len(O.bodies),4))
+		for i in range(len(O.bodies)):
+			b=O.bodies[i]
+			if not b:
+				self.assert_(numpy.isnan(pos[i]).all() and numpy.isnan(mass[i]) and dyn[i]==-1)
+				continue
+			self.assertEqual(tuple(pos[i]),tuple(b.state.pos))
+			self.assertEqual(tuple(vel[i]),tuple(b.state.vel))
+			self.assertEqual(tuple(ori[i]),(b.state.ori[3],b.state.ori[0],b.state.ori[1],b.state.ori[2]))
+			self.assertEqual(mass[i],b.state.mass)
+			self.assertEqual(dyn[i],int(b.dynamic))
+			if isinstance(b.shape,Sphere): self.assertEqual(radius[i],b.shape.radius)
+			else: self.assert_(numpy.isnan(radius[i]))
+	def testSetArray(self):
+		"Bodies: setArray() sets the same values as per-body assignment, NaN rows are skipped"
+		import numpy
+		ids=[b.id for b in O.bodies if isinstance(b.shape,Sphere)]
+		vel=numpy.array([[i,2.*i,-i] for i in ids],dtype=float)
+		vel[0]=numpy.nan
+		old=Vector3(O.bodies[ids[0]].state.vel)
+		O.bodies.setArray('vel',vel,ids)
+		self.assertEqual(O.bodies[ids[0]].state.vel,old)
+		for k in range(1,len(ids)): self.assertEqual(tuple(O.bodies[ids[k]].state.vel),tuple(vel[k]))
+	def testForceAndInteractionArrays(self):
+		"Forces and interactions: array() matches O.forces and per-interaction access"
+		f=O.forces.array('f',sync=True)
+		for i in range(len(O.bodies)): self.assertEqual(tuple(f[i]),tuple(O.forces.f(i,sync=True)))
+		real=[i for i in O.interactions if i.isReal]
+		self.assert_(len(real)>0)
+		id1,id2,fn,depth=[O.interactions.array(a) for a in ('id1','id2','normalForce','penetrationDepth')]
+		self.assertEqual(len(id1),len(real))
+		for k,i in enumerate(real):
+			self.assertEqual((id1[k],id2[k]),(i.id1,i.id2))
+			self.assertEqual(tuple(fn[k]),tuple(i.phys.normalForce))
+			self.assertEqual(depth[k],i.geom.penetrationDepth)
+
+class TestAppendSpheres(unittest.TestCase):
+	"O.bodies.appendSpheres (BodyContainer::insertBatch) creates the same bodies as utils.sphere and O.bodies.append."
+	def setUp(self):
+		O.reset()
+		random.seed(2)
+		self.centers=[Vector3(random.random(),random.random(),random.random()) for i in range(0,30)]
+		self.radii=[.05+.05*random.random() for i in range(0,30)]
+	def build(self,batch):
+		import numpy
+		O.reset()
+		O.materials.append(FrictMat(density=2000,young=1e7,label='mat'))
+		O.bodies.append(utils.sphere((0,0,-5),1,fixed=True)) # ids of the batch do not start at 0
+		if batch: ids=O.bodies.appendSpheres(numpy.array(self.centers),numpy.array(self.radii),material='mat',mask=3,color=(1,0,0))
+		else: ids=O.bodies.append([utils.sphere(c,r,material='mat',mask=3,color=(1,0,0)) for c,r in zip(self.centers,self.radii)])
+		O.engines=[
+			ForceResetter(),
+			InsertionSortCollider([Bo1_Sphere_Aabb()]),
+			InteractionLoop([Ig2_Sphere_Sphere_ScGeom()],[Ip2_FrictMat_FrictMat_FrictPhys()],[Law2_ScGeom_FrictPhys_CundallStrack()]),
+			NewtonIntegrator(damping=0.1,gravity=(0,0,-9.81))
+		]
+		O.dt=.5*utils.PWaveTimeStep()
+		return ids
+	def testSameBodies(self):
+		"Bodies: appendSpheres gives the same bodies as a list of utils.sphere"
+		ids=self.build(True)
+		batch=[(b.id,b.state.pos,b.shape.radius,b.state.mass,b.state.inertia,b.material.id,b.mask,b.dynamic,b.shape.color) for b in O.bodies]
+		self.assertEqual(ids,self.build(False))
+		ref=[(b.id,b.state.pos,b.shape.radius,b.state.mass,b.state.inertia,b.material.id,b.mask,b.dynamic,b.shape.color) for b in O.bodies]
+		self.assertEqual(len(batch),len(ref))
+		for a,b in zip(batch,ref):
+			self.assertEqual((a[0],a[1],a[2],a[5],a[6],a[7],a[8]),(b[0],b[1],b[2],b[5],b[6],b[7],b[8]))
+			self.assertAlmostEqual(a[3]/b[3],1.,places=12)
+			self.assertAlmostEqual(a[4][0]/b[4][0],1.,places=12)
+	def testSameInteractions(self):
+		"Bodies: spheres inserted by appendSpheres are collided like the ones appended as a list"
+		def contacts(batch):
+			self.build(batch)
+			O.run(200,True)
+			return sorted((i.id1,i.id2) for i in O.interactions if i.isReal)
+		batch=contacts(True)
+		self.assert_(len(batch)>0)
+		self.assertEqual(batch,contacts(False))
+
 class TestMaterials(unittest.TestCase):
 	def setUp(self):
 		# common setup for all tests in this class
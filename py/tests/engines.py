@@ -4,7 +4,7 @@ import unittest
 import random
 from yade.wrapper import *
 from yade._customConverters import *
-from yade import utils
+from yade import utils,config
 from yade import *
 from math import *
 from minieigen import *
@@ -96,3 +96,203 @@ class TestLabelsOfEngines(unittest.TestCase):
 		self.assertEqual(rot2,lrot2)
 		self.assertEqual(newton,lnewton)
 		self.assertEqual(pyRunner,lpyRunner)
+
+class TestTriMeshContact(unittest.TestCase):
+	"A sphere on a TriMesh behaves as on the same triangles made of Facets, and the torque on the mesh is taken about its center."
+	vertices=[Vector3(0,0,0),Vector3(2,0,0),Vector3(2,1,0),Vector3(0,1,0)]
+	triangles=[Vector3i(0,1,2),Vector3i(0,2,3)]
+	def simulate(self,mesh):
+		O.reset()
+		if mesh: meshIds=[O.bodies.append(utils.triMesh(self.vertices,self.triangles))]
+		else: meshIds=O.bodies.append([utils.facet([self.vertices[i] for i in t]) for t in self.triangles])
+		s=O.bodies.append(utils.sphere((1.7,.3,.099),.1))
+		O.bodies[s].state.vel=(-.05,.02,0)
+		O.engines=[
+			ForceResetter(),
+			InsertionSortCollider([Bo1_Sphere_Aabb(),Bo1_Facet_Aabb(),Bo1_TriMesh_Aabb()]),
+			# facets need contact point branches, the mesh must get them regardless of sphericalBodies
+			InteractionLoop([Ig2_Facet_Sphere_ScGeom(),Ig2_TriMesh_Sphere_ScGeom()],[Ip2_FrictMat_FrictMat_FrictPhys()],[Law2_ScGeom_FrictPhys_CundallStrack(sphericalBodies=mesh)]),
+			NewtonIntegrator(damping=0,gravity=(0,0,-9.81))
+		]
+		O.dt=.3*utils.PWaveTimeStep()
+		O.run(500,True)
+		center=sum(self.vertices,Vector3.Zero)/len(self.vertices)
+		torque=sum([O.forces.t(i)+(O.bodies[i].state.pos-center).cross(O.forces.f(i)) for i in meshIds],Vector3.Zero)
+		return O.bodies[s].state.pos,O.bodies[s].state.vel,torque
+	def testSameAsFacets(self):
+		"Engines: Ig2_TriMesh_Sphere_ScGeom gives the trajectory and mesh torque of Ig2_Facet_Sphere_ScGeom"
+		pos,vel,torque=self.simulate(True)
+		refPos,refVel,refTorque=self.simulate(False)
+		self.assert_(refTorque.norm()>0)
+		self.assert_((pos-refPos).norm()<1e-9)
+		self.assert_((vel-refVel).norm()<1e-9)
+		self.assert_((torque-refTorque).norm()<1e-6*refTorque.norm())
+
+@unittest.skipIf('CGAL' not in config.features,'Polyhedra not compiled')
+class TestPolyhedraGJK(unittest.TestCase):
+	"Ig2_Polyhedra_Polyhedra_PolyhedraGeomGJK gives the overlap of Ig2_Polyhedra_Polyhedra_PolyhedraGeom and keeps the separating axis on potential interactions."
+	box=[Vector3(x,y,z) for x in (-.5,.5) for y in (-.4,.4) for z in (-.3,.3)]
+	def simulate(self,functor,pos,ori):
+		from yade import polyhedra_utils
+		O.reset()
+		m=PolyhedraMat()
+		O.bodies.append(polyhedra_utils.polyhedra(m,v=self.box))
+		b=polyhedra_utils.polyhedra(m,v=self.box)
+		b.state.pos=pos; b.state.ori=ori
+		O.bodies.append(b)
+		O.engines=[
+			ForceResetter(),
+			InsertionSortCollider([Bo1_Polyhedra_Aabb()]),
+			InteractionLoop([functor],[Ip2_PolyhedraMat_PolyhedraMat_PolyhedraPhys()],[Law2_PolyhedraGeom_PolyhedraPhys_Volumetric()])
+		]
+		O.dt=1e-8
+		O.step()
+		return [i for i in O.interactions.all(False) if i.id1+i.id2==1]
+	def testSameAsCGAL(self):
+		"Engines: Ig2_Polyhedra_Polyhedra_PolyhedraGeomGJK gives the volume, centroid and normal of Ig2_Polyhedra_Polyhedra_PolyhedraGeom"
+		for pos,ori in [((.9,.1,.05),Quaternion.Identity),((.8,.2,.1),Quaternion((0,0,1),.3)*Quaternion((1,0,0),.2)),((.7,.3,.2),Quaternion(Vector3(1,1,1).normalized(),.5))]:
+			i=self.simulate(Ig2_Polyhedra_Polyhedra_PolyhedraGeomGJK(),pos,ori)[0]
+			ref=self.simulate(Ig2_Polyhedra_Polyhedra_PolyhedraGeom(),pos,ori)[0]
+			self.assert_(i.isReal and ref.isReal)
+			self.assert_(ref.geom.penetrationVolume>0)
+			self.assert_(abs(i.geom.penetrationVolume-ref.geom.penetrationVolume)<1e-6*ref.geom.penetrationVolume)
+			self.assert_((i.geom.contactPoint-ref.geom.contactPoint).norm()<1e-6)
+			# the normals are defined differently (enclosed faces vs. fit of the intersection curve), they only agree roughly
+			self.assert_(i.geom.normal.dot(ref.geom.normal)>.9)
+	def testSeparatingAxisKept(self):
+		"Engines: Ig2_Polyhedra_Polyhedra_PolyhedraGeomGJK keeps the separating axis while bounds overlap without contact"
+		# bounds overlap, the near corner of the second box passes beside the first one
+		ori=Quaternion((0,0,1),.2)
+		ref=self.simulate(Ig2_Polyhedra_Polyhedra_PolyhedraGeom(),(1.05,.75,0),ori)[0]
+		i=self.simulate(Ig2_Polyhedra_Polyhedra_PolyhedraGeomGJK(),(1.05,.75,0),ori)[0]
+		self.assert_(not i.isReal and not ref.isReal)
+		self.assert_(i.geom and i.geom.sepAxis.norm()>0)
+		# the axis separates the boxes: projections of their vertices do not overlap
+		axis=i.geom.sepAxis
+		self.assert_(max([axis.dot(v) for v in self.box])<min([axis.dot(ori*v+Vector3(1.05,.75,0)) for v in self.box]))
+		O.bodies[1].state.pos=(.9,.3,0)
+		O.step()
+		self.assert_(O.interactions[0,1].isReal)
+		self.assert_(O.interactions[0,1].geom.penetrationVolume>0)
+
+class TestImplicitLubricationSolver(unittest.TestCase):
+	"ImplicitLubricationSolver gives the lubrication of Law2_ScGeom_ImplicitLubricationPhys with resolution 0."
+	def simulate(self,implicit):
+		O.reset()
+		# a fixed sphere pushed toward a free sphere at rest
+		s1=O.bodies.append(utils.sphere((0,0,0),1,fixed=True))
+		s2=O.bodies.append(utils.sphere((2.1,0,0),1))
+		O.bodies[s1].state.vel=(1,0,0)
+		solver=ImplicitLubricationSolver()
+		O.engines=[
+			ForceResetter(),
+			InsertionSortCollider([Bo1_Sphere_Aabb(aabbEnlargeFactor=1.5)]),
+			InteractionLoop([Ig2_Sphere_Sphere_ScGeom(interactionDetectionFactor=1.5)],[Ip2_FrictMat_FrictMat_LubricationPhys(eta=1000)],[Law2_ScGeom_ImplicitLubricationPhys(resolution=3 if implicit else 0)]),
+		]+([solver] if implicit else [])+[
+			NewtonIntegrator(damping=0,gravity=(0,0,0))
+		]
+		O.dt=1e-3
+		O.step()
+		if implicit:
+			# the free sphere is at rest at the first step, the tolerance must not be relative to its (null) momentum
+			self.assertEqual(solver.nContacts,1)
+			self.assert_(solver.iterations<solver.maxIter)
+		O.run(49,True)
+		if implicit: self.assert_(solver.iterations<solver.maxIter)
+		return O.bodies[s2].state.vel
+	def testSameAsResolution0(self):
+		"Engines: ImplicitLubricationSolver gives the velocities of Law2_ScGeom_ImplicitLubricationPhys.resolution=0"
+		vel=self.simulate(True)
+		ref=self.simulate(False)
+		self.assert_(ref[0]>0)
+		self.assert_((vel-ref).norm()<.02*ref.norm())
+
+class TestGridMesh(unittest.TestCase):
+	"Spheres falling on a membrane of PFacets touch the same elements whether the membrane is grouped in a GridMesh or not."
+	def simulate(self,mesh):
+		from yade import gridpfacet
+		O.reset()
+		random.seed(1)
+		O.materials.append(CohFrictMat(young=1e7,poisson=1,density=1e2,frictionAngle=radians(30),normalCohesion=3e7,shearCohesion=3e7,momentRotationLaw=True,label='gridNodeMat'))
+		O.materials.append(FrictMat(young=1e7,poisson=1,density=1e2,frictionAngle=radians(30),label='gridConnectionMat'))
+		# interactions between nodes are created with the functors of the engines
+		O.engines=[
+			ForceResetter(),
+			InsertionSortCollider([Bo1_Sphere_Aabb(),Bo1_GridConnection_Aabb(),Bo1_PFacet_Aabb()]),
+			InteractionLoop(
+				[Ig2_GridNode_GridNode_GridNodeGeom6D(),Ig2_Sphere_Sphere_ScGeom(),Ig2_Sphere_GridConnection_ScGridCoGeom(),Ig2_Sphere_PFacet_ScGridCoGeom()],
+				[Ip2_CohFrictMat_CohFrictMat_CohFrictPhys(setCohesionNow=True,setCohesionOnNewContacts=True),Ip2_FrictMat_FrictMat_FrictPhys()],
+				[Law2_ScGeom6D_CohFrictPhys_CohesionMoment(),Law2_ScGeom_FrictPhys_CundallStrack(),Law2_ScGridCoGeom_FrictPhys_CundallStrack()]
+			),
+			NewtonIntegrator(damping=.2,gravity=(0,0,-9.81))
+		]
+		nodesIds,cylIds,pfIds=[],[],[]
+		n=4
+		for i in range(n):
+			for j in range(n):
+				a,b,c,d=[Vector3(float(x)/n,float(y)/n,0) for x,y in ((i,j),(i+1,j),(i+1,j+1),(i,j+1))]
+				for vertices in ([a,b,c],[a,c,d]): gridpfacet.pfacetCreator1(vertices,.02,nodesIds=nodesIds,cylIds=cylIds,pfIds=pfIds,fixed=True,materialNodes='gridNodeMat',material='gridConnectionMat')
+		for i in range(3):
+			for j in range(3):
+				for k in range(2):
+					O.bodies.append(utils.sphere((.2+.3*i+.02*random.random(),.2+.3*j+.02*random.random(),.1+.2*k),.08,material='gridConnectionMat'))
+		# appended last, so that ids of other bodies are the same in both simulations
+		if mesh: O.bodies.append(gridpfacet.gridMesh(cylIds+pfIds,selfCollide=True))
+		O.dt=.5*utils.PWaveTimeStep()
+		elements=set(cylIds+pfIds)
+		ret=[]
+		for step in range(5):
+			O.run(200,True)
+			ret.append(sorted([(min(i.id1,i.id2),max(i.id1,i.id2)) for i in O.interactions if i.isReal and (i.id1 in elements or i.id2 in elements)]))
+		return ret
+	def testSameContacts(self):
+		"Engines: real interactions of spheres with PFacets and GridConnections are the same with and without gridMesh"
+		flat=self.simulate(False)
+		grouped=self.simulate(True)
+		self.assert_(len(flat[-1])>0)
+		for n in range(len(flat)): self.assertEqual(grouped[n],flat[n])
+
+class TestStatsEngine(unittest.TestCase):
+	"StatsEngine gives the same values as the functions of yade.utils it replaces."
+	def simulate(self,splitFabric):
+		from yade import pack
+		O.reset()
+		sp=pack.SpherePack()
+		sp.makeCloud((0,0,0),(1,1,1),rMean=.1,rRelFuzz=.3,seed=1)
+		# enlarged spheres, so that there are contacts from the first step
+		O.bodies.append([utils.sphere(c,1.2*r) for c,r in sp])
+		O.bodies[0].state.blockedDOFs='xyzXYZ'
+		O.engines=[
+			ForceResetter(),
+			InsertionSortCollider([Bo1_Sphere_Aabb()]),
+			InteractionLoop([Ig2_Sphere_Sphere_ScGeom()],[Ip2_FrictMat_FrictMat_FrictPhys()],[Law2_ScGeom_FrictPhys_CundallStrack()]),
+			NewtonIntegrator(damping=.4,gravity=(0,0,-9.81)),
+			StatsEngine(iterPeriod=1,computeFabric=True,computeBodyStress=True,splitFabric=splitFabric,label='stats')
+		]
+		O.dt=.5*utils.PWaveTimeStep()
+		O.run(20,True)
+	def assertClose(self,a,b):
+		self.assert_(abs(a-b)<=1e-9*abs(b))
+	def assertMatClose(self,a,b):
+		self.assert_((a-b).norm()<=1e-9*b.norm())
+	def check(self,splitFabric):
+		self.simulate(splitFabric)
+		self.assert_(len([i for i in O.interactions if i.isReal])>0)
+		self.assertClose(stats.unbalancedForce,utils.unbalancedForce())
+		self.assertClose(stats.maxUnbalancedForce,utils.unbalancedForce(useMaxForce=True))
+		self.assertClose(stats.kineticEnergy,utils.kineticEnergy())
+		self.assertMatClose(stats.stress,utils.getStress())
+		self.assertMatClose(stats.fabric,utils.fabricTensor()[0])
+		if splitFabric:
+			strong,weak=utils.fabricTensor(splitTensor=True)
+			self.assertMatClose(stats.fabricStrong,strong)
+			self.assertMatClose(stats.fabricWeak,weak)
+		bodyStresses=utils.bodyStressTensors()
+		self.assertEqual(len(stats.bodyStresses),len(bodyStresses))
+		for s,ref in zip(stats.bodyStresses,bodyStresses): self.assert_((s-ref).norm()<=1e-9*max(ref.norm(),1e-30))
+	def testSameAsUtils(self):
+		"Engines: StatsEngine gives the values of unbalancedForce, kineticEnergy, getStress, fabricTensor and bodyStressTensors"
+		self.check(False)
+	def testSameAsUtilsSplitFabric(self):
+		"Engines: StatsEngine gives the values of utils.fabricTensor(splitTensor=True) with splitFabric"
+		self.check(True)
@@ -0,0 +1,74 @@
+# encoding: utf-8
+'''
+Columnar storage of yade.plot data (yade._plotData.DataStore) compared with the default dictionary of lists.
+'''
+
+import unittest,math,os,tempfile
+from yade import plot
+from minieigen import *
+
+class TestColumnarPlotData(unittest.TestCase):
+	"plot.addData and friends give the same columns with plot.columnar=True as with the list backend."
+	def setUp(self): self.columnar=plot.columnar
+	def tearDown(self):
+		plot.columnar=self.columnar
+		plot.reset()
+	def fill(self,columnar):
+		plot.columnar=columnar
+		plot.reset()
+		for i in range(100):
+			d={'i':i,'x':.1*i,'y':math.sin(.1*i)}
+			if i>=30: d['late']=i*i           # column appearing later, NaN in previous rows
+			if i%7: d['sparse']=-i            # missing in some rows
+			if i==50: d['v']=Vector3(1,2,3)   # synthesized vx,vy,vz columns
+			plot.addData(**d)
+		plot.addDataColumns(['empty'])
+	def columns(self):
+		return dict([(k,[float(v) for v in plot.data[k]]) for k in plot.data.keys()])
+	def assertSameColumns(self,a,b):
+		self.assertEqual(sorted(a.keys()),sorted(b.keys()))
+		for k in a:
+			self.assertEqual(len(a[k]),len(b[k]))
+			for u,v in zip(a[k],b[k]):
+				if math.isnan(u): self.assert_(math.isnan(v),k)
+				else: self.assertEqual(u,v,k)
+	def testAddData(self):
+		"plot: columnar data equal list data after addData"
+		self.fill(False); ref=self.columns()
+		self.fill(True)
+		self.assert_(isinstance(plot.data,plot.DataStore))
+		self.assertSameColumns(self.columns(),ref)
+	def testReverse(self):
+		"plot: reverseData on columnar data"
+		self.fill(False); plot.reverseData(); ref=self.columns()
+		self.fill(True); plot.reverseData()
+		self.assertSameColumns(self.columns(),ref)
+	def testSaveDataTxt(self):
+		"plot: saveDataTxt writes the same values for both backends (integers are written as floats by the columnar one)"
+		import numpy
+		fd,name=tempfile.mkstemp(suffix='.txt'); os.close(fd)
+		try:
+			self.fill(False); plot.saveDataTxt(name,vars=('i','x','late')); ref=numpy.genfromtxt(name,names=True)
+			self.fill(True); plot.saveDataTxt(name,vars=('i','x','late')); d=numpy.genfromtxt(name,names=True)
+			self.assertSameColumns(dict([(k,list(d[k])) for k in ('i','x','late')]),dict([(k,list(ref[k])) for k in ('i','x','late')]))
+		finally: os.remove(name)
+	def testBinaryRoundTrip(self):
+		"plot: saveDataBinary/loadDataBinary round-trip from and to both backends"
+		fd,name=tempfile.mkstemp(suffix='.bin'); os.close(fd)
+		try:
+			self.fill(False); ref=self.columns(); plot.saveDataBinary(name)
+			for columnar in (False,True):
+				plot.columnar=columnar; plot.reset(); plot.loadDataBinary(name)
+				self.assertSameColumns(self.columns(),ref)
+			self.fill(True); plot.saveDataBinary(name)
+			plot.columnar=False; plot.reset(); plot.loadDataBinary(name)
+			self.assertSameColumns(self.columns(),ref)
+		finally: os.remove(name)
+	def testDecimated(self):
+		"plot: decimated columns keep the end points and return all rows when they are few"
+		self.fill(True)
+		x,y=plot.data.decimated('x','y',10,'lttb')
+		self.assert_(len(x)<=12 and len(x)==len(y))
+		self.assertEqual((x[0],x[-1]),(plot.data['x'][0],plot.data['x'][-1]))
+		x,y=plot.data.decimated('x','y',1000,'lttb')
+		self.assertEqual(list(x),list(plot.data['x']))
@@ -0,0 +1,45 @@
+# encoding: utf-8
+'''
+Random packings generated by SpherePack::makeCloud.
+'''
+
+import unittest
+from yade.wrapper import *
+from yade._customConverters import *
+from yade import pack
+from yade import *
+from math import *
+from minieigen import *
+
+class TestMakeCloud(unittest.TestCase):
+	"makeCloud is deterministic for a given seed (trial positions are tested in parallel batches, the accepted one must not depend on scheduling)."
+	def cloud(self,**kw):
+		sp=pack.SpherePack()
+		n=sp.makeCloud(seed=5,**kw)
+		self.assert_(n>0)
+		self.assertEqual(n,len(sp))
+		return [(tuple(c),r) for c,r in sp]
+	def checkSame(self,**kw):
+		a=self.cloud(**kw)
+		self.assertEqual(a,self.cloud(**kw))
+		return a
+	def testBox(self):
+		"makeCloud: same seed, same packing (aperiodic box, stochastic sizes)"
+		sp=self.checkSame(minCorner=(0,0,0),maxCorner=(1,1,1),rMean=.05,rRelFuzz=.3)
+		# no overlap between generated spheres
+		for i in range(len(sp)):
+			for j in range(i+1,len(sp)):
+				self.assert_((Vector3(sp[i][0])-Vector3(sp[j][0])).norm()>=sp[i][1]+sp[j][1])
+	def testNum(self):
+		"makeCloud: same seed, same packing (imposed number of spheres and porosity)"
+		self.checkSame(minCorner=(0,0,0),maxCorner=(1,1,1),rRelFuzz=.3,num=300,porosity=.6)
+	def testPeriodic(self):
+		"makeCloud: same seed, same packing (periodic, sheared cell)"
+		self.checkSame(rMean=.06,rRelFuzz=.2,periodic=True,hSize=Matrix3(1,.3,0, 0,1,0, 0,0,1))
+	def testPsd(self):
+		"makeCloud: same seed, same packing (particle size distribution, 2D box)"
+		self.checkSame(minCorner=(0,0,0),maxCorner=(1,1,0),psdSizes=[.04,.06,.1],psdCumm=[0,.5,1.],num=100)
+	def testDifferentSeeds(self):
+		"makeCloud: different seeds give different packings"
+		sp=pack.SpherePack(); sp.makeCloud((0,0,0),(1,1,1),rMean=.05,rRelFuzz=.3,seed=6)
+		self.assertNotEqual(self.cloud(minCorner=(0,0,0),maxCorner=(1,1,1),rMean=.05,rRelFuzz=.3),[(tuple(c),r) for c,r in sp])
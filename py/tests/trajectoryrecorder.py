@@ -0,0 +1,79 @@
+# encoding: utf-8
+'''
+TrajectoryRecorder files read back with yade.trajectory.
+'''
+
+import unittest,os,tempfile,random
+from yade.wrapper import *
+from yade._customConverters import *
+from yade import utils
+from yade import *
+from minieigen import *
+
+class TestTrajectoryRoundTrip(unittest.TestCase):
+	"Frames read by yade.trajectory.TrajectoryReader match the state of bodies when they were recorded."
+	def setUp(self):
+		O.reset()
+		fd,self.fileName=tempfile.mkstemp(suffix='.trj'); os.close(fd)
+		random.seed(3)
+		O.bodies.append(utils.wall(0,axis=2))
+		for i in range(20):
+			b=utils.sphere((random.random(),random.random(),.2+random.random()),.05+.03*random.random())
+			b.state.angVel=(random.random(),random.random(),random.random())
+			O.bodies.append(b)
+		self.recorder=TrajectoryRecorder(file=self.fileName,truncate=True,iterPeriod=5,keyframeInterval=3,recordAngVel=True,scalars=['radius','mass'])
+		self.snapshots={}
+		runner=PyRunner(iterPeriod=5,initRun=True)
+		runner.callable=self.snapshot
+		O.engines=[
+			ForceResetter(),
+			InsertionSortCollider([Bo1_Sphere_Aabb(),Bo1_Wall_Aabb()]),
+			InteractionLoop([Ig2_Sphere_Sphere_ScGeom(),Ig2_Wall_Sphere_ScGeom()],[Ip2_FrictMat_FrictMat_FrictPhys()],[Law2_ScGeom_FrictPhys_CundallStrack()]),
+			NewtonIntegrator(damping=0,gravity=(0,0,-9.81)),
+			self.recorder,
+			runner
+		]
+		O.dt=.5*utils.PWaveTimeStep()
+	def tearDown(self):
+		O.reset()
+		os.remove(self.fileName)
+	def snapshot(self):
+		self.snapshots[O.iter]=dict([(b.id,(b.state.pos,b.state.ori,b.state.vel,b.state.angVel,b.shape.radius if isinstance(b.shape,Sphere) else float('nan'),b.state.mass)) for b in O.bodies])
+	def check(self,fr,keyframe):
+		import math
+		ref=self.snapshots[fr['iter']]
+		self.assertEqual(sorted(fr['ids']),sorted(ref.keys()))
+		tol=(0,0,0) if keyframe else (self.recorder.posPrecision,10*self.recorder.oriPrecision,self.recorder.velPrecision)
+		for k,id in enumerate(fr['ids']):
+			pos,ori,vel,angVel,radius,mass=ref[id]
+			for i in range(3):
+				self.assertTrue(abs(fr['pos'][k][i]-pos[i])<=tol[0])
+				self.assertTrue(abs(fr['vel'][k][i]-vel[i])<=tol[2])
+				self.assertTrue(abs(fr['angVel'][k][i]-angVel[i])<=tol[2])
+			for i,q in enumerate((ori[3],ori[0],ori[1],ori[2])): self.assertTrue(abs(fr['ori'][k][i]-q)<=tol[1])
+			# scalars are stored as float32
+			if math.isnan(radius): self.assertTrue(math.isnan(fr['radius'][k]))
+			else: self.assertAlmostEqual(fr['radius'][k]/radius,1.,places=6)
+			self.assertTrue(abs(fr['mass'][k]-mass)<=1e-6*mass)
+	def testRoundTrip(self):
+		"TrajectoryRecorder: frames read back match the recorded state, within the precision of difference frames"
+		from yade import trajectory
+		O.run(50,True)
+		erased=O.bodies[5].id; O.bodies.erase(erased) # the set of bodies changes, the next frame is a keyframe
+		O.run(30,True)
+		traj=trajectory.TrajectoryReader(self.fileName)
+		self.assertEqual(len(traj),self.recorder.nFrames)
+		self.assertEqual(list(traj.iters),sorted(self.snapshots.keys()))
+		nKey=0
+		for i in range(len(traj)):
+			keyframe=(traj._frames[i][2]==i)
+			nKey+=keyframe
+			fr=traj[i]
+			self.check(fr,keyframe)
+			if fr['iter']>50: self.assertFalse(erased in fr['ids'])
+		self.assertEqual(nKey,self.recorder.nKeyframes)
+		self.assertTrue(nKey<len(traj))
+		# random access gives the same frames as sequential access
+		last=traj[-1]
+		for name in ('pos','ori','vel'): self.assertTrue((last[name]==list(traj)[-1][name]).all())
+		traj.close()
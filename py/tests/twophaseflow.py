@@ -0,0 +1,57 @@
+'''
+Quasi-static invasion in TwoPhaseFlowEngine.
+'''
+
+import unittest
+from yade.wrapper import *
+from yade._customConverters import *
+from yade import utils,pack,config
+from yade import *
+from math import *
+from minieigen import *
+
+@unittest.skipIf('TWOPHASEFLOW' not in config.features,'TwoPhaseFlowEngine not compiled')
+class TestInvasionPercolation(unittest.TestCase):
+	"Heap-based invasionPercolation on a small loose packing, compared with the step-wise invasion."
+	def setUp(self):
+		O.reset()
+		mn,mx=Vector3(0,0,0),Vector3(1,1,1)
+		O.bodies.append(utils.aabbWalls([mn,mx],thickness=0))
+		sp=pack.SpherePack()
+		sp.makeCloud(mn,mx,rMean=.08,rRelFuzz=.3,seed=1)
+		sp.toSimulation()
+		self.flow=TwoPhaseFlowEngine(bndCondIsPressure=[0,0,1,1,0,0],bndCondValue=[0,0,0,0,0,0],isDrainageActivated=True,isImbibitionActivated=False)
+		O.engines=[self.flow]
+		self.flow.initialization()
+		self.minPc=self.flow.getMinDrainagePc()
+	def reset(self,trapped):
+		self.flow.bndCondValue=[0,0,0,0,0,0]
+		self.flow.isPhaseTrapped=trapped
+		self.flow.initialization()
+	def testSameAsStepwiseInvasion(self):
+		"TwoPhaseFlow: invasionPercolation and invasion give the same saturation without trapping"
+		for f in (1.2,2.,4.):
+			pc=f*self.minPc
+			self.reset(False)
+			self.flow.invasionPercolation(pc)
+			s1=self.flow.getSaturation(False)
+			self.reset(False)
+			self.flow.bndCondValue=[0,0,0,pc,0,0]
+			self.flow.invasion()
+			self.assertAlmostEqual(s1,self.flow.getSaturation(False))
+	def testCurveLabels(self):
+		"TwoPhaseFlow: each point of the drainage curve is reached by stopping at its capillary pressure"
+		self.reset(True)
+		pcMax=4*self.minPc
+		curve=self.flow.invasionPercolation(pcMax)
+		self.assert_(len(curve)>2)
+		pcs=[c[0] for c in curve]; sats=[c[1] for c in curve]
+		self.assertEqual(pcs,sorted(pcs))
+		self.assert_(pcs[-1]<=pcMax)
+		self.assertEqual(sats,sorted(sats,reverse=True))
+		# labels must not be inflated by trapped events, stopping at a label gives the saturation of that point
+		for k in (0,len(curve)//2,len(curve)-1):
+			self.reset(True)
+			c=self.flow.invasionPercolation(pcs[k])
+			self.assertAlmostEqual(c[-1][0],pcs[k])
+			self.assertAlmostEqual(c[-1][1],sats[k])
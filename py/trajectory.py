@@ -0,0 +1,130 @@
+# encoding: utf-8
+"""
+Reading trajectories written by :yref:`TrajectoryRecorder`.
+
+Example
+=======
+::
+
+ O.engines=O.engines+[TrajectoryRecorder(file='/tmp/traj.bin',iterPeriod=100,scalars=['radius'])]
+ O.run(10000,True)
+
+ from yade import trajectory
+ traj=trajectory.TrajectoryReader('/tmp/traj.bin')
+ print len(traj),traj.iters[-1]
+ last=traj[-1]              # random access, decodes only the last keyframe and the last frame
+ print last['pos'].shape    # (number of bodies, 3)
+ for fr in traj: pass       # sequential access
+
+File format
+===========
+All values are stored in the byte order of the machine which wrote the file. The file starts with the 8 bytes ``YADETRJ1`` and the ``uint32`` value ``0x01020304`` (to check the byte order), followed by frames. Each frame has a 64 bytes header:
+
+============= ======== =====================================================
+field         type     meaning
+============= ======== =====================================================
+magic         char[4]  ``FRAM``
+kind          uint8    0 for keyframes, 1 for difference frames
+fields        uint8    bits: 1 orientation, 2 velocity, 4 angular velocity
+intBytes      uint8    size of quantized differences (2 or 4), 0 for keyframes
+nScalars      uint8    number of additional scalars
+iter          int64    :yref:`O.iter<Omega.iter>`
+time          float64  :yref:`O.time<Omega.time>`
+nBodies       uint32   number of recorded bodies
+(reserved)    uint32
+precisions    float64  ×3 for positions, orientations and velocities
+payloadBytes  uint64   size of the data following the header
+============= ======== =====================================================
+
+Keyframe data: names of scalars (``uint8`` length and characters), ids (``int32``), then ``float64`` values of positions (n×3), orientations (n×4, w,x,y,z), velocities (n×3) and angular velocities (n×3) -- depending on *fields* -- and finally scalars (``float32``, nScalars×n). Difference frames contain the same values, without names and ids, as integers: the value is ``keyValue+precision*difference``, where ``keyValue`` comes from the last keyframe before the frame.
+"""
+import numpy,struct,os
+
+_frameHeader=struct.Struct('4sBBBBqdII3dQ')
+
+class TrajectoryReader(object):
+	"""Random-access reader of a :yref:`TrajectoryRecorder` file. Only frame headers are read when opening the file; frames are decoded on demand and returned as dictionaries with keys ``iter``, ``time``, ``ids``, ``pos``, ``ori`` (quaternions as w,x,y,z), ``vel``, ``angVel`` (the last three only if recorded) and names of recorded scalars; all arrays are NumPy arrays with one row per body."""
+	def __init__(self,fileName):
+		self.fileName=fileName
+		self._f=open(fileName,'rb')
+		magic=self._f.read(8)
+		if magic!=b'YADETRJ1': raise IOError("%s is not a trajectory file."%fileName)
+		probe=self._f.read(4)
+		if struct.unpack('<I',probe)[0]==0x01020304: self._endian='<'
+		elif struct.unpack('>I',probe)[0]==0x01020304: self._endian='>'
+		else: raise IOError("%s: unable to determine byte order."%fileName)
+		self._header=struct.Struct(self._endian+_frameHeader.format)
+		self.iters,self.times=[],[]
+		self._frames=[] # (offset of the data, header tuple, index of the keyframe)
+		self._keyCache=(None,None)
+		lastKey=None
+		while True:
+			pos=self._f.tell()
+			buf=self._f.read(self._header.size)
+			if len(buf)<self._header.size: break
+			h=self._header.unpack(buf)
+			if h[0]!=b'FRAM': raise IOError("%s: corrupted frame at offset %d."%(fileName,pos))
+			if h[12]+self._f.tell()>self._fileSize(): break # frame being written
+			if h[1]==0: lastKey=len(self._frames)
+			elif lastKey is None: raise IOError("%s: difference frame without keyframe at offset %d."%(fileName,pos))
+			self._frames.append((pos+self._header.size,h,lastKey))
+			self.iters.append(h[5]); self.times.append(h[6])
+			self._f.seek(h[12],1)
+	def _fileSize(self):
+		return os.fstat(self._f.fileno()).st_size
+	def __len__(self): return len(self._frames)
+	def __iter__(self):
+		for i in range(len(self)): yield self[i]
+	def _readArray(self,dtype,count):
+		dt=numpy.dtype(dtype).newbyteorder(self._endian)
+		return numpy.frombuffer(self._f.read(count*dt.itemsize),dtype=dt,count=count)
+	def _layout(self,h):
+		n,fields=h[7],h[2]
+		ret=[('pos',3)]
+		if fields&1: ret.append(('ori',4))
+		if fields&2: ret.append(('vel',3))
+		if fields&4: ret.append(('angVel',3))
+		return n,ret
+	def _readKey(self,k):
+		if self._keyCache[0]==k: return self._keyCache[1]
+		off,h,_=self._frames[k]
+		self._f.seek(off)
+		names=[]
+		for s in range(h[4]):
+			l=struct.unpack('B',self._f.read(1))[0]
+			names.append(self._f.read(l).decode())
+		n,layout=self._layout(h)
+		ids=self._readArray('i4',n)
+		values=self._readArray('f8',sum(n*c for name,c in layout))
+		scalars=self._readArray('f4',h[4]*n)
+		key=dict(names=names,ids=ids,values=values,scalars=scalars)
+		self._keyCache=(k,key)
+		return key
+	def __getitem__(self,i):
+		if i<0: i+=len(self)
+		if i<0 or i>=len(self): raise IndexError("Frame index out of range.")
+		off,h,k=self._frames[i]
+		key=self._readKey(k)
+		n,layout=self._layout(h)
+		if h[1]==0:
+			values,scalars=key['values'],key['scalars']
+		else:
+			self._f.seek(off)
+			size=sum(n*c for name,c in layout)
+			q=self._readArray('i2' if h[3]==2 else 'i4',size)
+			scalars=self._readArray('f4',h[4]*n)
+			values=numpy.empty(size)
+			start=0
+			for name,c in layout:
+				prec=h[9] if name=='pos' else (h[10] if name=='ori' else h[11])
+				values[start:start+n*c]=key['values'][start:start+n*c]+prec*q[start:start+n*c]
+				start+=n*c
+		ret=dict(iter=h[5],time=h[6],ids=key['ids'].copy())
+		start=0
+		for name,c in layout:
+			ret[name]=values[start:start+n*c].reshape(n,c).copy()
+			start+=n*c
+		if 'ori' in ret and h[1]!=0: ret['ori']/=numpy.sqrt((ret['ori']**2).sum(axis=1))[:,None]
+		for s,name in enumerate(key['names']): ret[name]=scalars[s*n:(s+1)*n].copy()
+		return ret
+	def close(self): self._f.close()
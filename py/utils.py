@@ -266,6 +266,24 @@ def facet(vertices,dynamic=None,fixed=True,wire=True,color=None,highlight=False,
 	return b
 
 
+def triMesh(vertices,triangles,center=None,dynamic=None,fixed=True,wire=True,color=None,highlight=False,noBound=False,material=-1,mask=1):
+	"""Create one body with :yref:`TriMesh` shape from a triangulated surface.
+
+	:param [Vector3,…] vertices: coordinates of vertices in the global coordinate system.
+	:param [Vector3i,…] triangles: triples of indices into *vertices*.
+	:param Vector3-or-None center: position of the body (vertices are stored relative to it); the mean of vertices is used if ``None``.
+
+	See :yref:`yade.utils.sphere`'s documentation for meaning of other parameters."""
+	b=Body()
+	if center is None: center=sum([Vector3(v) for v in vertices],Vector3.Zero)/max(len(vertices),1)
+	b.shape=TriMesh(color=color if color else randomColor(),wire=wire,highlight=highlight)
+	b.shape.setMesh([Vector3(v)-center for v in vertices],[Vector3i(t) for t in triangles])
+	_commonBodySetup(b,0,Vector3(0,0,0),material,noBound=noBound,pos=center,dynamic=dynamic,fixed=fixed)
+	b.aspherical=False
+	b.mask=mask
+	return b
+
+
 def tetraPoly(vertices,dynamic=True,fixed=False,wire=True,color=None,highlight=False,noBound=False,material=-1,mask=1,chain=-1):
 	"""Create tetrahedron (actually simple Polyhedra) with given parameters.
 
@@ -29,6 +29,7 @@
 
 #include <core/Clump.hpp>
 #include <pkg/common/Sphere.hpp>
+#include <pkg/common/Aabb.hpp>
 #include <boost/math/special_functions/nonfinite_num_facets.hpp>
 
 #include <locale>
@@ -42,9 +43,19 @@
 #include <csignal>
 
 #include <pkg/common/KinematicEngines.hpp>
+#include <pkg/common/NormShearPhys.hpp>
+#include <pkg/dem/ScGeom.hpp>
+#include <lib/pyutil/numpy_boost.hpp>
 
 namespace py = boost::python;
 
+/*
+Bulk access to bodies, interactions and forces as numpy arrays (BodyContainer.array and friends).
+Arrays are allocated once and filled in parallel straight from c++ data, no python object is created per body.
+*/
+template<class T, int NDims> py::object numpyObject(const numpy_boost<T,NDims>& arr){ return py::object(py::handle<>(py::borrowed(arr.py_ptr()))); }
+void bulkError(PyObject* type, const string& msg){ PyErr_SetString(type,msg.c_str()); py::throw_error_already_set(); }
+
 /*
 Python normally iterates over object it is has __getitem__ and __len__, which BodyContainer does.
 However, it will not skip removed bodies automatically, hence this iterator which does just that.
@@ -392,6 +403,192 @@ class pyBodyContainer{
 		return RC_sum/c;	//return roundness coefficient RC
 	}
 	vector<Body::id_t> replace(vector<shared_ptr<Body> > bb){proxee->clear(); return appendList(bb);}
+	shared_ptr<Material> materialFromPy(py::object material){
+		Scene* scene(Omega::instance().getScene().get());
+		py::extract<shared_ptr<Material> > instance(material);
+		if(instance.check()) return instance();
+		py::extract<string> label(material);
+		if(label.check()){
+			FOREACH(const shared_ptr<Material>& m, scene->materials){ if(m->label==label()) return m; }
+			PyErr_SetString(PyExc_KeyError,("No material labeled '"+label()+"'.").c_str()); py::throw_error_already_set();
+		}
+		py::extract<int> index(material);
+		if(!index.check()){ PyErr_SetString(PyExc_TypeError,"The 'material' argument must be int (shared material id), string (shared material label) or Material instance."); py::throw_error_already_set(); }
+		int id=index();
+		// same as utils.sphere: default material is created if there is no shared material yet
+		if(id<0 && scene->materials.empty()) scene->addMaterial(py::extract<shared_ptr<Material> >(py::import("yade.utils").attr("defaultMaterial")())());
+		if(id<0) id+=scene->materials.size();
+		if(id<0 || (size_t)id>=scene->materials.size()){ PyErr_SetString(PyExc_IndexError,"Material id out of range."); py::throw_error_already_set(); }
+		return scene->materials[id];
+	}
+	vector<Body::id_t> appendSpheres(py::object pyCenters, py::object pyRadii, py::object material, int mask, bool fixed, py::object color, bool wire){
+		numpy_boost<Real,2> centers(pyCenters.ptr());
+		numpy_boost<Real,1> radii(pyRadii.ptr());
+		const long n=centers.shape()[0];
+		if(centers.shape()[1]!=3){ PyErr_SetString(PyExc_ValueError,"centers must have shape (n,3)."); py::throw_error_already_set(); }
+		if((long)radii.shape()[0]!=n){ PyErr_SetString(PyExc_ValueError,"centers and radii must have the same length."); py::throw_error_already_set(); }
+		const shared_ptr<Material> mat=materialFromPy(material);
+		const bool randomColor=(color.ptr()==Py_None);
+		const Vector3r fixedColor(randomColor ? Vector3r::Ones() : py::extract<Vector3r>(color)());
+		const Body::id_t first=proxee->size();
+		// construct bodies in parallel; the container itself is only touched once, below
+		vector<shared_ptr<Body> > bb(n);
+		#ifdef YADE_OPENMP
+		#pragma omp parallel for
+		#endif
+		for(long k=0; k<n; k++){
+			const Real r=radii[k];
+			const shared_ptr<Body> b(new Body);
+			const shared_ptr<Sphere> sphere(new Sphere(r));
+			if(randomColor){
+				// deterministic per-id color, independent of the number of threads
+				boost::minstd_rand rng((first+k+1)*2654435761u);
+				boost::variate_generator<boost::minstd_rand&,boost::uniform_real<> > rnd(rng,boost::uniform_real<>(0,1));
+				rnd(); sphere->color=Vector3r(rnd(),rnd(),rnd());
+			} else sphere->color=fixedColor;
+			sphere->wire=wire;
+			b->shape=sphere;
+			b->material=mat;
+			b->state=mat->newAssocState();
+			const Real mass=(4./3.)*Mathr::PI*r*r*r*mat->density;
+			b->state->mass=mass;
+			b->state->inertia=Vector3r::Constant((2./5.)*mass*r*r);
+			b->state->pos=b->state->refPos=Vector3r(centers[k][0],centers[k][1],centers[k][2]);
+			if(fixed) b->setDynamic(false);
+			b->groupMask=mask;
+			b->bound=shared_ptr<Aabb>(new Aabb);
+			bb[k]=b;
+		}
+		boost::mutex::scoped_lock lock(Omega::instance().renderMutex);
+		proxee->insertBatch(bb);
+		vector<Body::id_t> ret(n); for(long k=0; k<n; k++) ret[k]=first+k;
+		return ret;
+	}
+	py::object array(const string& attr){
+		const long N=proxee->size();
+		const BodyContainer& bodies=*proxee;
+		int vec=-1;
+		if(attr=="pos") vec=0; else if(attr=="vel") vec=1; else if(attr=="angVel") vec=2; else if(attr=="angMom") vec=3;
+		else if(attr=="refPos") vec=4; else if(attr=="inertia") vec=5; else if(attr=="color") vec=6;
+		if(vec>=0){
+			int dims[]={(int)N,3}; numpy_boost<Real,2> ret(dims); Real* data=ret.data();
+			#ifdef YADE_OPENMP
+			#pragma omp parallel for
+			#endif
+			for(long id=0; id<N; id++){
+				const shared_ptr<Body>& b=bodies[id];
+				Vector3r v(NaN,NaN,NaN);
+				if(b) switch(vec){
+					case 0: v=b->state->pos; break;
+					case 1: v=b->state->vel; break;
+					case 2: v=b->state->angVel; break;
+					case 3: v=b->state->angMom; break;
+					case 4: v=b->state->refPos; break;
+					case 5: v=b->state->inertia; break;
+					case 6: if(b->shape) v=b->shape->color; break;
+				}
+				for(int k=0; k<3; k++) data[3*id+k]=v[k];
+			}
+			return numpyObject(ret);
+		}
+		if(attr=="ori"){
+			int dims[]={(int)N,4}; numpy_boost<Real,2> ret(dims); Real* data=ret.data();
+			#ifdef YADE_OPENMP
+			#pragma omp parallel for
+			#endif
+			for(long id=0; id<N; id++){
+				const shared_ptr<Body>& b=bodies[id];
+				Quaternionr q(b ? b->state->ori : Quaternionr(NaN,NaN,NaN,NaN));
+				data[4*id]=q.w(); data[4*id+1]=q.x(); data[4*id+2]=q.y(); data[4*id+3]=q.z();
+			}
+			return numpyObject(ret);
+		}
+		if(attr=="mass" || attr=="radius"){
+			const bool mass=(attr=="mass");
+			int dims[]={(int)N}; numpy_boost<Real,1> ret(dims); Real* data=ret.data();
+			#ifdef YADE_OPENMP
+			#pragma omp parallel for
+			#endif
+			for(long id=0; id<N; id++){
+				const shared_ptr<Body>& b=bodies[id];
+				data[id]=NaN;
+				if(!b) continue;
+				if(mass) data[id]=b->state->mass;
+				else { Sphere* sphere=dynamic_cast<Sphere*>(b->shape.get()); if(sphere) data[id]=sphere->radius; }
+			}
+			return numpyObject(ret);
+		}
+		int flag=-1;
+		if(attr=="blockedDOFs") flag=0; else if(attr=="isDynamic") flag=1; else if(attr=="clumpId") flag=2;
+		#ifndef YADE_MASK_ARBITRARY
+			else if(attr=="mask") flag=3;
+		#endif
+		if(flag>=0){
+			int dims[]={(int)N}; numpy_boost<int,1> ret(dims); int* data=ret.data();
+			#ifdef YADE_OPENMP
+			#pragma omp parallel for
+			#endif
+			for(long id=0; id<N; id++){
+				const shared_ptr<Body>& b=bodies[id];
+				data[id]=-1;
+				if(b) switch(flag){
+					case 0: data[id]=b->state->blockedDOFs; break;
+					case 1: data[id]=b->isDynamic(); break;
+					case 2: data[id]=b->clumpId; break;
+					#ifndef YADE_MASK_ARBITRARY
+					case 3: data[id]=b->groupMask; break;
+					#endif
+				}
+			}
+			return numpyObject(ret);
+		}
+		bulkError(PyExc_KeyError,"Unknown body attribute '"+attr+"' (pos, vel, angVel, angMom, refPos, inertia, color, ori, mass, radius, blockedDOFs, isDynamic, clumpId, mask).");
+		return py::object(); // never reached
+	}
+	void setArray(const string& attr, py::object values, py::object pyIds){
+		const BodyContainer& bodies=*proxee;
+		vector<Body::id_t> ids;
+		if(pyIds.ptr()!=Py_None) ids=py::extract<vector<Body::id_t> >(pyIds)();
+		// rows are body ids unless ids are given explicitly
+		FOREACH(Body::id_t id, ids) if(id<0 || (size_t)id>=bodies.size()) bulkError(PyExc_IndexError,"Body id out of range.");
+		int vec=-1;
+		if(attr=="vel") vec=1; else if(attr=="angVel") vec=2; else if(attr=="color") vec=6;
+		if(vec>=0){
+			numpy_boost<Real,2> arr(values.ptr());
+			const long n=arr.shape()[0];
+			if(arr.shape()[1]!=3) bulkError(PyExc_ValueError,"Array of shape (n,3) expected.");
+			if((ids.empty() && (size_t)n!=bodies.size()) || (!ids.empty() && (size_t)n!=ids.size())) bulkError(PyExc_ValueError,"Number of rows must match the number of ids (or of bodies if no ids are given).");
+			#ifdef YADE_OPENMP
+			#pragma omp parallel for
+			#endif
+			for(long k=0; k<n; k++){
+				const shared_ptr<Body>& b=bodies[ids.empty() ? k : ids[k]];
+				const Vector3r v(arr[k][0],arr[k][1],arr[k][2]);
+				if(!b || std::isnan(v[0]) || std::isnan(v[1]) || std::isnan(v[2])) continue; // rows with NaN are skipped
+				switch(vec){
+					case 1: b->state->vel=v; break;
+					case 2: b->state->angVel=v; break;
+					case 6: if(b->shape) b->shape->color=v; break;
+				}
+			}
+			return;
+		}
+		if(attr=="blockedDOFs"){
+			numpy_boost<int,1> arr(values.ptr());
+			const long n=arr.shape()[0];
+			if((ids.empty() && (size_t)n!=bodies.size()) || (!ids.empty() && (size_t)n!=ids.size())) bulkError(PyExc_ValueError,"Number of rows must match the number of ids (or of bodies if no ids are given).");
+			#ifdef YADE_OPENMP
+			#pragma omp parallel for
+			#endif
+			for(long k=0; k<n; k++){
+				const shared_ptr<Body>& b=bodies[ids.empty() ? k : ids[k]];
+				if(!b || arr[k]<0) continue; // negative values are skipped
+				b->state->blockedDOFs=(arr[k] & State::DOF_ALL);
+			}
+			return;
+		}
+		bulkError(PyExc_KeyError,"Body attribute '"+attr+"' can not be set in bulk (vel, angVel, color, blockedDOFs).");
+	}
 	long length(){return proxee->size();}
 	void clear(){proxee->clear();}
 	bool erase(Body::id_t id, bool eraseClumpMembers){ return proxee->erase(id,eraseClumpMembers); }
@@ -479,6 +676,51 @@ class pyInteractionContainer{
 		void serializeSorted_set(bool ss){proxee->serializeSorted=ss;}
 		void eraseNonReal(){ proxee->eraseNonReal(); }
 		void erase(Body::id_t id1, Body::id_t id2){ proxee->requestErase(id1,id2); }
+		py::object array(const string& attr){
+			// real interactions only, in container order (the same for all attributes as long as the container does not change)
+			vector<Interaction*> real; real.reserve(proxee->size());
+			FOREACH(const shared_ptr<Interaction>& I, *proxee){ if(I->isReal()) real.push_back(I.get()); }
+			const long N=real.size();
+			if(attr=="id1" || attr=="id2"){
+				const bool first=(attr=="id1");
+				int dims[]={(int)N}; numpy_boost<int,1> ret(dims); int* data=ret.data();
+				#ifdef YADE_OPENMP
+				#pragma omp parallel for
+				#endif
+				for(long k=0; k<N; k++) data[k]=(first ? real[k]->getId1() : real[k]->getId2());
+				return numpyObject(ret);
+			}
+			if(attr=="penetrationDepth"){
+				int dims[]={(int)N}; numpy_boost<Real,1> ret(dims); Real* data=ret.data();
+				#ifdef YADE_OPENMP
+				#pragma omp parallel for
+				#endif
+				for(long k=0; k<N; k++){ ScGeom* geom=dynamic_cast<ScGeom*>(real[k]->geom.get()); data[k]=(geom ? geom->penetrationDepth : NaN); }
+				return numpyObject(ret);
+			}
+			int vec=-1;
+			if(attr=="normalForce") vec=0; else if(attr=="shearForce") vec=1; else if(attr=="normal") vec=2; else if(attr=="contactPoint") vec=3;
+			if(vec>=0){
+				int dims[]={(int)N,3}; numpy_boost<Real,2> ret(dims); Real* data=ret.data();
+				#ifdef YADE_OPENMP
+				#pragma omp parallel for
+				#endif
+				for(long k=0; k<N; k++){
+					Vector3r v(NaN,NaN,NaN);
+					if(vec<2){
+						if(vec==0){ NormPhys* phys=dynamic_cast<NormPhys*>(real[k]->phys.get()); if(phys) v=phys->normalForce; }
+						else { NormShearPhys* phys=dynamic_cast<NormShearPhys*>(real[k]->phys.get()); if(phys) v=phys->shearForce; }
+					} else {
+						GenericSpheresContact* geom=dynamic_cast<GenericSpheresContact*>(real[k]->geom.get());
+						if(geom) v=(vec==2 ? geom->normal : geom->contactPoint);
+					}
+					for(int i=0; i<3; i++) data[3*k+i]=v[i];
+				}
+				return numpyObject(ret);
+			}
+			bulkError(PyExc_KeyError,"Unknown interaction attribute '"+attr+"' (id1, id2, normalForce, shearForce, normal, contactPoint, penetrationDepth).");
+			return py::object(); // never reached
+		}
 };
 
 class pyForceContainer{
@@ -502,6 +744,31 @@ class pyForceContainer{
 		long syncCount_get(){ return scene->forces.syncCount;}
 		void syncCount_set(long count){ scene->forces.syncCount=count;}
 		bool getPermForceUsed() {return scene->forces.getPermForceUsed();}
+		py::object array(const string& what, bool sync){
+			int which=-1;
+			if(what=="f") which=0; else if(what=="t") which=1; else if(what=="move") which=2; else if(what=="rot") which=3; else if(what=="permF") which=4; else if(what=="permT") which=5;
+			if(which<0) bulkError(PyExc_KeyError,"Unknown force container field '"+what+"' (f, t, move, rot, permF, permT).");
+			// permanent forces are only readable from a synced container
+			if(sync || which>=4) scene->forces.sync();
+			const long N=scene->bodies->size();
+			int dims[]={(int)N,3}; numpy_boost<Real,2> ret(dims); Real* data=ret.data();
+			#ifdef YADE_OPENMP
+			#pragma omp parallel for
+			#endif
+			for(long id=0; id<N; id++){
+				Vector3r v;
+				switch(which){
+					case 0: v=(sync ? scene->forces.getForce(id) : scene->forces.getForceSingle(id)); break;
+					case 1: v=(sync ? scene->forces.getTorque(id) : scene->forces.getTorqueSingle(id)); break;
+					case 2: v=scene->forces.getMoveSingle(id); break;
+					case 3: v=scene->forces.getRotSingle(id); break;
+					case 4: v=scene->forces.getPermForce(id); break;
+					default: v=scene->forces.getPermTorque(id); break;
+				}
+				for(int k=0; k<3; k++) data[3*id+k]=v[k];
+			}
+			return numpyObject(ret);
+		}
 };
 
 class pyMaterialContainer{
@@ -692,6 +959,20 @@ class pyOmega{
 		load(OMEGA.sceneFile,true);
 	}
 	int thisScene(){return OMEGA.currentSceneNb;}
+	void runScenes(py::object sceneIds, long nSteps, int workers, py::object ompThreads){
+		vector<int> ids, omp;
+		if(sceneIds.is_none()) for(int i=0; i<(int)OMEGA.scenes.size(); i++) ids.push_back(i);
+		else ids=py::extract<vector<int> >(sceneIds)();
+		if(py::extract<int>(ompThreads).check()) omp.push_back(py::extract<int>(ompThreads)());
+		else omp=py::extract<vector<int> >(ompThreads)();
+		// workers may run python code (PyRunner), the GIL must be released while they run
+		string error;
+		Py_BEGIN_ALLOW_THREADS;
+			try{ OMEGA.runScenesConcurrently(ids,nSteps,workers,omp); }
+			catch(std::exception& e){ error=e.what(); }
+		Py_END_ALLOW_THREADS;
+		if(!error.empty()) throw runtime_error(error);
+	}
 
 	void save(std::string fileName,bool quiet=false){
 		assertScene();
@@ -805,6 +1086,8 @@ class pyOmega{
 BOOST_PYTHON_MODULE(wrapper)
 {
 	py::scope().attr("__doc__")="Wrapper for c++ internals of yade.";
+	// numpy C-API, used by the bulk array accessors
+	if(_import_array()<0){ PyErr_Print(); LOG_ERROR("Unable to import numpy, bulk array accessors (O.bodies.array etc.) will not work."); }
 
 	YADE_SET_DOCSTRING_OPTS;
 
@@ -846,6 +1129,7 @@ BOOST_PYTHON_MODULE(wrapper)
 		.def("resetCurrentScene",&pyOmega::resetCurrentScene,"Reset current scene.")
 		.def("resetAllScenes",&pyOmega::resetAllScenes,"Reset all scenes.")
 		.def("addScene",&pyOmega::addScene,"Add new scene to Omega, returns its number")
+		.def("runScenes",&pyOmega::runScenes,(py::arg("scenes")=py::object(),py::arg("nSteps")=1,py::arg("workers")=0,py::arg("ompThreads")=1),"Step several scenes (created by :yref:`addScene<Omega.addScene>`) concurrently, and return once all of them are done. Each scene is advanced *nSteps* times (less if its :yref:`stopAtIter<Omega.stopAtIter>` or :yref:`stopAtTime<Omega.stopAtTime>` is reached) by one thread of a pool of *workers* threads (by default, as many as the number of cores divided by *ompThreads*). *scenes* is a list of scene numbers (all scenes by default); *ompThreads* is the number of OpenMP threads given to each scene, as a number or as a list with one value per scene. While a scene runs, ``O`` refers to it in python code run by its engines. The main simulation loop must not be running. Engines must not use data shared between scenes.")
 		.def("switchToScene",&pyOmega::switchToScene,"Switch to defined scene. Default scene has number 0, other scenes have to be created by addScene method.")
 		.def("switchScene",&pyOmega::switchScene,"Switch to alternative simulation (while keeping the old one). Calling the function again switches back to the first one. Note that most variables from the first simulation will still refer to the first simulation even after the switch\n(e.g. b=O.bodies[4]; O.switchScene(); [b still refers to the body in the first simulation here])")
 		.add_property("thisScene",&pyOmega::thisScene,"Return current scene's id.")
@@ -899,6 +1183,9 @@ BOOST_PYTHON_MODULE(wrapper)
 		.def("replaceByClumps",&pyBodyContainer::replaceByClumps,(py::arg("discretization")=0),"Replace spheres by clumps using a list of clump templates and a list of amounts; returns a list of tuples: ``[(clumpId1,[memberId1,memberId2,...]),(clumpId2,[memberId1,memberId2,...]),...]``. A new clump will have the same volume as the sphere, that was replaced. Clump masses and inertia are adapted automatically (for details see :yref:`clump()<BodyContainer.clump>`). \n\n\t *O.bodies.replaceByClumps( [utils.clumpTemplate([1,1],[.5,.5])] , [.9] ) #will replace 90 % of all standalone spheres by 'dyads'*\n\nSee :ysrc:`examples/clumps/replaceByClumps-example.py` for an example script.")
 		.def("getRoundness",&pyBodyContainer::getRoundness,(py::arg("excludeList")=py::list()),"Returns roundness coefficient RC = R2/R1. R1 is the equivalent sphere radius of a clump. R2 is the minimum radius of a sphere, that imbeds the clump. If just spheres are present RC = 1. If clumps are present 0 < RC < 1. Bodies can be excluded from the calculation by giving a list of ids: *O.bodies.getRoundness([ids])*.\n\nSee :ysrc:`examples/clumps/replaceByClumps-example.py` for an example script.")
 		.def("clear", &pyBodyContainer::clear,"Remove all bodies (interactions not checked)")
+		.def("array",&pyBodyContainer::array,(py::arg("attr")),"Return a numpy array with one row per body id (deleted bodies give NaN, or -1 for integers), gathered in parallel. *attr* is one of ``pos``, ``vel``, ``angVel``, ``angMom``, ``refPos``, ``inertia``, ``color`` (shape (n,3)), ``ori`` (shape (n,4), as w,x,y,z), ``mass``, ``radius`` (NaN for non-spherical bodies), ``blockedDOFs`` (bitmask, x=1, y=2, z=4, rx=8, ry=16, rz=32), ``isDynamic``, ``clumpId`` or ``mask``.\n\n\t*pos=O.bodies.array('pos'); print pos[:,2].max()*")
+		.def("appendSpheres",&pyBodyContainer::appendSpheres,(py::arg("centers"),py::arg("radii"),py::arg("material")=-1,py::arg("mask")=1,py::arg("fixed")=false,py::arg("color")=py::object(),py::arg("wire")=false),"Create and append spheres from arrays of *centers* (shape (n,3)) and *radii* (shape (n,)), like :yref:`yade.utils.sphere` would, but building all bodies in c++ in parallel and inserting them at once. *material* is a shared material id, label or :yref:`Material` instance (callables are not accepted); *color* is random if not given. Return the list of new ids.")
+		.def("setArray",&pyBodyContainer::setArray,(py::arg("attr"),py::arg("values"),py::arg("ids")=py::object()),"Set ``vel``, ``angVel``, ``color`` (array of shape (n,3)) or ``blockedDOFs`` (integer bitmask, see :yref:`BodyContainer.array`) for many bodies at once. Rows correspond to body ids, or to *ids* if given. Rows containing NaN (negative values for ``blockedDOFs``) are skipped.")
 		.def("erase", &pyBodyContainer::erase,(py::arg("eraseClumpMembers")=0),"Erase body with the given id; all interaction will be deleted by InteractionLoop in the next step. If a clump is erased use *O.bodies.erase(clumpId,True)* to erase the clump AND its members.")
 		.def("replace",&pyBodyContainer::replace);
 	py::class_<pyBodyIterator>("BodyIterator",py::init<pyBodyIterator&>())
@@ -916,6 +1203,7 @@ BOOST_PYTHON_MODULE(wrapper)
 		.def("all",&pyInteractionContainer::getAll,(py::arg("onlyReal")=false),"Return list of all interactions. Virtual interaction are filtered out if onlyReal=True, else (default) it dumps the full content.")
 		.def("eraseNonReal",&pyInteractionContainer::eraseNonReal,"Erase all interactions that are not :yref:`real <Interaction.isReal>`.")
 		.def("erase",&pyInteractionContainer::erase,"Erase one interaction, given by id1, id2 (internally, ``requestErase`` is called -- the interaction might still exist as potential, if the :yref:`Collider` decides so).")
+		.def("array",&pyInteractionContainer::array,(py::arg("attr")),"Return a numpy array with one row per :yref:`real<Interaction.isReal>` interaction, in container order, gathered in parallel. *attr* is one of ``id1``, ``id2``, ``normalForce``, ``shearForce`` (from :yref:`NormShearPhys`), ``normal``, ``contactPoint`` (from :yref:`GenericSpheresContact`) or ``penetrationDepth`` (from :yref:`ScGeom`); NaN is returned where the interaction does not provide the value.")
 		.add_property("serializeSorted",&pyInteractionContainer::serializeSorted_get,&pyInteractionContainer::serializeSorted_set)
 		.def("clear",&pyInteractionContainer::clear,"Remove all interactions, and invalidate persistent collider data (if the collider supports it).");
 	py::class_<pyInteractionIterator>("InteractionIterator",py::init<pyInteractionIterator&>())
@@ -938,6 +1226,7 @@ BOOST_PYTHON_MODULE(wrapper)
 		.def("addRot",&pyForceContainer::rot_add,(py::arg("id"),py::arg("r")),"Apply rotation on body (accumulates).")
 		.def("reset",&pyForceContainer::reset,(py::arg("resetAll")=true),"Reset the force container, including user defined permanent forces/torques. resetAll=False will keep permanent forces/torques unchanged.")
 		.def("getPermForceUsed",&pyForceContainer::getPermForceUsed,"Check wether permanent forces are present.")
+		.def("array",&pyForceContainer::array,(py::arg("what"),py::arg("sync")=false),"Return a numpy array of shape (n,3), one row per body id, with ``f`` (force), ``t`` (torque), ``move``, ``rot``, ``permF`` or ``permT``. With sync=True the container is synchronized first (see :yref:`ForceContainer.f`).")
 		.add_property("syncCount",&pyForceContainer::syncCount_get,&pyForceContainer::syncCount_set,"Number of synchronizations  of ForceContainer (cummulative); if significantly higher than number of steps, there might be unnecessary syncs hurting performance.")
 		;
 
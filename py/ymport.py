@@ -112,10 +112,21 @@ def text(fileName,shift=Vector3.Zero,scale=1.0,**kw):
 	return textExt(fileName=fileName,format='x_y_z_r',shift=shift,scale=scale,**kw)
 
 
-def stl(file, dynamic=None,fixed=True,wire=True,color=None,highlight=False,noBound=False,material=-1):
-	""" Import geometry from stl file, return list of created facets."""
+def stl(file, dynamic=None,fixed=True,wire=True,color=None,highlight=False,noBound=False,material=-1,mesh=False):
+	""" Import geometry from stl file, return list of created facets. If *mesh* is ``True``, return a list with one body of :yref:`TriMesh` shape instead (see :yref:`yade.utils.triMesh`); vertices shared by triangles are merged."""
 	imp = STLImporter()
 	facets=imp.ymport(file)
+	if mesh:
+		vertices,triangles,index=[],[],{}
+		for b in facets:
+			tri=[]
+			for v in b.shape.vertices:
+				v=b.state.pos+b.state.ori*v
+				key=(v[0],v[1],v[2])
+				if key not in index: index[key]=len(vertices); vertices.append(v)
+				tri.append(index[key])
+			triangles.append(tri)
+		return [utils.triMesh(vertices,triangles,dynamic=dynamic,fixed=fixed,wire=wire,color=color,highlight=highlight,noBound=noBound,material=material)]
 	for b in facets:
 		b.shape.color=color if color else utils.randomColor()
 		b.shape.wire=wire
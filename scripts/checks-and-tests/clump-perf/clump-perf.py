@@ -0,0 +1,47 @@
+# Performance test of NewtonIntegrator with many clumps
+#
+# Clumps of 10-50 spheres are deposited on a box by gravity; the time spent in NewtonIntegrator
+# (reduction of member forces to clumps and motion of members) is reported by timing.stats().
+#
+# Run the test like this:
+#
+#  yade-trunk-opt-multi -j1 clump-perf.py
+#
+# or with different parameters, e.g. in the batch mode with a table with columns nClumps, nMembers, clumpLevel
+#
+#  yade-trunk -j4 clump-perf.py
+#
+utils.readParamsFromTable(nClumps=2000,nMembers=30,clumpLevel=False,noTableOk=True)
+from yade.params.table import *
+from yade import pack,timing
+import random
+random.seed(1)
+
+O.bodies.append(geom.facetBox((.5,.5,.5),(.5,.5,.5),wallMask=31))
+rad=.004
+# templates of clumps, members placed randomly around the center
+templates=[]
+for t in range(10):
+	n=random.randint(max(nMembers-20,10),nMembers+20)
+	templates.append(pack.SpherePack([((random.uniform(-2,2)*rad,random.uniform(-2,2)*rad,random.uniform(-2,2)*rad),rad*random.uniform(.7,1.3)) for i in range(n)]))
+sp=pack.SpherePack()
+sp.makeClumpCloud((0,0,0),(1,1,1),templates,num=nClumps,seed=1)
+sp.toSimulation()
+
+O.engines=[
+	ForceResetter(),
+	InsertionSortCollider([Bo1_Sphere_Aabb(),Bo1_Facet_Aabb()],clumpLevel=clumpLevel),
+	InteractionLoop(
+		[Ig2_Sphere_Sphere_ScGeom(),Ig2_Facet_Sphere_ScGeom()],
+		[Ip2_FrictMat_FrictMat_FrictPhys()],
+		[Law2_ScGeom_FrictPhys_CundallStrack()]
+	),
+	NewtonIntegrator(damping=.3,gravity=(0,0,-9.81)),
+]
+O.dt=.5*PWaveTimeStep()
+print 'Clumps: %d, bodies: %d'%(len([b for b in O.bodies if b.isClump]),len(O.bodies))
+print "Interactions: %d (real: %d)"%(len(O.interactions),O.interactions.countReal())
+O.run(10,True) # filter out initialization
+O.timingEnabled=True
+O.run(500,True)
+timing.stats()
@@ -0,0 +1,58 @@
+# Performance test of InsertionSortCollider with a PFacet membrane
+#
+# Spheres are deposited by gravity on a square membrane of PFacets with fixed edges; the time spent in the collider
+# is reported by timing.stats(). With useGridMesh, the membrane is grouped in a GridMesh body and the collider sorts
+# one bound for it instead of one bound per GridConnection and PFacet.
+#
+# Run the test like this:
+#
+#  yade-trunk-opt-multi -j1 gridmesh-perf.py
+#
+# or with different parameters, e.g. in the batch mode with a table with columns nNodes, nSpheres, useGridMesh
+#
+#  yade-trunk -j4 gridmesh-perf.py
+#
+utils.readParamsFromTable(nNodes=80,nSpheres=5000,useGridMesh=True,noTableOk=True)
+from yade.params.table import *
+from yade import pack,timing
+from yade.gridpfacet import *
+
+O.materials.append(CohFrictMat(young=1e7,poisson=.3,density=1000,frictionAngle=radians(20),normalCohesion=1e100,shearCohesion=1e100,momentRotationLaw=True,label='nodeMat'))
+O.materials.append(FrictMat(young=1e7,poisson=.3,density=1000,frictionAngle=radians(20),label='mat'))
+
+# membrane of nNodes x nNodes nodes in the plane z=0, edges fixed
+L=1.; h=L/(nNodes-1); r=.1*h
+nodes=[[O.bodies.append(gridNode((i*h,j*h,0),r,fixed=(i in (0,nNodes-1) or j in (0,nNodes-1)),material='nodeMat')) for j in range(nNodes)] for i in range(nNodes)]
+elements=[]
+for i in range(nNodes):
+	for j in range(nNodes):
+		if i<nNodes-1: elements.append(O.bodies.append(gridConnection(nodes[i][j],nodes[i+1][j],r,material='nodeMat')))
+		if j<nNodes-1: elements.append(O.bodies.append(gridConnection(nodes[i][j],nodes[i][j+1],r,material='nodeMat')))
+		if i<nNodes-1 and j<nNodes-1: elements.append(O.bodies.append(gridConnection(nodes[i][j],nodes[i+1][j+1],r,material='nodeMat')))
+for i in range(nNodes-1):
+	for j in range(nNodes-1):
+		elements.append(O.bodies.append(pfacet(nodes[i][j],nodes[i+1][j],nodes[i+1][j+1],material='mat')))
+		elements.append(O.bodies.append(pfacet(nodes[i][j],nodes[i+1][j+1],nodes[i][j+1],material='mat')))
+if useGridMesh: O.bodies.append(gridMesh(elements))
+
+sp=pack.SpherePack()
+sp.makeCloud((.1*L,.1*L,.05*L),(.9*L,.9*L,.5*L),rMean=.004*L,rRelFuzz=.3,num=nSpheres,seed=1)
+sp.toSimulation(material='mat')
+
+O.engines=[
+	ForceResetter(),
+	InsertionSortCollider([Bo1_Sphere_Aabb(),Bo1_GridConnection_Aabb(),Bo1_PFacet_Aabb()]),
+	InteractionLoop(
+		[Ig2_Sphere_Sphere_ScGeom(),Ig2_GridNode_GridNode_GridNodeGeom6D(),Ig2_Sphere_PFacet_ScGridCoGeom(),Ig2_Sphere_GridConnection_ScGridCoGeom(),Ig2_GridConnection_GridConnection_GridCoGridCoGeom(),Ig2_GridConnection_PFacet_ScGeom(),Ig2_PFacet_PFacet_ScGeom()],
+		[Ip2_CohFrictMat_CohFrictMat_CohFrictPhys(setCohesionNow=True,setCohesionOnNewContacts=False),Ip2_FrictMat_FrictMat_FrictPhys()],
+		[Law2_ScGeom6D_CohFrictPhys_CohesionMoment(),Law2_ScGeom_FrictPhys_CundallStrack(),Law2_ScGridCoGeom_FrictPhys_CundallStrack(),Law2_GridCoGridCoGeom_FrictPhys_CundallStrack()]
+	),
+	NewtonIntegrator(damping=.3,gravity=(0,0,-9.81)),
+]
+O.dt=.5*PWaveTimeStep()
+print 'Grid elements: %d, spheres: %d, bodies: %d'%(len(elements),nSpheres,len(O.bodies))
+O.run(10,True) # filter out initialization
+print "Interactions: %d (real: %d)"%(len(O.interactions),O.interactions.countReal())
+O.timingEnabled=True
+O.run(500,True)
+timing.stats()